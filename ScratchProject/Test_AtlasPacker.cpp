@@ -0,0 +1,202 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/FontCsv/AtlasPacker.h>
+
+using Sqex::FontCsv::AtlasPacker;
+using Sqex::FontCsv::CreateConfig::PackingHeuristic;
+
+struct Glyph {
+	size_t Font;
+	size_t Index;
+	uint16_t Width;
+	uint16_t Height;
+};
+
+struct Space {
+	size_t Page;
+	uint16_t X;
+	uint16_t Y;
+};
+
+// Row layout that RenderTarget used before AtlasPacker, for glyphs without borders.
+class PreviousRowLayout {
+	const uint16_t m_width;
+	const uint16_t m_height;
+	const uint16_t m_gap;
+	size_t m_pageCount = 0;
+	uint16_t m_currentX = 0;
+	uint16_t m_currentY = 0;
+	uint16_t m_currentLineHeight = 0;
+
+public:
+	PreviousRowLayout(uint16_t width, uint16_t height, uint16_t gap)
+		: m_width(width)
+		, m_height(height)
+		, m_gap(gap) {
+	}
+
+	Space Place(uint16_t width, uint16_t height) {
+		auto newTargetRequired = false;
+		if (!m_pageCount)
+			newTargetRequired = true;
+		else {
+			if (static_cast<size_t>(0) + m_currentX + width + m_gap >= m_width) {
+				m_currentX = m_gap;
+				m_currentY += m_currentLineHeight + m_gap + 1;
+				m_currentLineHeight = 0;
+			}
+			if (m_currentY + height + m_gap + 1 >= m_height)
+				newTargetRequired = true;
+		}
+
+		if (newTargetRequired) {
+			++m_pageCount;
+			m_currentX = m_currentY = m_gap;
+			m_currentLineHeight = 0;
+		}
+
+		const Space result{m_pageCount - 1, m_currentX, m_currentY};
+		m_currentX += width + m_gap;
+		m_currentLineHeight = std::max(m_currentLineHeight, height);
+		return result;
+	}
+
+	[[nodiscard]] size_t PageCount() const {
+		return m_pageCount;
+	}
+};
+
+// Glyphs of a texture group: fonts of different sizes, each with some narrow and some wide glyphs.
+// Without compact layout, every glyph of a font is as tall as the font; with it, glyphs are as tall as they are drawn.
+static std::vector<Glyph> MakeGlyphs(std::mt19937& rng, size_t fontCount, size_t glyphsPerFont, bool compact) {
+	std::vector<Glyph> glyphs;
+	for (size_t font = 0; font < fontCount; ++font) {
+		const auto fontHeight = static_cast<uint16_t>(10 + rng() % 40);
+		for (size_t i = 0; i < glyphsPerFont; ++i) {
+			const auto width = static_cast<uint16_t>(rng() % 4 == 0 ? 1 + rng() % (fontHeight / 3 + 1) : fontHeight / 2 + rng() % (fontHeight / 2 + 1));
+			const auto height = compact ? static_cast<uint16_t>(1 + rng() % fontHeight) : fontHeight;
+			glyphs.emplace_back(Glyph{font, i, width, height});
+		}
+	}
+
+	// Fonts are numbered in the order they are laid out in, from the smallest.
+	std::vector<uint16_t> fontHeights(fontCount);
+	for (const auto& glyph : glyphs)
+		fontHeights[glyph.Font] = std::max(fontHeights[glyph.Font], glyph.Height);
+	std::vector<size_t> order(fontCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::ranges::stable_sort(order, [&](size_t l, size_t r) { return fontHeights[l] < fontHeights[r]; });
+	std::vector<size_t> rank(fontCount);
+	for (size_t i = 0; i < fontCount; ++i)
+		rank[order[i]] = i;
+	for (auto& glyph : glyphs)
+		glyph.Font = rank[glyph.Font];
+	std::ranges::sort(glyphs, [](const Glyph& l, const Glyph& r) { return std::tie(l.Font, l.Index) < std::tie(r.Font, r.Index); });
+	return glyphs;
+}
+
+// Places glyphs the way RenderTarget::Pack does, leaving a gap at the right and the bottom of every glyph, and at the left and the top of every page.
+static std::vector<Space> Pack(std::vector<Glyph> glyphs, uint16_t width, uint16_t height, uint16_t gap, PackingHeuristic heuristic, size_t& pageCount, std::vector<Glyph>& placedGlyphs) {
+	if (heuristic != PackingHeuristic::Shelf) {
+		std::ranges::sort(glyphs, [](const Glyph& l, const Glyph& r) {
+			return l.Height == r.Height ? std::tie(l.Font, l.Index) < std::tie(r.Font, r.Index) : l.Height > r.Height;
+		});
+	}
+
+	AtlasPacker packer(static_cast<uint16_t>(width - gap - 1), static_cast<uint16_t>(height - gap - 1), heuristic);
+	std::vector<Space> spaces;
+	for (const auto& glyph : glyphs) {
+		const auto placement = packer.Insert(static_cast<uint16_t>(glyph.Width + gap), static_cast<uint16_t>(glyph.Height + gap + 1));
+		spaces.emplace_back(Space{placement.Index, static_cast<uint16_t>(placement.X + gap), static_cast<uint16_t>(placement.Y + gap)});
+	}
+	pageCount = packer.PageCount();
+	placedGlyphs = std::move(glyphs);
+	return spaces;
+}
+
+// Checks that AtlasPacker keeps every glyph, along with its gap, inside the page and away from other glyphs, with every heuristic.
+// Shelf has to reproduce the previous row layout exactly, as it is the default; the others must not need more pages than it did.
+int main() {
+	constexpr uint16_t TextureWidth = 1024;
+	constexpr uint16_t TextureHeight = 1024;
+
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	const std::vector<std::pair<PackingHeuristic, const char*>> heuristics{
+		{PackingHeuristic::Shelf, "shelf"},
+		{PackingHeuristic::SkylineBottomLeft, "skylineBottomLeft"},
+		{PackingHeuristic::SkylineMinWaste, "skylineMinWaste"},
+		{PackingHeuristic::MaxRectsBestShortSideFit, "maxRectsBestShortSideFit"},
+		{PackingHeuristic::MaxRectsBestAreaFit, "maxRectsBestAreaFit"},
+	};
+
+	for (uint32_t seed = 0; seed < 8; ++seed) {
+		std::mt19937 rng(seed);
+		const auto gap = static_cast<uint16_t>(seed % 3);
+		const auto compact = seed % 2 == 1;
+		const auto glyphs = MakeGlyphs(rng, 2 + seed % 4, 500 + rng() % 1500, compact);
+
+		PreviousRowLayout previous(TextureWidth, TextureHeight, gap);
+		std::vector<Space> previousSpaces;
+		for (const auto& glyph : glyphs)
+			previousSpaces.emplace_back(previous.Place(glyph.Width, glyph.Height));
+
+		std::string line = std::format("Seed {}: {} glyphs, gap {}{}; previous {} pages", seed, glyphs.size(), gap, compact ? ", compact" : "", previous.PageCount());
+		for (const auto& [heuristic, name] : heuristics) {
+			size_t pageCount;
+			std::vector<Glyph> placedGlyphs;
+			const auto start = std::chrono::steady_clock::now();
+			const auto spaces = Pack(glyphs, TextureWidth, TextureHeight, gap, heuristic, pageCount, placedGlyphs);
+			const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			std::vector<std::vector<uint8_t>> used(pageCount, std::vector<uint8_t>(static_cast<size_t>(TextureWidth) * TextureHeight));
+			for (size_t i = 0; i < spaces.size(); ++i) {
+				const auto& glyph = placedGlyphs[i];
+				const auto& space = spaces[i];
+				const auto right = space.X + glyph.Width + gap, bottom = space.Y + glyph.Height + gap + 1;
+				if (space.Page >= pageCount || space.X < gap || space.Y < gap || right > TextureWidth || bottom > TextureHeight) {
+					check(false, std::format("Seed {} {}: glyph {}/{} out of bounds at page {} ({}, {})", seed, name, glyph.Font, glyph.Index, space.Page, space.X, space.Y));
+					continue;
+				}
+
+				auto overlaps = false;
+				for (auto y = space.Y; y < bottom; ++y) {
+					for (auto x = space.X; x < right; ++x) {
+						auto& pixel = used[space.Page][static_cast<size_t>(y) * TextureWidth + x];
+						overlaps |= pixel != 0;
+						pixel = 1;
+					}
+				}
+				check(!overlaps, std::format("Seed {} {}: glyph {}/{} overlaps another at page {} ({}, {})", seed, name, glyph.Font, glyph.Index, space.Page, space.X, space.Y));
+			}
+
+			if (heuristic == PackingHeuristic::Shelf) {
+				check(pageCount == previous.PageCount(), std::format("Seed {} {}: {} pages, previously {}", seed, name, pageCount, previous.PageCount()));
+				for (size_t i = 0; i < std::min(spaces.size(), previousSpaces.size()); ++i) {
+					check(spaces[i].Page == previousSpaces[i].Page && spaces[i].X == previousSpaces[i].X && spaces[i].Y == previousSpaces[i].Y,
+						std::format("Seed {} {}: glyph {} at page {} ({}, {}), previously page {} ({}, {})", seed, name, i,
+							spaces[i].Page, spaces[i].X, spaces[i].Y, previousSpaces[i].Page, previousSpaces[i].X, previousSpaces[i].Y));
+				}
+			} else
+				check(pageCount <= previous.PageCount(), std::format("Seed {} {}: {} pages, previously {}", seed, name, pageCount, previous.PageCount()));
+
+			line += std::format("; {} {} pages in {:.1f}ms", name, pageCount, elapsed);
+		}
+		std::cout << line << std::endl;
+	}
+
+	try {
+		AtlasPacker packer(16, 16, PackingHeuristic::SkylineBottomLeft);
+		void(packer.Insert(17, 1));
+		check(false, "Inserting a rectangle wider than a page succeeded");
+	} catch (const std::invalid_argument&) {
+		// pass
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
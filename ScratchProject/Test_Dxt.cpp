@@ -0,0 +1,207 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Utils/Dxt.h>
+
+#ifndef PF_AVX2_INSTRUCTIONS_AVAILABLE
+#define PF_AVX2_INSTRUCTIONS_AVAILABLE 40
+#endif
+
+// Previous implementation, from https://github.com/Benjamin-Dobell/s3tc-dxt-decompression/blob/master/s3tc.cpp,
+// with pixels packed in R, G, B, A byte order, and rows past the bottom of the image left alone.
+namespace Reference {
+	uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	void DecodePalette(const uint8_t* block, bool allowThreeColors, bool threeColorIndex3IsTransparent, uint32_t(&palette)[4]) {
+		const auto color0 = *reinterpret_cast<const uint16_t*>(block);
+		const auto color1 = *reinterpret_cast<const uint16_t*>(block + 2);
+
+		uint32_t temp;
+		temp = (color0 >> 11) * 255 + 16;
+		const auto r0 = (temp / 32 + temp) / 32;
+		temp = ((color0 & 0x07E0) >> 5) * 255 + 32;
+		const auto g0 = (temp / 64 + temp) / 64;
+		temp = (color0 & 0x001F) * 255 + 16;
+		const auto b0 = (temp / 32 + temp) / 32;
+
+		temp = (color1 >> 11) * 255 + 16;
+		const auto r1 = (temp / 32 + temp) / 32;
+		temp = ((color1 & 0x07E0) >> 5) * 255 + 32;
+		const auto g1 = (temp / 64 + temp) / 64;
+		temp = (color1 & 0x001F) * 255 + 16;
+		const auto b1 = (temp / 32 + temp) / 32;
+
+		palette[0] = PackRGBA(r0, g0, b0, 255);
+		palette[1] = PackRGBA(r1, g1, b1, 255);
+		if (!allowThreeColors || color0 > color1) {
+			palette[2] = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+			palette[3] = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+		} else {
+			palette[2] = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+			palette[3] = threeColorIndex3IsTransparent ? 0 : PackRGBA(0, 0, 0, 255);
+		}
+	}
+
+	uint32_t DecodeAlphaBC3(const uint8_t* block, size_t i, size_t j) {
+		const auto alpha0 = block[0];
+		const auto alpha1 = block[1];
+
+		const auto bits = block + 2;
+		const uint32_t alphaCode1 = bits[2] | (bits[3] << 8) | (bits[4] << 16) | (bits[5] << 24);
+		const uint16_t alphaCode2 = bits[0] | (bits[1] << 8);
+
+		const auto alphaCodeIndex = static_cast<int>(3 * (4 * j + i));
+		int alphaCode;
+		if (alphaCodeIndex <= 12)
+			alphaCode = (alphaCode2 >> alphaCodeIndex) & 0x07;
+		else if (alphaCodeIndex == 15)
+			alphaCode = (alphaCode2 >> 15) | ((alphaCode1 << 1) & 0x06);
+		else
+			alphaCode = (alphaCode1 >> (alphaCodeIndex - 16)) & 0x07;
+
+		if (alphaCode == 0)
+			return alpha0;
+		if (alphaCode == 1)
+			return alpha1;
+		if (alpha0 > alpha1)
+			return ((8 - alphaCode) * alpha0 + (alphaCode - 1) * alpha1) / 7;
+		if (alphaCode == 6)
+			return 0;
+		if (alphaCode == 7)
+			return 255;
+		return ((6 - alphaCode) * alpha0 + (alphaCode - 1) * alpha1) / 5;
+	}
+
+	enum class Kind {
+		BC1,
+		BC2,
+		BC3,
+	};
+
+	void DecompressImage(Kind kind, bool threeColorIndex3IsTransparent, uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
+		const auto blockSize = kind == Kind::BC1 ? 8 : 16;
+		const auto blockCountX = (width + 3) / 4;
+		const auto blockCountY = (height + 3) / 4;
+		for (uint32_t by = 0; by < blockCountY; ++by) {
+			for (uint32_t bx = 0; bx < blockCountX; ++bx, blockStorage += blockSize) {
+				const auto colorBlock = kind == Kind::BC1 ? blockStorage : blockStorage + 8;
+				uint32_t palette[4];
+				DecodePalette(colorBlock, kind == Kind::BC1, threeColorIndex3IsTransparent, palette);
+				const auto code = *reinterpret_cast<const uint32_t*>(colorBlock + 4);
+
+				for (uint32_t j = 0; j < 4; ++j) {
+					for (uint32_t i = 0; i < 4; ++i) {
+						auto color = palette[(code >> 2 * (4 * j + i)) & 0x03];
+						if (kind == Kind::BC2)
+							color = (color & 0x00FFFFFF) | ((17 * ((blockStorage[j * 2 + i / 2] >> (i % 2 * 4)) & 0xF)) << 24);
+						else if (kind == Kind::BC3)
+							color = (color & 0x00FFFFFF) | (DecodeAlphaBC3(blockStorage, i, j) << 24);
+
+						const auto x = bx * 4 + i, y = by * 4 + j;
+						if (x < width && y < height)
+							image[y * width + x] = color;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void Decompress(Reference::Kind kind, uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
+	switch (kind) {
+		case Reference::Kind::BC1:
+			return Utils::BlockDecompressImageDXT1(width, height, blockStorage, image);
+		case Reference::Kind::BC2:
+			return Utils::BlockDecompressImageDXT3(width, height, blockStorage, image);
+		case Reference::Kind::BC3:
+			return Utils::BlockDecompressImageDXT5(width, height, blockStorage, image);
+	}
+}
+
+// Checks the DXT decoders against the previous implementation on random blocks and odd image sizes,
+// including BC1 three-color blocks, where index 3 used to decode to opaque black instead of transparent black;
+// then compares the time taken.
+int main() {
+	std::cout << std::format("Using the {} path\n", IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE) ? "AVX2" : "SSE2");
+
+	std::mt19937 rng(0);
+	const auto randomBlocks = [&](Reference::Kind kind, uint32_t width, uint32_t height) {
+		const size_t blockSize = kind == Reference::Kind::BC1 ? 8 : 16;
+		std::vector<uint8_t> blocks(blockSize * ((width + 3) / 4) * ((height + 3) / 4));
+		for (size_t i = 0; i < blocks.size(); i += blockSize) {
+			for (size_t j = 0; j < blockSize; ++j)
+				blocks[i + j] = static_cast<uint8_t>(rng());
+
+			// Make both orderings of color endpoints and alpha endpoints, and equal endpoints, equally likely.
+			const auto colorOffset = kind == Reference::Kind::BC1 ? 0 : 8;
+			if (rng() % 4 == 0)
+				std::copy_n(&blocks[i + colorOffset], 2, &blocks[i + colorOffset + 2]);
+			if (kind == Reference::Kind::BC3 && rng() % 4 == 0)
+				blocks[i + 1] = blocks[i];
+		}
+		return blocks;
+	};
+
+	size_t failures = 0, threeColorIndex3Pixels = 0;
+	for (const auto kind : { Reference::Kind::BC1, Reference::Kind::BC2, Reference::Kind::BC3 }) {
+		for (auto iteration = 0; iteration < 2000; ++iteration) {
+			// Mostly small sizes that are not multiples of 4; some big enough to be decoded on multiple threads.
+			const auto width = iteration % 100 == 0 ? 256 + rng() % 64 : 1 + rng() % 40;
+			const auto height = iteration % 100 == 0 ? 256 + rng() % 64 : 1 + rng() % 40;
+			const auto blocks = randomBlocks(kind, width, height);
+
+			std::vector<uint32_t> expected(static_cast<size_t>(width) * height), previous(expected.size()), actual(expected.size());
+			Reference::DecompressImage(kind, true, width, height, blocks.data(), expected.data());
+			Reference::DecompressImage(kind, false, width, height, blocks.data(), previous.data());
+			Decompress(kind, width, height, blocks.data(), actual.data());
+
+			for (size_t i = 0; i < expected.size(); ++i) {
+				if (expected[i] != previous[i]) {
+					// Only BC1 three-color blocks are expected to differ from the previous implementation.
+					++threeColorIndex3Pixels;
+					if (kind != Reference::Kind::BC1 || expected[i] != 0 || previous[i] != 0xFF000000) {
+						if (failures++ < 16)
+							std::cout << std::format("BC{} {}x{} pixel {}: reference disagrees with previous implementation\n", static_cast<int>(kind) + 1, width, height, i);
+					}
+				}
+				if (actual[i] != expected[i]) {
+					if (failures++ < 16)
+						std::cout << std::format("BC{} {}x{} pixel {}: {:08x}, expected {:08x}\n", static_cast<int>(kind) + 1, width, height, i, actual[i], expected[i]);
+				}
+			}
+		}
+	}
+
+	// A three-color block with every index set to 3 must decode to transparent black.
+	{
+		const uint8_t block[8]{ 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+		uint32_t pixels[16];
+		Utils::BlockDecompressImageDXT1(4, 4, block, pixels);
+		if (std::ranges::any_of(pixels, [](uint32_t p) { return p != 0; }) && failures++ < 16)
+			std::cout << "BC1 three-color index 3 did not decode to transparent black\n";
+	}
+	std::cout << std::format("{} failures; {} pixels decoded as transparent black where they used to be opaque black\n", failures, threeColorIndex3Pixels);
+
+	// 1024x1024 is decoded on multiple threads; 252x252 stays below the threshold, and is decoded on one thread.
+	for (const auto [size, repeat] : { std::make_pair(1024u, 16), std::make_pair(252u, 256) }) {
+		for (const auto kind : { Reference::Kind::BC1, Reference::Kind::BC3 }) {
+			const auto blocks = randomBlocks(kind, size, size);
+			std::vector<uint32_t> image(static_cast<size_t>(size) * size);
+
+			const auto start = std::chrono::steady_clock::now();
+			for (auto i = 0; i < repeat; ++i)
+				Decompress(kind, size, size, blocks.data(), image.data());
+			const auto mid = std::chrono::steady_clock::now();
+			for (auto i = 0; i < repeat; ++i)
+				Reference::DecompressImage(kind, false, size, size, blocks.data(), image.data());
+			const auto end = std::chrono::steady_clock::now();
+
+			std::cout << std::format("BC{} {}x{}: {:.2f}ms vs reference {:.2f}ms per image\n",
+				static_cast<int>(kind) + 1, size, size,
+				std::chrono::duration<double, std::milli>(mid - start).count() / repeat,
+				std::chrono::duration<double, std::milli>(end - mid).count() / repeat);
+		}
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Utils/Dxt.h>
+
+enum class Kind {
+	BC1,
+	BC2,
+	BC3,
+};
+
+static void Compress(Kind kind, uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, Utils::DxtQuality quality) {
+	switch (kind) {
+		case Kind::BC1:
+			return Utils::BlockCompressImageDXT1(width, height, image, blockStorage, quality);
+		case Kind::BC2:
+			return Utils::BlockCompressImageDXT3(width, height, image, blockStorage, quality);
+		case Kind::BC3:
+			return Utils::BlockCompressImageDXT5(width, height, image, blockStorage, quality);
+	}
+}
+
+static void Decompress(Kind kind, uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
+	switch (kind) {
+		case Kind::BC1:
+			return Utils::BlockDecompressImageDXT1(width, height, blockStorage, image);
+		case Kind::BC2:
+			return Utils::BlockDecompressImageDXT3(width, height, blockStorage, image);
+		case Kind::BC3:
+			return Utils::BlockDecompressImageDXT5(width, height, blockStorage, image);
+	}
+}
+
+static double Psnr(double squaredErrorSum, size_t count) {
+	return squaredErrorSum ? 10 * std::log10(255. * 255. * static_cast<double>(count) / squaredErrorSum) : std::numeric_limits<double>::infinity();
+}
+
+// Encodes a noisy gradient with every format and quality, decodes it back, and reports PSNR and the time taken.
+// Fails if quality drops below a floor, gets worse with higher quality settings, or if BC1 gets transparency wrong.
+int main() {
+	constexpr uint32_t Width = 509, Height = 387;
+	constexpr auto Repeat = 3;
+	constexpr double MinRgbPsnr = 32;
+	constexpr double MinAlphaPsnr = 30;
+
+	std::mt19937 rng(0);
+	std::normal_distribution<float> noise(0, 6);
+	std::vector<uint32_t> image(static_cast<size_t>(Width) * Height);
+	for (uint32_t y = 0; y < Height; ++y) {
+		for (uint32_t x = 0; x < Width; ++x) {
+			const auto clamp = [](float v) { return static_cast<uint32_t>(std::clamp(v, 0.f, 255.f)); };
+			const auto r = 127 + 120 * std::sin(x * 0.03f + y * 0.01f) + noise(rng);
+			const auto g = 127 + 120 * std::cos(y * 0.05f) + noise(rng);
+			const auto b = static_cast<float>((x ^ y) & 0xFF);
+			const auto a = 127 + 127 * std::sin((x + y) * 0.02f);
+			image[static_cast<size_t>(y) * Width + x] = clamp(r) | (clamp(g) << 8) | (clamp(b) << 16) | (clamp(a) << 24);
+		}
+	}
+
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	for (const auto kind : { Kind::BC1, Kind::BC2, Kind::BC3 }) {
+		const auto name = std::format("BC{}", static_cast<int>(kind) + 1);
+		std::vector<uint8_t> blocks(((Width + 3) / 4) * ((Height + 3) / 4) * (kind == Kind::BC1 ? 8 : 16));
+		std::vector<uint32_t> decoded(image.size());
+
+		auto previousRgbPsnr = 0.;
+		auto fastElapsed = 0.;
+		for (const auto quality : { Utils::DxtQuality::Fast, Utils::DxtQuality::Normal, Utils::DxtQuality::High }) {
+			const auto start = std::chrono::steady_clock::now();
+			for (auto i = 0; i < Repeat; ++i)
+				Compress(kind, Width, Height, image.data(), blocks.data(), quality);
+			const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / Repeat;
+			if (quality == Utils::DxtQuality::Fast)
+				fastElapsed = elapsed;
+
+			Decompress(kind, Width, Height, blocks.data(), decoded.data());
+
+			// BC1 turns pixels with alpha below 128 into transparent black, so their color does not count.
+			double rgbError = 0, alphaError = 0;
+			size_t rgbCount = 0, wrongTransparency = 0;
+			for (size_t i = 0; i < image.size(); ++i) {
+				const auto sourceAlpha = image[i] >> 24;
+				const auto decodedAlpha = decoded[i] >> 24;
+				if (kind == Kind::BC1) {
+					wrongTransparency += (sourceAlpha >= 128) != (decodedAlpha == 255);
+					if (sourceAlpha < 128)
+						continue;
+				} else {
+					const auto d = static_cast<double>(sourceAlpha) - decodedAlpha;
+					alphaError += d * d;
+				}
+				for (size_t c = 0; c < 3; ++c) {
+					const auto d = static_cast<double>((image[i] >> (8 * c)) & 0xFF) - ((decoded[i] >> (8 * c)) & 0xFF);
+					rgbError += d * d;
+				}
+				rgbCount += 3;
+			}
+
+			const auto rgbPsnr = Psnr(rgbError, rgbCount);
+			const auto alphaPsnr = Psnr(alphaError, image.size());
+			std::cout << std::format("{} quality {}: RGB {:.2f}dB, alpha {:.2f}dB; {:.2f}ms ({:.1f}x Fast)\n",
+				name, static_cast<int>(quality), rgbPsnr, kind == Kind::BC1 ? 0. : alphaPsnr, elapsed, elapsed / fastElapsed);
+
+			check(rgbPsnr >= MinRgbPsnr, std::format("{} quality {}: RGB PSNR below {}dB", name, static_cast<int>(quality), MinRgbPsnr));
+			check(rgbPsnr >= previousRgbPsnr - 0.05, std::format("{} quality {}: RGB PSNR lower than the previous quality setting", name, static_cast<int>(quality)));
+			check(kind == Kind::BC1 || alphaPsnr >= MinAlphaPsnr, std::format("{} quality {}: alpha PSNR below {}dB", name, static_cast<int>(quality), MinAlphaPsnr));
+			check(!wrongTransparency, std::format("{} quality {}: {} pixels with wrong transparency", name, static_cast<int>(quality), wrongTransparency));
+			previousRgbPsnr = rgbPsnr;
+		}
+	}
+
+	// Tiny images of a single color must survive the round trip, apart from the rounding 5:6:5 color implies.
+	for (const auto size : { 1u, 2u, 3u, 5u }) {
+		for (const auto kind : { Kind::BC1, Kind::BC2, Kind::BC3 }) {
+			const auto color = kind == Kind::BC1 ? 0xFF102030u : 0x80102030u;
+			std::vector<uint32_t> source(static_cast<size_t>(size) * size, color), decoded(source.size());
+			std::vector<uint8_t> blocks(((size + 3) / 4) * ((size + 3) / 4) * 16);
+			Compress(kind, size, size, source.data(), blocks.data(), Utils::DxtQuality::High);
+			Decompress(kind, size, size, blocks.data(), decoded.data());
+			for (const auto pixel : decoded) {
+				auto maxError = 0;
+				for (size_t c = 0; c < 4; ++c)
+					maxError = std::max(maxError, std::abs(static_cast<int>((pixel >> (8 * c)) & 0xFF) - static_cast<int>((color >> (8 * c)) & 0xFF)));
+				check(maxError <= (kind == Kind::BC2 ? 8 : 4), std::format("BC{} {}x{}: {:08x} decoded as {:08x}", static_cast<int>(kind) + 1, size, size, color, pixel));
+			}
+		}
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,346 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/FontCsv/BaseDrawableFont.h>
+#include <XivAlexanderCommon/Sqex/FontCsv/CreateConfig.h>
+#include <XivAlexanderCommon/Sqex/FontCsv/Creator.h>
+
+static uint32_t ResolveL8(const uint8_t& v) {
+	return v;
+}
+
+// Previous implementation of RgbBitmapCopy, which resolved gamma with std::pow on every pixel.
+template<typename SrcPixFmt, uint32_t ResolverFunction(const SrcPixFmt&), typename DestPixFmt, typename OpacityType>
+class PreviousRgbBitmapCopy {
+	static constexpr auto VerticalDirection = 1;
+	static constexpr auto Scaler = 0xFFUL;
+	static constexpr auto MaxOpacity = std::numeric_limits<OpacityType>::max();
+
+	static inline void DrawLineToRgb(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto blendedBgColor = DestPixFmt{
+				(bgColor.R * bgColor.A + destPtr->R * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+				(bgColor.G * bgColor.A + destPtr->G * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+				(bgColor.B * bgColor.A + destPtr->B * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+				DestPixFmt::MaxA - ((DestPixFmt::MaxA - bgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+			};
+			const auto blendedFgColor = DestPixFmt{
+				(fgColor.R * fgColor.A + destPtr->R * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+				(fgColor.G * fgColor.A + destPtr->G * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+				(fgColor.B * fgColor.A + destPtr->B * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+				DestPixFmt::MaxA - ((DestPixFmt::MaxA - fgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+			};
+			const auto currentColor = DestPixFmt{
+				(blendedBgColor.R * (Scaler - opacityScaled) + blendedFgColor.R * opacityScaled) / Scaler,
+				(blendedBgColor.G * (Scaler - opacityScaled) + blendedFgColor.G * opacityScaled) / Scaler,
+				(blendedBgColor.B * (Scaler - opacityScaled) + blendedFgColor.B * opacityScaled) / Scaler,
+				(blendedBgColor.A * (Scaler - opacityScaled) + blendedFgColor.A * opacityScaled) / Scaler,
+			};
+			const auto blendedDestColor = DestPixFmt{
+				(destPtr->R * destPtr->A + currentColor.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+				(destPtr->G * destPtr->A + currentColor.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+				(destPtr->B * destPtr->A + currentColor.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+				DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - currentColor.A)) / DestPixFmt::MaxA,
+			};
+			destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - currentColor.A) + currentColor.R * currentColor.A) / DestPixFmt::MaxR;
+			destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - currentColor.A) + currentColor.G * currentColor.A) / DestPixFmt::MaxG;
+			destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - currentColor.A) + currentColor.B * currentColor.A) / DestPixFmt::MaxB;
+			destPtr->A = blendedDestColor.A;
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	static inline void DrawLineToRgbOpaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			destPtr->R = (bgColor.R * (Scaler - opacityScaled) + fgColor.R * opacityScaled) / Scaler;
+			destPtr->G = (bgColor.G * (Scaler - opacityScaled) + fgColor.G * opacityScaled) / Scaler;
+			destPtr->B = (bgColor.B * (Scaler - opacityScaled) + fgColor.B * opacityScaled) / Scaler;
+			destPtr->A = DestPixFmt::MaxA;
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	template<bool ColorIsForeground>
+	static inline void DrawLineToRgbBinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto opacity = DestPixFmt::MaxA * (ColorIsForeground ? opacityScaled : Scaler - opacityScaled) / Scaler;
+			if (opacity) {
+				const auto blendedDestColor = DestPixFmt{
+					(destPtr->R * destPtr->A + color.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					(destPtr->G * destPtr->A + color.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					(destPtr->B * destPtr->A + color.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - opacity)) / DestPixFmt::MaxA,
+				};
+				destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - opacity) + color.R * opacity) / DestPixFmt::MaxR;
+				destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - opacity) + color.G * opacity) / DestPixFmt::MaxG;
+				destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - opacity) + color.B * opacity) / DestPixFmt::MaxB;
+				destPtr->A = blendedDestColor.A;
+			}
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	static inline void DrawLineToL8(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
+		constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto blendedBgColor = (1 * bgColor * bgOpacity + 1 * *destPtr * (MaxOpacity - bgOpacity)) / MaxOpacity;
+			const auto blendedFgColor = (1 * fgColor * fgOpacity + 1 * *destPtr * (MaxOpacity - fgOpacity)) / MaxOpacity;
+			*destPtr = static_cast<DestPixFmt>((blendedBgColor * (Scaler - opacityScaled) + blendedFgColor * opacityScaled) / Scaler);
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	static inline void DrawLineToL8Opaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, double gamma) {
+		constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			*destPtr = static_cast<DestPixFmt>(MaxOpacity * opacityScaled / Scaler);
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	template<bool ColorIsForeground>
+	static inline void DrawLineToL8BinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
+		constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto opacityScaled2 = ColorIsForeground ? opacityScaled : Scaler - opacityScaled;
+			*destPtr = static_cast<DestPixFmt>((*destPtr * (Scaler - opacityScaled2) + 1 * color * opacityScaled2) / Scaler);
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+public:
+	static void CopyTo(const Sqex::FontCsv::GlyphMeasurement& src, const Sqex::FontCsv::GlyphMeasurement& dest, const SrcPixFmt* srcBuf, DestPixFmt* destBuf, SSIZE_T srcWidth, SSIZE_T srcHeight, SSIZE_T destWidth, DestPixFmt fgColor, DestPixFmt bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
+		auto destPtrBegin = &destBuf[static_cast<size_t>(1) * dest.top * destWidth + dest.left];
+		auto srcPtrBegin = &srcBuf[static_cast<size_t>(1) * (VerticalDirection == 1 ? src.top : srcHeight - src.top - 1) * srcWidth + src.left];
+		const auto srcPtrDelta = srcWidth * VerticalDirection;
+		const auto regionWidth = src.right - src.left;
+		const auto regionHeight = src.bottom - src.top;
+
+		gamma = 1.0 / gamma;
+
+		if constexpr (std::is_integral_v<DestPixFmt>) {
+			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+			if (fgOpacity == MaxOpacity && bgOpacity == MaxOpacity && fgColor == DestPixFmtMax && bgColor == 0) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8Opaque(destPtrBegin, srcPtrBegin, regionWidth, gamma);
+			} else if (fgOpacity == MaxOpacity && bgOpacity == 0) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8BinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+			} else if (fgOpacity == 0 && bgOpacity == MaxOpacity) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8BinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+			} else {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+			}
+		} else {
+			fgColor.A = fgColor.A * fgOpacity / std::numeric_limits<OpacityType>::max();
+			bgColor.A = bgColor.A * bgOpacity / std::numeric_limits<OpacityType>::max();
+			if (fgColor.A == DestPixFmt::MaxA && bgColor.A == DestPixFmt::MaxA) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgbOpaque(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+			} else if (fgColor.A == DestPixFmt::MaxA && bgColor.A == 0) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgbBinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+			} else if (fgColor.A == 0 && bgColor.A == DestPixFmt::MaxA) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgbBinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+			} else {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgb(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+			}
+		}
+	}
+};
+
+using L8Copy = Sqex::FontCsv::RgbBitmapCopy<uint8_t, ResolveL8, uint8_t, uint8_t>;
+using PreviousL8Copy = PreviousRgbBitmapCopy<uint8_t, ResolveL8, uint8_t, uint8_t>;
+using RgbaCopy = Sqex::FontCsv::RgbBitmapCopy<uint8_t, ResolveL8, Sqex::Texture::RGBA8888, uint8_t>;
+using PreviousRgbaCopy = PreviousRgbBitmapCopy<uint8_t, ResolveL8, Sqex::Texture::RGBA8888, uint8_t>;
+
+// Largest difference in any channel between two pixels.
+static uint32_t Difference(uint8_t a, uint8_t b) {
+	return static_cast<uint32_t>(std::abs(static_cast<int>(a) - static_cast<int>(b)));
+}
+
+static uint32_t Difference(Sqex::Texture::RGBA8888 a, Sqex::Texture::RGBA8888 b) {
+	uint32_t result = 0;
+	for (size_t c = 0; c < 4; ++c)
+		result = std::max(result, Difference(static_cast<uint8_t>(a.Value >> (8 * c)), static_cast<uint8_t>(b.Value >> (8 * c))));
+	return result;
+}
+
+// Builds every file of a font set, and returns the wall time taken in seconds.
+static double BuildFontSet(const std::filesystem::path& configPath) {
+	std::ifstream fin(configPath);
+	nlohmann::json j;
+	fin >> j;
+	const auto cfg = j.get<Sqex::FontCsv::CreateConfig::FontCreateConfig>();
+
+	const auto start = std::chrono::steady_clock::now();
+	Sqex::FontCsv::FontSetsCreator creator(cfg, R"(C:\Program Files (x86)\SquareEnix\FINAL FANTASY XIV - A Realm Reborn\game)");
+	creator.VerifyRequirements(nullptr, nullptr);
+	creator.Start();
+	while (!creator.Wait(100)) {
+		const auto progress = creator.GetProgress();
+		std::cout << progress.Scale(100.) << "%     \r";
+	}
+	void(creator.GetResult());
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Checks RgbBitmapCopy against the previous implementation over random rows in every blend mode, for L8 and RGBA8888 destinations,
+// then compares the time taken to blend 1M RGBA8888 pixels, and measures the wall time of building whole font sets.
+int main() {
+	// The new implementation is meant to be exact; raise this to accept rounding differences.
+	constexpr uint32_t Tolerance = 0;
+	constexpr size_t RowCount = 20000;
+
+	std::mt19937 rng(0);
+	size_t failures = 0;
+	uint32_t maxDifference = 0;
+	size_t rowsPerMode[8]{};
+
+	const auto randomGamma = [&]() { return 0.5 + static_cast<double>(rng() % 100) / 40; };
+	const auto randomSource = [&](size_t count) {
+		// Fully covered and uncovered pixels are common in glyphs.
+		std::vector<uint8_t> src(count);
+		for (auto& v : src)
+			v = static_cast<uint8_t>(rng() % 4 == 0 ? (rng() % 2 ? 255 : 0) : rng());
+		return src;
+	};
+
+	for (size_t row = 0; row < RowCount; ++row) {
+		// Glyphs of up to 3 rows drawn at an offset into a wider destination.
+		const auto width = static_cast<SSIZE_T>(1 + rng() % 40);
+		const auto height = static_cast<SSIZE_T>(1 + rng() % 3);
+		const auto destWidth = width + 5;
+		const auto src = randomSource(static_cast<size_t>(width * height));
+		const auto gamma = randomGamma();
+
+		Sqex::FontCsv::GlyphMeasurement srcRect, destRect;
+		srcRect.SetFrom({ 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) });
+		destRect.SetFrom({ 3, 1, static_cast<LONG>(3 + width), static_cast<LONG>(1 + height) });
+
+		const auto mode = row % 8;
+		++rowsPerMode[mode];
+		if (mode < 4) {
+			std::vector<uint8_t> expected(static_cast<size_t>(destWidth * (height + 2)));
+			for (auto& v : expected)
+				v = static_cast<uint8_t>(rng());
+			auto actual = expected;
+
+			// Opaque, foreground only, background only, and everything else.
+			auto fgColor = static_cast<uint8_t>(rng()), bgColor = static_cast<uint8_t>(rng());
+			auto fgOpacity = static_cast<uint8_t>(rng()), bgOpacity = static_cast<uint8_t>(rng());
+			if (mode == 0)
+				fgColor = fgOpacity = bgOpacity = 255, bgColor = 0;
+			else if (mode == 1)
+				fgOpacity = 255, bgOpacity = 0;
+			else if (mode == 2)
+				fgOpacity = 0, bgOpacity = 255;
+
+			PreviousL8Copy::CopyTo(srcRect, destRect, src.data(), expected.data(), width, height, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+			L8Copy::CopyTo(srcRect, destRect, src.data(), actual.data(), width, height, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, Sqex::FontCsv::GetGammaTable(1.0 / gamma));
+			for (size_t i = 0; i < expected.size(); ++i) {
+				const auto difference = Difference(expected[i], actual[i]);
+				maxDifference = std::max(maxDifference, difference);
+				if (difference > Tolerance && failures++ < 16)
+					std::cout << std::format("L8 mode {} width {} pixel {}: {}, expected {}\n", mode, width, i, static_cast<int>(actual[i]), static_cast<int>(expected[i]));
+			}
+
+		} else {
+			std::vector<Sqex::Texture::RGBA8888> expected(static_cast<size_t>(destWidth * (height + 2)));
+			for (auto& v : expected)
+				v.Value = rng() % 3 == 0 ? rng() & 0x00FFFFFF : static_cast<uint32_t>(rng());
+			auto actual = expected;
+
+			// Opaque, foreground only, background only, and everything else.
+			Sqex::Texture::RGBA8888 fgColor(static_cast<uint32_t>(rng())), bgColor(static_cast<uint32_t>(rng()));
+			uint8_t fgOpacity = 255, bgOpacity = 255;
+			if (mode == 4)
+				fgColor.A = bgColor.A = 255;
+			else if (mode == 5)
+				fgColor.A = 255, bgOpacity = 0;
+			else if (mode == 6)
+				fgOpacity = 0, bgColor.A = 255;
+			else
+				fgOpacity = static_cast<uint8_t>(rng()), bgOpacity = static_cast<uint8_t>(rng());
+
+			PreviousRgbaCopy::CopyTo(srcRect, destRect, src.data(), expected.data(), width, height, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+			RgbaCopy::CopyTo(srcRect, destRect, src.data(), actual.data(), width, height, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, Sqex::FontCsv::GetGammaTable(1.0 / gamma));
+			for (size_t i = 0; i < expected.size(); ++i) {
+				const auto difference = Difference(expected[i], actual[i]);
+				maxDifference = std::max(maxDifference, difference);
+				if (difference > Tolerance && failures++ < 16)
+					std::cout << std::format("RGBA8888 mode {} width {} pixel {}: {:08x}, expected {:08x}\n", mode - 4, width, i, actual[i].Value, expected[i].Value);
+			}
+		}
+	}
+	std::cout << std::format("{} rows ({} per blend mode): {} failures, largest difference {}\n", RowCount, rowsPerMode[0], failures, maxDifference);
+
+	// 1M pixels as a 1024x1024 glyph, in the general blend mode.
+	{
+		constexpr SSIZE_T Size = 1024;
+		const auto src = randomSource(Size * Size);
+		std::vector<Sqex::Texture::RGBA8888> dest(Size * Size);
+		Sqex::FontCsv::GlyphMeasurement rect;
+		rect.SetFrom({ 0, 0, Size, Size });
+
+		for (auto pass = 0; pass < 3; ++pass) {
+			const Sqex::Texture::RGBA8888 fgColor(static_cast<uint32_t>(rng())), bgColor(static_cast<uint32_t>(rng()));
+			const auto start = std::chrono::steady_clock::now();
+			RgbaCopy::CopyTo(rect, rect, src.data(), dest.data(), Size, Size, Size, fgColor, bgColor, 200, 100, Sqex::FontCsv::GetGammaTable(1.0 / 1.4));
+			const auto mid = std::chrono::steady_clock::now();
+			PreviousRgbaCopy::CopyTo(rect, rect, src.data(), dest.data(), Size, Size, Size, fgColor, bgColor, 200, 100, 1.4);
+			const auto end = std::chrono::steady_clock::now();
+
+			std::cout << std::format("1M RGBA8888 pixels: {:.2f}ms vs previous {:.2f}ms\n",
+				std::chrono::duration<double, std::milli>(mid - start).count(),
+				std::chrono::duration<double, std::milli>(end - mid).count());
+		}
+	}
+
+	// Every glyph drawn used to look its gamma table up, under a lock shared by all threads.
+	{
+		constexpr size_t LookupCount = 1000000;
+		const auto start = std::chrono::steady_clock::now();
+		size_t sum = 0;
+		for (size_t i = 0; i < LookupCount; ++i)
+			sum += Sqex::FontCsv::GetGammaTable(1.0 / 1.4)[128];
+		std::cout << std::format("{} gamma table lookups: {:.2f}ms ({})\n",
+			LookupCount, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), sum / LookupCount);
+	}
+
+	// Blending is only a part of building a font set; see how long the whole of it takes.
+	for (const auto& configName : { "ComicSans.json", "Gulim.json" }) {
+		try {
+			const auto configPath = std::filesystem::path(R"(..\StaticData\FontConfig)") / configName;
+			if (!exists(configPath)) {
+				std::cout << std::format("{}: not found\n", configName);
+				continue;
+			}
+			for (auto pass = 0; pass < 2; ++pass)
+				std::cout << std::format("{} pass {}: {:.2f}s\n", configName, pass, BuildFontSet(configPath));
+		} catch (const std::exception& e) {
+			std::cout << std::format("{}: {}\n", configName, e.what());
+		}
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/FontCsv/CreateConfig.h>
+#include <XivAlexanderCommon/Sqex/FontCsv/Creator.h>
+#include <XivAlexanderCommon/Sqex/Sqpack.h>
+
+// Builds every file of a font set, and returns their contents.
+static std::map<std::string, std::vector<uint8_t>> Build(const Sqex::FontCsv::CreateConfig::FontCreateConfig& cfg, const std::filesystem::path& glyphCacheDirectory, double& elapsed) {
+	const auto start = std::chrono::steady_clock::now();
+	Sqex::FontCsv::FontSetsCreator creator(cfg, R"(C:\Program Files (x86)\SquareEnix\FINAL FANTASY XIV - A Realm Reborn\game)");
+	if (!glyphCacheDirectory.empty())
+		creator.SetGlyphCacheDirectory(glyphCacheDirectory);
+	creator.VerifyRequirements(nullptr, nullptr);
+	creator.Start();
+	while (!creator.Wait(100)) {
+		const auto progress = creator.GetProgress();
+		std::cout << progress.Scale(100.) << "%     \r";
+	}
+	const auto result = creator.GetResult();
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::map<std::string, std::vector<uint8_t>> files;
+	for (const auto& [pathSpec, stream] : result.GetAllStreams())
+		files.emplace(Utils::ToUtf8(pathSpec.FullPath.wstring()), stream->ReadStreamIntoVector<uint8_t>(0));
+	return files;
+}
+
+// Builds a font set without a glyph cache directory, then cold and warm with one, and compares the time taken.
+// Output has to be the same no matter where glyphs came from, and cache files left unused for long have to be removed.
+int main() {
+	std::ifstream fin(R"(..\StaticData\FontConfig\ComicSans.json)");
+	nlohmann::json j;
+	fin >> j;
+	const auto cfg = j.get<Sqex::FontCsv::CreateConfig::FontCreateConfig>();
+
+	const auto cacheDir = std::filesystem::temp_directory_path() / "XivAlexanderGlyphCacheTest";
+	remove_all(cacheDir);
+	create_directories(cacheDir);
+
+	const auto staleFile = cacheDir / "0000000000000000000000000000000000000000.glyphs";
+	std::ofstream(staleFile) << "stale";
+	last_write_time(staleFile, std::filesystem::file_time_type::clock::now() - std::chrono::hours(24 * 60));
+
+	try {
+		double uncachedElapsed, coldElapsed, warmElapsed;
+		const auto uncached = Build(cfg, {}, uncachedElapsed);
+		const auto cold = Build(cfg, cacheDir, coldElapsed);
+		const auto staleRemoved = !exists(staleFile);
+
+		uint64_t cacheSize = 0;
+		size_t cacheFileCount = 0;
+		for (const auto& item : std::filesystem::directory_iterator(cacheDir)) {
+			cacheSize += item.file_size();
+			++cacheFileCount;
+		}
+
+		const auto warm = Build(cfg, cacheDir, warmElapsed);
+
+		std::cout << std::format("Without cache directory: {:.2f}s\n", uncachedElapsed);
+		std::cout << std::format("Cold: {:.2f}s; {} cache files, {} bytes\n", coldElapsed, cacheFileCount, cacheSize);
+		std::cout << std::format("Warm: {:.2f}s ({:.1f}x faster than cold)\n", warmElapsed, coldElapsed / warmElapsed);
+
+		size_t failures = 0;
+		if (!staleRemoved) {
+			++failures;
+			std::cout << "Unused cache file has not been removed\n";
+		}
+		if (!cacheFileCount) {
+			++failures;
+			std::cout << "No cache file has been written\n";
+		}
+		for (const auto& [name, data] : uncached) {
+			for (const auto& [kind, other] : { std::make_pair("cold", &cold), std::make_pair("warm", &warm) }) {
+				const auto it = other->find(name);
+				if (it == other->end()) {
+					++failures;
+					std::cout << std::format("{}: missing from {} build\n", name, kind);
+				} else if (it->second != data) {
+					++failures;
+					std::cout << std::format("{}: {} build differs\n", name, kind);
+				}
+			}
+		}
+		std::cout << std::format("{} files, {} failures\n", uncached.size(), failures);
+
+		remove_all(cacheDir);
+		return failures ? 1 : 0;
+
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		remove_all(cacheDir);
+		return 1;
+	}
+}
@@ -0,0 +1,277 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Excel/Generator.h>
+#include <XivAlexanderCommon/Sqex/Excel/Reader.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/EntryRawStream.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/Reader.h>
+#include <XivAlexanderCommon/Utils/OrderedResultQueue.h>
+
+struct CompiledEntry {
+	std::string Path;
+	std::vector<char> Data;
+};
+
+// A row replacement rule, applied the way SetUpMergedExd applies rules from ExcelTransformConfig files:
+// matching string cells in the target language get replaced with strings of the same cell in source languages, put together through ReplaceTo.
+struct ReplacementRule {
+	srell::u8cregex ExhNamePattern;
+	srell::u8cregex StringPattern;
+	Sqex::Language TargetLanguage;
+	std::vector<Sqex::Language> SourceLanguages;
+	std::string ReplaceTo;
+	std::set<size_t> ColumnIndices;
+};
+
+static size_t ApplyRule(Sqex::Excel::Depth2ExhExdCreator& creator, const ReplacementRule& rule) {
+	if (!srell::regex_search(creator.Name, rule.ExhNamePattern))
+		return 0;
+
+	size_t replaced = 0;
+	for (const auto id : creator.GetIds()) {
+		const auto rowSet = creator.GetRowSet(id);
+		const auto target = rowSet.find(rule.TargetLanguage);
+		if (target == rowSet.end())
+			continue;
+
+		auto row = target->second;
+		auto changed = false;
+		for (const auto columnIndex : rule.ColumnIndices) {
+			if (columnIndex >= row.size() || row[columnIndex].Type != Sqex::Excel::Exh::String)
+				continue;
+			if (!srell::regex_search(row[columnIndex].String.Escaped(), rule.StringPattern))
+				continue;
+
+			std::vector p = { std::format("{}:{}", creator.Name, id) };
+			for (const auto language : rule.SourceLanguages) {
+				if (const auto it = rowSet.find(language); it != rowSet.end())
+					p.emplace_back(it->second[columnIndex].String.Escaped());
+				else
+					p.emplace_back();
+			}
+			while (p.size() < 4)
+				p.emplace_back();
+
+			auto allSame = true;
+			size_t nonEmptySize = 0;
+			size_t lastNonEmptyIndex = 1;
+			for (size_t i = 1; i < p.size(); ++i) {
+				if (!p[i].empty()) {
+					if (p[i] != p[1])
+						allSame = false;
+					nonEmptySize++;
+					lastNonEmptyIndex = i;
+				}
+			}
+			std::string out;
+			if (allSame)
+				out = p[1];
+			else if (nonEmptySize <= 1)
+				out = p[lastNonEmptyIndex];
+			else
+				out = std::vformat(rule.ReplaceTo, std::make_format_args(p[0], p[1], p[2], p[3]));
+
+			if (out != row[columnIndex].String.Escaped()) {
+				row[columnIndex].String = Sqex::SeString(out);
+				changed = true;
+				replaced++;
+			}
+		}
+		if (changed)
+			creator.SetRow(id, rule.TargetLanguage, std::move(row));
+	}
+	return replaced;
+}
+
+// Rebuilds a sheet in every language the way SetUpMergedExd starts off, and then applies rules to it.
+static std::vector<CompiledEntry> CompileSheet(const Sqex::Sqpack::Reader& reader, const std::string& exhName, const std::vector<ReplacementRule>& rules, size_t& replacedCount) {
+	const auto exh = Sqex::Excel::ExhReader(exhName, Sqex::Sqpack::EntryRawStream(reader.GetEntryProvider(std::format("exd/{}.exh", exhName))));
+	if (exh.Header.Depth != Sqex::Excel::Exh::Depth::Level2)
+		return {};
+	if (std::ranges::find(exh.Languages, Sqex::Language::Unspecified) != exh.Languages.end())
+		return {};
+
+	Sqex::Excel::Depth2ExhExdCreator creator(exhName, *exh.Columns, exh.Header.Flags.Value());
+	for (const auto language : exh.Languages) {
+		for (const auto& page : exh.Pages) {
+			try {
+				const auto exd = Sqex::Excel::ExdReader(exh, reader[exh.GetDataPathSpec(page, language)]);
+				creator.AddLanguage(language);
+				for (const auto i : exd.GetIds())
+					creator.SetRow(i, language, exd.ReadDepth2(i));
+			} catch (const std::out_of_range&) {
+				// pass
+			}
+		}
+	}
+
+	for (const auto& rule : rules)
+		replacedCount += ApplyRule(creator, rule);
+
+	std::vector<CompiledEntry> result;
+	for (auto& [pathSpec, data] : creator.Compile())
+		result.emplace_back(CompiledEntry{ Utils::ToUtf8(pathSpec.FullPath.wstring()), std::move(data) });
+	return result;
+}
+
+static uint64_t EstimateSheetCost(const Sqex::Sqpack::Reader& reader, const std::string& exhName) {
+	uint64_t size = 0;
+	try {
+		const auto exh = Sqex::Excel::ExhReader(exhName, Sqex::Sqpack::EntryRawStream(reader.GetEntryProvider(std::format("exd/{}.exh", exhName))));
+		for (const auto language : exh.Languages) {
+			for (const auto& page : exh.Pages) {
+				try {
+					size += reader[exh.GetDataPathSpec(page, language)]->StreamSize();
+				} catch (const std::out_of_range&) {
+					// pass
+				}
+			}
+		}
+	} catch (...) {
+		// pass
+	}
+	return size * 8;
+}
+
+// Lays out compiled entries into list and data files the way SetUpMergedExd writes TTMPL.mpl and TTMPD.mpd.
+class OutputWriter {
+public:
+	std::string List;
+	std::vector<char> Data;
+
+	void Write(const std::vector<CompiledEntry>& entries) {
+		for (const auto& entry : entries) {
+			List += std::format("{}\t{}\t{}\n", entry.Path, Data.size(), entry.Data.size());
+			Data.insert(Data.end(), entry.Data.begin(), entry.Data.end());
+		}
+	}
+};
+
+// Generates sheets concurrently through OrderedResultQueue, with sheets finishing in a shuffled order.
+static OutputWriter CompileParallel(const Sqex::Sqpack::Reader& reader, const std::vector<std::string>& exhNames, const std::vector<ReplacementRule>& rules, uint32_t workerCount, uint64_t budget, uint64_t& maxCostInFlight, uint64_t& maxSheetCost) {
+	OutputWriter parallel;
+	Utils::OrderedResultQueue<std::vector<CompiledEntry>> queue(budget, [&](std::vector<CompiledEntry>& entries) { parallel.Write(entries); });
+
+	std::mutex workMtx;
+	std::condition_variable workCv;
+	std::deque<std::pair<size_t, std::string>> work;
+	auto admittedAll = false;
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < workerCount; ++i) {
+		workers.emplace_back([&, rng = std::mt19937(static_cast<uint32_t>(i))]() mutable {
+			while (true) {
+				std::pair<size_t, std::string> item;
+				{
+					auto lock = std::unique_lock(workMtx);
+					workCv.wait(lock, [&]() { return admittedAll || !work.empty(); });
+					if (work.empty())
+						return;
+					item = std::move(work.front());
+					work.pop_front();
+				}
+
+				// Make sheets finish out of order.
+				std::this_thread::sleep_for(std::chrono::milliseconds(rng() % 5));
+				size_t replacedCount = 0;
+				queue.Finish(item.first, CompileSheet(reader, item.second, rules, replacedCount));
+			}
+		});
+	}
+
+	for (const auto& exhName : exhNames) {
+		const auto cost = EstimateSheetCost(reader, exhName);
+		const auto index = queue.Admit(cost);
+		maxSheetCost = std::max(maxSheetCost, cost);
+		maxCostInFlight = std::max(maxCostInFlight, queue.CostInFlight());
+		{
+			const auto lock = std::lock_guard(workMtx);
+			work.emplace_back(index, exhName);
+		}
+		workCv.notify_one();
+	}
+	{
+		const auto lock = std::lock_guard(workMtx);
+		admittedAll = true;
+	}
+	workCv.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+	return parallel;
+}
+
+// Checks that generating sheets concurrently through OrderedResultQueue gives output identical to generating them one by one,
+// with sheets finishing in a shuffled order and a budget small enough to make admission wait.
+// Runs once as-is, and once with replacement rules that have to change some cells, and change them the same way either way.
+int main() {
+	const auto reader = Sqex::Sqpack::Reader::FromPath(LR"(C:\Program Files (x86)\SquareEnix\FINAL FANTASY XIV - A Realm Reborn\game\sqpack\ffxiv\0a0000.win32.index)");
+	const auto exl = Sqex::Excel::ExlReader(Sqex::Sqpack::EntryRawStream(reader.GetEntryProvider("exd/root.exl")));
+	std::vector<std::string> exhNames;
+	for (const auto& name : exl | std::views::keys)
+		exhNames.emplace_back(name);
+
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	const std::vector<std::pair<std::string, std::vector<ReplacementRule>>> ruleSets{
+		{ "no rules", {} },
+		{ "rules", {
+			ReplacementRule{
+				.ExhNamePattern = srell::u8cregex("^(Item|Action|Status|PlaceName)$"),
+				.StringPattern = srell::u8cregex("."),
+				.TargetLanguage = Sqex::Language::Japanese,
+				.SourceLanguages = { Sqex::Language::Japanese, Sqex::Language::English },
+				.ReplaceTo = "{1} ({2})",
+				.ColumnIndices = { 0 },
+			},
+			ReplacementRule{
+				.ExhNamePattern = srell::u8cregex("^Addon$"),
+				.StringPattern = srell::u8cregex("^[A-Z]"),
+				.TargetLanguage = Sqex::Language::English,
+				.SourceLanguages = { Sqex::Language::German, Sqex::Language::French },
+				.ReplaceTo = "{1}/{2}",
+				.ColumnIndices = { 0 },
+			},
+		} },
+	};
+
+	OutputWriter unmodified;
+	for (const auto& [ruleSetName, rules] : ruleSets) {
+		OutputWriter serial;
+		size_t replacedCount = 0;
+		const auto serialStart = std::chrono::steady_clock::now();
+		for (const auto& exhName : exhNames)
+			serial.Write(CompileSheet(reader, exhName, rules, replacedCount));
+		const auto serialElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - serialStart).count();
+		std::cout << std::format("[{}] Serial: {} sheets, {} bytes of data, {} cells replaced in {:.2f}s\n", ruleSetName, exhNames.size(), serial.Data.size(), replacedCount, serialElapsed);
+
+		if (rules.empty()) {
+			unmodified = serial;
+		} else {
+			check(replacedCount > 0, std::format("[{}] No cell has been replaced", ruleSetName));
+			check(serial.Data != unmodified.Data, std::format("[{}] Output is the same as without rules", ruleSetName));
+		}
+
+		constexpr uint64_t Budget = 64 * 1048576;
+		for (const auto workerCount : { 2u, std::max(2u, std::thread::hardware_concurrency()) }) {
+			uint64_t maxCostInFlight = 0, maxSheetCost = 0;
+			const auto start = std::chrono::steady_clock::now();
+			const auto parallel = CompileParallel(reader, exhNames, rules, workerCount, Budget, maxCostInFlight, maxSheetCost);
+			const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			check(parallel.List == serial.List, std::format("[{}] {} workers: list differs", ruleSetName, workerCount));
+			check(parallel.Data == serial.Data, std::format("[{}] {} workers: data differs", ruleSetName, workerCount));
+			check(maxCostInFlight <= std::max(Budget, maxSheetCost), std::format("[{}] {} workers: {} bytes in flight", ruleSetName, workerCount, maxCostInFlight));
+			std::cout << std::format("[{}] {} workers: {:.2f}s; list {}, data {}; peak cost in flight {}MB (budget {}MB, largest sheet {}MB)\n",
+				ruleSetName, workerCount, elapsed,
+				parallel.List == serial.List ? "identical" : "DIFFERENT",
+				parallel.Data == serial.Data ? "identical" : "DIFFERENT",
+				maxCostInFlight / 1048576, Budget / 1048576, maxSheetCost / 1048576);
+		}
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
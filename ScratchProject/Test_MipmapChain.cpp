@@ -0,0 +1,139 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Texture/Mipmap.h>
+#include <XivAlexanderCommon/Sqex/Texture/MipmapGenerator.h>
+#include <XivAlexanderCommon/Sqex/Texture/ModifiableTextureStream.h>
+
+using namespace Sqex::Texture;
+
+// Builds mipmaps one level at a time, the way it would be done without GenerateMipmapChain:
+// each level is averaged from the previous level as RGBA8888, and then converted into the target format on its own.
+static std::vector<std::shared_ptr<MemoryBackedMipmap>> GeneratePerLevel(const MipmapStream* base, Format type, size_t levelCount) {
+	const auto convert = [type](const std::shared_ptr<MemoryBackedMipmap>& rgba8888) {
+		if (type == Format::A8R8G8B8)
+			return rgba8888;
+		return MemoryBackedMipmap::NewBlockCompressedFrom(rgba8888.get(), type);
+	};
+
+	std::vector<std::shared_ptr<MemoryBackedMipmap>> result;
+	auto previous = MemoryBackedMipmap::NewARGB8888From(base);
+	result.emplace_back(convert(previous));
+	while (result.size() < levelCount && (previous->Width > 1 || previous->Height > 1)) {
+		const size_t pw = previous->Width, ph = previous->Height;
+		const auto w = std::max<size_t>(1, pw / 2), h = std::max<size_t>(1, ph / 2);
+		auto next = std::make_shared<MemoryBackedMipmap>(w, h, 1, Format::A8R8G8B8, std::vector<uint8_t>(w * h * 4));
+
+		const auto src = std::as_const(*previous).View<uint8_t>();
+		const auto dst = next->View<uint8_t>();
+		for (size_t y = 0; y < h; ++y) {
+			const auto y0 = ph == 1 ? 0 : 2 * y, y1 = ph == 1 ? 0 : 2 * y + 1;
+			for (size_t x = 0; x < w; ++x) {
+				const auto x0 = pw == 1 ? 0 : 2 * x, x1 = pw == 1 ? 0 : 2 * x + 1;
+				for (size_t c = 0; c < 4; ++c) {
+					const auto sum = src[(y0 * pw + x0) * 4 + c] + src[(y0 * pw + x1) * 4 + c] + src[(y1 * pw + x0) * 4 + c] + src[(y1 * pw + x1) * 4 + c];
+					dst[(y * w + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+
+		previous = std::move(next);
+		result.emplace_back(convert(previous));
+	}
+	return result;
+}
+
+// Smooth gradients with noise and hard edges, so that both filtering and rounding show up in the result.
+static std::shared_ptr<MemoryBackedMipmap> MakeImage(size_t width, size_t height, uint32_t seed) {
+	std::mt19937 rng(seed);
+	auto image = std::make_shared<MemoryBackedMipmap>(width, height, 1, Format::A8R8G8B8, std::vector<uint8_t>(width * height * 4));
+	const auto pixels = image->View<uint8_t>();
+	for (size_t y = 0; y < height; ++y) {
+		for (size_t x = 0; x < width; ++x) {
+			const auto p = &pixels[(y * width + x) * 4];
+			p[0] = static_cast<uint8_t>(x * 255 / std::max<size_t>(1, width - 1));
+			p[1] = static_cast<uint8_t>(y * 255 / std::max<size_t>(1, height - 1));
+			p[2] = static_cast<uint8_t>(((x / 16 + y / 16) & 1) ? 224 : 32);
+			p[3] = static_cast<uint8_t>(128 + static_cast<int>(rng() % 64) - 32);
+		}
+	}
+	return image;
+}
+
+// Compares GenerateMipmapChain against building each level from the previous one.
+// With the box filter and no sRGB conversion, both average 2x2 pixels; the chain keeps levels as floats in between instead of rounding each of them,
+// so every channel must stay within a small distance of the per-level result. Also checks that GenerateMipmaps leaves a texture unchanged on failure,
+// and that a texture with generated mipmaps reads back the same.
+int main() {
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	// Rounding every level adds up to half a step each time, which averaging mostly cancels out; 2 has been seen at 4096x4096.
+	constexpr auto MaxChannelDifference = 3;
+	for (const auto& [width, height] : { std::pair<size_t, size_t>{ 4096, 4096 }, { 1024, 256 }, { 37, 5 }, { 1, 1 } }) {
+		const auto base = MakeImage(width, height, static_cast<uint32_t>(width * height));
+
+		for (const auto type : { Format::A8R8G8B8, Format::DXT5 }) {
+			const auto perLevelStart = std::chrono::steady_clock::now();
+			const auto perLevel = GeneratePerLevel(base.get(), type, SIZE_MAX);
+			const auto perLevelElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - perLevelStart).count();
+
+			const auto chainStart = std::chrono::steady_clock::now();
+			const auto chain = GenerateMipmapChain(base.get(), type, { .Filter = MipmapFilter::Box, .Srgb = false });
+			const auto chainElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - chainStart).count();
+
+			check(chain.size() == perLevel.size(), std::format("{}x{} type {}: {} levels, expected {}", width, height, static_cast<int>(type), chain.size(), perLevel.size()));
+
+			int maxDifference = 0;
+			for (size_t level = 0; level < std::min(chain.size(), perLevel.size()); ++level) {
+				const auto& actual = *chain[level];
+				const auto& expected = *perLevel[level];
+				check(actual.Width == expected.Width && actual.Height == expected.Height && actual.Type == type && actual.StreamSize() == RawDataLength(type, actual.Width, actual.Height, 1),
+					std::format("{}x{} type {} level {}: {}x{} type {}, {} bytes", width, height, static_cast<int>(type), level, actual.Width, actual.Height, static_cast<int>(actual.Type), actual.StreamSize()));
+				if (type != Format::A8R8G8B8)
+					continue;
+
+				const auto a = actual.View<uint8_t>();
+				const auto e = expected.View<uint8_t>();
+				for (size_t i = 0; i < std::min(a.size(), e.size()); ++i)
+					maxDifference = std::max(maxDifference, std::abs(static_cast<int>(a[i]) - static_cast<int>(e[i])));
+			}
+			check(maxDifference <= MaxChannelDifference, std::format("{}x{}: channels differ by up to {}", width, height, maxDifference));
+
+			std::cout << std::format("{}x{} type {}: {} levels; per level {:.1f}ms, chain {:.1f}ms ({:.2f}x); max channel difference {}\n",
+				width, height, static_cast<int>(type), chain.size(), perLevelElapsed, chainElapsed, perLevelElapsed / chainElapsed, maxDifference);
+		}
+	}
+
+	{
+		ModifiableTextureStream texture(Format::A8R8G8B8, 64, 64, 1, 1, 2);
+		const auto first = MakeImage(64, 64, 1);
+		texture.SetMipmap(0, 0, first);
+		try {
+			texture.GenerateMipmaps(Format::DXT1);
+			check(false, "GenerateMipmaps succeeded with a repeat missing its first mipmap");
+		} catch (const std::invalid_argument&) {
+			check(texture.GetType() == Format::A8R8G8B8 && texture.GetMipmapCount() == 1 && texture.GetMipmap(0, 0) == first,
+				"GenerateMipmaps changed the texture on failure");
+		}
+	}
+
+	{
+		auto texture = std::make_shared<ModifiableTextureStream>(Format::A8R8G8B8, 256, 128);
+		texture->SetMipmap(0, 0, MakeImage(256, 128, 2));
+		texture->GenerateMipmaps(Format::DXT5, { .Srgb = false });
+		check(texture->GetType() == Format::DXT5 && texture->GetMipmapCount() == 9, std::format("GenerateMipmaps made {} mipmaps of type {}", texture->GetMipmapCount(), static_cast<int>(texture->GetType())));
+
+		const auto reread = ModifiableTextureStream(texture);
+		for (size_t i = 0; i < texture->GetMipmapCount(); ++i) {
+			const auto expected = texture->GetMipmap(i, 0)->ReadStreamIntoVector<uint8_t>(0);
+			const auto actual = reread.GetMipmap(i, 0)->ReadStreamIntoVector<uint8_t>(0);
+			check(actual == expected, std::format("Mipmap {} reads back differently", i));
+		}
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Sound/MusicImporter.h>
+#include <XivAlexanderCommon/Sqex/Sound/Reader.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/Reader.h>
+
+// Compares the time taken to import music with and without going through ffmpeg for decoding.
+int main() {
+	const Sqex::Sqpack::Reader bgmReader(LR"(C:\Program Files (x86)\SquareEnix\FINAL FANTASY XIV - A Realm Reborn\game\sqpack\ffxiv\0c0000.win32.index)");
+	const auto configFile = std::filesystem::path(LR"(..\StaticData\MusicImportConfig\A Realm Reborn.json)");
+	const auto directory = std::filesystem::path(LR"(D:\OneDrive\Musics\Sorted by OSTs\Final Fantasy XIV\Final Fantasy 14 - 2.0 - A Realm Reborn)");
+	constexpr size_t MaxItems = 8;
+
+	Sqex::Sound::MusicImportConfig conf;
+	from_json(Utils::ParseJsonFromFile(canonical(configFile)), conf);
+
+	std::string defaultDir;
+	for (const auto& [dirName, dirConfig] : conf.searchDirectories) {
+		if (dirConfig.default_)
+			defaultDir = dirName;
+	}
+
+	for (const auto useInProcessDecoder : {false, true}) {
+		size_t count = 0;
+		uint64_t totalSize = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (const auto& item : conf.items) {
+			if (count >= MaxItems)
+				break;
+
+			for (const auto& target : item.target) {
+				if (!target.enable || count >= MaxItems)
+					continue;
+
+				try {
+					Sqex::Sound::MusicImporter importer(item.source, target, Utils::Win32::ResolvePathFromFileName("ffmpeg.exe"), Utils::Win32::ResolvePathFromFileName("ffprobe.exe"), Utils::Win32::Event::Create());
+					importer.SetUseInProcessDecoder(useInProcessDecoder);
+					for (const auto& path : target.path)
+						importer.AppendReader(std::make_shared<Sqex::Sound::ScdReader>(bgmReader[path]));
+					const auto logger = importer.OnWarningLog([&](const std::string& s) {
+						std::cout << std::format("Warning on {}: {}\n", target.path.front(), s);
+					});
+
+					if (!importer.ResolveSources(defaultDir, directory))
+						throw std::runtime_error("Not all source files are found");
+					importer.Merge([&totalSize](const std::filesystem::path&, std::vector<uint8_t> data) {
+						totalSize += data.size();
+					});
+					count++;
+				} catch (const std::exception& e) {
+					std::cout << std::format("Error on {}: {}\n", target.path.front(), e.what());
+				}
+			}
+		}
+		const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::format("{}: {} items, {} bytes, {}ms\n", useInProcessDecoder ? "In-process" : "ffmpeg", count, totalSize, elapsed);
+	}
+	return 0;
+}
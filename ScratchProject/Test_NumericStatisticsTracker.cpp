@@ -0,0 +1,287 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
+#include <XivAlexanderCommon/Utils/Utils.h>
+
+// Straightforward implementation to compare against, which scans every value on each query.
+// The tracker takes its own timestamps, so each value is given the times from right before and right after it has been added to the tracker,
+// and queries are answered as of a time range within which the tracker has answered them.
+class NaiveTracker {
+	struct Item {
+		int64_t Value;
+		int64_t TimestampUs;  // taken before the tracker has taken its own
+		int64_t AddedUs;  // taken after
+	};
+
+	const size_t m_trackCount;
+	const int64_t m_emptyValue;
+	const int64_t m_maxAgeUs;
+	std::vector<Item> m_values;
+	int64_t m_nowFromUs = 0;
+	int64_t m_nowToUs = 0;
+
+	[[nodiscard]] bool Live(const Item& v) const {
+		return m_maxAgeUs == INT64_MAX || v.TimestampUs + m_maxAgeUs >= m_nowToUs;
+	}
+
+	[[nodiscard]] std::vector<Item> LiveSince(int64_t sinceUs) const {
+		std::vector<Item> result;
+		for (const auto& v : m_values) {
+			if (Live(v) && v.TimestampUs >= sinceUs)
+				result.emplace_back(v);
+		}
+		return result;
+	}
+
+	[[nodiscard]] std::vector<int64_t> Since(int64_t sinceUs) const {
+		std::vector<int64_t> result;
+		for (const auto& v : LiveSince(sinceUs))
+			result.emplace_back(v.Value);
+		return result;
+	}
+
+public:
+	NaiveTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs = INT64_MAX)
+		: m_trackCount(trackCount)
+		, m_emptyValue(emptyValue)
+		, m_maxAgeUs(maxAgeUs) {
+	}
+
+	void AddValue(int64_t value, int64_t timestampUs, int64_t addedUs) {
+		m_values.emplace_back(Item{ value, timestampUs, addedUs });
+		if (m_values.size() > m_trackCount)
+			m_values.erase(m_values.begin());
+	}
+
+	void AddValue(int64_t value, int64_t timestampUs) {
+		AddValue(value, timestampUs, timestampUs);
+	}
+
+	void Clear() {
+		m_values.clear();
+	}
+
+	// Returns false if some value might have expired somewhere within the range, in which case the tracker may have seen either.
+	bool SetNow(int64_t fromUs, int64_t toUs) {
+		m_nowFromUs = fromUs;
+		m_nowToUs = toUs;
+		if (m_maxAgeUs == INT64_MAX)
+			return true;
+		return std::ranges::none_of(m_values, [&](const Item& v) {
+			return v.TimestampUs + m_maxAgeUs < toUs && v.AddedUs + m_maxAgeUs >= fromUs;
+		});
+	}
+
+	[[nodiscard]] int64_t Latest() const {
+		const auto values = Since(0);
+		return values.empty() ? m_emptyValue : values.back();
+	}
+
+	[[nodiscard]] int64_t NextBlankInUs() const {
+		const auto values = Since(0);
+		return values.size() < m_trackCount ? 0 : values.front();
+	}
+
+	// Bounds of what CountFractional may return, as the fraction depends on when exactly the tracker has taken timestamps.
+	[[nodiscard]] std::pair<double, double> CountFractional(int64_t sinceUs = 0) const {
+		const auto live = LiveSince(0);
+		const auto values = LiveSince(sinceUs);
+		const auto count = static_cast<double>(values.size());
+		if (!sinceUs || values.empty() || values.size() == live.size())
+			return { count, count };
+
+		const auto& previous = live[live.size() - values.size() - 1];
+		const auto& current = values.front();
+
+		// If the tracker has taken the same timestamp as sinceUs for the first value, there is no fraction.
+		const auto lowest = current.TimestampUs == sinceUs ? 0. : static_cast<double>(sinceUs - previous.AddedUs) / static_cast<double>(current.AddedUs - previous.AddedUs);
+		const auto highest = static_cast<double>(sinceUs - previous.TimestampUs) / static_cast<double>(current.TimestampUs - previous.TimestampUs);
+		return { count + std::clamp(lowest, 0., 1.), count + std::clamp(highest, 0., 1.) };
+	}
+
+	[[nodiscard]] int64_t Min(int64_t sinceUs = 0) const {
+		const auto values = Since(sinceUs);
+		return values.empty() ? m_emptyValue : *std::ranges::min_element(values);
+	}
+
+	[[nodiscard]] int64_t Max(int64_t sinceUs = 0) const {
+		const auto values = Since(sinceUs);
+		return values.empty() ? m_emptyValue : *std::ranges::max_element(values);
+	}
+
+	[[nodiscard]] int64_t Median(int64_t sinceUs = 0) const {
+		auto values = Since(sinceUs);
+		if (values.empty())
+			return m_emptyValue;
+		std::ranges::sort(values);
+		if (values.size() % 2 == 0)
+			return (values[values.size() / 2] + values[values.size() / 2 - 1]) / 2;
+		return values[values.size() / 2];
+	}
+
+	[[nodiscard]] int64_t Percentile(double fraction, int64_t sinceUs = 0) const {
+		auto values = Since(sinceUs);
+		if (values.empty())
+			return m_emptyValue;
+		std::ranges::sort(values);
+		const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(values.size())));
+		return values[std::min(values.size() - 1, rank ? rank - 1 : 0)];
+	}
+
+	[[nodiscard]] std::pair<int64_t, int64_t> MeanAndDeviation(int64_t sinceUs = 0) const {
+		const auto values = Since(sinceUs);
+		const auto count = static_cast<int64_t>(values.size());
+		if (count == 0)
+			return { m_emptyValue, 0 };
+		const auto acc = std::accumulate(values.begin(), values.end(), int64_t());
+		if (count == 1)
+			return { acc, 0 };
+		const auto mean = acc / count;
+		int64_t diffSquaredSum = 0;
+		for (const auto v : values)
+			diffSquaredSum += (v - mean) * (v - mean);
+		return { mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count)) };
+	}
+
+	[[nodiscard]] size_t Count(int64_t sinceUs = 0) const {
+		return Since(sinceUs).size();
+	}
+};
+
+// Checks queries against NaiveTracker, with and without values expiring, and also while another thread is adding values; compares the time taken.
+int main() {
+	std::mt19937_64 rng(0);
+
+	size_t failures = 0, skipped = 0;
+	for (const auto trackCount : { 1, 2, 7, 10, 64, 128, 1024 }) {
+		for (const auto [valueRange, maxAgeUs] : { std::make_pair(4, INT64_MAX), std::make_pair(1000000, INT64_MAX), std::make_pair(4, int64_t{ 2000 }), std::make_pair(1000000, int64_t{ 2000 }) }) {
+			Utils::NumericStatisticsTracker tracker(trackCount, -1, maxAgeUs);
+			NaiveTracker naive(trackCount, -1, maxAgeUs);
+			std::vector<int64_t> timestamps;
+
+			for (size_t i = 0; i < 4096; ++i) {
+				if (rng() % 1000 == 0) {
+					tracker.Clear();
+					naive.Clear();
+				}
+
+				const auto value = static_cast<int64_t>(rng() % valueRange) - valueRange / 3;
+				const auto timestampUs = Utils::QpcUs();
+				tracker.AddValue(value);
+				naive.AddValue(value, timestampUs, Utils::QpcUs());
+				timestamps.emplace_back(timestampUs);
+
+				// Make sure that the next value gets a later timestamp than what the tracker has recorded for this one.
+				for (const auto addedUs = Utils::QpcUs(); Utils::QpcUs() == addedUs;) {}
+
+				const auto sinceUs = rng() % 4 == 0 ? 0 : timestamps[timestamps.size() - 1 - rng() % std::min<size_t>(timestamps.size(), trackCount * 2)];
+				const auto fraction = static_cast<double>(rng() % 101) / 100.;
+				const auto check = [&](bool success, const char* name) {
+					if (!success && failures++ < 16)
+						std::cout << std::format("trackCount={} range={} maxAge={} i={}: {} mismatch\n", trackCount, valueRange, maxAgeUs, i, name);
+				};
+
+				const auto nowFromUs = Utils::QpcUs();
+				const auto min = tracker.Min(sinceUs);
+				const auto max = tracker.Max(sinceUs);
+				const auto median = tracker.Median(sinceUs);
+				const auto percentile = tracker.Percentile(fraction, sinceUs);
+				const auto meanAndDeviation = tracker.MeanAndDeviation(sinceUs);
+				const auto count = tracker.Count(sinceUs);
+				const auto countFractional = tracker.CountFractional(sinceUs);
+				const auto latest = tracker.Latest();
+				const auto nextBlank = tracker.NextBlankInUs();
+				if (!naive.SetNow(nowFromUs, Utils::QpcUs())) {
+					skipped++;
+					continue;
+				}
+
+				check(min == naive.Min(sinceUs), "Min");
+				check(max == naive.Max(sinceUs), "Max");
+				check(median == naive.Median(sinceUs), "Median");
+				check(percentile == naive.Percentile(fraction, sinceUs), "Percentile");
+				check(meanAndDeviation == naive.MeanAndDeviation(sinceUs), "MeanAndDeviation");
+				check(count == naive.Count(sinceUs), "Count");
+				const auto [countFractionalLow, countFractionalHigh] = naive.CountFractional(sinceUs);
+				check(countFractionalLow - 1e-9 <= countFractional && countFractional <= countFractionalHigh + 1e-9, "CountFractional");
+				check(latest == naive.Latest(), "Latest");
+				check(nextBlank == naive.NextBlankInUs(), "NextBlankInUs");
+			}
+		}
+	}
+	std::cout << std::format("{} mismatches; {} sets of queries skipped, as values were expiring while they ran\n", failures, skipped);
+
+	// Values repeat with a period of trackCount, so once the window is full every query has a fixed answer;
+	// anything else seen by readers running alongside the writer means a query mixed up two states.
+	for (const auto trackCount : { 7, 128, 1024 }) {
+		std::vector<int64_t> period(trackCount);
+		std::iota(period.begin(), period.end(), -static_cast<int64_t>(trackCount) / 3);
+		std::ranges::shuffle(period, rng);
+
+		Utils::NumericStatisticsTracker tracker(trackCount, -1);
+		NaiveTracker naive(trackCount, -1);
+		for (const auto v : period) {
+			tracker.AddValue(v);
+			naive.AddValue(v, 0);
+		}
+
+		std::atomic_bool done = false;
+		std::atomic_size_t concurrentFailures = 0, queries = 0;
+		std::vector<std::thread> readers;
+		for (size_t i = 0; i < 3; ++i) {
+			readers.emplace_back([&]() {
+				size_t count = 0;
+				while (!done) {
+					const auto ok = tracker.Min() == naive.Min()
+						&& tracker.Max() == naive.Max()
+						&& tracker.Median() == naive.Median()
+						&& tracker.Percentile(0.9) == naive.Percentile(0.9)
+						&& tracker.MeanAndDeviation() == naive.MeanAndDeviation()
+						&& tracker.Count() == naive.Count();
+					concurrentFailures += !ok;
+					++count;
+				}
+				queries += count;
+			});
+		}
+		for (size_t i = 0; i < 1000000; ++i)
+			tracker.AddValue(period[i % trackCount]);
+		done = true;
+		for (auto& reader : readers)
+			reader.join();
+
+		failures += concurrentFailures;
+		std::cout << std::format("trackCount={}: {} inconsistent results out of {} sets of queries made while values were being added\n", trackCount, concurrentFailures.load(), queries.load());
+	}
+
+	for (const auto trackCount : { 10, 128, 1024, 16384 }) {
+		// Start with a full window, so that every AddValue also removes a value.
+		const auto iterations = std::max<size_t>(1000, 100000000 / trackCount / 64);
+		Utils::NumericStatisticsTracker tracker(trackCount, 0);
+		NaiveTracker naive(trackCount, 0);
+		for (size_t i = 0; i < static_cast<size_t>(trackCount); ++i) {
+			tracker.AddValue(static_cast<int64_t>(rng() % 100000));
+			naive.AddValue(static_cast<int64_t>(rng() % 100000), 0);
+		}
+		int64_t sink = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i) {
+			tracker.AddValue(static_cast<int64_t>(i * 7919 % 100000));
+			sink += tracker.Min() + tracker.Max() + tracker.Median() + tracker.MeanAndDeviation().second;
+		}
+		const auto mid = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i) {
+			naive.AddValue(static_cast<int64_t>(i * 7919 % 100000), 0);
+			sink += naive.Min() + naive.Max() + naive.Median() + naive.MeanAndDeviation().second;
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		std::cout << std::format("trackCount={}: {:.1f}ns vs naive {:.1f}ns per AddValue and 4 queries ({})\n",
+			trackCount,
+			std::chrono::duration<double, std::nano>(mid - start).count() / iterations,
+			std::chrono::duration<double, std::nano>(end - mid).count() / iterations,
+			sink);
+	}
+	return failures ? 1 : 0;
+}
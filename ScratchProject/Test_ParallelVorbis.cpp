@@ -0,0 +1,273 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Sound/ParallelVorbisEncoder.h>
+
+using Packet = Sqex::Sound::ParallelVorbisEncoder::Packet;
+using Pcm = std::vector<std::vector<float>>;
+
+enum class Signal {
+	Notes,  // short notes and drum hits
+	Pad,  // slowly changing tones
+	NoiseBursts,  // noise alternating with silence every 3 seconds
+};
+
+static Pcm Generate(Signal signal, uint32_t rate, uint32_t channels, size_t length) {
+	constexpr auto Pi = 3.14159265f;
+	Pcm pcm(channels, std::vector<float>(length));
+	std::mt19937 rng(static_cast<uint32_t>(signal) * 7 + channels);
+	std::uniform_real_distribution<float> uniform(0, 1);
+
+	switch (signal) {
+		case Signal::Notes:
+			for (size_t t = 0; t < length;) {
+				const auto noteLength = static_cast<size_t>(rate * (0.1f + 0.5f * uniform(rng)));
+				const auto frequency = 110.f * std::pow(2.f, std::floor(uniform(rng) * 36) / 12.f);
+				const auto drum = uniform(rng) < 0.3f;
+				for (size_t i = 0; i < noteLength * 2 && t + i < length; ++i) {
+					const auto v = drum
+						? (uniform(rng) * 2 - 1) * std::exp(-30.f * i / rate) * 0.5f
+						: 0.2f * std::exp(-3.f * i / rate) * std::sin(2 * Pi * frequency * i / rate);
+					for (uint32_t c = 0; c < channels; ++c)
+						pcm[c][t + i] += v * (1.f - 0.1f * c);
+				}
+				t += noteLength;
+			}
+			break;
+
+		case Signal::Pad:
+			for (size_t i = 0; i < length; ++i) {
+				const auto t = static_cast<float>(i) / rate;
+				for (uint32_t c = 0; c < channels; ++c)
+					pcm[c][i] = 0.2f * std::sin(2 * Pi * (220.f + c) * t) * (0.6f + 0.4f * std::sin(t * 0.3f)) + 0.1f * std::sin(2 * Pi * 330.f * t + std::sin(t));
+			}
+			break;
+
+		case Signal::NoiseBursts:
+			for (size_t i = 0; i < length; ++i) {
+				const auto on = i / (rate * 3) % 2;
+				for (uint32_t c = 0; c < channels; ++c)
+					pcm[c][i] = on ? (uniform(rng) * 2 - 1) * 0.3f : 0.f;
+			}
+			break;
+	}
+	return pcm;
+}
+
+// Encodes the way MusicImporter did before ParallelVorbisEncoder, with one encoder fed 8192 sample blocks at a time.
+static std::vector<Packet> EncodeSerial(const Pcm& pcm, uint32_t rate, float quality) {
+	vorbis_info vi{};
+	vorbis_info_init(&vi);
+	vorbis_encode_init_vbr(&vi, static_cast<long>(pcm.size()), static_cast<long>(rate), quality);
+	vorbis_dsp_state vd{};
+	vorbis_analysis_init(&vd, &vi);
+	vorbis_block vb{};
+	vorbis_block_init(&vd, &vb);
+
+	std::vector<Packet> packets;
+	const auto length = pcm[0].size();
+	for (size_t ptr = 0; ; ptr += 8192) {
+		const auto count = ptr < length ? std::min<size_t>(8192, length - ptr) : 0;
+		if (count) {
+			const auto buf = vorbis_analysis_buffer(&vd, static_cast<int>(count));
+			for (size_t c = 0; c < pcm.size(); ++c)
+				std::copy_n(&pcm[c][ptr], count, buf[c]);
+		}
+		vorbis_analysis_wrote(&vd, static_cast<int>(count));
+
+		while (vorbis_analysis_blockout(&vd, &vb) == 1) {
+			vorbis_analysis(&vb, nullptr);
+			vorbis_bitrate_addblock(&vb);
+			ogg_packet op{};
+			while (vorbis_bitrate_flushpacket(&vd, &op) == 1)
+				packets.emplace_back(Packet{ { op.packet, op.packet + op.bytes }, op.granulepos, !!op.e_o_s });
+		}
+		if (!count)
+			break;
+	}
+
+	vorbis_block_clear(&vb);
+	vorbis_dsp_clear(&vd);
+	vorbis_info_clear(&vi);
+	return packets;
+}
+
+// Feeds the encoder in pieces of random sizes, as the resampler in MusicImporter does.
+static std::vector<Packet> EncodeParallel(const Pcm& pcm, Sqex::Sound::ParallelVorbisEncoder& encoder) {
+	std::mt19937 rng(0);
+	const auto length = pcm[0].size();
+	for (size_t ptr = 0; ptr < length;) {
+		const auto count = std::min<size_t>(1 + rng() % 8192, length - ptr);
+		const auto buf = encoder.Buffer(count);
+		for (size_t c = 0; c < pcm.size(); ++c)
+			std::copy_n(&pcm[c][ptr], count, buf[c]);
+		encoder.Wrote(count);
+		ptr += count;
+	}
+	encoder.Wrote(0);
+	return encoder.Packets();
+}
+
+static Pcm Decode(const std::vector<Packet>& packets, ogg_packet(&headers)[3], size_t channels) {
+	vorbis_info vi{};
+	vorbis_info_init(&vi);
+	vorbis_comment vc{};
+	vorbis_comment_init(&vc);
+	for (auto& header : headers) {
+		if (const auto res = vorbis_synthesis_headerin(&vi, &vc, &header))
+			throw std::runtime_error(std::format("vorbis_synthesis_headerin: {}", res));
+	}
+	vorbis_dsp_state vd{};
+	vorbis_synthesis_init(&vd, &vi);
+	vorbis_block vb{};
+	vorbis_block_init(&vd, &vb);
+
+	Pcm pcm(channels);
+	for (size_t i = 0; i < packets.size(); ++i) {
+		ogg_packet op{
+			.packet = const_cast<uint8_t*>(packets[i].Data.data()),
+			.bytes = static_cast<long>(packets[i].Data.size()),
+			.e_o_s = packets[i].EndOfStream ? 1 : 0,
+			.granulepos = packets[i].GranulePos,
+			.packetno = static_cast<ogg_int64_t>(3 + i),
+		};
+		if (vorbis_synthesis(&vb, &op) == 0)
+			vorbis_synthesis_blockin(&vd, &vb);
+
+		float** buf;
+		while (const auto count = vorbis_synthesis_pcmout(&vd, &buf)) {
+			for (size_t c = 0; c < channels; ++c)
+				pcm[c].insert(pcm[c].end(), buf[c], buf[c] + count);
+			vorbis_synthesis_read(&vd, count);
+		}
+	}
+
+	// Like players do, drop what comes after the granule position of the last packet.
+	if (!packets.empty()) {
+		for (auto& channel : pcm)
+			channel.resize(std::min<size_t>(channel.size(), static_cast<size_t>(packets.back().GranulePos)));
+	}
+
+	vorbis_block_clear(&vb);
+	vorbis_dsp_clear(&vd);
+	vorbis_comment_clear(&vc);
+	vorbis_info_clear(&vi);
+	return pcm;
+}
+
+// Where MusicImporter moves loop start to: the granule position of the last packet at or before it.
+static int64_t SnapLoopStart(const std::vector<Packet>& packets, int64_t loopStart) {
+	size_t count = 0;
+	while (count < packets.size() && packets[count].GranulePos <= loopStart)
+		count++;
+	return count ? packets[count - 1].GranulePos : 0;
+}
+
+// Compares ParallelVorbisEncoder against a single encoder over different signals, sample rates, and channel counts.
+// Packet positions, decoded length, and loop offsets have to match; the parallel encoder is allowed to make different
+// choices within a block, so decoded output only has to be as close to the source as that of the single encoder.
+int main() {
+	constexpr float Quality = 1.f;
+
+	// Parallel encoding may not lose more than this much SNR overall, or be this much worse than the serial encoder
+	// over any 2048 sample window; a badly joined chunk shows up as a single window with a lot of error.
+	constexpr double MaxSnrLossDb = 0.1;
+	constexpr double MaxWindowErrorRatio = 2;
+	constexpr double MaxSizeDifference = 0.005;
+
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 32)
+			std::cout << what << std::endl;
+	};
+
+	for (const auto signal : { Signal::Notes, Signal::Pad, Signal::NoiseBursts }) {
+		for (const auto [rate, channels] : { std::make_pair(44100u, 2u), std::make_pair(48000u, 2u), std::make_pair(48000u, 1u), std::make_pair(44100u, 6u) }) {
+			for (const auto seconds : { 5, 25, 63 }) {
+				const auto name = std::format("signal {} {}Hz {}ch {}s", static_cast<int>(signal), rate, channels, seconds);
+				const auto source = Generate(signal, rate, channels, static_cast<size_t>(rate) * seconds + 1234);
+
+				const auto start = std::chrono::steady_clock::now();
+				Sqex::Sound::ParallelVorbisEncoder encoder(channels, rate, Quality);
+				const auto parallel = EncodeParallel(source, encoder);
+				const auto mid = std::chrono::steady_clock::now();
+				const auto serial = EncodeSerial(source, rate, Quality);
+				const auto end = std::chrono::steady_clock::now();
+
+				// Packets have to cover the same samples.
+				check(parallel.size() == serial.size(), std::format("{}: {} packets, expected {}", name, parallel.size(), serial.size()));
+				for (size_t i = 0, i_ = std::min(parallel.size(), serial.size()); i < i_; ++i) {
+					if (parallel[i].GranulePos != serial[i].GranulePos || parallel[i].EndOfStream != serial[i].EndOfStream) {
+						check(false, std::format("{}: packet {} at {} (eos={}), expected {} (eos={})", name, i, parallel[i].GranulePos, parallel[i].EndOfStream, serial[i].GranulePos, serial[i].EndOfStream));
+						break;
+					}
+				}
+
+				// Loop offsets derived from packet positions have to be the same.
+				std::mt19937_64 rng(0);
+				for (auto i = 0; i < 100; ++i) {
+					const auto loopStart = static_cast<int64_t>(rng() % source[0].size());
+					const auto snappedParallel = SnapLoopStart(parallel, loopStart);
+					const auto snappedSerial = SnapLoopStart(serial, loopStart);
+					check(snappedParallel == snappedSerial, std::format("{}: loop start {} snapped to {}, expected {}", name, loopStart, snappedParallel, snappedSerial));
+				}
+
+				ogg_packet headers[3]{};
+				vorbis_comment vc{};
+				vorbis_comment_init(&vc);
+				encoder.HeaderOut(vc, headers[0], headers[1], headers[2]);
+				const auto decodedParallel = Decode(parallel, headers, channels);
+				const auto decodedSerial = Decode(serial, headers, channels);
+				vorbis_comment_clear(&vc);
+
+				check(decodedParallel[0].size() == decodedSerial[0].size(), std::format("{}: decoded {} samples, expected {}", name, decodedParallel[0].size(), decodedSerial[0].size()));
+
+				double signalEnergy = 0, parallelError = 0, serialError = 0, worstWindowRatio = 0;
+				size_t worstWindow = 0;
+				const auto length = std::min(decodedParallel[0].size(), decodedSerial[0].size());
+				for (size_t w = 0; w + 2048 <= length; w += 2048) {
+					double windowParallelError = 0, windowSerialError = 0;
+					for (size_t c = 0; c < channels; ++c) {
+						for (size_t i = w; i < w + 2048; ++i) {
+							const double p = decodedParallel[c][i] - source[c][i];
+							const double s = decodedSerial[c][i] - source[c][i];
+							windowParallelError += p * p;
+							windowSerialError += s * s;
+							signalEnergy += static_cast<double>(source[c][i]) * source[c][i];
+						}
+					}
+					parallelError += windowParallelError;
+					serialError += windowSerialError;
+
+					// Windows of silence have next to no error either way.
+					const auto ratio = (windowParallelError + 1e-7 * 2048) / (windowSerialError + 1e-7 * 2048);
+					if (ratio > worstWindowRatio)
+						worstWindowRatio = ratio, worstWindow = w;
+				}
+				const auto parallelSnr = 10 * std::log10(signalEnergy / parallelError);
+				const auto serialSnr = 10 * std::log10(signalEnergy / serialError);
+
+				size_t parallelBytes = 0, serialBytes = 0, identicalPackets = 0;
+				for (const auto& packet : parallel)
+					parallelBytes += packet.Data.size();
+				for (const auto& packet : serial)
+					serialBytes += packet.Data.size();
+				for (size_t i = 0, i_ = std::min(parallel.size(), serial.size()); i < i_; ++i)
+					identicalPackets += parallel[i].Data == serial[i].Data;
+
+				std::cout << std::format("{}: SNR {:.2f}dB vs serial {:.2f}dB; worst window {:.2f}x at {:.2f}s; {} bytes vs {}, {}/{} packets identical; {}ms vs {}ms\n",
+					name, parallelSnr, serialSnr, worstWindowRatio, static_cast<double>(worstWindow) / rate,
+					parallelBytes, serialBytes, identicalPackets, serial.size(),
+					std::chrono::duration_cast<std::chrono::milliseconds>(mid - start).count(),
+					std::chrono::duration_cast<std::chrono::milliseconds>(end - mid).count());
+
+				check(parallelSnr >= serialSnr - MaxSnrLossDb, std::format("{}: SNR {:.2f}dB, serial {:.2f}dB", name, parallelSnr, serialSnr));
+				check(worstWindowRatio <= MaxWindowErrorRatio, std::format("{}: window at {:.2f}s has {:.2f}x the error of serial", name, static_cast<double>(worstWindow) / rate, worstWindowRatio));
+				check(std::abs(static_cast<double>(parallelBytes) - static_cast<double>(serialBytes)) <= MaxSizeDifference * static_cast<double>(serialBytes),
+					std::format("{}: {} bytes, serial {} bytes", name, parallelBytes, serialBytes));
+			}
+		}
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex.h>
+#include <XivAlexanderCommon/Sqex/Sound/PcmDecoder.h>
+#include <XivAlexanderCommon/Utils/Win32.h>
+#include <XivAlexanderCommon/Utils/Win32/Process.h>
+
+// Sines and a sweep from 1kHz to 9kHz, so that both resamplers pass everything through.
+static std::vector<int16_t> MakeSignal(uint32_t rate, uint32_t channels, size_t blockCount) {
+	std::vector<int16_t> samples(blockCount * channels);
+	for (size_t i = 0; i < blockCount; ++i) {
+		const auto t = static_cast<double>(i) / rate;
+		for (uint32_t c = 0; c < channels; ++c) {
+			const auto v = 0.4 * std::sin(2 * 3.14159265358979 * (220. * (c + 1)) * t)
+				+ 0.3 * std::sin(2 * 3.14159265358979 * (1000. + 4000. * t / (static_cast<double>(blockCount) / rate)) * t);
+			samples[i * channels + c] = static_cast<int16_t>(std::lround(v * 32767));
+		}
+	}
+	return samples;
+}
+
+static void WriteWav(const std::filesystem::path& path, uint32_t rate, uint32_t channels, std::span<const int16_t> samples) {
+	const auto dataSize = static_cast<uint32_t>(samples.size_bytes());
+	const auto blockAlign = static_cast<uint16_t>(channels * sizeof(int16_t));
+	std::ofstream out(path, std::ios::binary);
+	const auto write = [&out](const auto& value) { out.write(reinterpret_cast<const char*>(&value), sizeof value); };
+	out.write("RIFF", 4);
+	write(static_cast<uint32_t>(36 + dataSize));
+	out.write("WAVEfmt ", 8);
+	write(uint32_t{ 16 });
+	write(uint16_t{ WAVE_FORMAT_PCM });
+	write(static_cast<uint16_t>(channels));
+	write(rate);
+	write(rate * blockAlign);
+	write(blockAlign);
+	write(uint16_t{ 16 });
+	out.write("data", 4);
+	write(dataSize);
+	out.write(reinterpret_cast<const char*>(samples.data()), dataSize);
+}
+
+static void RunFfmpeg(const std::filesystem::path& ffmpeg, std::initializer_list<std::wstring> args) {
+	auto builder = Utils::Win32::ProcessBuilder();
+	builder.WithPath(ffmpeg).WithNoWindow()
+		.WithAppendArgument("-hide_banner")
+		.WithAppendArgument("-loglevel").WithAppendArgument("error")
+		.WithAppendArgument("-y")
+		.WithAppendArgument(args);
+	if (const auto exitCode = builder.Run().first.WaitAndGetExitCode())
+		throw std::runtime_error(std::format("ffmpeg exited with code {}", exitCode));
+}
+
+// Decodes the whole file into interleaved floats the way MusicImporter has ffmpeg do it.
+static std::vector<float> DecodeWithFfmpeg(const std::filesystem::path& ffmpeg, const std::filesystem::path& path, const std::filesystem::path& tempPath, uint32_t rate) {
+	RunFfmpeg(ffmpeg, { L"-i", path.wstring(), L"-resampler", L"soxr", L"-ar", std::to_wstring(rate), L"-f", L"f32le", tempPath.wstring() });
+	return Sqex::MemoryMappedRandomAccessStream(tempPath).ReadStreamIntoVector<float>(0);
+}
+
+static std::vector<float> DecodeInProcess(const std::filesystem::path& path, uint32_t rate) {
+	auto decoder = Sqex::Sound::PcmDecoder::TryCreate(std::make_shared<Sqex::MemoryRandomAccessStream>(Sqex::MemoryMappedRandomAccessStream(path)));
+	if (!decoder)
+		throw std::runtime_error("Not supported by PcmDecoder");
+	decoder = Sqex::Sound::PcmDecoder::Resample(std::move(decoder), rate);
+
+	std::vector<float> result;
+	while (true) {
+		const auto read = decoder->Read(4096);
+		if (read.empty())
+			break;
+		result.insert(result.end(), read.begin(), read.end());
+	}
+	return result;
+}
+
+// Encodes a test signal with ffmpeg into FLAC and MS-ADPCM WAV, and decodes each of them and the source WAV with both PcmDecoder and ffmpeg.
+// Without resampling, both must agree exactly; resampling goes through different filters, so only a small difference is allowed there,
+// ignoring a few blocks at either end where the filters run out of input differently.
+int main() {
+	const auto ffmpeg = Utils::Win32::ResolvePathFromFileName("ffmpeg.exe");
+	const auto tempDir = std::filesystem::temp_directory_path() / "XivAlexanderPcmDecoderTest";
+	remove_all(tempDir);
+	create_directories(tempDir);
+
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	try {
+		constexpr uint32_t SourceRate = 44100;
+		constexpr uint32_t Channels = 2;
+		constexpr size_t EdgeBlocks = 256;
+		constexpr double MaxResampledRmsDifference = 1e-3;
+		constexpr double MaxResampledDifference = 1e-2;
+
+		const auto wavPath = tempDir / "source.wav";
+		const auto flacPath = tempDir / "source.flac";
+		const auto adpcmPath = tempDir / "source.adpcm.wav";
+		const auto rawPath = tempDir / "decoded.raw";
+		WriteWav(wavPath, SourceRate, Channels, MakeSignal(SourceRate, Channels, SourceRate * 10));
+		RunFfmpeg(ffmpeg, { L"-i", wavPath.wstring(), L"-c:a", L"flac", flacPath.wstring() });
+		RunFfmpeg(ffmpeg, { L"-i", wavPath.wstring(), L"-c:a", L"adpcm_ms", adpcmPath.wstring() });
+
+		for (const auto& [path, name] : { std::make_pair(wavPath, "PCM"), std::make_pair(flacPath, "FLAC"), std::make_pair(adpcmPath, "MS-ADPCM") }) {
+			for (const auto rate : { SourceRate, uint32_t{ 48000 }, uint32_t{ 32000 } }) {
+				const auto expected = DecodeWithFfmpeg(ffmpeg, path, rawPath, rate);
+
+				const auto start = std::chrono::steady_clock::now();
+				const auto actual = DecodeInProcess(path, rate);
+				const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+				if (rate == SourceRate) {
+					check(actual == expected, std::format("{}: decoded samples differ from ffmpeg ({} vs {} samples)", name, actual.size(), expected.size()));
+					std::cout << std::format("{}: {} samples in {:.1f}ms\n", name, actual.size(), elapsed);
+					continue;
+				}
+
+				const auto expectedBlocks = expected.size() / Channels, actualBlocks = actual.size() / Channels;
+				check(std::max(expectedBlocks, actualBlocks) - std::min(expectedBlocks, actualBlocks) <= 1,
+					std::format("{} at {}Hz: {} blocks, ffmpeg {}", name, rate, actualBlocks, expectedBlocks));
+
+				double sumSquared = 0, maxDifference = 0;
+				size_t compared = 0;
+				for (auto i = EdgeBlocks * Channels; i + EdgeBlocks * Channels < std::min(actual.size(), expected.size()); ++i, ++compared) {
+					const auto d = std::abs(static_cast<double>(actual[i]) - expected[i]);
+					sumSquared += d * d;
+					maxDifference = std::max(maxDifference, d);
+				}
+				const auto rms = compared ? std::sqrt(sumSquared / compared) : 0.;
+				check(compared && rms <= MaxResampledRmsDifference && maxDifference <= MaxResampledDifference,
+					std::format("{} at {}Hz: differs from ffmpeg by {:.6f} RMS, {:.6f} at most", name, rate, rms, maxDifference));
+				std::cout << std::format("{} at {}Hz: {} samples in {:.1f}ms; differs from ffmpeg by {:.6f} RMS, {:.6f} at most\n", name, rate, actual.size(), elapsed, rms, maxDifference);
+			}
+		}
+
+	} catch (const std::exception& e) {
+		check(false, e.what());
+	}
+
+	remove_all(tempDir);
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/RandomAccessStream.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/ReadScheduler.h>
+
+// Plain in-memory stream whose content can be replaced, and which takes a while for every read like a file would.
+class SlowMemoryStream : public Sqex::RandomAccessStream {
+	mutable std::mutex m_mtx;
+	std::vector<uint8_t> m_data;
+	const std::chrono::microseconds m_latency;
+
+public:
+	SlowMemoryStream(size_t size, std::chrono::microseconds latency)
+		: m_data(size)
+		, m_latency(latency) {
+		Fill(0);
+	}
+
+	void Fill(uint8_t seed) {
+		const auto lock = std::lock_guard(m_mtx);
+		for (size_t i = 0; i < m_data.size(); ++i)
+			m_data[i] = Expected(seed, i);
+	}
+
+	static uint8_t Expected(uint8_t seed, uint64_t offset) {
+		return static_cast<uint8_t>(offset * 31 + offset / 4096 + seed);
+	}
+
+	[[nodiscard]] uint64_t StreamSize() const override {
+		return m_data.size();
+	}
+
+	uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+		std::this_thread::sleep_for(m_latency);
+		const auto lock = std::lock_guard(m_mtx);
+		if (offset >= m_data.size())
+			return 0;
+		length = std::min<uint64_t>(length, m_data.size() - offset);
+		std::copy_n(&m_data[static_cast<size_t>(offset)], static_cast<size_t>(length), static_cast<uint8_t*>(buf));
+		return length;
+	}
+};
+
+// Submits a read, and waits for it to complete.
+static uint64_t ReadThrough(Sqex::Sqpack::ReadScheduler& scheduler, const std::shared_ptr<SlowMemoryStream>& stream, uint64_t offset, void* buf, uint64_t length) {
+	std::promise<uint64_t> done;
+	scheduler.Submit(stream, offset, buf, length, [&done](uint64_t read, std::exception_ptr error) {
+		if (error)
+			done.set_exception(error);
+		else
+			done.set_value(read);
+	});
+	return done.get_future().get();
+}
+
+static size_t CountMismatches(uint8_t seed, uint64_t offset, std::span<const uint8_t> data) {
+	size_t mismatches = 0;
+	for (size_t i = 0; i < data.size(); ++i)
+		mismatches += data[i] != SlowMemoryStream::Expected(seed, offset + i);
+	return mismatches;
+}
+
+// Checks that reads through ReadScheduler return what the stream has, including after the stream content changes,
+// and compares the time taken for sequential reads against reading directly.
+int main() {
+	constexpr size_t StreamSize = 16 * 1048576;
+	constexpr size_t ChunkSize = 65536;
+	std::mt19937_64 rng(0);
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	// Sequential and random reads from several threads at once.
+	{
+		Sqex::Sqpack::ReadScheduler scheduler;
+		std::vector<std::shared_ptr<SlowMemoryStream>> streams;
+		for (auto i = 0; i < 4; ++i)
+			streams.emplace_back(std::make_shared<SlowMemoryStream>(StreamSize, std::chrono::microseconds(0)));
+
+		std::mutex failuresMtx;
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < streams.size(); ++t) {
+			threads.emplace_back([&, t, seed = rng()]() {
+				std::mt19937_64 localRng(seed);
+				std::vector<uint8_t> buf;
+				uint64_t offset = 0;
+				for (auto i = 0; i < 2000; ++i) {
+					if (localRng() % 8 == 0)
+						offset = localRng() % StreamSize;
+					const auto length = 1 + localRng() % ChunkSize;
+					buf.resize(length);
+					const auto read = ReadThrough(scheduler, streams[t], offset, buf.data(), length);
+					const auto expectedRead = std::min<uint64_t>(length, StreamSize - std::min<uint64_t>(offset, StreamSize));
+					const auto mismatches = CountMismatches(0, offset, std::span(buf).subspan(0, static_cast<size_t>(std::min(read, expectedRead))));
+
+					const auto lock = std::lock_guard(failuresMtx);
+					check(read == expectedRead, std::format("stream {} offset {} length {}: read {} bytes, expected {}", t, offset, length, read, expectedRead));
+					check(!mismatches, std::format("stream {} offset {} length {}: {} bytes differ", t, offset, length, mismatches));
+					offset = std::min<uint64_t>(offset + length, StreamSize);
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		const auto stats = scheduler.GetStatistics();
+		std::cout << std::format("Concurrent: {} reads, {} served from read-ahead\n", stats.Reads, stats.ReadAheadHits);
+	}
+
+	// Content changes after Invalidate must never be hidden behind data read ahead before it.
+	{
+		Sqex::Sqpack::ReadScheduler scheduler;
+		const auto stream = std::make_shared<SlowMemoryStream>(StreamSize, std::chrono::microseconds(200));
+		std::vector<uint8_t> buf(ChunkSize);
+		for (uint8_t seed = 0; seed < 32; ++seed) {
+			const auto base = rng() % (StreamSize / 2);
+			for (uint64_t offset = base; offset < base + 8 * ChunkSize; offset += ChunkSize) {
+				const auto read = ReadThrough(scheduler, stream, offset, buf.data(), ChunkSize);
+				const auto mismatches = CountMismatches(seed, offset, std::span(buf).subspan(0, static_cast<size_t>(read)));
+				check(read == ChunkSize && !mismatches, std::format("seed {} offset {}: read {} bytes, {} bytes differ", seed, offset, read, mismatches));
+			}
+
+			// Leave some reads in flight, the way the game would while the entries get swapped.
+			std::vector<std::vector<uint8_t>> pendingBuffers(4, std::vector<uint8_t>(ChunkSize));
+			std::atomic<size_t> pending = pendingBuffers.size();
+			for (size_t i = 0; i < pendingBuffers.size(); ++i)
+				scheduler.Submit(stream, base + (8 + i) * ChunkSize, pendingBuffers[i].data(), ChunkSize, [&pending](uint64_t, std::exception_ptr) { --pending; });
+
+			scheduler.Invalidate();
+			check(!pending, std::format("seed {}: Invalidate returned with {} reads pending", seed, pending.load()));
+			stream->Fill(static_cast<uint8_t>(seed + 1));
+
+			// Read from where the read-ahead was going to be.
+			for (uint64_t offset = base + 12 * ChunkSize; offset < base + 16 * ChunkSize; offset += ChunkSize) {
+				const auto read = ReadThrough(scheduler, stream, offset, buf.data(), ChunkSize);
+				const auto mismatches = CountMismatches(static_cast<uint8_t>(seed + 1), offset, std::span(buf).subspan(0, static_cast<size_t>(read)));
+				check(read == ChunkSize && !mismatches, std::format("seed {} offset {}: {} stale bytes after Invalidate", seed, offset, mismatches));
+			}
+		}
+	}
+	std::cout << std::format("{} failures\n", failures);
+
+	// Simulated disk latency of 200us per read.
+	for (const auto chunkSize : { 4096, 16384, 65536 }) {
+		const auto stream = std::make_shared<SlowMemoryStream>(StreamSize, std::chrono::microseconds(200));
+		std::vector<uint8_t> buf(chunkSize);
+
+		const auto start = std::chrono::steady_clock::now();
+		for (uint64_t offset = 0; offset < StreamSize / 4; offset += chunkSize)
+			stream->ReadStreamPartial(offset, buf.data(), chunkSize);
+		const auto mid = std::chrono::steady_clock::now();
+		{
+			Sqex::Sqpack::ReadScheduler scheduler;
+			for (uint64_t offset = 0; offset < StreamSize / 4; offset += chunkSize)
+				ReadThrough(scheduler, stream, offset, buf.data(), chunkSize);
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		std::cout << std::format("chunkSize={}: {:.1f}ms vs direct {:.1f}ms\n",
+			chunkSize,
+			std::chrono::duration<double, std::milli>(end - mid).count(),
+			std::chrono::duration<double, std::milli>(mid - start).count());
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Sound/Reader.h>
+#include <XivAlexanderCommon/Sqex/Sound/Writer.h>
+
+static std::vector<uint8_t> RandomBytes(std::mt19937& rng, size_t length) {
+	std::vector<uint8_t> res(length);
+	for (auto& b : res)
+		b = static_cast<uint8_t>(rng());
+	return res;
+}
+
+static std::vector<std::vector<uint8_t>> RandomTable(std::mt19937& rng, size_t count) {
+	std::vector<std::vector<uint8_t>> res;
+	for (size_t i = 0; i < count; ++i)
+		res.emplace_back(RandomBytes(rng, 4 + rng() % 256));
+	return res;
+}
+
+// Entry with aux chunks, extra data, and stream data of random sizes; sizes in the header are filled on export.
+static Sqex::Sound::ScdWriter::SoundEntry RandomEntry(std::mt19937& rng) {
+	if (rng() % 4 == 0)
+		return Sqex::Sound::ScdWriter::SoundEntry::EmptyEntry();
+
+	Sqex::Sound::ScdWriter::SoundEntry entry{
+		.Header = {
+			.ChannelCount = static_cast<uint32_t>(1 + rng() % 2),
+			.SamplingRate = 44100,
+			.Format = Sqex::Sound::SoundEntryHeader::EntryFormat_Ogg,
+		},
+		.ExtraData = RandomBytes(rng, rng() % 128),
+		.Data = RandomBytes(rng, rng() % 2 ? rng() % 64 : rng() % 65536),
+	};
+	for (auto i = rng() % 3; i; --i)
+		entry.AuxChunks.emplace(std::format("aux{}", i), RandomBytes(rng, rng() % 32));
+	return entry;
+}
+
+// Builds scd files out of random tables and sound entries, and reads their exported streams at random offsets and lengths,
+// including ranges that cross the boundaries between the head, entries, and trailing padding, and ranges past the end;
+// every read has to return what Export() has at the same place. Reading the file back has to give the same tables and entries,
+// and a file rebuilt from views into it has to be identical.
+int main() {
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	for (uint32_t seed = 0; seed < 32; ++seed) {
+		std::mt19937 rng(seed);
+
+		const auto table1And4Count = rng() % 8;
+		const auto table1 = RandomTable(rng, table1And4Count);
+		const auto table2 = RandomTable(rng, rng() % 8);
+		const auto table4 = RandomTable(rng, table1And4Count);
+
+		Sqex::Sound::ScdWriter writer;
+		writer.SetTable1(table1);
+		writer.SetTable2(table2);
+		writer.SetTable4(table4);
+
+		// Entries that are never set get written as empty ones.
+		std::vector<std::vector<uint8_t>> expectedEntries(1 + rng() % 16);
+		for (size_t i = 0; i < expectedEntries.size(); ++i) {
+			if (i + 1 < expectedEntries.size() && rng() % 8 == 0)
+				Sqex::Sound::ScdWriter::SoundEntry().ExportTo(expectedEntries[i]);
+			else {
+				const auto entry = RandomEntry(rng);
+				entry.ExportTo(expectedEntries[i]);
+				writer.SetSoundEntry(i, entry);
+			}
+		}
+
+		const auto exported = writer.Export();
+		const auto stream = writer.ExportStream();
+		check(exported.size() % 0x10 == 0 && stream->StreamSize() == exported.size(),
+			std::format("Seed {}: exported {} bytes, stream has {}", seed, exported.size(), stream->StreamSize()));
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<uint8_t> buf;
+		for (size_t i = 0; i < 4096; ++i) {
+			const auto offset = static_cast<uint64_t>(rng() % (exported.size() + 64));
+			const auto length = static_cast<uint64_t>(rng() % 4 == 0 ? rng() % exported.size() : rng() % 64);
+			buf.assign(static_cast<size_t>(length), 0xCC);
+			const auto read = stream->ReadStreamPartial(offset, buf.data(), length);
+
+			const auto expectedLength = offset >= exported.size() ? 0 : std::min<uint64_t>(length, exported.size() - offset);
+			check(read == expectedLength && std::equal(buf.begin(), buf.begin() + static_cast<ptrdiff_t>(expectedLength), exported.begin() + static_cast<ptrdiff_t>(std::min<uint64_t>(offset, exported.size()))),
+				std::format("Seed {}: read {} bytes at {}, got {} bytes that differ from Export(), expected {}", seed, length, offset, read, expectedLength));
+		}
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		const Sqex::Sound::ScdReader reader(std::make_shared<Sqex::MemoryRandomAccessStream>(exported));
+		check(reader.ReadTable1Entries() == table1 && reader.ReadTable2Entries() == table2 && reader.ReadTable4Entries() == table4,
+			std::format("Seed {}: tables read back differently", seed));
+		check(reader.GetSoundEntryCount() == expectedEntries.size(),
+			std::format("Seed {}: {} sound entries read back, expected {}", seed, reader.GetSoundEntryCount(), expectedEntries.size()));
+
+		Sqex::Sound::ScdWriter rebuilt;
+		rebuilt.SetTable1(reader.ReadTable1Entries());
+		rebuilt.SetTable2(reader.ReadTable2Entries());
+		rebuilt.SetTable4(reader.ReadTable4Entries());
+		for (size_t i = 0; i < std::min(reader.GetSoundEntryCount(), expectedEntries.size()); ++i) {
+			const auto view = reader.GetSoundEntryView(i);
+			auto actual = view.EntryStream()->ReadStreamIntoVector<uint8_t>(0);
+
+			// The last entry runs up to the end of the file, including padding.
+			if (i + 1 == expectedEntries.size() && actual.size() >= expectedEntries[i].size())
+				actual.resize(expectedEntries[i].size());
+			check(actual == expectedEntries[i], std::format("Seed {}: sound entry {} read back differently", seed, i));
+
+			const auto data = view.DataStream()->ReadStreamIntoVector<uint8_t>(0);
+			check(data.size() == view.Header().StreamSize && data.size() <= expectedEntries[i].size() && std::equal(data.begin(), data.end(), expectedEntries[i].end() - static_cast<ptrdiff_t>(data.size())),
+				std::format("Seed {}: data of sound entry {} read back differently", seed, i));
+			rebuilt.SetSoundEntry(i, view);
+		}
+		check(rebuilt.Export() == exported, std::format("Seed {}: file rebuilt from views differs", seed));
+
+		std::cout << std::format("Seed {}: {} bytes, {} sound entries; 4096 reads in {:.2f}ms\n", seed, exported.size(), expectedEntries.size(), elapsed);
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
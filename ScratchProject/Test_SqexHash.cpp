@@ -0,0 +1,62 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Sqpack.h>
+
+// Previous implementation: normalize into a copy, and run zlib's crc32 over it.
+static uint32_t SqexHashReference(const char* data, size_t len) {
+	std::string buf(data, len);
+	for (auto& c : buf) {
+		if ('A' <= c && c <= 'Z')
+			c -= 'A' - 'a';
+		else if (c == '\\')
+			c = '/';
+	}
+	return ~crc32(0, reinterpret_cast<const Bytef*>(buf.data()), static_cast<uInt>(buf.size()));
+}
+
+// Checks SqexHash against the previous implementation, and compares the time taken.
+int main() {
+	std::mt19937_64 rng(0);
+
+	// Bias towards characters that get normalized, and those next to them.
+	static constexpr char Interesting[] = "AZaz@[`{\\/._0123456789";
+	const auto randomString = [&](size_t length) {
+		std::string s(length, '\0');
+		for (auto& c : s)
+			c = rng() % 2 ? Interesting[rng() % (sizeof Interesting - 1)] : static_cast<char>(rng() % 255 + 1);
+		return s;
+	};
+
+	size_t failures = 0;
+	for (size_t i = 0; i < 2000000; ++i) {
+		const auto s = randomString(rng() % 260);
+		const auto expected = SqexHashReference(s.data(), s.size());
+		if (Sqex::Sqpack::SqexHash(s.data(), s.size()) != expected || Sqex::Sqpack::SqexHash(s.c_str()) != expected) {
+			if (failures++ < 16)
+				std::cout << std::format("Mismatch: {}\n", s);
+		}
+	}
+	std::cout << std::format("{} mismatches\n", failures);
+
+	// Typical game paths are 20-70 bytes long.
+	std::vector<std::string> paths;
+	for (size_t i = 0; i < 100000; ++i)
+		paths.emplace_back(randomString(20 + rng() % 50));
+
+	for (auto pass = 0; pass < 3; ++pass) {
+		uint32_t sink = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (const auto& path : paths)
+			sink ^= Sqex::Sqpack::SqexHash(path.data(), path.size());
+		const auto mid = std::chrono::steady_clock::now();
+		for (const auto& path : paths)
+			sink ^= SqexHashReference(path.data(), path.size());
+		const auto end = std::chrono::steady_clock::now();
+
+		std::cout << std::format("{:.1f}ns vs reference {:.1f}ns per path ({})\n",
+			std::chrono::duration<double, std::nano>(mid - start).count() / paths.size(),
+			std::chrono::duration<double, std::nano>(end - mid).count() / paths.size(),
+			sink);
+	}
+	return 0;
+}
@@ -0,0 +1,41 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Sqpack/BinaryEntryProvider.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/Creator.h>
+
+// Measures how fast Creator::WriteToFiles writes entries spanning several dat files.
+int main() {
+	constexpr size_t EntryCount = 512;
+	constexpr size_t EntrySize = 1024 * 1024;
+	constexpr uint64_t MaxFileSize = 128 * 1024 * 1024;
+
+	const auto dir = std::filesystem::temp_directory_path() / "XivAlexanderSqpackWriteTest";
+	create_directories(dir);
+
+	std::vector<std::shared_ptr<Sqex::MemoryRandomAccessStream>> sources;
+	std::mt19937 rng(0);
+	for (size_t i = 0; i < EntryCount; ++i) {
+		std::vector<uint8_t> data(EntrySize);
+		for (auto& b : data)
+			b = static_cast<uint8_t>(rng() & 0x3F);  // compressible, but not trivially
+		sources.emplace_back(std::make_shared<Sqex::MemoryRandomAccessStream>(std::move(data)));
+	}
+
+	for (const auto strict : { false, true }) {
+		Sqex::Sqpack::Creator creator("ffxiv", "0a0000", MaxFileSize);
+		for (size_t i = 0; i < EntryCount; ++i)
+			creator.AddEntry(std::make_shared<Sqex::Sqpack::MemoryBinaryEntryProvider>(Sqex::Sqpack::EntryPathSpec(std::format("bench/{}.bin", i)), sources[i], Z_NO_COMPRESSION));
+
+		const auto start = std::chrono::steady_clock::now();
+		creator.WriteToFiles(dir, strict);
+		const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		uint64_t totalSize = 0;
+		for (const auto& item : std::filesystem::directory_iterator(dir))
+			totalSize += item.file_size();
+		std::cout << std::format("strict={}: {} bytes in {:.2f}s, {:.1f}MB/s\n", strict, totalSize, elapsed, static_cast<double>(totalSize) / 1048576. / elapsed);
+	}
+
+	remove_all(dir);
+	return 0;
+}
@@ -0,0 +1,230 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Sqex/Network/XivStream.h>
+#include <XivAlexanderCommon/Utils/Oodle.h>
+#include <XivAlexanderCommon/Utils/ZlibWrapper.h>
+
+using namespace Sqex::Network::Structure;
+
+// A piece of the stream: either a bundle, or bytes that are not part of any bundle.
+struct StreamItem {
+	bool IsBundle;
+	std::vector<uint8_t> Data;
+};
+
+// What a bundle is expected to look like after being relayed.
+struct ExpectedItem {
+	bool IsBundle;
+	bool Unchanged;
+	std::vector<uint8_t> Data;
+	XivBundleHeader Header;
+	std::vector<uint8_t> DecodedBody;
+};
+
+// Messages from actors whose id is 0 modulo 5 get dropped, 1 modulo 5 get modified, and the rest are left alone.
+static bool Mangle(XivMessage* pMessage, bool& modified) {
+	if (pMessage->SourceActor % 5 == 0)
+		return false;
+	if (pMessage->SourceActor % 5 == 1) {
+		pMessage->CurrentActor ^= 0xFFFFFFFF;
+		modified = true;
+	}
+	return true;
+}
+
+static std::vector<uint8_t> MakeMessage(std::mt19937& rng) {
+	std::vector<uint8_t> message(sizeof XivMessageHeader + rng() % 512);
+	for (auto& b : message)
+		b = static_cast<uint8_t>(rng());
+	auto& header = *reinterpret_cast<XivMessageHeader*>(message.data());
+	header.Length = static_cast<uint32_t>(message.size());
+	header.Type = MessageType::Ipc;
+	return message;
+}
+
+static std::vector<uint8_t> MakeBundle(const XivBundleHeader& headerTemplate, std::span<const uint8_t> body, size_t messageCount, Utils::ZlibReusableDeflater& deflater) {
+	const auto encoded = headerTemplate.CompressionType == CompressionType::Deflate ? std::span<const uint8_t>(deflater(body)) : body;
+	auto header = headerTemplate;
+	header.TotalLength = static_cast<uint32_t>(sizeof XivBundleHeader + encoded.size());
+	header.MessageCount = static_cast<uint16_t>(messageCount);
+	header.DecodedBodyLength = static_cast<uint32_t>(body.size());
+
+	std::vector<uint8_t> bundle(header.TotalLength);
+	memcpy(&bundle[0], &header, sizeof header);
+	std::ranges::copy(encoded, bundle.begin() + sizeof header);
+	return bundle;
+}
+
+// Makes bundles of up to 32 messages, compressed with none or deflate, with bytes not belonging to any bundle in between.
+static std::vector<StreamItem> MakeStream(std::mt19937& rng, size_t bundleCount, std::vector<ExpectedItem>& expected) {
+	Utils::ZlibReusableDeflater deflater;
+	std::vector<StreamItem> items;
+	for (size_t i = 0; i < bundleCount; ++i) {
+		if (rng() % 8 == 0 && (items.empty() || items.back().IsBundle)) {
+			// Neither 0x00 nor 0x52 appear, so no part of it looks like the start of a bundle.
+			std::vector<uint8_t> trash(1 + rng() % 100);
+			for (auto& b : trash)
+				b = static_cast<uint8_t>(1 + rng() % 0x51);
+			expected.emplace_back(ExpectedItem{ false, true, trash });
+			items.emplace_back(StreamItem{ false, std::move(trash) });
+		}
+
+		XivBundleHeader header{};
+		memcpy(header.Magic, XivBundle::MagicConstant1, sizeof header.Magic);
+		header.Timestamp = static_cast<int64_t>(rng()) << 8;
+		header.ConnType = static_cast<uint16_t>(rng() % 3);
+		header.Encoding = 1;
+		header.CompressionType = rng() % 2 ? CompressionType::Deflate : CompressionType::None;
+		header.Unknown2 = static_cast<uint16_t>(rng());
+
+		std::vector<uint8_t> body, expectedBody;
+		const auto messageCount = rng() % 33;
+		size_t expectedMessageCount = 0;
+		auto unchanged = true;
+		for (size_t j = 0; j < messageCount; ++j) {
+			auto message = MakeMessage(rng);
+			body.insert(body.end(), message.begin(), message.end());
+
+			auto modified = false;
+			if (!Mangle(reinterpret_cast<XivMessage*>(message.data()), modified)) {
+				unchanged = false;
+				continue;
+			}
+			unchanged &= !modified;
+			expectedBody.insert(expectedBody.end(), message.begin(), message.end());
+			expectedMessageCount++;
+		}
+
+		items.emplace_back(StreamItem{ true, MakeBundle(header, body, messageCount, deflater) });
+		header.MessageCount = static_cast<uint16_t>(expectedMessageCount);
+		header.DecodedBodyLength = static_cast<uint32_t>(expectedBody.size());
+		expected.emplace_back(ExpectedItem{ true, unchanged, unchanged ? items.back().Data : std::vector<uint8_t>(), header, std::move(expectedBody) });
+	}
+	return items;
+}
+
+// Feeds data to a stream in pieces of random size, and drains what comes out of the other end by random amounts, the way the socket hooks do.
+static std::vector<uint8_t> Relay(std::mt19937& rng, const Utils::Oodle::OodleModule& oodleModule, std::span<const uint8_t> input, const Sqex::Network::XivStream::MessageMangler& mangler, double& elapsed) {
+	Sqex::Network::XivStream source("Source", oodleModule, false, [](const std::string& s) { std::cout << s << std::endl; });
+	Sqex::Network::XivStream target("Target", oodleModule, false, [](const std::string& s) { std::cout << s << std::endl; });
+
+	const auto randomSize = [&]() -> size_t {
+		switch (rng() % 4) {
+			case 0: return 1 + rng() % 16;
+			case 1: return 1 + rng() % 1024;
+			case 2: return 1 + rng() % 65536;
+			default: return 1 + rng() % 1048576;
+		}
+	};
+
+	std::vector<uint8_t> output;
+	output.reserve(input.size());
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < input.size() || source.Available() || target.Available();) {
+		if (i < input.size()) {
+			const auto buf = source.Allocate(std::min(randomSize(), input.size() - i));
+			std::copy_n(&input[i], buf.size(), buf.begin());
+			source.Commit(buf.size());
+			i += buf.size();
+		}
+
+		source.TunnelXivStream(target, mangler);
+
+		if (rng() % 4 || i == input.size()) {
+			const auto offset = output.size();
+			output.resize(offset + std::min(randomSize(), target.Available()));
+			target.Read(&output[offset], output.size() - offset);
+		}
+	}
+	elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return output;
+}
+
+// Splits relayed data back into bundles and bytes in between.
+static std::vector<StreamItem> SplitStream(std::span<const uint8_t> data) {
+	std::vector<StreamItem> items;
+	for (size_t i = 0; i < data.size();) {
+		if (data.size() - i >= sizeof XivBundleHeader && !memcmp(&data[i], XivBundle::MagicConstant1, sizeof XivBundle::MagicConstant1)) {
+			const auto length = std::min<size_t>(reinterpret_cast<const XivBundleHeader*>(&data[i])->TotalLength, data.size() - i);
+			items.emplace_back(StreamItem{ true, { &data[i], &data[i] + length } });
+			i += length;
+		} else {
+			if (items.empty() || items.back().IsBundle)
+				items.emplace_back(StreamItem{ false });
+			items.back().Data.push_back(data[i++]);
+		}
+	}
+	return items;
+}
+
+// Relays synthetic bundles compressed with none or deflate through XivStream, fed and drained in pieces of random size.
+// Bundles left alone must come out byte for byte identical; bundles with messages modified or dropped must decode to what is expected.
+int main() {
+	const Utils::Oodle::OodleModule oodleModule;
+	Utils::ZlibReusableInflater inflater;
+
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	for (uint32_t seed = 0; seed < 16; ++seed) {
+		std::mt19937 rng(seed);
+		std::vector<ExpectedItem> expected;
+		const auto items = MakeStream(rng, 2000, expected);
+		std::vector<uint8_t> input;
+		for (const auto& item : items)
+			input.insert(input.end(), item.Data.begin(), item.Data.end());
+
+		size_t messagesSeen = 0, totalMessages = 0;
+		for (const auto& item : items) {
+			if (item.IsBundle)
+				totalMessages += reinterpret_cast<const XivBundleHeader*>(item.Data.data())->MessageCount;
+		}
+
+		double passthroughElapsed, mangledElapsed;
+		const auto passthrough = Relay(rng, oodleModule, input, [&](XivMessage*, bool&) { messagesSeen++; return true; }, passthroughElapsed);
+		check(passthrough == input, std::format("Seed {}: data relayed without changes differs from input", seed));
+		check(messagesSeen == totalMessages, std::format("Seed {}: {} messages seen, expected {}", seed, messagesSeen, totalMessages));
+
+		const auto mangled = SplitStream(Relay(rng, oodleModule, input, Mangle, mangledElapsed));
+		check(mangled.size() == expected.size(), std::format("Seed {}: {} items relayed, expected {}", seed, mangled.size(), expected.size()));
+		for (size_t i = 0; i < std::min(mangled.size(), expected.size()); ++i) {
+			const auto& actual = mangled[i];
+			const auto& exp = expected[i];
+			if (actual.IsBundle != exp.IsBundle) {
+				check(false, std::format("Seed {} item {}: expected {}", seed, i, exp.IsBundle ? "a bundle" : "trash"));
+				continue;
+			}
+			if (exp.Unchanged) {
+				check(actual.Data == exp.Data, std::format("Seed {} item {}: changed, where it should have been relayed as-is", seed, i));
+				continue;
+			}
+
+			const auto& header = *reinterpret_cast<const XivBundleHeader*>(actual.Data.data());
+			check(header.TotalLength == actual.Data.size(), std::format("Seed {} item {}: truncated bundle", seed, i));
+			check(!memcmp(&header, &exp.Header, offsetof(XivBundleHeader, TotalLength))
+				&& header.ConnType == exp.Header.ConnType
+				&& header.MessageCount == exp.Header.MessageCount
+				&& header.Encoding == exp.Header.Encoding
+				&& header.CompressionType == exp.Header.CompressionType
+				&& header.Unknown2 == exp.Header.Unknown2
+				&& header.DecodedBodyLength == exp.Header.DecodedBodyLength,
+				std::format("Seed {} item {}: header differs", seed, i));
+			if (header.TotalLength != actual.Data.size())
+				continue;
+
+			const auto encoded = std::span(actual.Data).subspan(sizeof XivBundleHeader);
+			const auto decoded = header.CompressionType == CompressionType::Deflate ? std::span<const uint8_t>(inflater(encoded)) : encoded;
+			check(std::ranges::equal(decoded, exp.DecodedBody), std::format("Seed {} item {}: messages differ", seed, i));
+		}
+
+		std::cout << std::format("Seed {}: {} bytes, {} messages; {:.2f}ms relaying as-is, {:.2f}ms with changes\n",
+			seed, input.size(), totalMessages, passthroughElapsed, mangledElapsed);
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
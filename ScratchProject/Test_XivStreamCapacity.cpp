@@ -0,0 +1,196 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Sqex/Network/XivStream.h>
+#include <XivAlexanderCommon/Utils/Oodle.h>
+#include <XivAlexanderCommon/Utils/ZlibWrapper.h>
+
+using namespace Sqex::Network::Structure;
+
+struct StreamStats {
+	size_t SourceCapacity;
+	size_t TargetCapacity;
+	size_t SourceGrowCount;
+	size_t TargetGrowCount;
+	size_t StallCount;
+};
+
+// Bytes from 0x01 to 0x51, which never look like the start of a bundle.
+static void AppendTrash(std::mt19937& rng, std::vector<uint8_t>& data, size_t length) {
+	for (size_t i = 0; i < length; ++i)
+		data.push_back(static_cast<uint8_t>(1 + rng() % 0x51));
+}
+
+// Appends a header that starts like a bundle but claims to be too long to be one.
+static void AppendInvalidHeader(std::mt19937& rng, std::vector<uint8_t>& data) {
+	XivBundleHeader header{};
+	std::vector<uint8_t> fill;
+	AppendTrash(rng, fill, sizeof header);
+	memcpy(&header, fill.data(), sizeof header);
+	memcpy(header.Magic, XivBundle::MagicConstant1, sizeof header.Magic);
+	if (rng() % 2)
+		header.TotalLength = 0x51515151;
+	else {
+		header.TotalLength = 0x01010101 % Sqex::Network::XivStream::MaxBundleLength;
+		header.DecodedBodyLength = 0x51515151;
+	}
+	data.insert(data.end(), reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header) + sizeof header);
+}
+
+// Appends a bundle of up to 64 messages of up to 2KB each, compressed with none or deflate.
+static void AppendBundle(std::mt19937& rng, std::vector<uint8_t>& data, Utils::ZlibReusableDeflater& deflater, size_t& maxTotalLength, size_t& maxEncodedLength) {
+	std::vector<uint8_t> body;
+	const auto messageCount = rng() % 65;
+	for (size_t i = 0; i < messageCount; ++i) {
+		const auto offset = body.size();
+		body.resize(offset + sizeof XivMessageHeader + rng() % 2048);
+		for (auto j = offset; j < body.size(); ++j)
+			body[j] = static_cast<uint8_t>(rng() % 4 ? 0x20 : rng());
+		auto& header = *reinterpret_cast<XivMessageHeader*>(&body[offset]);
+		header.Length = static_cast<uint32_t>(body.size() - offset);
+		header.Type = MessageType::Ipc;
+	}
+
+	XivBundleHeader header{};
+	memcpy(header.Magic, XivBundle::MagicConstant1, sizeof header.Magic);
+	header.Timestamp = static_cast<int64_t>(rng()) << 8;
+	header.MessageCount = static_cast<uint16_t>(messageCount);
+	header.Encoding = 1;
+	header.CompressionType = rng() % 2 ? CompressionType::Deflate : CompressionType::None;
+	header.DecodedBodyLength = static_cast<uint32_t>(body.size());
+	const auto encoded = header.CompressionType == CompressionType::Deflate ? std::span<const uint8_t>(deflater(body)) : std::span<const uint8_t>(body);
+	header.TotalLength = static_cast<uint32_t>(sizeof header + encoded.size());
+
+	data.insert(data.end(), reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header) + sizeof header);
+	data.insert(data.end(), encoded.begin(), encoded.end());
+	maxTotalLength = std::max<size_t>(maxTotalLength, header.TotalLength);
+	maxEncodedLength = std::max<size_t>(maxEncodedLength, std::max<size_t>(header.TotalLength, sizeof header + compressBound(header.DecodedBodyLength)));
+}
+
+// Feeds data to a stream in pieces of random size, and drains what comes out of the other end by random amounts, the way the socket hooks do.
+static std::vector<uint8_t> Relay(std::mt19937& rng, const Utils::Oodle::OodleModule& oodleModule, size_t capacity, std::span<const uint8_t> input, StreamStats& stats) {
+	Sqex::Network::XivStream source("Source", oodleModule, false, nullptr, capacity);
+	Sqex::Network::XivStream target("Target", oodleModule, false, nullptr, capacity);
+
+	const auto randomSize = [&]() -> size_t {
+		switch (rng() % 4) {
+			case 0: return 1 + rng() % 16;
+			case 1: return 1 + rng() % 1024;
+			case 2: return 1 + rng() % 65536;
+			default: return 1 + rng() % 1048576;
+		}
+	};
+
+	std::vector<uint8_t> output;
+	output.reserve(input.size());
+	for (size_t i = 0; i < input.size() || source.Available() || target.Available();) {
+		if (i < input.size()) {
+			const auto buf = source.Allocate(std::min(randomSize(), input.size() - i));
+			std::copy_n(&input[i], buf.size(), buf.begin());
+			source.Commit(buf.size());
+			i += buf.size();
+		}
+
+		source.TunnelXivStream(target, [](XivMessage*, bool&) { return true; });
+
+		if (rng() % 4 || i == input.size()) {
+			const auto offset = output.size();
+			output.resize(offset + std::min(randomSize(), target.Available()));
+			target.Read(&output[offset], output.size() - offset);
+		}
+	}
+
+	stats = {
+		.SourceCapacity = source.Capacity(),
+		.TargetCapacity = target.Capacity(),
+		.SourceGrowCount = source.GrowCount(),
+		.TargetGrowCount = target.GrowCount(),
+		.StallCount = target.StallCount(),
+	};
+	return output;
+}
+
+// Relays data through XivStream at capacities from the smallest allowed to the default, fed and drained in pieces of random size.
+// Output must be identical to input. Streams must not grow at all for data that is not a bundle, and for bundles only as far as
+// needed to hold the largest one; writing past the free space must fail without touching the buffer.
+int main() {
+	const Utils::Oodle::OodleModule oodleModule;
+
+	size_t failures = 0;
+	const auto check = [&](bool success, const std::string& what) {
+		if (!success && failures++ < 16)
+			std::cout << what << std::endl;
+	};
+
+	for (const auto capacity : { 0, 48, 96, 1 << 27 }) {
+		try {
+			Sqex::Network::XivStream stream("Invalid", oodleModule, false, nullptr, capacity);
+			check(false, std::format("Capacity {} accepted", capacity));
+		} catch (const std::invalid_argument&) {
+			// pass
+		}
+	}
+
+	{
+		Sqex::Network::XivStream stream("Full", oodleModule, false, nullptr, 64);
+		const std::vector<uint8_t> data(48, 0x20);
+		stream.Write(data.data(), data.size());
+		try {
+			stream.Write(data.data(), data.size());
+			check(false, "Writing past the free space succeeded");
+		} catch (const std::length_error&) {
+			check(stream.Available() == data.size() && stream.Capacity() == 64, "Writing past the free space changed the stream");
+		}
+	}
+
+	for (const auto capacity : { size_t{ 64 }, size_t{ 4096 }, size_t{ 65536 }, Sqex::Network::XivStream::DefaultCapacity }) {
+		for (uint32_t seed = 0; seed < 4; ++seed) {
+			std::mt19937 rng(seed);
+
+			std::vector<uint8_t> trash;
+			while (trash.size() < 4 * 1048576) {
+				AppendTrash(rng, trash, 1 + rng() % 4096);
+				if (rng() % 4 == 0)
+					AppendInvalidHeader(rng, trash);
+			}
+			AppendTrash(rng, trash, sizeof XivBundleHeader);
+
+			StreamStats trashStats{};
+			const auto trashStart = std::chrono::steady_clock::now();
+			check(Relay(rng, oodleModule, capacity, trash, trashStats) == trash, std::format("Capacity {} seed {}: data without bundles changed", capacity, seed));
+			const auto trashElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - trashStart).count();
+			check(!trashStats.SourceGrowCount && !trashStats.TargetGrowCount && trashStats.SourceCapacity == capacity && trashStats.TargetCapacity == capacity,
+				std::format("Capacity {} seed {}: grew without bundles, to {} and {}", capacity, seed, trashStats.SourceCapacity, trashStats.TargetCapacity));
+
+			Utils::ZlibReusableDeflater deflater;
+			std::vector<uint8_t> bundles;
+			size_t maxTotalLength = 0, maxEncodedLength = 0;
+			while (bundles.size() < 16 * 1048576) {
+				AppendBundle(rng, bundles, deflater, maxTotalLength, maxEncodedLength);
+				if (rng() % 8 == 0)
+					AppendTrash(rng, bundles, 1 + rng() % 100);
+			}
+
+			StreamStats bundleStats{};
+			const auto bundleStart = std::chrono::steady_clock::now();
+			check(Relay(rng, oodleModule, capacity, bundles, bundleStats) == bundles, std::format("Capacity {} seed {}: bundles changed", capacity, seed));
+			const auto bundleElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bundleStart).count();
+
+			const auto expectedSourceCapacity = std::max(capacity, std::bit_ceil(maxTotalLength));
+			const auto expectedTargetCapacity = std::max(capacity, std::bit_ceil(maxEncodedLength));
+			check(bundleStats.SourceCapacity == expectedSourceCapacity && bundleStats.TargetCapacity == expectedTargetCapacity,
+				std::format("Capacity {} seed {}: grew to {} and {}, expected {} and {}", capacity, seed,
+					bundleStats.SourceCapacity, bundleStats.TargetCapacity, expectedSourceCapacity, expectedTargetCapacity));
+			check(bundleStats.SourceGrowCount <= static_cast<size_t>(std::countr_zero(expectedSourceCapacity / capacity))
+				&& bundleStats.TargetGrowCount <= static_cast<size_t>(std::countr_zero(expectedTargetCapacity / capacity)),
+				std::format("Capacity {} seed {}: grew {} and {} times", capacity, seed, bundleStats.SourceGrowCount, bundleStats.TargetGrowCount));
+
+			std::cout << std::format("Capacity {} seed {}: {:.2f}ms for {} bytes without bundles; {:.2f}ms for {} bytes of bundles, grown to {} and {} in {} and {} steps, {} stalls\n",
+				capacity, seed, trashElapsed, trash.size(), bundleElapsed, bundles.size(),
+				bundleStats.SourceCapacity, bundleStats.TargetCapacity, bundleStats.SourceGrowCount, bundleStats.TargetGrowCount, bundleStats.StallCount);
+		}
+	}
+
+	std::cout << std::format("{} failures\n", failures);
+	return failures ? 1 : 0;
+}
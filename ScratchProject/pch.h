@@ -11,6 +11,15 @@
 #include <numeric>
 #include <regex>
 #include <set>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
 
 #define NOMINMAX
 #include <Windows.h>
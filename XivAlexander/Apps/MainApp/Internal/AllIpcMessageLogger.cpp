@@ -19,7 +19,7 @@ struct XivAlexander::Apps::MainApp::Internal::AllIpcMessageLogger::Implementatio
 			: Impl(impl)
 			, Conn(conn) {
 
-			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage) {
+			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage, bool&) {
 				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
 					const char* pszPossibleMessageType;
 					switch (pMessage->Length) {
@@ -56,7 +56,7 @@ struct XivAlexander::Apps::MainApp::Internal::AllIpcMessageLogger::Implementatio
 				}
 				return true;
 				});
-			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage) {
+			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage, bool&) {
 				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
 					const char* pszPossibleMessageType;
 					switch (pMessage->Length) {
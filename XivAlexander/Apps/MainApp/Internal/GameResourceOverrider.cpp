@@ -2,6 +2,7 @@
 #include "Apps/MainApp/Internal/GameResourceOverrider.h"
 
 #include <XivAlexanderCommon/Sqex/SeString.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/ReadScheduler.h>
 #include <XivAlexanderCommon/Utils/Win32/Process.h>
 
 #include "Apps/MainApp/Internal/VirtualSqPacks.h"
@@ -11,6 +12,9 @@
 #include "Misc/Logger.h"
 #include "XivAlexander.h"
 
+// STATUS_IO_DEVICE_ERROR from ntstatus.h, which conflicts with Windows.h.
+static constexpr ULONG_PTR StatusIoDeviceError = 0xC0000185L;
+
 class AntiReentry {
 	std::mutex m_lock;
 	std::set<DWORD> m_tids;
@@ -50,6 +54,86 @@ public:
 	};
 };
 
+// Remembers what the path hash hook did for a given input, as the game keeps hashing the same few thousand paths.
+class PathHashMemo {
+public:
+	static constexpr size_t MaxEntries = 65536;
+
+	struct Result {
+		size_t Hash;
+		std::string Rewritten;  // empty if the path is left as is
+		std::string Description;
+	};
+
+private:
+	struct Key {
+		uint32_t InitVal;
+		std::string Path;
+	};
+
+	struct KeyView {
+		uint32_t InitVal;
+		std::string_view Path;
+	};
+
+	struct KeyHash {
+		using is_transparent = void;
+
+		size_t operator()(const KeyView& k) const noexcept {
+			const auto h = std::hash<std::string_view>()(k.Path);
+			return h ^ (std::hash<uint32_t>()(k.InitVal) + 0x9e3779b9 + (h << 6) + (h >> 2));
+		}
+
+		size_t operator()(const Key& k) const noexcept {
+			return (*this)(KeyView{k.InitVal, k.Path});
+		}
+	};
+
+	struct KeyEqual {
+		using is_transparent = void;
+
+		template<typename L, typename R>
+		bool operator()(const L& l, const R& r) const noexcept {
+			return l.InitVal == r.InitVal && std::string_view(l.Path) == std::string_view(r.Path);
+		}
+	};
+
+	mutable std::shared_mutex m_mtx;
+	std::unordered_map<Key, Result, KeyHash, KeyEqual> m_items;
+	uint64_t m_generation = 0;
+
+public:
+	// Pass the value to Put, so that results computed across a call to Clear get discarded.
+	[[nodiscard]] uint64_t Generation() const {
+		const auto lock = std::shared_lock(m_mtx);
+		return m_generation;
+	}
+
+	[[nodiscard]] bool Find(uint32_t initVal, std::string_view path, Result& result) const {
+		const auto lock = std::shared_lock(m_mtx);
+		const auto it = m_items.find(KeyView{initVal, path});
+		if (it == m_items.end())
+			return false;
+		result = it->second;
+		return true;
+	}
+
+	void Put(uint64_t generation, uint32_t initVal, std::string_view path, Result result) {
+		const auto lock = std::unique_lock(m_mtx);
+		if (generation != m_generation)
+			return;
+		if (m_items.size() >= MaxEntries)
+			m_items.clear();
+		m_items.insert_or_assign(Key{initVal, std::string(path)}, std::move(result));
+	}
+
+	void Clear() {
+		const auto lock = std::unique_lock(m_mtx);
+		m_items.clear();
+		++m_generation;
+	}
+};
+
 struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementation {
 	Apps::MainApp::App& App;
 	const std::shared_ptr<XivAlexander::Config> Config;
@@ -60,6 +144,7 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 
 	std::vector<std::unique_ptr<Misc::Hooks::PointerFunction<size_t, uint32_t, const char*, size_t>>> FoundPathHashFunctions{};
 	std::vector<std::unique_ptr<Misc::Hooks::PointerFunction<const char8_t*, const char8_t*>>> FoundStringIndirectionResolverFunctions{};
+	PathHashMemo PathHashResults;
 	std::vector<std::string> LastLoggedPaths;
 	std::mutex LastLoggedPathMtx;
 	Utils::CallOnDestruction::Multiple Cleanup;
@@ -95,6 +180,9 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 				return;
 			}
 
+			// Paths hashed so far have not been checked against virtual sqpack entries.
+			PathHashResults.Clear();
+
 			OnVirtualSqPacksInitialized();
 
 			});
@@ -114,8 +202,10 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 					!hTemplateFile) {
 
 					VirtualSqPackInitThread.Wait();
-					if (const auto res = Sqpacks ? Sqpacks->Open(lpFileName) : nullptr)
+					if (const auto res = Sqpacks ? Sqpacks->Open(lpFileName) : nullptr) {
+						Sqpacks->Get(res)->Overlapped = !!(dwFlagsAndAttributes & FILE_FLAG_OVERLAPPED);
 						return res;
+					}
 				}
 
 				return CreateFileW.bridge(lpFileName, dwDesiredAccess, dwShareMode, lpSecurityAttributes, dwCreationDisposition, dwFlagsAndAttributes, hTemplateFile);
@@ -124,8 +214,11 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 		Cleanup += CloseHandle.SetHook([this](
 			HANDLE handle
 		) {
-				if (Sqpacks && Sqpacks->Close(handle))
+				if (const auto pvpath = Sqpacks ? Sqpacks->Get(handle) : nullptr) {
+					Sqpacks->GetReadScheduler().Forget(pvpath->Stream.get());
+					Sqpacks->Close(handle);
 					return 0;
+				}
 
 				return CloseHandle.bridge(handle);
 			});
@@ -142,6 +235,49 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 					try {
 						Sqpacks->MarkIoRequest();
 						const auto fp = lpOverlapped ? ((static_cast<uint64_t>(lpOverlapped->OffsetHigh) << 32) | lpOverlapped->Offset) : vpath.FilePointer.QuadPart;
+
+						if (lpOverlapped && vpath.Overlapped) {
+							// Low bit of hEvent only tells not to post to the completion port.
+							// Without an event, there is nothing to signal; a virtual handle is not a kernel object, and may be closed before the read completes.
+							const auto hEvent = reinterpret_cast<HANDLE>(reinterpret_cast<size_t>(lpOverlapped->hEvent) & ~static_cast<size_t>(1));
+							if (hEvent)
+								ResetEvent(hEvent);
+							lpOverlapped->Internal = STATUS_PENDING;
+							lpOverlapped->InternalHigh = 0;
+							if (lpNumberOfBytesRead)
+								*lpNumberOfBytesRead = 0;
+
+							Sqpacks->GetReadScheduler().Submit(vpath.Stream, fp, lpBuffer, nNumberOfBytesToRead, [this, lpOverlapped, hEvent, nNumberOfBytesToRead, path = vpath.Path, stream = vpath.Stream](uint64_t read, std::exception_ptr error) {
+								if (error) {
+									try {
+										std::rethrow_exception(error);
+									} catch (const std::exception& e) {
+										Logger->Format<LogLevel::Warning>(LogCategory::GameResourceOverrider, L"ReadFile: {}, Message: {}",
+											path.filename(), e.what());
+									} catch (...) {
+										Logger->Format<LogLevel::Warning>(LogCategory::GameResourceOverrider, L"ReadFile: {}, Message: unknown error",
+											path.filename());
+									}
+								} else if (read != nNumberOfBytesToRead) {
+									Logger->Format<LogLevel::Warning>(LogCategory::GameResourceOverrider, L"ReadFile: {}, requested {} bytes, read {} bytes; state: {}",
+										path.filename(), nNumberOfBytesToRead, read, stream->DescribeState());
+								} else if (Config->Runtime.LogAllDataFileRead) {
+									Logger->Format<LogLevel::Info>(LogCategory::GameResourceOverrider, L"ReadFile: {}, requested {} bytes; state: {}",
+										path.filename(), nNumberOfBytesToRead, stream->DescribeState());
+								}
+
+								// Internal must be written last; the game may poll it via HasOverlappedIoCompleted.
+								lpOverlapped->InternalHigh = error ? 0 : static_cast<ULONG_PTR>(read);
+								MemoryBarrier();
+								lpOverlapped->Internal = error ? StatusIoDeviceError : 0;
+								if (hEvent)
+									SetEvent(hEvent);
+							});
+
+							SetLastError(ERROR_IO_PENDING);
+							return FALSE;
+						}
+
 						const auto read = vpath.Stream->ReadStreamPartial(fp, lpBuffer, nNumberOfBytesToRead);
 
 						if (lpNumberOfBytesRead)
@@ -234,6 +370,9 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 			});
 
 
+		Cleanup += Config->Runtime.ResourceLanguageOverride.OnChange([this]() { PathHashResults.Clear(); });
+		Cleanup += Config->Runtime.VoiceResourceLanguageOverride.OnChange([this]() { PathHashResults.Clear(); });
+
 		for (auto ptr : Utils::Signatures::LookupForData(Utils::Signatures::SectionFilterTextOnly,
 				"\x40\x57\x48\x8d\x3d\x00\x00\x00\x00\x00\x8b\xd8\x4c\x8b\xd2\xf7\xd1\x00\x85\xc0\x74\x00\x41\xf6\xc2\x03\x74\x00\x41\x0f\xb6\x12\x8b\xc1",
 				"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF",
@@ -245,76 +384,23 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 				reinterpret_cast<size_t(__stdcall*)(uint32_t, const char*, size_t)>(ptr)
 			));
 			Cleanup += FoundPathHashFunctions.back()->SetHook([this, ptr, self = FoundPathHashFunctions.back().get()](uint32_t initVal, const char* str, size_t len) {
-				if (!str || !*str || len >= 512 || !MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, static_cast<int>(len), nullptr, 0))
+				if (!str || !*str || len >= 512)
 					return self->bridge(initVal, str, len);
 
-				auto name = std::string(str);
-				std::string ext, rest;
-				if (const auto i1 = name.find_first_of('.'); i1 != std::string::npos) {
-					ext = name.substr(i1);
-					name.resize(i1);
-					if (const auto i2 = ext.find_first_of('.', 1); i2 != std::string::npos) {
-						rest = ext.substr(i2);
-						ext.resize(i2);
-					}
-				}
-
-				const auto nameLower = [&name]() {
-					auto val = Utils::FromUtf8(name);
-					CharLowerW(&val[0]);
-					return Utils::ToUtf8(val);
-				}();
-
-				const auto extLower = [&ext]() {
-					auto val = Utils::FromUtf8(ext);
-					CharLowerW(&val[0]);
-					return Utils::ToUtf8(val);
-				}();
-
-				auto overrideLanguage = Sqex::Language::Unspecified;
-				if (extLower == ".scd") {
-					if (nameLower.starts_with("cut/") || nameLower.starts_with("sound/voice/vo_line"))
-						overrideLanguage = Config->Runtime.VoiceResourceLanguageOverride;
-				} else {
-					overrideLanguage = Config->Runtime.ResourceLanguageOverride;
+				PathHashMemo::Result result;
+				if (str[len] || !PathHashResults.Find(initVal, std::string_view(str, len), result)) {
+					const auto generation = PathHashResults.Generation();
+					result = ResolvePathHash(*self, initVal, str, len);
+					if (!str[len])
+						PathHashResults.Put(generation, initVal, std::string_view(str, len), result);
 				}
 
-				std::string description;
-				if (overrideLanguage != Sqex::Language::Unspecified) {
-					const char* languageCodes[] = {"ja", "en", "de", "fr", "chs", "cht", "ko"};
-					const auto targetLanguageCode = languageCodes[static_cast<int>(overrideLanguage) - 1];
-
-					std::string newName;
-					if (nameLower.starts_with("ui/uld/logo")) {
-						// do nothing, as overriding this often freezes the game
-					} else {
-						for (const auto languageCode : languageCodes) {
-							char t[16];
-							sprintf_s(t, "_%s", languageCode);
-							if (nameLower.ends_with(t)) {
-								newName = name.substr(0, name.size() - strlen(languageCode)) + targetLanguageCode;
-								break;
-							}
-							sprintf_s(t, "/%s/", languageCode);
-							if (const auto pos = nameLower.find(t); pos != std::string::npos) {
-								newName = std::format("{}/{}/{}", name.substr(0, pos), targetLanguageCode, name.substr(pos + strlen(t)));
-								break;
-							}
-							sprintf_s(t, "_%s_", languageCode);
-							if (const auto pos = nameLower.find(t); pos != std::string::npos) {
-								newName = std::format("{}_{}_{}", name.substr(0, pos), targetLanguageCode, name.substr(pos + strlen(t)));
-								break;
-							}
-						}
-					}
-					if (!newName.empty() && name != newName && Sqpacks && Sqpacks->EntryExists(std::format("{}{}", newName, ext))) {
-						const auto newStr = std::format("{}{}{}", newName, ext, rest);
-						description = std::format("{} => {}", std::string_view(str, len), newStr);
-						Utils::Win32::Process::Current().WriteMemory(const_cast<char*>(str), newStr.c_str(), newStr.size() + 1, true);
-						len = newStr.size();
-					}
+				if (!result.Rewritten.empty()) {
+					Utils::Win32::Process::Current().WriteMemory(const_cast<char*>(str), result.Rewritten.c_str(), result.Rewritten.size() + 1, true);
+					len = result.Rewritten.size();
 				}
-				const auto res = self->bridge(initVal, str, len);
+				const auto res = result.Hash;
+				const auto& description = result.Description;
 
 				if (Config->Runtime.UseHashTrackerKeyLogging || !description.empty()) {
 					auto current = std::string(str, len);
@@ -399,6 +485,82 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 		};
 	}
 
+	// Figures out which path the game should be actually hashing, and hashes it, without modifying the string passed from the game.
+	PathHashMemo::Result ResolvePathHash(Misc::Hooks::PointerFunction<size_t, uint32_t, const char*, size_t>& fn, uint32_t initVal, const char* str, size_t len) {
+		if (!MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, static_cast<int>(len), nullptr, 0))
+			return {.Hash = fn.bridge(initVal, str, len)};
+
+		auto name = std::string(str);
+		std::string ext, rest;
+		if (const auto i1 = name.find_first_of('.'); i1 != std::string::npos) {
+			ext = name.substr(i1);
+			name.resize(i1);
+			if (const auto i2 = ext.find_first_of('.', 1); i2 != std::string::npos) {
+				rest = ext.substr(i2);
+				ext.resize(i2);
+			}
+		}
+
+		const auto nameLower = [&name]() {
+			auto val = Utils::FromUtf8(name);
+			CharLowerW(&val[0]);
+			return Utils::ToUtf8(val);
+		}();
+
+		const auto extLower = [&ext]() {
+			auto val = Utils::FromUtf8(ext);
+			CharLowerW(&val[0]);
+			return Utils::ToUtf8(val);
+		}();
+
+		auto overrideLanguage = Sqex::Language::Unspecified;
+		if (extLower == ".scd") {
+			if (nameLower.starts_with("cut/") || nameLower.starts_with("sound/voice/vo_line"))
+				overrideLanguage = Config->Runtime.VoiceResourceLanguageOverride;
+		} else {
+			overrideLanguage = Config->Runtime.ResourceLanguageOverride;
+		}
+
+		PathHashMemo::Result result{};
+		if (overrideLanguage != Sqex::Language::Unspecified) {
+			const char* languageCodes[] = {"ja", "en", "de", "fr", "chs", "cht", "ko"};
+			const auto targetLanguageCode = languageCodes[static_cast<int>(overrideLanguage) - 1];
+
+			std::string newName;
+			if (nameLower.starts_with("ui/uld/logo")) {
+				// do nothing, as overriding this often freezes the game
+			} else {
+				for (const auto languageCode : languageCodes) {
+					char t[16];
+					sprintf_s(t, "_%s", languageCode);
+					if (nameLower.ends_with(t)) {
+						newName = name.substr(0, name.size() - strlen(languageCode)) + targetLanguageCode;
+						break;
+					}
+					sprintf_s(t, "/%s/", languageCode);
+					if (const auto pos = nameLower.find(t); pos != std::string::npos) {
+						newName = std::format("{}/{}/{}", name.substr(0, pos), targetLanguageCode, name.substr(pos + strlen(t)));
+						break;
+					}
+					sprintf_s(t, "_%s_", languageCode);
+					if (const auto pos = nameLower.find(t); pos != std::string::npos) {
+						newName = std::format("{}_{}_{}", name.substr(0, pos), targetLanguageCode, name.substr(pos + strlen(t)));
+						break;
+					}
+				}
+			}
+			if (!newName.empty() && name != newName && Sqpacks && Sqpacks->EntryExists(std::format("{}{}", newName, ext))) {
+				result.Rewritten = std::format("{}{}{}", newName, ext, rest);
+				result.Description = std::format("{} => {}", std::string_view(str, len), result.Rewritten);
+			}
+		}
+
+		result.Hash = result.Rewritten.empty()
+			? fn.bridge(initVal, str, len)
+			: fn.bridge(initVal, result.Rewritten.c_str(), result.Rewritten.size());
+		return result;
+	}
+
 	~Implementation() {
 		Cleanup.Clear();
 	}
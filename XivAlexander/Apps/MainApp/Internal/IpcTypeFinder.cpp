@@ -19,7 +19,7 @@ struct XivAlexander::Apps::MainApp::Internal::IpcTypeFinder::Implementation {
 			: Impl(pImpl)
 			, Conn(conn) {
 
-			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage) {
+			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage, bool&) {
 				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
 					if (pMessage->CurrentActor == pMessage->SourceActor) {
 						if (pMessage->Length == 0x9c ||
@@ -117,7 +117,7 @@ struct XivAlexander::Apps::MainApp::Internal::IpcTypeFinder::Implementation {
 				}
 				return true;
 			});
-			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage) {
+			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage, bool&) {
 				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
 					if (pMessage->Length == 0x40) {
 						// Test ActionRequest
@@ -54,7 +54,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 
 			Impl.LastCooldownGroup.clear();
 
-			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage) {
+			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage, bool&) {
 				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
 					if (pMessage->Data.Ipc.SubType == gameConfig.C2S_ActionRequest[0]
 						|| pMessage->Data.Ipc.SubType == gameConfig.C2S_ActionRequest[1]) {
@@ -88,7 +88,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 				}
 				return true;
 				});
-			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage) {
+			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage, bool& modified) {
 				const auto nowUs = Utils::QpcUs();
 
 				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::CustomType) {
@@ -184,6 +184,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 
 								if (!runtimeConfig.UseHighLatencyMitigationPreviewMode) {
 									actionEffect.AnimationLockDurationUs(0);
+									modified = true;
 									if (LatestSuccessfulRequest)
 										LatestSuccessfulRequest->WaitTimeUs = -LatestSuccessfulRequest->OriginalWaitUs;
 								}
@@ -193,6 +194,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 
 								if (!runtimeConfig.UseHighLatencyMitigationPreviewMode) {
 									actionEffect.AnimationLockDurationUs(waitUs);
+									modified = true;
 									if (LatestSuccessfulRequest)
 										LatestSuccessfulRequest->WaitTimeUs = waitUs - originalWaitUs;
 								}
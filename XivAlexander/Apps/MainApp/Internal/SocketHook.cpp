@@ -2,8 +2,8 @@
 #include "SocketHook.h"
 
 #include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Sqex/Network/XivStream.h>
 #include <XivAlexanderCommon/Utils/Oodle.h>
-#include <XivAlexanderCommon/Utils/ZlibWrapper.h>
 
 #include "Apps/MainApp/App.h"
 #include "Config.h"
@@ -13,189 +13,10 @@
 
 using namespace Sqex::Network::Structure;
 
-class XivAlexander::Apps::MainApp::Internal::SingleConnection::SingleStream {
-	Misc::Logger& m_logger;
-	const std::string m_name;
-	Utils::ZlibReusableDeflater m_deflater;
-	Utils::ZlibReusableInflater m_inflater;
-	Utils::Oodle::Oodler m_oodler, m_unoodler;
-
-	std::vector<uint8_t> m_buffer{};
-	size_t m_pointer = 0;
-
+class XivAlexander::Apps::MainApp::Internal::SingleConnection::SingleStream : public Sqex::Network::XivStream {
 public:
-	class SingleStreamWriter {
-		SingleStream& m_stream;
-		const size_t m_offset;
-		size_t m_commitLength = 0;
-
-	public:
-		SingleStreamWriter(SingleStream& stream)
-			: m_stream(stream)
-			, m_offset(stream.m_buffer.size()) {
-		}
-
-		template<typename T>
-		T* Allocate(size_t length) {
-			m_stream.m_buffer.resize(m_offset + m_commitLength + length);
-			return reinterpret_cast<T*>(&m_stream.m_buffer[m_offset + m_commitLength]);
-		}
-
-		size_t Write(size_t length) {
-			m_commitLength += length;
-			return length;
-		}
-
-		~SingleStreamWriter() {  // NOLINT(bugprone-exception-escape)
-			m_stream.m_buffer.resize(m_offset + m_commitLength);
-		}
-	};
-
 	SingleStream(Misc::Logger& logger, std::string name, const Utils::Oodle::OodleModule& oodleModule, bool oodleTcp)
-		: m_logger(logger)
-		, m_name(std::move(name))
-		, m_oodler(oodleModule, !oodleTcp)
-		, m_unoodler(oodleModule, !oodleTcp) {
-	}
-
-	SingleStreamWriter Write() {
-		return { *this };
-	}
-
-	void Write(const void* buf, size_t length) {
-		const auto uint8buf = static_cast<const uint8_t*>(buf);
-		m_buffer.insert(m_buffer.end(), uint8buf, uint8buf + length);
-	}
-
-	template<typename T, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
-	void Write(const T& data) {
-		Write(&data, sizeof data);
-	}
-
-	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
-	void Write(const std::span<T>& data) {
-		Write(data.data(), data.size_bytes());
-	}
-
-	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
-	[[nodiscard]] std::span<const T> Peek(size_t count = SIZE_MAX) const {
-		if (m_buffer.empty())
-			return {};
-		return {
-			reinterpret_cast<const T*>(&m_buffer[m_pointer]),
-			count == SIZE_MAX ? (m_buffer.size() - m_pointer) / sizeof(T) : count
-		};
-	}
-
-	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
-	void Consume(size_t count) {
-		m_pointer += count * sizeof(T);
-		if (m_pointer == m_buffer.size()) {
-			m_buffer.clear();
-			m_pointer = 0;
-		} else if (m_pointer > m_buffer.size()) {
-			m_buffer.clear();
-			m_pointer = 0;
-			m_logger.Log(LogCategory::SocketHook, "SingleStream: overconsuming", LogLevel::Warning);
-		}
-	}
-
-	template<typename T, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
-	size_t Read(T* buf, size_t count) {
-		count = std::min(count, (m_buffer.size() - m_pointer) / sizeof(T));
-		memcpy(buf, &m_buffer[m_pointer], count * sizeof(T));
-		Consume<T>(count);
-		return count;
-	}
-
-	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
-	[[nodiscard]] size_t Available() const {
-		return (m_buffer.size() - m_pointer) / sizeof(T);
-	}
-
-	void TunnelXivStream(SingleStream& target, const XivAlexander::Apps::MainApp::Internal::SingleConnection::MessageMangler& messageMangler) {
-		while (true) {
-			auto buf = Peek();
-			if (buf.empty())
-				break;
-
-			if (const auto trash = XivBundle::ExtractFrontTrash(buf); !trash.empty()) {
-				target.Write(trash);
-				Consume(trash.size_bytes());
-				buf = buf.subspan(trash.size_bytes());
-			}
-
-			// Incomplete header
-			if (buf.size_bytes() < sizeof XivBundleHeader)
-				break;
-
-			const auto* pGamePacket = reinterpret_cast<const XivBundle*>(buf.data());
-
-			// Invalid TotalLength
-			if (pGamePacket->TotalLength == 0) {
-				target.Write(buf.subspan(0, 1));
-				Consume(1);
-				continue;
-			}
-
-			// Incomplete data
-			if (buf.size_bytes() < pGamePacket->TotalLength)
-				break;
-
-			try {
-				auto messages = pGamePacket->GetMessages(m_inflater, m_unoodler);
-				auto header = *pGamePacket;
-				header.TotalLength = static_cast<uint32_t>(sizeof XivBundleHeader);
-				header.MessageCount = 0;
-				header.CompressionType = pGamePacket->CompressionType;
-				header.DecodedBodyLength = 0;
-
-				for (auto& message : messages) {
-					const auto pMessage = reinterpret_cast<XivMessage*>(&message[0]);
-
-					if (!messageMangler(pMessage))
-						pMessage->Length = 0;
-
-					if (!pMessage->Length)
-						continue;
-
-					header.DecodedBodyLength += pMessage->Length;
-					header.MessageCount += 1;
-				}
-
-				std::vector<uint8_t> body;
-				body.reserve(header.DecodedBodyLength);
-				for (const auto& message : messages) {
-					if (!reinterpret_cast<const XivMessage*>(&message[0])->Length)
-						continue;
-					body.insert(body.end(), message.begin(), message.end());
-				}
-
-				std::span<uint8_t> encoded;
-				switch (header.CompressionType) {
-					case CompressionType::None:
-						encoded = { body };
-						break;
-					case CompressionType::Deflate:
-						encoded = m_deflater(body);
-						break;
-					case CompressionType::Oodle:
-						encoded = m_oodler.Encode(body);
-						break;
-					default:
-						throw std::runtime_error("Unsupported compression method");
-				}
-
-				header.TotalLength += static_cast<uint32_t>(encoded.size());
-				target.Write(&header, sizeof XivBundleHeader);
-				target.Write(encoded);
-			} catch (const std::exception& e) {
-				m_logger.Format<XivAlexander::LogLevel::Warning>(XivAlexander::LogCategory::SocketHook, "{}: Error: {}\n{}", m_name, e.what(), pGamePacket->Represent());
-				target.Write(pGamePacket, pGamePacket->TotalLength);
-			}
-
-			Consume(pGamePacket->TotalLength);
-		}
+		: XivStream(std::move(name), oodleModule, oodleTcp, [&logger](const std::string& s) { logger.Log(LogCategory::SocketHook, s, LogLevel::Warning); }) {
 	}
 };
 
@@ -252,27 +73,35 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 	void ResolveAddresses();
 
 	void AttemptReceive() {
-		if (auto write = RecvRaw.Write();
-			!write.Write(std::max(0, SocketHook.recv.bridge(SingleConnection.m_socket, write.Allocate<char>(65536), 65536, 0))))
-			return;
+		if (const auto buf = RecvRaw.Allocate(65536); buf.empty()) {
+			// Leave data in the socket until the game catches up.
+			RecvRaw.Stall();
+		} else if (const auto read = SocketHook.recv.bridge(SingleConnection.m_socket, reinterpret_cast<char*>(buf.data()), static_cast<int>(buf.size()), 0); read > 0) {
+			RecvRaw.Commit(read);
+		}
 
 		ProcessRecvData();
 	}
 
 	void AttemptSend() {
-		const auto data = SendProcessed.Peek<char>();
-		if (data.empty())
-			return;
+		// Data wrapping around the end of the buffer comes in two pieces.
+		for (auto data = SendProcessed.Peek<char>(); !data.empty(); data = SendProcessed.Peek<char>()) {
+			const auto sent = SocketHook.send.bridge(SingleConnection.m_socket, data.data(), static_cast<int>(data.size_bytes()), 0);
+			if (sent == SOCKET_ERROR)
+				break;
 
-		const auto sent = SocketHook.send.bridge(SingleConnection.m_socket, data.data(), static_cast<int>(data.size_bytes()), 0);
-		if (sent == SOCKET_ERROR)
-			return;
+			SendProcessed.Consume(sent);
+			if (static_cast<size_t>(sent) < data.size_bytes())
+				break;
+		}
 
-		SendProcessed.Consume(sent);
+		// Pick up what has been held back while SendProcessed was full.
+		if (SendRaw.Available())
+			ProcessSendData();
 	}
 
 	void ProcessRecvData() {
-		RecvRaw.TunnelXivStream(RecvProcessed, [&](auto* pMessage) {
+		RecvRaw.TunnelXivStream(RecvProcessed, [&](auto* pMessage, bool& modified) {
 			auto use = true;
 
 			switch (pMessage->Type) {
@@ -294,7 +123,7 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 				case MessageType::Ipc:
 					for (const auto& cbs : IncomingHandlers) {
 						for (const auto& cb : cbs.second) {
-							use &= cb(pMessage);
+							use &= cb(pMessage, modified);
 						}
 					}
 			}
@@ -304,7 +133,7 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 	}
 
 	void ProcessSendData() {
-		SendRaw.TunnelXivStream(SendProcessed, [&](auto* pMessage) {
+		SendRaw.TunnelXivStream(SendProcessed, [&](auto* pMessage, bool& modified) {
 			auto use = true;
 
 			switch (pMessage->Type) {
@@ -315,7 +144,7 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 				case MessageType::Ipc:
 					for (const auto& cbs : OutgoingHandlers) {
 						for (const auto& cb : cbs.second) {
-							use &= cb(pMessage);
+							use &= cb(pMessage, modified);
 						}
 					}
 			}
@@ -454,6 +283,9 @@ struct XivAlexander::Apps::MainApp::Internal::SocketHook::Implementation {
 	decltype(Sockets.end()) CleanupSocket(decltype(Sockets.end()) it) {
 		if (it == Sockets.end())
 			return it;
+		const auto& impl = *it->second->m_pImpl;
+		SocketHook.m_logger->Format(LogCategory::SocketHook, "{:x}: Buffers: {}, {}, {}, {}", it->first,
+			impl.RecvRaw.DescribeUsage(), impl.RecvProcessed.DescribeUsage(), impl.SendRaw.DescribeUsage(), impl.SendProcessed.DescribeUsage());
 		SocketHook.OnSocketGone(*it->second);
 		return Sockets.erase(it);
 	}
@@ -611,10 +443,19 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App
 							if (conn == nullptr)
 								return send.bridge(s, buf, len, flags);
 
-							conn->m_pImpl->SendRaw.Write(buf, len);
+							// Take only what fits, and let the game retry the rest as it would on a full socket buffer.
+							const auto accepted = std::min<size_t>(len, conn->m_pImpl->SendRaw.Free());
+							if (!accepted) {
+								conn->m_pImpl->SendRaw.Stall();
+								conn->m_pImpl->AttemptSend();
+								WSASetLastError(WSAEWOULDBLOCK);
+								return SOCKET_ERROR;
+							}
+
+							conn->m_pImpl->SendRaw.Write(buf, accepted);
 							conn->m_pImpl->ProcessSendData();
 							conn->m_pImpl->AttemptSend();
-							return len;
+							return static_cast<int>(accepted);
 							}).Wrap([&app](auto fn) { app.RunOnGameLoop(std::move(fn)); }));
 
 						m_pImpl->Cleanup += std::move(recv.SetHook([&](SOCKET s, char* buf, int len, int flags) {
@@ -655,6 +496,8 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App
 
 								if (FD_ISSET(s, &readfds_temp))
 									conn->m_pImpl->AttemptReceive();
+								else if (conn->m_pImpl->RecvRaw.Available())
+									conn->m_pImpl->ProcessRecvData();
 
 								if (conn->m_pImpl->RecvProcessed.Available())
 									FD_SET(s, readfds);
@@ -37,7 +37,9 @@ namespace XivAlexander::Apps::MainApp::Internal {
 		SingleConnection(SocketHook& hook, SOCKET s);
 		~SingleConnection();
 
-		typedef std::function<bool(Sqex::Network::Structure::XivMessage*)> MessageMangler;
+		// Return false to drop the message. Set modified to true after changing the message in place;
+		// bundles with no message dropped or modified are relayed as they were received.
+		typedef std::function<bool(Sqex::Network::Structure::XivMessage*, bool& modified)> MessageMangler;
 		void AddIncomingFFXIVMessageHandler(void* token, MessageMangler cb);
 		void AddOutgoingFFXIVMessageHandler(void* token, MessageMangler cb);
 		void RemoveMessageHandlers(void* token);
@@ -21,6 +21,7 @@
 #include <XivAlexanderCommon/Sqex/Sqpack/Reader.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/TextureEntryProvider.h>
 #include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
+#include <XivAlexanderCommon/Utils/OrderedResultQueue.h>
 #include <XivAlexanderCommon/Utils/Win32/Process.h>
 #include <XivAlexanderCommon/Utils/Win32/TaskDialogBuilder.h>
 #include <XivAlexanderCommon/Utils/Win32/ThreadPool.h>
@@ -60,6 +61,9 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 
 	Utils::CallOnDestruction::Multiple Cleanup;
 
+	// Declared last, so that pending reads get completed before anything else goes away.
+	Sqex::Sqpack::ReadScheduler ReadScheduler;
+
 	Implementation(Apps::MainApp::App& app, VirtualSqPacks* sqpacks, std::filesystem::path sqpackPath)
 		: App(app)
 		, Sqpacks(*sqpacks)
@@ -106,14 +110,47 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 	}
 
 	struct ReflectUsedEntriesTempData {
-		std::map<Sqex::Sqpack::EntryPathSpec, std::tuple<Sqex::Sqpack::HotSwappableEntryProvider*, std::shared_ptr<Sqex::Sqpack::EntryProvider>, std::string>, Sqex::Sqpack::EntryPathSpec::AllHashComparator> Replacements;
-		std::map<std::string, Sqex::Est::File> Est;
-		Sqex::EqpGmp::ExpandedFile Eqp;
-		Sqex::EqpGmp::ExpandedFile Gmp;
-		std::map<std::string, Sqex::Imc::File> Imc;
-		std::map<std::pair<Sqex::ThirdParty::TexTools::ItemMetadata::TargetItemType, uint32_t>, Sqex::Eqdp::ExpandedFile> Eqdp;
+		struct Replacement {
+			Sqex::Sqpack::HotSwappableEntryProvider* Place;
+
+			// Identifies what Create would return; empty to reset to the original entry.
+			std::string SourceKey;
+			std::function<std::shared_ptr<Sqex::Sqpack::EntryProvider>()> Create;
+			std::string Description;
+		};
+
+		struct MetadataFileEdits {
+			Sqex::ThirdParty::TexTools::ItemMetadata::MetaDataType Type;
+			uint32_t Race;
+			std::vector<std::shared_ptr<const Sqex::ThirdParty::TexTools::ItemMetadata>> Contributors;
+		};
+
+		std::map<Sqex::Sqpack::EntryPathSpec, Replacement, Sqex::Sqpack::EntryPathSpec::AllHashComparator> Replacements;
+		std::map<std::string, MetadataFileEdits> MetadataFiles;
+	};
+
+	// What a TTMP may ever replace regardless of choices, valid as long as its files stay the same.
+	struct ReflectedTtmpState {
+		uint64_t Fingerprint{};
+		uint64_t Generation{};
+		std::vector<std::pair<Sqex::Sqpack::EntryPathSpec, Sqex::Sqpack::HotSwappableEntryProvider*>> Placeholders;
+		std::map<uint64_t, std::shared_ptr<const Sqex::ThirdParty::TexTools::ItemMetadata>> Metadata;  // by ModOffset
 	};
 
+	struct ReflectedMetadataFile {
+		uint64_t Generation{};
+		std::vector<std::shared_ptr<const Sqex::ThirdParty::TexTools::ItemMetadata>> Contributors;
+		std::shared_ptr<const std::vector<uint8_t>> Data;
+	};
+
+	// Following fields keep what previous ReflectUsedEntries calls have computed and applied,
+	// so that a change in a single TTMP only recomputes and swaps what depends on it.
+	std::map<std::filesystem::path, ReflectedTtmpState> ReflectedTtmps;
+	std::map<std::string, ReflectedMetadataFile> ReflectedMetadataFiles;
+	std::map<Sqex::Sqpack::EntryPathSpec, std::pair<Sqex::Sqpack::HotSwappableEntryProvider*, std::string>, Sqex::Sqpack::EntryPathSpec::AllHashComparator> ReflectedSources;
+	std::optional<std::vector<std::pair<Sqex::Sqpack::HotSwappableEntryProvider*, size_t>>> VoicePlaceholders;  // index into voice types
+	uint64_t ReflectedGeneration = 0;
+
 	void ReflectUsedEntries(bool isCalledFromConstructor = false) {
 		const auto mainThreadStallEvent = Utils::Win32::Event::Create();
 		const auto mainThreadStalledEvent = Utils::Win32::Event::Create();
@@ -132,6 +169,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			mainThreadStalledEvent.Wait();
 
 		// Step. Wait until ReadFile stops
+		Utils::CallOnDestruction resumeIo;
 		if (!isCalledFromConstructor) {
 			while (true) {
 				const auto waitFor = static_cast<int64_t>(100LL + LastIoRequestTimestamp - GetTickCount64());
@@ -142,36 +180,44 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					break;
 			}
 			IoLockEvent.Reset();
-			const auto resumeIo = Utils::CallOnDestruction([this]() { IoLockEvent.Set(); });
+			resumeIo = Utils::CallOnDestruction([this]() { IoLockEvent.Set(); });
 		}
 
-		ReflectUsedEntriesTempData tempData{
-			.Eqp{*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::EqpPath)},
-			.Gmp{*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::GmpPath)},
-		};
+		ReflectUsedEntriesTempData tempData;
 
 		// Step. Find voices to enable or disable
-		const auto voBattle = Sqex::Sqpack::SqexHash("sound/voice/vo_battle", SIZE_MAX);
-		const auto voCm = Sqex::Sqpack::SqexHash("sound/voice/vo_cm", SIZE_MAX);
-		const auto voEmote = Sqex::Sqpack::SqexHash("sound/voice/vo_emote", SIZE_MAX);
-		const auto voLine = Sqex::Sqpack::SqexHash("sound/voice/vo_line", SIZE_MAX);
-		for (const auto& entry : SqpackViews.at(SqpackPath / L"ffxiv/070000.win32.index2").Entries) {
-			const auto provider = dynamic_cast<Sqex::Sqpack::HotSwappableEntryProvider*>(entry->Provider.get());
-			if (!provider)
-				continue;
+		if (!VoicePlaceholders) {
+			const uint32_t voiceHashes[]{
+				Sqex::Sqpack::SqexHash("sound/voice/vo_battle", SIZE_MAX),
+				Sqex::Sqpack::SqexHash("sound/voice/vo_cm", SIZE_MAX),
+				Sqex::Sqpack::SqexHash("sound/voice/vo_emote", SIZE_MAX),
+				Sqex::Sqpack::SqexHash("sound/voice/vo_line", SIZE_MAX),
+			};
+			VoicePlaceholders.emplace();
+			for (const auto& entry : SqpackViews.at(SqpackPath / L"ffxiv/070000.win32.index2").Entries) {
+				const auto provider = dynamic_cast<Sqex::Sqpack::HotSwappableEntryProvider*>(entry->Provider.get());
+				if (!provider || entry->HasDuplicates)
+					continue;
 
-			const auto& pathSpec = provider->PathSpec();
-			if (pathSpec.PathHash == voBattle || pathSpec.PathHash == voCm || pathSpec.PathHash == voEmote || pathSpec.PathHash == voLine)
-				tempData.Replacements.insert_or_assign(pathSpec, std::make_tuple(provider, std::shared_ptr<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(), std::string()));
-
-			if (pathSpec.PathHash == voBattle && Config->Runtime.MuteVoice_Battle)
-				std::get<1>(tempData.Replacements.at(pathSpec)) = std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(pathSpec, EmptyScd);
-			if (pathSpec.PathHash == voCm && Config->Runtime.MuteVoice_Cm)
-				std::get<1>(tempData.Replacements.at(pathSpec)) = std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(pathSpec, EmptyScd);
-			if (pathSpec.PathHash == voEmote && Config->Runtime.MuteVoice_Emote)
-				std::get<1>(tempData.Replacements.at(pathSpec)) = std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(pathSpec, EmptyScd);
-			if (pathSpec.PathHash == voLine && Config->Runtime.MuteVoice_Line)
-				std::get<1>(tempData.Replacements.at(pathSpec)) = std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(pathSpec, EmptyScd);
+				if (const auto it = std::ranges::find(voiceHashes, provider->PathSpec().PathHash); it != std::end(voiceHashes))
+					VoicePlaceholders->emplace_back(provider, static_cast<size_t>(it - std::begin(voiceHashes)));
+			}
+		}
+		{
+			const bool muteVoices[]{
+				Config->Runtime.MuteVoice_Battle,
+				Config->Runtime.MuteVoice_Cm,
+				Config->Runtime.MuteVoice_Emote,
+				Config->Runtime.MuteVoice_Line,
+			};
+			for (const auto& [provider, voiceType] : *VoicePlaceholders) {
+				const auto& pathSpec = provider->PathSpec();
+				auto& replacement = tempData.Replacements[pathSpec] = { .Place = provider };
+				if (muteVoices[voiceType]) {
+					replacement.SourceKey = "MuteVoice";
+					replacement.Create = [this, pathSpec = pathSpec]() { return std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(pathSpec, EmptyScd); };
+				}
+			}
 		}
 
 		Ttmps->Traverse(false, [&](NestedTtmp& nestedTtmp) {
@@ -180,33 +226,8 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			TtmpSet& ttmp = *nestedTtmp.Ttmp;
 
 			// Step. Find placeholders to adjust
-			ttmp.ForEachEntryInterruptible(false, [&](const auto& entry) {
-				const auto v = SqpackPath / std::format(L"{}.win32.index2", entry.ToExpacDatPath());
-				const auto it = SqpackViews.find(v);
-				if (it == SqpackViews.end()) {
-					Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "Failed to find {} as a sqpack file", v.c_str());
-					return Sqex::ThirdParty::TexTools::TTMPL::Continue;
-				}
-
-				if (!entry.IsMetadata()) {
-					ReflectUsedEntries_FindPlaceholders(it->second, tempData, entry.FullPath);
-				} else {
-					const auto ttmpd = std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ ttmp.DataFile, false });
-					const auto metadata = Sqex::ThirdParty::TexTools::ItemMetadata(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize)));
-					ReflectUsedEntries_FindPlaceholders(it->second, tempData, metadata.TargetImcPath);
-					ReflectUsedEntries_FindPlaceholders(it->second, tempData, Sqex::ThirdParty::TexTools::ItemMetadata::EqpPath);
-					ReflectUsedEntries_FindPlaceholders(it->second, tempData, Sqex::ThirdParty::TexTools::ItemMetadata::GmpPath);
-					if (const auto estPath = Sqex::ThirdParty::TexTools::ItemMetadata::EstPath(metadata.EstType))
-						ReflectUsedEntries_FindPlaceholders(it->second, tempData, estPath);
-					if (const auto eqdpedit = metadata.Get<Sqex::ThirdParty::TexTools::ItemMetadata::EqdpEntry>(Sqex::ThirdParty::TexTools::ItemMetadata::MetaDataType::Eqdp); !eqdpedit.empty()) {
-						for (const auto& v : eqdpedit) {
-							ReflectUsedEntries_FindPlaceholders(it->second, tempData, Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(metadata.ItemType, v.RaceCode));
-						}
-					}
-				}
-
-				return Sqex::ThirdParty::TexTools::TTMPL::Continue;
-				});
+			for (const auto& [pathSpec, provider] : ReflectUsedEntries_GetTtmpState(ttmp).Placeholders)
+				tempData.Replacements.insert_or_assign(pathSpec, ReflectUsedEntriesTempData::Replacement{ .Place = provider });
 
 			// Step. Unregister TTMP files that no longer exist and delete associated files
 			if (!exists(ttmp.ListPath)) {
@@ -259,41 +280,81 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 
 		Ttmps->RemoveEmptyChildren();
 
+		// Step. Forget states of TTMPs that are gone or moved
+		{
+			std::set<std::filesystem::path> existingTtmps;
+			Ttmps->Traverse(false, [&](const NestedTtmp& nestedTtmp) {
+				if (nestedTtmp.Ttmp)
+					existingTtmps.emplace(nestedTtmp.Ttmp->ListPath);
+				});
+			std::erase_if(ReflectedTtmps, [&](const auto& item) { return !existingTtmps.contains(item.first); });
+		}
+
 		// Step. Set new replacements
 		Ttmps->Traverse(true, [&](NestedTtmp& nestedTtmp) {
-			if (nestedTtmp.Ttmp && nestedTtmp.Ttmp->Allocated) {
+			if (nestedTtmp.Ttmp && nestedTtmp.Ttmp->Allocated && nestedTtmp.Ttmp->DataFile) {
+				const auto& state = ReflectUsedEntries_GetTtmpState(*nestedTtmp.Ttmp);
 				nestedTtmp.Ttmp->ForEachEntry(true, [&](const auto& entry) {
-					ReflectUsedEntries_SetReplacementsFromTtmpEntry(tempData, *nestedTtmp.Ttmp, entry);
+					ReflectUsedEntries_SetReplacementsFromTtmpEntry(tempData, *nestedTtmp.Ttmp, state, entry);
 					});
 			}
 			});
 
-		// Step. Replace metadata files
-		for (const auto& [path, data] : tempData.Est)
-			ReflectUsedEntries_SetFromBuffer(tempData, path, data.Data());
-		ReflectUsedEntries_SetFromBuffer(tempData, Sqex::ThirdParty::TexTools::ItemMetadata::EqpPath, tempData.Eqp.DataBytes());
-		ReflectUsedEntries_SetFromBuffer(tempData, Sqex::ThirdParty::TexTools::ItemMetadata::GmpPath, tempData.Gmp.DataBytes());
-		for (const auto& [path, data] : tempData.Imc)
-			ReflectUsedEntries_SetFromBuffer(tempData, path, data.Data());
-		for (const auto& [eqdpKey, data] : tempData.Eqdp)
-			ReflectUsedEntries_SetFromBuffer(tempData, Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(eqdpKey.first, eqdpKey.second), data.Data());
-
-		// Step. Apply replacements
-		for (const auto& pathSpec : tempData.Replacements | std::views::keys) {
-			auto& [place, newEntry, description] = tempData.Replacements.at(pathSpec);
-			if (!description.empty()) {
-				if (newEntry)
-					Logger->Format(LogCategory::VirtualSqPacks, "{}: {}", description, pathSpec);
-				else
-					Logger->Format(LogCategory::VirtualSqPacks, "Reset: {}", pathSpec);
+		// Step. Replace metadata files, rebuilding only those whose contributing edits have changed
+		for (const auto& [path, edits] : tempData.MetadataFiles) {
+			auto& reflected = ReflectedMetadataFiles[path];
+			if (!reflected.Data || reflected.Contributors != edits.Contributors) {
+				reflected.Generation = ++ReflectedGeneration;
+				reflected.Contributors = edits.Contributors;
+				reflected.Data = std::make_shared<const std::vector<uint8_t>>(ReflectUsedEntries_BuildMetadataFile(path, edits));
+			}
+			ReflectUsedEntries_SetFromBuffer(tempData, path, reflected);
+		}
+		std::erase_if(ReflectedMetadataFiles, [&](const auto& item) { return !tempData.MetadataFiles.contains(item.first); });
+
+		// Step. Finish reads that are already queued, and drop data read ahead from entries that may be swapped
+		ReadScheduler.Invalidate();
+
+		// Step. Apply replacements that differ from what is currently in place
+		auto anyChanged = false;
+		for (auto& [pathSpec, replacement] : tempData.Replacements) {
+			const auto it = ReflectedSources.find(pathSpec);
+			if (it == ReflectedSources.end() ? replacement.SourceKey.empty() : it->second.second == replacement.SourceKey)
+				continue;
+
+			auto newEntry = replacement.SourceKey.empty() ? nullptr : replacement.Create();
+			if (newEntry)
+				Logger->Format(LogCategory::VirtualSqPacks, "{}: {}", replacement.Description, pathSpec);
+			else
+				Logger->Format(LogCategory::VirtualSqPacks, "Reset: {}", pathSpec);
+			replacement.Place->SwapStream(std::move(newEntry));
+
+			if (replacement.SourceKey.empty())
+				ReflectedSources.erase(it);
+			else
+				ReflectedSources.insert_or_assign(pathSpec, std::make_pair(replacement.Place, replacement.SourceKey));
+			anyChanged = true;
+		}
+
+		// Step. Reset entries that are no longer claimed by any TTMP
+		for (auto it = ReflectedSources.begin(); it != ReflectedSources.end();) {
+			if (tempData.Replacements.contains(it->first)) {
+				++it;
+				continue;
 			}
-			place->SwapStream(std::move(newEntry));
+
+			Logger->Format(LogCategory::VirtualSqPacks, "Reset: {}", it->first);
+			it->second.first->SwapStream();
+			it = ReflectedSources.erase(it);
+			anyChanged = true;
 		}
 
 		// Step. Flush caches if any
-		for (const auto& view : SqpackViews) {
-			for (const auto& dataView : view.second.Data) {
-				dataView->Flush();
+		if (anyChanged) {
+			for (const auto& view : SqpackViews) {
+				for (const auto& dataView : view.second.Data) {
+					dataView->Flush();
+				}
 			}
 		}
 
@@ -301,9 +362,74 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			Sqpacks.OnTtmpSetsChanged();
 	}
 
+	static uint64_t ReflectUsedEntries_Fingerprint(const TtmpSet& ttmp) {
+		BY_HANDLE_FILE_INFORMATION dataInfo{};
+		if (!ttmp.DataFile || !GetFileInformationByHandle(ttmp.DataFile, &dataInfo))
+			return 0;
+
+		std::error_code ec;
+		const auto listWriteTime = last_write_time(ttmp.ListPath, ec);
+		if (ec)
+			return 0;
+
+		uint64_t fingerprint = std::hash<std::wstring>()(ttmp.ListPath.wstring());
+		for (const uint64_t v : {
+				static_cast<uint64_t>(listWriteTime.time_since_epoch().count()),
+				static_cast<uint64_t>(dataInfo.dwVolumeSerialNumber),
+				(static_cast<uint64_t>(dataInfo.nFileIndexHigh) << 32) | dataInfo.nFileIndexLow,
+				(static_cast<uint64_t>(dataInfo.nFileSizeHigh) << 32) | dataInfo.nFileSizeLow,
+				(static_cast<uint64_t>(dataInfo.ftLastWriteTime.dwHighDateTime) << 32) | dataInfo.ftLastWriteTime.dwLowDateTime,
+			})
+			fingerprint ^= v + 0x9E3779B97F4A7C15ULL + (fingerprint << 6) + (fingerprint >> 2);
+		return fingerprint ? fingerprint : 1;
+	}
+
+	const ReflectedTtmpState& ReflectUsedEntries_GetTtmpState(TtmpSet& ttmp) {
+		const auto fingerprint = ReflectUsedEntries_Fingerprint(ttmp);
+		auto& state = ReflectedTtmps[ttmp.ListPath];
+		if (fingerprint && state.Fingerprint == fingerprint)
+			return state;
+
+		state = {
+			.Fingerprint = fingerprint,
+			.Generation = ++ReflectedGeneration,
+		};
+
+		ttmp.ForEachEntryInterruptible(false, [&](const auto& entry) {
+			const auto v = SqpackPath / std::format(L"{}.win32.index2", entry.ToExpacDatPath());
+			const auto it = SqpackViews.find(v);
+			if (it == SqpackViews.end()) {
+				Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "Failed to find {} as a sqpack file", v.c_str());
+				return Sqex::ThirdParty::TexTools::TTMPL::Continue;
+			}
+
+			if (!entry.IsMetadata()) {
+				ReflectUsedEntries_FindPlaceholders(it->second, state, entry.FullPath);
+			} else {
+				const auto ttmpd = std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ ttmp.DataFile, false });
+				const auto metadata = std::make_shared<const Sqex::ThirdParty::TexTools::ItemMetadata>(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize)));
+				state.Metadata.insert_or_assign(entry.ModOffset, metadata);
+				ReflectUsedEntries_FindPlaceholders(it->second, state, metadata->TargetImcPath);
+				ReflectUsedEntries_FindPlaceholders(it->second, state, Sqex::ThirdParty::TexTools::ItemMetadata::EqpPath);
+				ReflectUsedEntries_FindPlaceholders(it->second, state, Sqex::ThirdParty::TexTools::ItemMetadata::GmpPath);
+				if (const auto estPath = Sqex::ThirdParty::TexTools::ItemMetadata::EstPath(metadata->EstType))
+					ReflectUsedEntries_FindPlaceholders(it->second, state, estPath);
+				if (const auto eqdpedit = metadata->Get<Sqex::ThirdParty::TexTools::ItemMetadata::EqdpEntry>(Sqex::ThirdParty::TexTools::ItemMetadata::MetaDataType::Eqdp); !eqdpedit.empty()) {
+					for (const auto& v : eqdpedit) {
+						ReflectUsedEntries_FindPlaceholders(it->second, state, Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(metadata->ItemType, v.RaceCode));
+					}
+				}
+			}
+
+			return Sqex::ThirdParty::TexTools::TTMPL::Continue;
+			});
+
+		return state;
+	}
+
 	void ReflectUsedEntries_FindPlaceholders(
 		Sqex::Sqpack::Creator::SqpackViews& view,
-		ReflectUsedEntriesTempData& tempData,
+		ReflectedTtmpState& state,
 		const Sqex::Sqpack::EntryPathSpec& pathSpec
 	) {
 		auto entryIt = view.HashOnlyEntries.find(pathSpec);
@@ -317,59 +443,110 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		if (!provider)
 			return;
 
+		// Other entries read from the same region; rebuilding the sqpacks will give it its own.
+		if (entryIt->second->HasDuplicates) {
+			Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "{}: shares its data with other entries; not replacing until sqpacks are rebuilt", pathSpec);
+			return;
+		}
+
 		provider->UpdatePathSpec(pathSpec);
-		tempData.Replacements.insert_or_assign(pathSpec, std::make_tuple(provider, std::shared_ptr<Sqex::Sqpack::EntryProvider>(), std::string()));
+		state.Placeholders.emplace_back(pathSpec, provider);
 	}
 
 	void ReflectUsedEntries_SetReplacementsFromTtmpEntry(
 		ReflectUsedEntriesTempData& tempData,
 		TtmpSet& ttmp,
+		const ReflectedTtmpState& state,
 		const Sqex::ThirdParty::TexTools::ModEntry& entry
 	) {
+		using Sqex::ThirdParty::TexTools::ItemMetadata;
+
 		if (entry.IsMetadata()) {
-			const auto ttmpd = std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ ttmp.DataFile, false });
-			const auto metadata = Sqex::ThirdParty::TexTools::ItemMetadata(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize)));
-			metadata.ApplyImcEdits([&]() -> Sqex::Imc::File& {
-				const auto imcPath = metadata.TargetImcPath;
-				if (const auto it = tempData.Imc.find(imcPath); it == tempData.Imc.end())
-					return tempData.Imc[imcPath] = Sqex::Imc::File(*GetOriginalEntry(metadata.SourceImcPath));
-				else
-					return it->second;
-				});
-			metadata.ApplyEqdpEdits([&](auto type, auto race) -> Sqex::Eqdp::ExpandedFile& {
-				const auto key = std::make_pair(type, race);
-				if (const auto it = tempData.Eqdp.find(key); it == tempData.Eqdp.end())
-					return tempData.Eqdp[key] = Sqex::Eqdp::ExpandedFile(*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(type, race)));
-				else
-					return it->second;
-				});
-			metadata.ApplyEqpEdits(tempData.Eqp);
-			metadata.ApplyGmpEdits(tempData.Gmp);
-
-			const auto estPath = Sqex::ThirdParty::TexTools::ItemMetadata::EstPath(metadata.EstType);
-			if (estPath) {
-				if (const auto it = tempData.Est.find(estPath); it == tempData.Est.end())
-					metadata.ApplyEstEdits(tempData.Est[estPath] = Sqex::Est::File(*GetOriginalEntry(estPath)));
-				else
-					metadata.ApplyEstEdits(it->second);
-			}
+			// Not parsed if the sqpack it belongs to could not be found; that has been logged already.
+			const auto metadataIt = state.Metadata.find(entry.ModOffset);
+			if (metadataIt == state.Metadata.end())
+				return;
+
+			const auto& metadata = metadataIt->second;
+			const auto addContributor = [&](const std::string& path, ItemMetadata::MetaDataType type, uint32_t race = 0) {
+				auto& edits = tempData.MetadataFiles.try_emplace(path, ReflectUsedEntriesTempData::MetadataFileEdits{ .Type = type, .Race = race }).first->second;
+				if (edits.Contributors.empty() || edits.Contributors.back() != metadata)
+					edits.Contributors.emplace_back(metadata);
+			};
+
+			if (!metadata->Get<Sqex::Imc::Entry>(ItemMetadata::MetaDataType::Imc).empty())
+				addContributor(metadata->TargetImcPath, ItemMetadata::MetaDataType::Imc);
+			for (const auto& v : metadata->Get<ItemMetadata::EqdpEntry>(ItemMetadata::MetaDataType::Eqdp))
+				addContributor(ItemMetadata::EqdpPath(metadata->ItemType, v.RaceCode), ItemMetadata::MetaDataType::Eqdp, v.RaceCode);
+			if (!metadata->Get<uint8_t>(ItemMetadata::MetaDataType::Eqp).empty())
+				addContributor(ItemMetadata::EqpPath, ItemMetadata::MetaDataType::Eqp);
+			if (!metadata->Get<uint8_t>(ItemMetadata::MetaDataType::Gmp).empty())
+				addContributor(ItemMetadata::GmpPath, ItemMetadata::MetaDataType::Gmp);
+			if (const auto estPath = ItemMetadata::EstPath(metadata->EstType); estPath && !metadata->Get<ItemMetadata::EstEntry>(ItemMetadata::MetaDataType::Est).empty())
+				addContributor(estPath, ItemMetadata::MetaDataType::Est);
+
 		} else {
 			const auto entryIt = tempData.Replacements.find(entry.FullPath);
 			if (entryIt == tempData.Replacements.end())
 				return;
 
-			std::get<1>(entryIt->second) = std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(
-				entry.FullPath,
-				std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ ttmp.DataFile, false }, entry.ModOffset, entry.ModSize)
-				);
-			std::get<2>(entryIt->second) = ttmp.List.Name;
+			entryIt->second.SourceKey = std::format("TTMP:{}:{}:{}", state.Generation, entry.ModOffset, entry.ModSize);
+			entryIt->second.Create = [dataFile = static_cast<HANDLE>(ttmp.DataFile), entry]() -> std::shared_ptr<Sqex::Sqpack::EntryProvider> {
+				return std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(
+					entry.FullPath,
+					std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ dataFile, false }, entry.ModOffset, entry.ModSize)
+					);
+			};
+			entryIt->second.Description = ttmp.List.Name;
+		}
+	}
+
+	std::vector<uint8_t> ReflectUsedEntries_BuildMetadataFile(const std::string& path, const ReflectUsedEntriesTempData::MetadataFileEdits& edits) const {
+		using Sqex::ThirdParty::TexTools::ItemMetadata;
+
+		switch (edits.Type) {
+			case ItemMetadata::MetaDataType::Imc: {
+				auto imc = Sqex::Imc::File(*GetOriginalEntry(edits.Contributors.front()->SourceImcPath));
+				for (const auto& metadata : edits.Contributors)
+					metadata->ApplyImcEdits([&]() -> Sqex::Imc::File& { return imc; });
+				return imc.Data();
+			}
+
+			case ItemMetadata::MetaDataType::Eqdp: {
+				auto eqdp = Sqex::Eqdp::ExpandedFile(*GetOriginalEntry(path));
+				for (const auto& metadata : edits.Contributors)
+					metadata->ApplyEqdpEdits(eqdp, edits.Race);
+				return eqdp.Data();
+			}
+
+			case ItemMetadata::MetaDataType::Eqp:
+			case ItemMetadata::MetaDataType::Gmp: {
+				auto file = Sqex::EqpGmp::ExpandedFile(Sqex::EqpGmp::CollapsedFile(*GetOriginalEntry(path)));
+				for (const auto& metadata : edits.Contributors) {
+					if (edits.Type == ItemMetadata::MetaDataType::Eqp)
+						metadata->ApplyEqpEdits(file);
+					else
+						metadata->ApplyGmpEdits(file);
+				}
+				return file.DataBytes();
+			}
+
+			case ItemMetadata::MetaDataType::Est: {
+				auto est = Sqex::Est::File(*GetOriginalEntry(path));
+				for (const auto& metadata : edits.Contributors)
+					metadata->ApplyEstEdits(est);
+				return est.Data();
+			}
+
+			default:
+				throw std::invalid_argument(std::format("unsupported metadata type for {}", path));
 		}
 	}
 
 	void ReflectUsedEntries_SetFromBuffer(
 		ReflectUsedEntriesTempData& tempData,
 		const std::string& path,
-		const std::vector<uint8_t>& data
+		const ReflectedMetadataFile& file
 	) {
 		const auto pathSpec = Sqex::Sqpack::EntryPathSpec(path);
 
@@ -377,9 +554,12 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		if (entryIt == tempData.Replacements.end())
 			return;
 
-		std::get<1>(entryIt->second) = std::make_shared<Sqex::Sqpack::OnTheFlyBinaryEntryProvider>(path, std::make_shared<Sqex::MemoryRandomAccessStream>(data));
-		// std::get<1>(entryIt->second) = std::make_shared<Sqex::Sqpack::EmptyOrObfuscatedEntryProvider>(path, std::make_shared<Sqex::MemoryRandomAccessStream>(data));
-		std::get<2>(entryIt->second) = "Metadata";
+		entryIt->second.SourceKey = std::format("Metadata:{}", file.Generation);
+		entryIt->second.Create = [path, data = file.Data]() -> std::shared_ptr<Sqex::Sqpack::EntryProvider> {
+			return std::make_shared<Sqex::Sqpack::OnTheFlyBinaryEntryProvider>(path, std::make_shared<Sqex::MemoryRandomAccessStream>(*data));
+			// return std::make_shared<Sqex::Sqpack::EmptyOrObfuscatedEntryProvider>(path, std::make_shared<Sqex::MemoryRandomAccessStream>(*data));
+		};
+		entryIt->second.Description = "Metadata";
 	}
 
 	std::vector<std::filesystem::path> GetPossibleTtmpDirs() const {
@@ -415,6 +595,142 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			ReflectUsedEntries();
 	}
 
+	static constexpr auto SampleScdPath = "sound/system/sample_system.scd";
+
+	void SetUpEmptyScd(std::shared_ptr<Sqex::RandomAccessStream> sampleScd) {
+		const auto reader = Sqex::Sound::ScdReader(std::move(sampleScd));
+		Sqex::Sound::ScdWriter writer;
+		writer.SetTable1(reader.ReadTable1Entries());
+		writer.SetTable4(reader.ReadTable4Entries());
+		writer.SetTable2(reader.ReadTable2Entries());
+		std::vector<uint8_t> emptyEntryBytes;
+		Sqex::Sound::ScdWriter::SoundEntry::EmptyEntry().ExportTo(emptyEntryBytes);
+		const auto emptyEntry = Sqex::Sound::ScdReader::SoundEntryView(std::make_shared<Sqex::MemoryRandomAccessStream>(std::move(emptyEntryBytes)));
+		for (size_t i = 0; i < 256; ++i) {
+			writer.SetSoundEntry(i, emptyEntry);
+		}
+		EmptyScd = std::make_shared<Sqex::MemoryRandomAccessStream>(
+			Sqex::Sqpack::MemoryBinaryEntryProvider("dummy/dummy", writer.ExportStream(), Config->Runtime.CompressModdedFiles ? Z_BEST_COMPRESSION : Z_NO_COMPRESSION)
+			.ReadStreamIntoVector<uint8_t>(0));
+		//EmptyScd = std::make_shared<Sqex::MemoryRandomAccessStream>(
+		//	Sqex::Sqpack::EmptyOrObfuscatedEntryProvider("dummy/dummy", std::make_shared<Sqex::MemoryRandomAccessStream>(writer.Export()))
+		//	.ReadStreamIntoVector<uint8_t>(0));
+	}
+
+	static std::string DescribeFileForCacheKey(const std::filesystem::path& path) {
+		return std::format("{}:{}:{}", path.wstring(), file_size(path), last_write_time(path).time_since_epoch().count());
+	}
+
+	static void AppendSqpackFilesToCacheKey(std::string& key, const std::filesystem::path& indexFile) {
+		for (const auto& extension : { L".index", L".index2" }) {
+			if (const auto path = std::filesystem::path(indexFile).replace_extension(extension); exists(path))
+				key += std::format("INDEX:{}:{}\n", path.wstring(), HashFileContentsForCacheKey(path));
+		}
+		for (int i = 0; i < 8; ++i) {
+			const auto path = std::filesystem::path(indexFile).replace_extension(std::format(".dat{}", i));
+			if (!exists(path))
+				break;
+			key += std::format("DAT:{}\n", DescribeFileForCacheKey(path));
+		}
+	}
+
+	// Generated files are only described if they are up to date; otherwise they are about to be regenerated,
+	// and the views built from them will be stored on the next launch instead.
+	static bool AppendGeneratedFilesToCacheKey(std::string& key, const std::filesystem::path& cachedDir, const std::string& currentCacheKeys) {
+		try {
+			const auto file = Utils::Win32::Handle::FromCreateFile(cachedDir / "sources", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+			const auto content = file.Read<char>(0, static_cast<size_t>(file.GetFileSize()));
+			if (!std::ranges::equal(content, currentCacheKeys))
+				return false;
+		} catch (...) {
+			return false;
+		}
+
+		key += currentCacheKeys;
+		key += std::format("GENERATED:{}\n", DescribeFileForCacheKey(cachedDir / "TTMPL.mpl"));
+		key += std::format("GENERATED:{}\n", DescribeFileForCacheKey(cachedDir / "TTMPD.mpd"));
+		return true;
+	}
+
+	// Describes inputs that affect every sqpack; empty if any of them cannot be described.
+	[[nodiscard]] std::string GetCachedViewsSharedKey() const {
+		std::string key("VERSION:1\n");
+		key += Config->Runtime.CompressModdedFiles ? "compress:true\n" : "compress:false\n";
+
+		auto describable = true;
+		Ttmps->Traverse(false, [&](const NestedTtmp& nestedTtmp) {
+			if (!nestedTtmp.Ttmp || !describable)
+				return;
+
+			const auto& ttmp = *nestedTtmp.Ttmp;
+			BY_HANDLE_FILE_INFORMATION dataInfo{};
+			if (!ttmp.DataFile || !GetFileInformationByHandle(ttmp.DataFile, &dataInfo)) {
+				describable = false;
+				return;
+			}
+
+			key += std::format("TTMP:{}:{}:{}:{}:{}\n",
+				ttmp.ListPath.wstring(),
+				HashFileContentsForCacheKey(ttmp.ListPath),
+				(static_cast<uint64_t>(dataInfo.nFileIndexHigh) << 32) | dataInfo.nFileIndexLow,
+				(static_cast<uint64_t>(dataInfo.nFileSizeHigh) << 32) | dataInfo.nFileSizeLow,
+				(static_cast<uint64_t>(dataInfo.ftLastWriteTime.dwHighDateTime) << 32) | dataInfo.ftLastWriteTime.dwLowDateTime);
+			});
+		return describable ? key : std::string();
+	}
+
+	// Describes every input that InitializeSqPacks uses to build views of given sqpack; empty if views should not be cached.
+	[[nodiscard]] std::string GetCachedViewsKey(const std::string& sharedKey, const Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexFile) const {
+		if (sharedKey.empty())
+			return {};
+
+		try {
+			auto key = sharedKey;
+			AppendSqpackFilesToCacheKey(key, indexFile);
+
+			if (creator.DatExpac != "ffxiv" || creator.DatName != "0a0000") {
+				for (const auto& additionalSqpackRootDirectory : Config->Runtime.AdditionalSqpackRootDirectories.Value()) {
+					if (const auto file = additionalSqpackRootDirectory / "sqpack" / indexFile.parent_path().filename() / indexFile.filename(); exists(file))
+						AppendSqpackFilesToCacheKey(key, file);
+					else
+						key += std::format("NOSQPACK:{}\n", file.wstring());
+				}
+			}
+
+			for (const auto& dir : GetVirtualFileEntryDirs(creator, indexFile) | std::views::keys) {
+				if (!is_directory(dir))
+					continue;
+
+				std::vector<std::filesystem::path> files;
+				for (const auto& iter : std::filesystem::recursive_directory_iterator(dir)) {
+					if (!is_directory(iter))
+						files.emplace_back(iter);
+				}
+				std::ranges::sort(files);
+				for (const auto& file : files)
+					key += std::format("FILE:{}\n", DescribeFileForCacheKey(file));
+			}
+
+			if (creator.DatExpac == "ffxiv" && creator.DatName == "000000") {
+				if (const auto fontConfigPath{ Config->Runtime.OverrideFontConfig.Value() }; !fontConfigPath.empty()) {
+					if (!AppendGeneratedFilesToCacheKey(key, GetGeneratedFontsCacheDir(fontConfigPath), GetGeneratedFontsCacheKeys(indexFile)))
+						return {};
+				}
+			} else if (creator.DatExpac == "ffxiv" && creator.DatName == "0a0000") {
+				if (!Config->Runtime.AdditionalSqpackRootDirectories.Value().empty() || !Config->Runtime.ExcelTransformConfigFiles.Value().empty()) {
+					if (!AppendGeneratedFilesToCacheKey(key, GetSqpackCacheDir(creator), GetMergedExdCacheKeys(indexFile)))
+						return {};
+				}
+			}
+
+			return key;
+		} catch (const std::exception& e) {
+			Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
+				"[{}/{}] Views will not be cached: {}", creator.DatExpac, creator.DatName, e.what());
+			return {};
+		}
+	}
+
 	void InitializeSqPacks(Apps::MainApp::Window::ProgressPopupWindow& progressWindow) {
 		progressWindow.UpdateMessage(Utils::ToUtf8(Config->Runtime.GetStringRes(IDS_TITLE_DISCOVERINGFILES)));
 
@@ -459,6 +775,14 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
 			throw std::runtime_error("Cancelled");
 
+		const auto dataViewBuffer = std::make_shared<Sqex::Sqpack::Creator::SqpackViewEntryCache>();
+
+		// Views reopened from the cache, and keys to store newly built views with.
+		const auto cachedViewsSharedKey = GetCachedViewsSharedKey();
+		std::map<std::filesystem::path, Sqex::Sqpack::Creator::SqpackViews> cachedViews;
+		std::map<std::filesystem::path, std::string> cachedViewsKeys;
+		std::mutex cachedViewsMtx;
+
 		{
 			std::mutex groupedLogPrintLock;
 			const auto progressMax = creators.size() * (0
@@ -482,6 +806,42 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 							progressValue += 1;
 							fileIndex += 1;
 							pLastStartedIndexFile = &indexFile;
+
+							if (auto cacheKey = GetCachedViewsKey(cachedViewsSharedKey, creator, indexFile); !cacheKey.empty()) {
+								try {
+									if (auto views = Sqex::Sqpack::Creator::LoadViews(GetSqpackCacheDir(creator) / "views", cacheKey, creator.DatName.starts_with("0c") ? nullptr : dataViewBuffer)) {
+										Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
+											"[{}/{}] Loaded cached views: {} entries",
+											creator.DatExpac, creator.DatName, views->Entries.size());
+
+										if (creator.DatExpac == "ffxiv" && creator.DatName == "070000") {
+											const auto pathSpec = Sqex::Sqpack::EntryPathSpec(SampleScdPath);
+											// The two maps are different containers, so each lookup is checked against its own end.
+											const Sqex::Sqpack::Creator::Entry* entry = nullptr;
+											if (const auto it = views->HashOnlyEntries.find(pathSpec); it != views->HashOnlyEntries.end())
+												entry = it->second.get();
+											else if (const auto it2 = views->FullPathEntries.find(pathSpec); it2 != views->FullPathEntries.end())
+												entry = it2->second.get();
+											if (entry) {
+												const auto provider = dynamic_cast<Sqex::Sqpack::HotSwappableEntryProvider*>(entry->Provider.get());
+												SetUpEmptyScd(std::make_shared<Sqex::BufferedRandomAccessStream>(std::make_shared<Sqex::Sqpack::EntryRawStream>(provider ? provider->GetBaseStream() : entry->Provider)));
+											}
+										}
+
+										const auto lock = std::lock_guard(cachedViewsMtx);
+										cachedViews.emplace(indexFile, std::move(*views));
+										progressValue += Config->Runtime.AdditionalSqpackRootDirectories.Value().size() + Ttmps->Count() + 1;
+										return;
+									}
+								} catch (const std::exception& e) {
+									Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
+										"[{}/{}] Failed to load cached views: {}", creator.DatExpac, creator.DatName, e.what());
+								}
+
+								const auto lock = std::lock_guard(cachedViewsMtx);
+								cachedViewsKeys.emplace(indexFile, std::move(cacheKey));
+							}
+
 							if (const auto result = creator.AddEntriesFromSqPack(indexFile, true, true); result.AnyItem()) {
 								const auto lock = std::lock_guard(groupedLogPrintLock);
 								Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
@@ -496,20 +856,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 
 							if (creator.DatExpac == "ffxiv" && creator.DatName == "070000") {
 								try {
-									const auto reader = Sqex::Sound::ScdReader(creator["sound/system/sample_system.scd"]);
-									Sqex::Sound::ScdWriter writer;
-									writer.SetTable1(reader.ReadTable1Entries());
-									writer.SetTable4(reader.ReadTable4Entries());
-									writer.SetTable2(reader.ReadTable2Entries());
-									for (size_t i = 0; i < 256; ++i) {
-										writer.SetSoundEntry(i, Sqex::Sound::ScdWriter::SoundEntry::EmptyEntry());
-									}
-									EmptyScd = std::make_shared<Sqex::MemoryRandomAccessStream>(
-										Sqex::Sqpack::MemoryBinaryEntryProvider("dummy/dummy", std::make_shared<Sqex::MemoryRandomAccessStream>(writer.Export()), Config->Runtime.CompressModdedFiles ? Z_BEST_COMPRESSION : Z_NO_COMPRESSION)
-										.ReadStreamIntoVector<uint8_t>(0));
-									//EmptyScd = std::make_shared<Sqex::MemoryRandomAccessStream>(
-									//	Sqex::Sqpack::EmptyOrObfuscatedEntryProvider("dummy/dummy", std::make_shared<Sqex::MemoryRandomAccessStream>(writer.Export()))
-									//	.ReadStreamIntoVector<uint8_t>(0));
+									SetUpEmptyScd(creator[SampleScdPath]);
 								} catch(std::out_of_range&) {
 									// ignore
 								}
@@ -572,6 +919,9 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 							pool.Cancel();
 							Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
 								"[{}/{}] Error: {}", creator.DatExpac, creator.DatName, e.what());
+
+							const auto lock = std::lock_guard(cachedViewsMtx);
+							cachedViewsKeys.erase(indexFile);
 						}
 					});
 				}
@@ -593,19 +943,26 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
 				throw std::runtime_error("Cancelled");
 
+			if (cachedViews.contains(indexFile))
+				continue;
+
+			auto complete = true;
 			if (pCreator->DatExpac == "ffxiv" && pCreator->DatName == "000000")
-				SetUpGeneratedFonts(progressWindow, *pCreator, indexFile);
+				complete = SetUpGeneratedFonts(progressWindow, *pCreator, indexFile);
 			else if (pCreator->DatExpac == "ffxiv" && pCreator->DatName == "070000" && EmptyScd) {
 				for (const auto& pathSpec : pCreator->AllPathSpec())
 					pCreator->ReserveSwappableSpace(pathSpec, static_cast<uint32_t>(EmptyScd->StreamSize()));
 			} else if (pCreator->DatExpac == "ffxiv" && pCreator->DatName == "0a0000")
-				SetUpMergedExd(progressWindow, *pCreator, indexFile);
+				complete = SetUpMergedExd(progressWindow, *pCreator, indexFile);
+
+			// do not let a launch where generation was skipped or failed decide what later launches see
+			if (!complete)
+				cachedViewsKeys.erase(indexFile);
 		}
 
 		{
 			const auto progressMax = creators.size();
 			size_t progressValue = 0;
-			const auto dataViewBuffer = std::make_shared<Sqex::Sqpack::Creator::SqpackViewEntryCache>();
 			const auto workerThread = Utils::Win32::Thread(L"InitializeSqPacks Finalizer", [&]() {
 				Utils::Win32::TpEnvironment pool(L"InitializeSqPacks Finalizer/Pool");
 				std::mutex resLock;
@@ -614,8 +971,26 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 						throw std::runtime_error("Cancelled");
 
 					pool.SubmitWork([&]() {
+						if (const auto it = cachedViews.find(indexFile); it != cachedViews.end()) {
+							const auto lock = std::lock_guard(resLock);
+							SqpackViews.emplace(indexFile, std::move(it->second));
+							progressValue += 1;
+							return;
+						}
+
 						auto v = pCreator->AsViews(false, pCreator->DatName.starts_with("0c") ? nullptr : dataViewBuffer);
 
+						if (const auto it = cachedViewsKeys.find(indexFile); it != cachedViewsKeys.end()) {
+							try {
+								if (!Sqex::Sqpack::Creator::StoreViews(v, GetSqpackCacheDir(*pCreator) / "views", it->second))
+									Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
+										"[{}/{}] Views will not be cached: some entries cannot be reopened", pCreator->DatExpac, pCreator->DatName);
+							} catch (const std::exception& e) {
+								Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
+									"[{}/{}] Failed to store views: {}", pCreator->DatExpac, pCreator->DatName, e.what());
+							}
+						}
+
 						//if (pCreator->DatName.starts_with("0a")) {
 						//	auto t = v.Index1->ReadStreamIntoVector<char>(0);
 						//	std::ofstream("Z:/0a0000.win32.index", std::ios::binary).write(&t[0], t.size());
@@ -736,6 +1111,11 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					uint64_t outPtr = 0;
 
 					std::mutex writeMtx;
+
+					// Entries with identical content are compressed and written only once; following are guarded by writeMtx.
+					std::map<std::string, Sqex::ThirdParty::TexTools::ModEntry*> payloadOwners;
+					std::vector<std::pair<Sqex::ThirdParty::TexTools::ModEntry*, const Sqex::ThirdParty::TexTools::ModEntry*>> duplicateEntries;
+
 					Utils::Win32::TpEnvironment pool(L"CompressTtmpEntry/pool");
 					list.ForEachEntry([&](Sqex::ThirdParty::TexTools::ModEntry& entry) {
 						pool.SubmitWork([&]() {
@@ -751,6 +1131,17 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 								std::vector<uint8_t> buf(entry.ModSize);
 								dataStream->ReadStreamPartial(entry.ModOffset, buf.data(), entry.ModSize);
 
+								std::string payloadHash(CryptoPP::SHA1::DIGESTSIZE, '\0');
+								CryptoPP::SHA1().CalculateDigest(reinterpret_cast<CryptoPP::byte*>(&payloadHash[0]), buf.data(), buf.size());
+								{
+									const auto _ = std::lock_guard(writeMtx);
+									if (const auto [it, inserted] = payloadOwners.emplace(std::move(payloadHash), &entry); !inserted) {
+										duplicateEntries.emplace_back(&entry, it->second);
+										progressMax -= entry.ModSize;
+										return;
+									}
+								}
+
 								stream = std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(
 									pathSpec,
 									std::make_shared<Sqex::MemoryRandomAccessStream>(std::move(buf)));
@@ -813,6 +1204,11 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 
 					pool.WaitOutstanding();
 
+					for (const auto& [duplicate, owner] : duplicateEntries) {
+						duplicate->ModOffset = owner->ModOffset;
+						duplicate->ModSize = owner->ModSize;
+					}
+
 					nlohmann::json j;
 					to_json(j, list);
 					Utils::SaveJsonToFile(tempTtmplPath, j);
@@ -942,24 +1338,80 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 				}
 			}
 
+			// entries sharing payload with another entry cannot be swapped independently
 			const auto provider = dynamic_cast<Sqex::Sqpack::HotSwappableEntryProvider*>(entryIt->second->Provider.get());
-			if (!provider)
-				return Sqex::ThirdParty::TexTools::TTMPL::Continue;
+			if (!provider || entryIt->second->HasDuplicates)
+				return Sqex::ThirdParty::TexTools::TTMPL::Break;
 
 			return provider->StreamSize() >= entry.ModSize ? Sqex::ThirdParty::TexTools::TTMPL::Continue : Sqex::ThirdParty::TexTools::TTMPL::Break;
 			});
 	}
 
-	void SetUpMergedExd(Apps::MainApp::Window::ProgressPopupWindow& progressWindow, Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexFile) {
+	static std::string HashFileContentsForCacheKey(const std::filesystem::path& path) {
+		uint8_t hash[20]{};
+		try {
+			const auto file = Utils::Win32::Handle::FromCreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+			CryptoPP::SHA1 sha1;
+			const auto content = file.Read<uint8_t>(0, static_cast<size_t>(file.GetFileSize()));
+			sha1.Update(content.data(), content.size());
+			sha1.Final(reinterpret_cast<byte*>(hash));
+		} catch (...) {
+		}
+
+		CryptoPP::HexEncoder encoder;
+		encoder.Put(hash, sizeof hash);
+		encoder.MessageEnd();
+
+		std::string buf(static_cast<size_t>(encoder.MaxRetrievable()), 0);
+		encoder.Get(reinterpret_cast<byte*>(&buf[0]), buf.size());
+		return buf;
+	}
+
+	[[nodiscard]] std::filesystem::path GetSqpackCacheDir(const Sqex::Sqpack::Creator& creator) const {
+		return Config->Init.ResolveConfigStorageDirectoryPath() / "Cached" / GameReleaseInfo.CountryCode / creator.DatExpac / creator.DatName;
+	}
+
+	[[nodiscard]] std::string GetMergedExdCacheKeys(const std::filesystem::path& indexFile) const {
+		std::string currentCacheKeys("VERSION:4\n");
+		currentCacheKeys += Config->Runtime.CompressModdedFiles ? "compress:true\n" : "compress:false\n";
+		{
+			const auto gameRoot = indexFile.parent_path().parent_path().parent_path();
+			const auto versionFile = Utils::Win32::Handle::FromCreateFile(gameRoot / "ffxivgame.ver", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+			const auto versionContent = versionFile.Read<char>(0, static_cast<size_t>(versionFile.GetFileSize()));
+			currentCacheKeys += std::format("SQPACK:{}:{}\n", canonical(gameRoot).wstring(), std::string(versionContent.begin(), versionContent.end()));
+		}
+
+		currentCacheKeys += "LANG";
+		for (const auto& lang : Config->Runtime.GetFallbackLanguageList())
+			currentCacheKeys += std::format(":{}", static_cast<int>(lang));
+		currentCacheKeys += "\n";
+
+		for (const auto& additionalSqpackRootDirectory : Config->Runtime.AdditionalSqpackRootDirectories.Value()) {
+			const auto file = additionalSqpackRootDirectory / "sqpack" / indexFile.parent_path().filename() / indexFile.filename();
+			if (!exists(file))
+				continue;
+
+			const auto versionFile = Utils::Win32::Handle::FromCreateFile(additionalSqpackRootDirectory / "ffxivgame.ver", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+			const auto versionContent = versionFile.Read<char>(0, static_cast<size_t>(versionFile.GetFileSize()));
+			currentCacheKeys += std::format("SQPACK:{}:{}\n", canonical(additionalSqpackRootDirectory).wstring(), std::string(versionContent.begin(), versionContent.end()));
+		}
+
+		for (const auto& configFile : Config->Runtime.ExcelTransformConfigFiles.Value())
+			currentCacheKeys += std::format("CONF:{}:{}\n", configFile.wstring(), HashFileContentsForCacheKey(configFile));
+
+		return currentCacheKeys;
+	}
+
+	bool SetUpMergedExd(Apps::MainApp::Window::ProgressPopupWindow& progressWindow, Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexFile) {
 		while (true) {
 			try {
 				const auto additionalGameRootDirectories{ Config->Runtime.AdditionalSqpackRootDirectories.Value() };
 				const auto excelTransformConfigFiles{ Config->Runtime.ExcelTransformConfigFiles.Value() };
 				if (additionalGameRootDirectories.empty() && excelTransformConfigFiles.empty())
-					return;
+					return true;
 
 				const auto fallbackLanguageList{ Config->Runtime.GetFallbackLanguageList() };
-				const auto cachedDir = Config->Init.ResolveConfigStorageDirectoryPath() / "Cached" / GameReleaseInfo.CountryCode / creator.DatExpac / creator.DatName;
+				const auto cachedDir = GetSqpackCacheDir(creator);
 
 				std::map<std::string, int> exhTable;
 				// maybe generate exl?
@@ -967,19 +1419,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 				for (const auto& pair : Sqex::Excel::ExlReader(*creator["exd/root.exl"]))
 					exhTable.emplace(pair);
 
-				std::string currentCacheKeys("VERSION:4\n");
-				currentCacheKeys += Config->Runtime.CompressModdedFiles ? "compress:true\n" : "compress:false\n";
-				{
-					const auto gameRoot = indexFile.parent_path().parent_path().parent_path();
-					const auto versionFile = Utils::Win32::Handle::FromCreateFile(gameRoot / "ffxivgame.ver", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
-					const auto versionContent = versionFile.Read<char>(0, static_cast<size_t>(versionFile.GetFileSize()));
-					currentCacheKeys += std::format("SQPACK:{}:{}\n", canonical(gameRoot).wstring(), std::string(versionContent.begin(), versionContent.end()));
-				}
-
-				currentCacheKeys += "LANG";
-				for (const auto& lang : fallbackLanguageList)
-					currentCacheKeys += std::format(":{}", static_cast<int>(lang));
-				currentCacheKeys += "\n";
+				const auto currentCacheKeys = GetMergedExdCacheKeys(indexFile);
 
 				std::vector<std::unique_ptr<Sqex::Sqpack::Reader>> readers;
 				for (const auto& additionalSqpackRootDirectory : additionalGameRootDirectories) {
@@ -987,34 +1427,9 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					if (!exists(file))
 						continue;
 
-					const auto versionFile = Utils::Win32::Handle::FromCreateFile(additionalSqpackRootDirectory / "ffxivgame.ver", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
-					const auto versionContent = versionFile.Read<char>(0, static_cast<size_t>(versionFile.GetFileSize()));
-					currentCacheKeys += std::format("SQPACK:{}:{}\n", canonical(additionalSqpackRootDirectory).wstring(), std::string(versionContent.begin(), versionContent.end()));
-
 					readers.emplace_back(std::make_unique<Sqex::Sqpack::Reader>(Sqex::Sqpack::Reader::FromPath(file)));
 				}
 
-				for (const auto& configFile : excelTransformConfigFiles) {
-					uint8_t hash[20]{};
-					try {
-						const auto file = Utils::Win32::Handle::FromCreateFile(configFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
-						CryptoPP::SHA1 sha1;
-						const auto content = file.Read<uint8_t>(0, static_cast<size_t>(file.GetFileSize()));
-						sha1.Update(content.data(), content.size());
-						sha1.Final(reinterpret_cast<byte*>(hash));
-					} catch (...) {
-					}
-
-					CryptoPP::HexEncoder encoder;
-					encoder.Put(hash, sizeof hash);
-					encoder.MessageEnd();
-
-					std::string buf(static_cast<size_t>(encoder.MaxRetrievable()), 0);
-					encoder.Get(reinterpret_cast<byte*>(&buf[0]), buf.size());
-
-					currentCacheKeys += std::format("CONF:{}:{}\n", configFile.wstring(), buf);
-				}
-
 				auto needRecreate = true;
 				try {
 					const auto file = Utils::Win32::Handle::FromCreateFile(cachedDir / "sources", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
@@ -1087,7 +1502,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					if (replacementFileParseFail) {
 						Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
 							"Skipping string table generation");
-						return;
+						return false;
 					}
 
 					const auto actCtx = Dll::ActivationContext().With();
@@ -1095,6 +1510,29 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					progressWindow.UpdateMessage(Utils::ToUtf8(Config->Runtime.GetStringRes(IDS_TITLE_GENERATING_EXD_FILES)));
 
 					static constexpr auto ProgressMaxPerTask = 1000;
+
+					// Decoded rows take several times the size of the raw data, and are kept for every source installation.
+					static constexpr uint64_t MemoryBudget = (sizeof(void*) >= 8 ? 1024ULL : 256ULL) * 1024 * 1024;
+					static constexpr uint64_t MemoryExpansionFactor = 8;
+					const auto estimateSheetCost = [&](const std::string& exhName) -> uint64_t {
+						uint64_t sourceSize = 0;
+						try {
+							const auto exhReaderSource = Sqex::Excel::ExhReader(exhName, *creator[Sqex::Sqpack::EntryPathSpec(std::format("exd/{}.exh", exhName))]);
+							for (const auto language : exhReaderSource.Languages) {
+								for (const auto& page : exhReaderSource.Pages) {
+									try {
+										sourceSize += creator[exhReaderSource.GetDataPathSpec(page, language)]->StreamSize();
+									} catch (const std::out_of_range&) {
+										// pass
+									}
+								}
+							}
+						} catch (...) {
+							// the task itself will report the error, if any
+						}
+						return sourceSize * (readers.size() + 1) * MemoryExpansionFactor;
+					};
+
 					std::map<std::string, uint64_t> progressPerTask;
 					for (const auto& exhName : exhTable | std::views::keys)
 						progressPerTask.emplace(exhName, 0);
@@ -1106,9 +1544,46 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 						std::mutex writeMtx;
 
 						std::string errorMessage;
+
+						// Sheets are admitted in order, and their outputs are written in the same order,
+						// so that the result stays the same as if every sheet had been processed one by one.
+						struct CompiledEntry {
+							Sqex::Sqpack::EntryPathSpec PathSpec;
+							uint64_t Size;
+							std::vector<char> Data;
+						};
+						Utils::OrderedResultQueue<std::vector<CompiledEntry>> sheetOutputs(MemoryBudget, [&](std::vector<CompiledEntry>& entries) {
+							try {
+								for (const auto& entry : entries) {
+									const auto entryLine = std::format("{}\n", nlohmann::json::object({
+										{"FullPath", Utils::StringReplaceAll<std::string>(Utils::ToUtf8(entry.PathSpec.FullPath.wstring()), "\\", "/")},
+										{"ModOffset", ttmpdPtr},
+										{"ModSize", entry.Size},
+										{"DatFile", "0a0000"},
+										}).dump());
+									ttmplPtr += ttmpl.Write(ttmplPtr, std::span(entryLine));
+									ttmpdPtr += ttmpd.Write(ttmpdPtr, std::span(entry.Data));
+								}
+							} catch (const std::exception& e) {
+								const auto lock = std::lock_guard(writeMtx);
+								if (errorMessage.empty()) {
+									errorMessage = std::format("Write to filesystem: {}", e.what());
+									Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "Error: {}", errorMessage);
+									progressWindow.Cancel();
+								}
+							}
+						});
+
 						const auto compressThread = Utils::Win32::Thread(L"CompressThread", [&]() {
 							for (const auto& exhName : exhTable | std::views::keys) {
-								pool.SubmitWork([&]() {
+								const auto sheetIndex = sheetOutputs.Admit(estimateSheetCost(exhName), [&]() { return progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0; });
+								if (sheetIndex == SIZE_MAX || progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
+									break;
+
+								pool.SubmitWork([&, sheetIndex]() {
+									std::vector<CompiledEntry> outputs;
+									const auto finishGuard = Utils::CallOnDestruction([&]() { sheetOutputs.Finish(sheetIndex, std::move(outputs)); });
+
 									const char* lastStep = "Begin";
 									try {
 										if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
@@ -1224,13 +1699,13 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 										} else if (exhName == "CompleteJournal") {
 											// Row ID does not persist across versions. Use first 4 columns as the alternate key.
 
-											const auto ToMapKey = [](const std::vector<Sqex::Excel::ExdColumn>& columns) {
+											const auto ToMapKey = [](uint64_t c0, uint64_t c1, uint64_t c2, uint64_t c3) {
 												// 20, 20, 16, 8
 												return 0
-													| (columns[0].uint64 << 44)
-													| (columns[1].uint64 << 24)
-													| (columns[2].uint64 << 8)
-													| (columns[3].uint64 << 0);
+													| (c0 << 44)
+													| (c1 << 24)
+													| (c2 << 8)
+													| (c3 << 0);
 											};
 
 											do {
@@ -1250,12 +1725,13 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 												}
 
 												std::map<uint64_t, uint32_t> questTitleIdMap;
-												for (const auto& [rowId, rowSet] : exCreator->Data) {
+												for (const auto rowId : exCreator->GetIds()) {
+													const auto rowSet = exCreator->GetRowSet(rowId);
 													for (const auto& row : rowSet | std::views::values) {
 														if (row[5].String.Empty())
 															continue;
 
-														questTitleIdMap[ToMapKey(row)] = rowId;
+														questTitleIdMap[ToMapKey(row[0].uint64, row[1].uint64, row[2].uint64, row[3].uint64)] = rowId;
 														break; // intentional; first 4 columns should be same for all languages across regions.
 													}
 												}
@@ -1289,20 +1765,24 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 																	Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
 																		"[{}] Adding {}", exhName, exdPathSpec);
 
+																	if (exhReaderCurrent.Header.Depth != Sqex::Excel::Exh::Depth::Level2)
+																		throw std::invalid_argument("Not a 2nd depth sheet");
 																	const auto exdReader = Sqex::Excel::ExdReader(exhReaderCurrent, (*reader)[exdPathSpec]);
 																	exCreator->AddLanguage(language);
 
 																	for (const auto i : exdReader.GetIds()) {
-																		auto addingRow = exdReader.ReadDepth2(i);
-																		if (addingRow[5].String.Empty())
+																		// Most rows do not match; look at the columns needed without decoding the whole row.
+																		const auto addingRow = exdReader.GetRow(i);
+																		const auto addingTitle = addingRow.GetStringView(5);
+																		if (addingTitle.empty())
 																			continue;
 
-																		const auto targetRowIdIt = questTitleIdMap.find(ToMapKey(addingRow));
+																		const auto targetRowIdIt = questTitleIdMap.find(ToMapKey(addingRow.GetColumn(0).uint64, addingRow.GetColumn(1).uint64, addingRow.GetColumn(2).uint64, addingRow.GetColumn(3).uint64));
 																		if (targetRowIdIt == questTitleIdMap.end())
 																			continue;
 																		const auto targetRowId = targetRowIdIt->second;
 
-																		auto& rowSet = exCreator->Data.at(targetRowId);
+																		auto rowSet = exCreator->GetRowSet(targetRowId);
 																		std::vector<Sqex::Excel::ExdColumn> *pRow = nullptr;
 																		if (const auto it = rowSet.find(language); it != rowSet.end())
 																			pRow = &it->second;
@@ -1318,7 +1798,8 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 																		if (!pRow)
 																			continue;
 
-																		(*pRow)[5].String = std::move(addingRow[5].String);
+																		(*pRow)[5].String = Sqex::SeString(std::string(addingTitle));
+																		exCreator->SetRow(targetRowId, language, std::move(*pRow));
 																	}
 																} catch (const std::exception& e) {
 																	Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
@@ -1348,31 +1829,26 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 															try {
 																Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
 																	"[{}] Adding {}", exhName, exdPathSpec);
+																if (exhReaderCurrent.Header.Depth != Sqex::Excel::Exh::Depth::Level2)
+																	throw std::invalid_argument("Not a 2nd depth sheet");
 																const auto exdReader = Sqex::Excel::ExdReader(exhReaderCurrent, (*reader)[exdPathSpec]);
 																exCreator->AddLanguage(language);
+																const auto& prevColumns = *exdReader.ColumnDefinitions;
 																for (const auto i : exdReader.GetIds()) {
-																	auto row = exdReader.ReadDepth2(i);
-																	const auto rowSetIt = exCreator->Data.find(i);
-																	if (rowSetIt == exCreator->Data.end())
-																		continue;
-
-																	const auto& rowSet = rowSetIt->second;
 																	auto referenceRowLanguage = Sqex::Language::Unspecified;
-																	const std::vector<Sqex::Excel::ExdColumn>* referenceRowPtr = nullptr;
+																	std::optional<std::vector<Sqex::Excel::ExdColumn>> referenceRow;
 																	for (const auto& l : exCreator->FillMissingLanguageFrom) {
-																		if (auto it = rowSet.find(l);
-																			it != rowSet.end()) {
+																		if ((referenceRow = exCreator->TryGetRow(i, l))) {
 																			referenceRowLanguage = l;
-																			referenceRowPtr = &it->second;
 																			break;
 																		}
 																	}
-																	if (!referenceRowPtr)
+																	if (!referenceRow)
 																		continue;
-																	const auto& referenceRow = *referenceRowPtr;
 
-																	auto prevRow{ std::move(row) };
-																	row = referenceRow;
+																	// Strings are looked at in place; only those that get used are copied.
+																	const auto prevRow = exdReader.GetRow(i);
+																	auto row = std::move(*referenceRow);
 
 																	Sqex::SeString pluralBaseString;
 																	{
@@ -1384,10 +1860,10 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 																			pluralColumnIndices.languageSpecificColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.languageSpecificColumnIndex),
 																		};
 																		for (auto& col : cols) {
-																			if (col == N || col >= prevRow.size() || prevRow[col].Type != Sqex::Excel::Exh::ColumnDataType::String)
+																			if (col == N || col >= prevColumns.size() || !prevColumns[col].IsString())
 																				col = N;
-																			else if (!prevRow[col].String.Empty() && pluralBaseString.Empty())
-																				pluralBaseString = prevRow[col].String;
+																			else if (const auto prevString = prevRow.GetStringView(col); !prevString.empty() && pluralBaseString.Empty())
+																				pluralBaseString = Sqex::SeString(std::string(prevString));
 																		}
 																	}
 
@@ -1396,22 +1872,23 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 																			continue;
 
 																		const auto otherColIndex = translateColumnIndex(referenceRowLanguage, language, j);
-																		if (otherColIndex >= prevRow.size()) {
+																		if (otherColIndex >= prevColumns.size()) {
 																			if (otherColIndex != j)
 																				Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
 																					"[{}] Skipping column: Column {} of language {} is was requested but there are {} columns",
-																					exhName, j, otherColIndex, static_cast<int>(language), prevRow.size());
+																					exhName, j, otherColIndex, static_cast<int>(language), prevColumns.size());
 																			continue;
 																		}
 
-																		if (prevRow[otherColIndex].Type != Sqex::Excel::Exh::ColumnDataType::String) {
+																		if (!prevColumns[otherColIndex].IsString()) {
 																			Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
 																				"[{}] Skipping column: Column {} of language {} is string but column {} of language {} is not a string",
 																				exhName, j, static_cast<int>(referenceRowLanguage), otherColIndex, static_cast<int>(language));
 																			continue;
 																		}
 
-																		if (prevRow[otherColIndex].String.Empty()) {
+																		const auto prevString = prevRow.GetStringView(otherColIndex);
+																		if (prevString.empty()) {
 																			if (pluralBaseString.Empty())
 																				continue;
 
@@ -1426,10 +1903,10 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 																			continue;
 																		}
 
-																		if (prevRow[otherColIndex].String.Escaped().starts_with("_rsv_"))
+																		if (prevString.starts_with("_rsv_"))
 																			continue;
 
-																		row[j].String = std::move(prevRow[otherColIndex].String);
+																		row[j].String = Sqex::SeString(std::string(prevString));
 																	}
 																	exCreator->SetRow(i, language, std::move(row), false);
 																}
@@ -1449,10 +1926,13 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 										}
 
 										lastStep = "Ensure that there are no missing rows from externally sourced exd files";
-										for (auto& [id, rowSet] : exCreator->Data) {
+										for (const auto id : exCreator->GetIds()) {
 											if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
 												return;
 
+											// Work on a decoded copy of the row, and store every language back once done.
+											auto rowSet = exCreator->GetRowSet(id);
+
 											lastStep = "Find which language to use while filling current row if missing in other languages";
 											const std::vector<Sqex::Excel::ExdColumn>* referenceRowPtr = nullptr;
 											auto referenceRowLanguage = Sqex::Language::Unspecified;
@@ -1695,6 +2175,8 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 												pendingReplacements.emplace(language, std::move(row));
 											}
 											for (auto& [language, row] : pendingReplacements)
+												rowSet[language] = std::move(row);
+											for (auto& [language, row] : rowSet)
 												exCreator->SetRow(id, language, std::move(row));
 										}
 
@@ -1760,21 +2242,12 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 												//else
 												//	provider = std::make_unique<Sqex::Sqpack::EmptyOrObfuscatedEntryProvider>(entryPathSpec, std::make_shared<Sqex::MemoryRandomAccessStream>(std::move(*reinterpret_cast<std::vector<uint8_t>*>(&data))));
 												const auto len = provider->StreamSize();
-												const auto dv = provider->ReadStreamIntoVector<char>(0, static_cast<SSIZE_T>(len));
+												auto dv = provider->ReadStreamIntoVector<char>(0, static_cast<SSIZE_T>(len));
 
 												if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
 													return;
 
-												lastStep = "Write to filesystem";
-												const auto lock = std::lock_guard(writeMtx);
-												const auto entryLine = std::format("{}\n", nlohmann::json::object({
-													{"FullPath", Utils::StringReplaceAll<std::string>(Utils::ToUtf8(entryPathSpec.FullPath.wstring()), "\\", "/")},
-													{"ModOffset", ttmpdPtr},
-													{"ModSize", len},
-													{"DatFile", "0a0000"},
-													}).dump());
-												ttmplPtr += ttmpl.Write(ttmplPtr, std::span(entryLine));
-												ttmpdPtr += ttmpd.Write(ttmpdPtr, std::span(dv));
+												outputs.emplace_back(CompiledEntry{entryPathSpec, len, std::move(dv)});
 											}
 											currentProgress = 0;
 											progressIndex++;
@@ -1815,7 +2288,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 						} catch (...) {
 							// whatever
 						}
-						return;
+						return false;
 					}
 
 					try {
@@ -1843,7 +2316,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 							"\t=> Error processing {}: {}", error.first, error.second);
 					}
 				}
-				return;
+				return true;
 
 			} catch (const std::exception& e) {
 				Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "[ffxiv/0a0000] Error: {}", e.what());
@@ -1853,13 +2326,14 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					case IDABORT:
 						ExitProcess(-1);
 					case IDIGNORE:
-						return;
+						return false;
 				}
 			}
 		}
 	}
 
-	void SetUpVirtualFileFromFileEntries(Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexPath) {
+	// Returns pairs of directory to look for replacement files in, and the directory that entry paths are relative to, in order of precedence.
+	[[nodiscard]] std::vector<std::pair<std::filesystem::path, std::filesystem::path>> GetVirtualFileEntryDirs(const Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexPath) const {
 		std::vector<std::filesystem::path> rootDirs;
 		rootDirs.emplace_back(indexPath.parent_path().parent_path());
 		rootDirs.emplace_back(Config->Init.ResolveConfigStorageDirectoryPath() / "ReplacementFileEntries");
@@ -1904,6 +2378,12 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			for (const auto& dir : rootDirs)
 				dirs.emplace_back(dir / pathPrefix, dir);
 		}
+		return dirs;
+	}
+
+	void SetUpVirtualFileFromFileEntries(Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexPath) {
+		const auto dirs = GetVirtualFileEntryDirs(creator, indexPath);
+
 		for (const auto& [dir, relativeTo] : dirs) {
 			if (!is_directory(dir))
 				continue;
@@ -1953,46 +2433,37 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		}
 	}
 
-	void SetUpGeneratedFonts(Apps::MainApp::Window::ProgressPopupWindow& progressWindow, Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexPath) {
-		while (true) {
-			const auto fontConfigPath{ Config->Runtime.OverrideFontConfig.Value() };
-			if (fontConfigPath.empty())
-				return;
+	[[nodiscard]] std::filesystem::path GetGeneratedFontsCacheDir(const std::filesystem::path& fontConfigPath) const {
+		return Config->Init.ResolveConfigStorageDirectoryPath() / "Cached" / GameReleaseInfo.CountryCode / "Font" / fontConfigPath.filename().replace_extension("");
+	}
 
-			try {
-				const auto cachedDir = Config->Init.ResolveConfigStorageDirectoryPath() / "Cached" / GameReleaseInfo.CountryCode / "Font" / fontConfigPath.filename().replace_extension("");
-
-				std::string currentCacheKeys("VERSION:2\n");
-				{
-					const auto gameRoot = indexPath.parent_path().parent_path().parent_path();
-					const auto versionFile = Utils::Win32::Handle::FromCreateFile(gameRoot / "ffxivgame.ver", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
-					const auto versionContent = versionFile.Read<char>(0, static_cast<size_t>(versionFile.GetFileSize()));
-					currentCacheKeys += std::format("SQPACK:{}:{}:{}\n",
-						canonical(gameRoot).wstring(),
-						Config->Runtime.CompressModdedFiles ? "compress" : "nocompress",
-						std::string(versionContent.begin(), versionContent.end()));
-				}
+	[[nodiscard]] std::string GetGeneratedFontsCacheKeys(const std::filesystem::path& indexPath) const {
+		std::string currentCacheKeys("VERSION:2\n");
+		{
+			const auto gameRoot = indexPath.parent_path().parent_path().parent_path();
+			const auto versionFile = Utils::Win32::Handle::FromCreateFile(gameRoot / "ffxivgame.ver", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+			const auto versionContent = versionFile.Read<char>(0, static_cast<size_t>(versionFile.GetFileSize()));
+			currentCacheKeys += std::format("SQPACK:{}:{}:{}\n",
+				canonical(gameRoot).wstring(),
+				Config->Runtime.CompressModdedFiles ? "compress" : "nocompress",
+				std::string(versionContent.begin(), versionContent.end()));
+		}
 
-				if (const auto& configFile = Config->Runtime.OverrideFontConfig.Value(); !configFile.empty()) {
-					uint8_t hash[20]{};
-					try {
-						const auto file = Utils::Win32::Handle::FromCreateFile(configFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
-						CryptoPP::SHA1 sha1;
-						const auto content = file.Read<uint8_t>(0, static_cast<size_t>(file.GetFileSize()));
-						sha1.Update(content.data(), content.size());
-						sha1.Final(reinterpret_cast<byte*>(hash));
-					} catch (...) {
-					}
+		if (const auto& configFile = Config->Runtime.OverrideFontConfig.Value(); !configFile.empty())
+			currentCacheKeys += std::format("CONF:{}:{}\n", configFile, HashFileContentsForCacheKey(configFile));
 
-					CryptoPP::HexEncoder encoder;
-					encoder.Put(hash, sizeof hash);
-					encoder.MessageEnd();
+		return currentCacheKeys;
+	}
 
-					std::string buf(static_cast<size_t>(encoder.MaxRetrievable()), 0);
-					encoder.Get(reinterpret_cast<byte*>(&buf[0]), buf.size());
+	bool SetUpGeneratedFonts(Apps::MainApp::Window::ProgressPopupWindow& progressWindow, Sqex::Sqpack::Creator& creator, const std::filesystem::path& indexPath) {
+		while (true) {
+			const auto fontConfigPath{ Config->Runtime.OverrideFontConfig.Value() };
+			if (fontConfigPath.empty())
+				return true;
 
-					currentCacheKeys += std::format("CONF:{}:{}\n", configFile, buf);
-				}
+			try {
+				const auto cachedDir = GetGeneratedFontsCacheDir(fontConfigPath);
+				const auto currentCacheKeys = GetGeneratedFontsCacheKeys(indexPath);
 
 				auto needRecreate = true;
 				try {
@@ -2016,6 +2487,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					cfg.ValidateOrThrow();
 
 					Sqex::FontCsv::FontSetsCreator fontCreator(cfg, Utils::Win32::Process::Current().PathOf().parent_path());
+					fontCreator.SetGlyphCacheDirectory(Config->Init.ResolveConfigStorageDirectoryPath() / "Cached" / "Glyphs");
 					for (const auto& additionalSqpackRootDirectory : Config->Runtime.AdditionalSqpackRootDirectories.Value()) {
 						try {
 							const auto info = Misc::GameInstallationDetector::GetGameReleaseInfo(Config::TranslatePath(additionalSqpackRootDirectory));
@@ -2029,6 +2501,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					for (const auto& info : Misc::GameInstallationDetector::FindInstallations())
 						fontCreator.ProvideGameDirectory(info.Region, info.RootPath);
 					SetupGeneratedFonts_VerifyRequirements(fontCreator, progressWindow);
+					const auto generateStartTime = GetTickCount64();
 					fontCreator.Start();
 
 					while (WAIT_TIMEOUT == progressWindow.DoModalLoop(100, { fontCreator.GetWaitableObject() })) {
@@ -2040,6 +2513,9 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 						else
 							progressWindow.UpdateMessage(Utils::ToUtf8(Config->Runtime.GetStringRes(IDS_TITLE_GENERATING_FONTS)));
 					}
+					Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
+						"=> Generated fonts in {}ms",
+						GetTickCount64() - generateStartTime);
 					if (progressWindow.GetCancelEvent().Wait(0) != WAIT_OBJECT_0) {
 						progressWindow.UpdateMessage(Utils::ToUtf8(Config->Runtime.GetStringRes(IDS_TITLE_COMPRESSING)));
 						Utils::Win32::TpEnvironment pool(L"SetUpGeneratedFonts");
@@ -2118,7 +2594,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 						} catch (...) {
 							// whatever
 						}
-						return;
+						return false;
 					}
 
 					try {
@@ -2147,22 +2623,22 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					}
 				}
 
-				return;
+				return true;
 			} catch (const Utils::Win32::CancelledError&) {
 				Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks, "[ffxiv/000000] Font generation cancelled");
-				return;
+				return false;
 
 			} catch (const std::exception& e) {
 				Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "[ffxiv/000000] Error: {}", e.what());
 				if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
-					return;
+					return false;
 				switch (Dll::MessageBoxF(progressWindow.Handle(), MB_ICONERROR | MB_ABORTRETRYIGNORE, IDS_ERROR_GENERATEFONT, e.what())) {
 					case IDRETRY:
 						continue;
 					case IDABORT:
 						ExitProcess(-1);
 					case IDIGNORE:
-						return;
+						return false;
 				}
 			}
 		}
@@ -2406,6 +2882,10 @@ void XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::MarkIoRequest() {
 	m_pImpl->IoEvent.Set();
 }
 
+Sqex::Sqpack::ReadScheduler& XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::GetReadScheduler() {
+	return m_pImpl->ReadScheduler;
+}
+
 void XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::TtmpSet::FixChoices() {
 	if (!Choices.is_array())
 		Choices = nlohmann::json::array();
@@ -2,6 +2,7 @@
 
 #include <XivAlexanderCommon/Sqex.h>
 #include <XivAlexanderCommon/Sqex/Sqpack.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/ReadScheduler.h>
 #include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
 #include <XivAlexanderCommon/Utils/Win32/Handle.h>
 
@@ -32,6 +33,7 @@ namespace XivAlexander::Apps::MainApp::Internal {
 			std::filesystem::path Path;
 			LARGE_INTEGER FilePointer;
 			std::shared_ptr<Sqex::RandomAccessStream> Stream;
+			bool Overlapped = false;
 		};
 
 		OverlayedHandleData* Get(HANDLE handle);
@@ -41,6 +43,9 @@ namespace XivAlexander::Apps::MainApp::Internal {
 
 		void MarkIoRequest();
 
+		// Services overlapped reads on virtual files; drained and invalidated whenever entries get swapped.
+		Sqex::Sqpack::ReadScheduler& GetReadScheduler();
+
 		struct TtmpSet {
 			bool Allocated = false;
 			std::filesystem::path ListPath;
@@ -15,6 +15,7 @@
 // C++ standard library
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <filesystem>
 #include <format>
 #include <fstream>
@@ -29,10 +30,12 @@
 #include <ranges>
 #include <regex>
 #include <set>
+#include <shared_mutex>
 #include <signal.h>
 #include <span>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 
 // Windows API, part 1
 #define NOMINMAX
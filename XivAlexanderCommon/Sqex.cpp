@@ -131,19 +131,6 @@ void Sqex::from_json(const nlohmann::json& j, GameReleaseRegion& newValue) {
 		newValue = GameReleaseRegion::Korean;
 }
 
-Sqex::RandomAccessStream::RandomAccessStream() = default;
-
-Sqex::RandomAccessStream::~RandomAccessStream() = default;
-
-uint64_t Sqex::RandomAccessStream::ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const {
-	return ReadStreamPartial(offset, buf, length);
-}
-
-void Sqex::RandomAccessStream::ReadStream(uint64_t offset, void* buf, uint64_t length) const {
-	if (ReadStreamPartial(offset, buf, length) != length)
-		throw std::runtime_error("Reached end of stream before reading all of the requested data.");
-}
-
 Sqex::BufferedRandomAccessStream::~BufferedRandomAccessStream() {
 	for (const auto addr : m_buffers)
 		if (addr)
@@ -243,3 +230,30 @@ uint64_t Sqex::FileRandomAccessStream::ReadStreamPartial(uint64_t offset, void*
 	const auto available = static_cast<size_t>(std::min(length, m_size - offset));
 	return m_file.Read(m_offset + offset, buf, available, Win32::Handle::PartialIoMode::AllowPartial);
 }
+
+Sqex::MemoryMappedRandomAccessStream::MemoryMappedRandomAccessStream(const std::filesystem::path& path)
+	: m_file(Win32::Handle::FromCreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0))
+	, m_size(m_file.GetFileSize())
+	// CreateFileMappingW refuses to map empty files
+	, m_mapping(m_size ? Win32::FileMapping::Create(m_file) : Win32::FileMapping())
+	, m_view(m_size ? Win32::FileMapping::View::Create(m_mapping) : Win32::FileMapping::View()) {
+	if (m_size > SIZE_MAX)
+		throw std::invalid_argument(std::format("file size({} from {}) exceeds addressable space", m_size, path));
+}
+
+Sqex::MemoryMappedRandomAccessStream::~MemoryMappedRandomAccessStream() = default;
+
+uint64_t Sqex::MemoryMappedRandomAccessStream::ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const {
+	if (offset >= m_size)
+		return 0;
+	if (offset + length > m_size)
+		length = m_size - offset;
+	std::copy_n(static_cast<const uint8_t*>(*m_view) + offset, static_cast<size_t>(length), static_cast<uint8_t*>(buf));
+	return length;
+}
+
+std::span<const uint8_t> Sqex::MemoryMappedRandomAccessStream::GetDirectView() const {
+	if (!m_size)
+		return {};
+	return {static_cast<const uint8_t*>(*m_view), static_cast<size_t>(m_size)};
+}
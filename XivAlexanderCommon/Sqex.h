@@ -5,6 +5,7 @@
 #include <span>
 #include <type_traits>
 
+#include "XivAlexanderCommon/Sqex/RandomAccessStream.h"
 #include "XivAlexanderCommon/Utils/Win32/Handle.h"
 #include "XivAlexanderCommon/Utils/Utils.h"
 #include "XivAlexanderCommon/Utils/StringUtils.h"
@@ -131,64 +132,6 @@ namespace Sqex {
 		return true;
 	}
 	
-	class RandomAccessStream : public std::enable_shared_from_this<RandomAccessStream> {
-	public:
-		RandomAccessStream();
-		RandomAccessStream(RandomAccessStream&&) = delete;
-		RandomAccessStream(const RandomAccessStream&) = delete;
-		RandomAccessStream& operator=(RandomAccessStream&&) = delete;
-		RandomAccessStream& operator=(const RandomAccessStream&) = delete;
-		virtual ~RandomAccessStream();
-
-		[[nodiscard]] virtual uint64_t StreamSize() const = 0;
-		virtual uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const = 0;
-
-		void ReadStream(uint64_t offset, void* buf, uint64_t length) const;
-
-		template<typename T>
-		T ReadStream(uint64_t offset) const {
-			T buf;
-			ReadStream(offset, &buf, sizeof(T));
-			return buf;
-		}
-
-		template<typename T>
-		void ReadStream(uint64_t offset, std::span<T> buf) const {
-			ReadStream(offset, buf.data(), buf.size_bytes());
-		}
-
-		template<typename T>
-		std::vector<T> ReadStreamIntoVector(uint64_t offset, size_t count = SIZE_MAX, size_t maxCount = SIZE_MAX) const {
-			if (count > maxCount)
-				throw std::runtime_error("trying to read too many");
-			if (count == SIZE_MAX)
-				count = static_cast<size_t>(StreamSize() / sizeof(T));
-			std::vector<T> result(count);
-			ReadStream(offset, std::span(result));
-			return result;
-		}
-
-		template<typename T>
-		std::function<std::span<T>(size_t len, bool throwOnIncompleteRead)> AsLinearReader() const {
-			return [this, buf = std::vector<T>(), ptr = uint64_t(), to = StreamSize()](size_t len, bool throwOnIncompleteRead) mutable {
-				if (ptr == to)
-					return std::span<T>();
-				buf.resize(static_cast<size_t>(std::min<uint64_t>(len, to - ptr)));
-				const auto read = ReadStreamPartial(ptr, buf.data(), buf.size());
-				if (read < buf.size() && throwOnIncompleteRead)
-					throw std::runtime_error("incomplete read");
-				ptr += buf.size();
-				return std::span(buf);
-			};
-		}
-
-		virtual std::string DescribeState() const { return {}; }
-
-		virtual void EnableBuffering(bool bEnable) {}
-
-		virtual void Flush() const {}
-	};
-
 	class BufferedRandomAccessStream : public RandomAccessStream {
 		const std::shared_ptr<RandomAccessStream> m_stream;
 		const size_t m_bufferSize;
@@ -339,8 +282,32 @@ namespace Sqex {
 			return length;
 		}
 
+		[[nodiscard]] std::span<const uint8_t> GetDirectView() const override {
+			return m_view;
+		}
+
 		bool OwnsData() const {
 			return !m_buffer.empty() && m_view.data() == m_buffer.data();
 		}
 	};
+
+	class MemoryMappedRandomAccessStream : public RandomAccessStream {
+		const Win32::Handle m_file;
+		const uint64_t m_size;
+		const Win32::FileMapping m_mapping;
+		const Win32::FileMapping::View m_view;
+
+	public:
+		MemoryMappedRandomAccessStream(const std::filesystem::path& path);
+		~MemoryMappedRandomAccessStream() override;
+
+		[[nodiscard]] uint64_t StreamSize() const override { return m_size; }
+		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override;
+
+		[[nodiscard]] std::span<const uint8_t> GetDirectView() const override;
+
+		std::string DescribeState() const override {
+			return std::format("MemoryMappedRandomAccessStream({}, {})", m_file.GetPathName(), m_size);
+		}
+	};
 }
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/Excel/Generator.h"
 
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
 Sqex::Excel::Depth2ExhExdCreator::Depth2ExhExdCreator(std::string name, std::vector<Exh::Column> columns, const Exh::ExhFlag& flag)
 	: Name(std::move(name))
 	, Columns(std::move(columns))
@@ -46,6 +48,7 @@ Sqex::Excel::Depth2ExhExdCreator::Depth2ExhExdCreator(std::string name, std::vec
 		}
 		return Sqex::Align<uint32_t>(size, 8).Alloc;
 	}()) {
+	m_strings.emplace_back();
 }
 
 void Sqex::Excel::Depth2ExhExdCreator::AddLanguage(Language language) {
@@ -54,46 +57,273 @@ void Sqex::Excel::Depth2ExhExdCreator::AddLanguage(Language language) {
 		Languages.insert(it, language);
 }
 
-const std::vector<Sqex::Excel::ExdColumn>& Sqex::Excel::Depth2ExhExdCreator::GetRow(uint32_t id, Language language) const {
-	return Data.at(id).at(language);
+size_t Sqex::Excel::Depth2ExhExdCreator::FindRowIndex(uint32_t id) const {
+	const auto it = std::ranges::lower_bound(m_ids, id);
+	if (it == m_ids.end() || *it != id)
+		return SIZE_MAX;
+	return static_cast<size_t>(it - m_ids.begin());
+}
+
+size_t Sqex::Excel::Depth2ExhExdCreator::EnsureRowIndex(uint32_t id) {
+	// Rows usually come in ascending order, making this an append.
+	const auto it = std::ranges::lower_bound(m_ids, id);
+	const auto index = static_cast<size_t>(it - m_ids.begin());
+	if (it != m_ids.end() && *it == id)
+		return index;
+
+	m_ids.insert(it, id);
+	for (auto& data : m_languageData | std::views::values) {
+		data.FixedData.insert(data.FixedData.begin() + static_cast<ptrdiff_t>(index * FixedDataSize), FixedDataSize, 0);
+		data.Present.insert(data.Present.begin() + static_cast<ptrdiff_t>(index), false);
+	}
+	return index;
+}
+
+uint32_t Sqex::Excel::Depth2ExhExdCreator::InternString(const std::string& s) {
+	if (s.empty())
+		return 0;
+	if (const auto it = m_stringIndices.find(s); it != m_stringIndices.end())
+		return it->second;
+
+	const auto index = static_cast<uint32_t>(m_strings.size());
+	m_stringIndices.emplace(m_strings.emplace_back(s), index);
+	return index;
+}
+
+bool Sqex::Excel::Depth2ExhExdCreator::HasRow(uint32_t id) const {
+	return FindRowIndex(id) != SIZE_MAX;
+}
+
+std::optional<std::vector<Sqex::Excel::ExdColumn>> Sqex::Excel::Depth2ExhExdCreator::TryGetRow(uint32_t id, Language language) const {
+	const auto index = FindRowIndex(id);
+	if (index == SIZE_MAX)
+		return std::nullopt;
+
+	const auto it = m_languageData.find(language);
+	if (it == m_languageData.end() || !it->second.Present[index])
+		return std::nullopt;
+
+	return DecodeRow(it->second, index);
+}
+
+std::vector<Sqex::Excel::ExdColumn> Sqex::Excel::Depth2ExhExdCreator::GetRow(uint32_t id, Language language) const {
+	if (auto row = TryGetRow(id, language))
+		return std::move(*row);
+	throw std::out_of_range("row not found");
+}
+
+std::map<Sqex::Language, std::vector<Sqex::Excel::ExdColumn>> Sqex::Excel::Depth2ExhExdCreator::GetRowSet(uint32_t id) const {
+	std::map<Language, std::vector<ExdColumn>> result;
+	const auto index = FindRowIndex(id);
+	if (index == SIZE_MAX)
+		return result;
+
+	for (const auto& [language, data] : m_languageData) {
+		if (data.Present[index])
+			result.emplace(language, DecodeRow(data, index));
+	}
+	return result;
 }
 
 void Sqex::Excel::Depth2ExhExdCreator::SetRow(uint32_t id, Language language, std::vector<ExdColumn> row, bool replace) {
 	if (!row.empty() && row.size() != Columns.size())
 		throw std::invalid_argument(std::format("bad column data (expected {} columns, got {} columns)", Columns.size(), row.size()));
-	auto& target = Data[id][language];
-	if (target.empty() || replace)
-		target = std::move(row);
+
+	const auto index = EnsureRowIndex(id);
+	auto it = m_languageData.find(language);
+	if (it == m_languageData.end()) {
+		it = m_languageData.emplace(language, LanguageData{
+			.FixedData = std::vector<char>(m_ids.size() * FixedDataSize),
+			.Present = std::vector<bool>(m_ids.size()),
+		}).first;
+	}
+	auto& data = it->second;
+	if (data.Present[index] && !replace)
+		return;
+
+	const auto fixedData = std::span(data.FixedData).subspan(index * FixedDataSize, FixedDataSize);
+	std::ranges::fill(fixedData, 0);
+	data.Present[index] = !row.empty();
+
+	for (size_t i = 0; i < row.size(); ++i) {
+		const auto& column = row[i];
+		const auto& columnDefinition = Columns[i];
+		size_t validSize = 0;
+		switch (columnDefinition.Type) {
+			case Exh::String:
+			{
+				const auto stringIndex = InternString(column.String.Escaped());
+				std::copy_n(reinterpret_cast<const char*>(&stringIndex), 4, &fixedData[columnDefinition.Offset]);
+				break;
+			}
+
+			case Exh::Bool:
+			case Exh::Int8:
+			case Exh::UInt8:
+				validSize = 1;
+				break;
+
+			case Exh::Int16:
+			case Exh::UInt16:
+				validSize = 2;
+				break;
+
+			case Exh::Int32:
+			case Exh::UInt32:
+			case Exh::Float32:
+				validSize = 4;
+				break;
+
+			case Exh::Int64:
+			case Exh::UInt64:
+				validSize = 8;
+				break;
+
+			case Exh::PackedBool0:
+			case Exh::PackedBool1:
+			case Exh::PackedBool2:
+			case Exh::PackedBool3:
+			case Exh::PackedBool4:
+			case Exh::PackedBool5:
+			case Exh::PackedBool6:
+			case Exh::PackedBool7:
+				if (column.boolean)
+					fixedData[columnDefinition.Offset] |= (1 << (static_cast<int>(columnDefinition.Type.Value()) - static_cast<int>(Exh::PackedBool0)));
+				break;
+		}
+		if (validSize) {
+			const auto target = fixedData.subspan(columnDefinition.Offset, validSize);
+			std::copy_n(&column.Buffer[0], validSize, &target[0]);
+			// ReSharper disable once CppUseRangeAlgorithm
+			std::reverse(target.begin(), target.end());
+		}
+	}
 }
 
-std::pair<Sqex::Sqpack::EntryPathSpec, std::vector<char>> Sqex::Excel::Depth2ExhExdCreator::Flush(uint32_t startId, std::map<uint32_t, std::vector<char>> rows, Language language) {
+std::vector<Sqex::Excel::ExdColumn> Sqex::Excel::Depth2ExhExdCreator::DecodeRow(const LanguageData& data, size_t rowIndex) const {
+	const auto fixedData = std::span(data.FixedData).subspan(rowIndex * FixedDataSize, FixedDataSize);
+
+	std::vector<ExdColumn> row;
+	row.reserve(Columns.size());
+	for (const auto& columnDefinition : Columns) {
+		auto& column = row.emplace_back(ExdColumn{ .Type = columnDefinition.Type });
+		switch (column.Type) {
+			case Exh::String:
+			{
+				uint32_t stringIndex;
+				std::copy_n(&fixedData[columnDefinition.Offset], 4, reinterpret_cast<char*>(&stringIndex));
+				column.String.SetEscaped(m_strings[stringIndex]);
+				break;
+			}
+
+			case Exh::Bool:
+			case Exh::Int8:
+			case Exh::UInt8:
+				column.ValidSize = 1;
+				break;
+
+			case Exh::Int16:
+			case Exh::UInt16:
+				column.ValidSize = 2;
+				break;
+
+			case Exh::Int32:
+			case Exh::UInt32:
+			case Exh::Float32:
+				column.ValidSize = 4;
+				break;
+
+			case Exh::Int64:
+			case Exh::UInt64:
+				column.ValidSize = 8;
+				break;
+
+			case Exh::PackedBool0:
+			case Exh::PackedBool1:
+			case Exh::PackedBool2:
+			case Exh::PackedBool3:
+			case Exh::PackedBool4:
+			case Exh::PackedBool5:
+			case Exh::PackedBool6:
+			case Exh::PackedBool7:
+				column.boolean = fixedData[columnDefinition.Offset] & (1 << (static_cast<int>(column.Type) - static_cast<int>(Exh::PackedBool0)));
+				break;
+		}
+		if (column.ValidSize) {
+			std::copy_n(&fixedData[columnDefinition.Offset], column.ValidSize, &column.Buffer[0]);
+			std::reverse(&column.Buffer[0], &column.Buffer[column.ValidSize]);
+		}
+	}
+	return row;
+}
+
+void Sqex::Excel::Depth2ExhExdCreator::AppendEncodedRow(std::vector<char>& out, const LanguageData& data, size_t rowIndex) const {
+	const auto sourceFixedData = std::span(data.FixedData).subspan(rowIndex * FixedDataSize, FixedDataSize);
+	const auto rowOffset = out.size();
+	const auto fixedDataOffset = rowOffset + sizeof Exd::RowHeader;
+	const auto variableDataOffset = fixedDataOffset + FixedDataSize;
+
+	out.resize(variableDataOffset);
+	std::ranges::copy(sourceFixedData, out.begin() + static_cast<ptrdiff_t>(fixedDataOffset));
+	for (const auto& columnDefinition : Columns) {
+		if (columnDefinition.Type != Exh::String)
+			continue;
+
+		uint32_t stringIndex;
+		std::copy_n(&sourceFixedData[columnDefinition.Offset], 4, reinterpret_cast<char*>(&stringIndex));
+		const auto stringOffset = BE(static_cast<uint32_t>(out.size() - variableDataOffset));
+		std::copy_n(reinterpret_cast<const char*>(&stringOffset), 4, &out[fixedDataOffset + columnDefinition.Offset]);
+
+		const auto& escaped = m_strings[stringIndex];
+		out.insert(out.end(), escaped.begin(), escaped.end());
+		out.push_back(0);
+	}
+	out.resize(rowOffset + Sqex::Align<size_t>(out.size() - rowOffset, 4));
+
+	Exd::RowHeader rowHeader;
+	rowHeader.DataSize = static_cast<uint32_t>(out.size() - fixedDataOffset);
+	rowHeader.SubRowCount = 1;
+	std::copy_n(reinterpret_cast<const char*>(&rowHeader), sizeof rowHeader, &out[rowOffset]);
+}
+
+std::optional<std::pair<Sqex::Sqpack::EntryPathSpec, std::vector<char>>> Sqex::Excel::Depth2ExhExdCreator::Flush(uint32_t startId, size_t fromRowIndex, size_t toRowIndex, Language language) const {
+	std::vector<std::pair<size_t, const LanguageData*>> rows;
+	for (auto i = fromRowIndex; i < toRowIndex; ++i) {
+		const LanguageData* source = nullptr;
+		if (const auto it = m_languageData.find(language); it != m_languageData.end() && it->second.Present[i]) {
+			source = &it->second;
+		} else {
+			for (const auto lang : FillMissingLanguageFrom) {
+				if (const auto it2 = m_languageData.find(lang); it2 != m_languageData.end() && it2->second.Present[i]) {
+					source = &it2->second;
+					break;
+				}
+			}
+		}
+		if (source)
+			rows.emplace_back(i, source);
+	}
+	if (rows.empty())
+		return std::nullopt;
+
 	Exd::Header exdHeader;
-	const auto exdHeaderSpan = span_cast<char>(1, &exdHeader);
 	memcpy(exdHeader.Signature, Exd::Header::Signature_Value, 4);
 	exdHeader.Version = Exd::Header::Version_Value;
+	exdHeader.IndexSize = static_cast<uint32_t>(rows.size() * sizeof Exd::RowLocator);
 
-	size_t dataSize = 0;
-	for (const auto& row : rows | std::views::values)
-		dataSize += row.size();
-	exdHeader.DataSize = static_cast<uint32_t>(dataSize);
-
+	std::vector<char> exdFile(sizeof exdHeader + exdHeader.IndexSize);
 	std::vector<Exd::RowLocator> locators;
-	auto offsetAccumulator = static_cast<uint32_t>(sizeof exdHeader + rows.size() * sizeof Exd::RowLocator);
-	for (const auto& row : rows) {
-		locators.emplace_back(row.first, offsetAccumulator);
-		offsetAccumulator += static_cast<uint32_t>(row.second.size());
-		if (reinterpret_cast<const Exd::RowHeader*>(&row.second[0])->DataSize != row.second.size() - 6)
-			__debugbreak();
+	locators.reserve(rows.size());
+	for (const auto& [rowIndex, source] : rows) {
+		locators.emplace_back(m_ids[rowIndex], static_cast<uint32_t>(exdFile.size()));
+		AppendEncodedRow(exdFile, *source, rowIndex);
 	}
-	const auto locatorSpan = span_cast<char>(locators);
-	exdHeader.IndexSize = static_cast<uint32_t>(locatorSpan.size_bytes());
+	exdHeader.DataSize = static_cast<uint32_t>(exdFile.size() - sizeof exdHeader - exdHeader.IndexSize);
 
-	std::vector<char> exdFile;
-	exdFile.reserve(offsetAccumulator);
-	std::copy_n(&exdHeaderSpan[0], exdHeaderSpan.size_bytes(), std::back_inserter(exdFile));
-	std::copy_n(&locatorSpan[0], locatorSpan.size_bytes(), std::back_inserter(exdFile));
-	for (const auto& row : rows | std::views::values)
-		std::copy_n(&row[0], row.size(), std::back_inserter(exdFile));
+	const auto exdHeaderSpan = span_cast<char>(1, &exdHeader);
+	const auto locatorSpan = span_cast<char>(locators);
+	std::copy_n(&exdHeaderSpan[0], exdHeaderSpan.size_bytes(), &exdFile[0]);
+	std::copy_n(&locatorSpan[0], locatorSpan.size_bytes(), &exdFile[sizeof exdHeader]);
 
 	const auto* languageCode = "";
 	switch (language) {
@@ -129,126 +359,41 @@ std::pair<Sqex::Sqpack::EntryPathSpec, std::vector<char>> Sqex::Excel::Depth2Exh
 	);
 }
 
-std::map<Sqex::Sqpack::EntryPathSpec, std::vector<char>, Sqex::Sqpack::EntryPathSpec::FullPathComparator> Sqex::Excel::Depth2ExhExdCreator::Compile(size_t divideUnit) {
+std::map<Sqex::Sqpack::EntryPathSpec, std::vector<char>, Sqex::Sqpack::EntryPathSpec::FullPathComparator> Sqex::Excel::Depth2ExhExdCreator::Compile(size_t divideUnit) const {
 	std::map<Sqpack::EntryPathSpec, std::vector<char>, Sqpack::EntryPathSpec::FullPathComparator> result;
-	std::vector<std::pair<Exh::Pagination, std::vector<uint32_t>>> pages;
-	for (const auto id : Data | std::views::keys) {
-		if (pages.empty()) {
-			pages.emplace_back();
-		} else if (pages.back().second.size() == divideUnit || DivideAtIds.find(id) != DivideAtIds.end()) {
-			pages.back().first.RowCountWithSkip = pages.back().second.back() - pages.back().second.front() + 1;
-			pages.emplace_back();
-		}
 
-		if (pages.back().second.empty())
-			pages.back().first.StartId = id;
-		pages.back().second.push_back(id);
+	struct Page {
+		Exh::Pagination Pagination;
+		size_t FromRowIndex;
+		size_t ToRowIndex;
+	};
+	std::vector<Page> pages;
+	for (size_t i = 0; i < m_ids.size(); ++i) {
+		const auto id = m_ids[i];
+		if (!pages.empty() && i - pages.back().FromRowIndex != divideUnit && !DivideAtIds.contains(id))
+			continue;
+
+		if (!pages.empty()) {
+			pages.back().ToRowIndex = i;
+			pages.back().Pagination.RowCountWithSkip = m_ids[i - 1] - pages.back().Pagination.StartId + 1;
+		}
+		pages.emplace_back(Page{ .FromRowIndex = i });
+		pages.back().Pagination.StartId = id;
 	}
 	if (pages.empty())
 		return {};
-	pages.back().first.RowCountWithSkip = pages.back().second.back() - pages.back().second.front() + 1;
-
-	for (const auto& page : pages) {
-		for (const auto language : Languages) {
-			std::map<uint32_t, std::vector<char>> rows;
-			for (const auto id : page.second) {
-				std::vector<char> row(sizeof Exd::RowHeader + FixedDataSize);
-
-				const auto fixedDataOffset = sizeof Exd::RowHeader;
-				const auto variableDataOffset = fixedDataOffset + FixedDataSize;
-
-				auto sourceLanguage = language;
-				auto& rowSet = Data[id];
-				if (rowSet.find(sourceLanguage) == rowSet.end()) {
-					sourceLanguage = Language::Unspecified;
-					for (auto lang : FillMissingLanguageFrom) {
-						if (rowSet.find(lang) == rowSet.end()) {
-							sourceLanguage = lang;
-							break;
-						}
-					}
-					if (sourceLanguage == Language::Unspecified)
-						continue;
-				}
-
-				auto& columns = rowSet[sourceLanguage];
-				if (columns.empty())
-					continue;
-
-				for (size_t i = 0; i < columns.size(); ++i) {
-					auto& column = columns[i];
-					const auto& columnDefinition = Columns[i];
-					switch (columnDefinition.Type) {
-						case Exh::String:
-						{
-							const auto stringOffset = BE(static_cast<uint32_t>(row.size() - variableDataOffset));
-							std::copy_n(reinterpret_cast<const char*>(&stringOffset), 4, &row[fixedDataOffset + columnDefinition.Offset]);
-							row.reserve(row.size() + column.String.Escaped().size() + 1);
-							row.insert(row.end(), column.String.Escaped().begin(), column.String.Escaped().end());
-							row.push_back(0);
-							column.ValidSize = 0;
-							break;
-						}
-
-						case Exh::Bool:
-						case Exh::Int8:
-						case Exh::UInt8:
-							column.ValidSize = 1;
-							break;
-
-						case Exh::Int16:
-						case Exh::UInt16:
-							column.ValidSize = 2;
-							break;
-
-						case Exh::Int32:
-						case Exh::UInt32:
-						case Exh::Float32:
-							column.ValidSize = 4;
-							break;
-
-						case Exh::Int64:
-						case Exh::UInt64:
-							column.ValidSize = 8;
-							break;
-
-						case Exh::PackedBool0:
-						case Exh::PackedBool1:
-						case Exh::PackedBool2:
-						case Exh::PackedBool3:
-						case Exh::PackedBool4:
-						case Exh::PackedBool5:
-						case Exh::PackedBool6:
-						case Exh::PackedBool7:
-							column.ValidSize = 0;
-							if (column.boolean)
-								row[fixedDataOffset + columnDefinition.Offset] |= (1 << (static_cast<int>(column.Type) - static_cast<int>(Exh::PackedBool0)));
-							else
-								row[fixedDataOffset + columnDefinition.Offset] &= ~((1 << (static_cast<int>(column.Type) - static_cast<int>(Exh::PackedBool0))));
-							break;
-					}
-					if (column.ValidSize) {
-						const auto target = std::span(row).subspan(fixedDataOffset + columnDefinition.Offset, column.ValidSize);
-						std::copy_n(&column.Buffer[0], column.ValidSize, &target[0]);
-						// ReSharper disable once CppUseRangeAlgorithm
-						std::reverse(target.begin(), target.end());
-					}
-				}
-				row.resize(Sqex::Align<size_t>(row.size(), 4));
-
-				auto& rowHeader = *reinterpret_cast<Exd::RowHeader*>(&row[0]);
-				rowHeader.DataSize = static_cast<uint32_t>(row.size() - sizeof rowHeader);
-				rowHeader.SubRowCount = 1;
-
-				if (reinterpret_cast<const Exd::RowHeader*>(&row[0])->DataSize != row.size() - 6)
-					__debugbreak();
-
-				rows.emplace(id, std::move(row));
-			}
-			if (rows.empty())
-				continue;
-			result.emplace(Flush(page.first.StartId, std::move(rows), language));
-		}
+	pages.back().ToRowIndex = m_ids.size();
+	pages.back().Pagination.RowCountWithSkip = m_ids.back() - pages.back().Pagination.StartId + 1;
+
+	// Pages are independent of each other; encode them concurrently, and collect them in order.
+	std::vector<std::optional<std::pair<Sqpack::EntryPathSpec, std::vector<char>>>> exdFiles(pages.size() * Languages.size());
+	Utils::Win32::ParallelFor(exdFiles.size(), [&](size_t i) {
+		const auto& page = pages[i / Languages.size()];
+		exdFiles[i] = Flush(page.Pagination.StartId, page.FromRowIndex, page.ToRowIndex, Languages[i % Languages.size()]);
+	});
+	for (auto& exdFile : exdFiles) {
+		if (exdFile)
+			result.emplace(std::move(*exdFile));
 	}
 
 	{
@@ -262,12 +407,12 @@ std::map<Sqex::Sqpack::EntryPathSpec, std::vector<char>, Sqex::Sqpack::EntryPath
 		exhHeader.LanguageCount = static_cast<uint16_t>(Languages.size());
 		exhHeader.Flags = Flags;
 		exhHeader.Depth = Exh::Level2;
-		exhHeader.RowCountWithoutSkip = static_cast<uint32_t>(Data.size());
+		exhHeader.RowCountWithoutSkip = static_cast<uint32_t>(m_ids.size());
 
 		const auto columnSpan = span_cast<char>(Columns);
 		std::vector<Exh::Pagination> paginations;
-		for (const auto& pagination : pages | std::views::keys)
-			paginations.emplace_back(pagination);
+		for (const auto& page : pages)
+			paginations.emplace_back(page.Pagination);
 		const auto paginationSpan = span_cast<char>(paginations);
 		const auto languageSpan = span_cast<char>(Languages);
 
@@ -1,30 +1,65 @@
 #pragma once
+
+#include <deque>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
 #include "XivAlexanderCommon/Sqex/Excel.h"
 #include "XivAlexanderCommon/Sqex/Sqpack.h"
 
 namespace Sqex::Excel {
 	class Depth2ExhExdCreator {
+		// Fixed data of every row, laid out as in exd files, except that string columns hold an index into m_strings.
+		struct LanguageData {
+			std::vector<char> FixedData;  // [row index * FixedDataSize]
+			std::vector<bool> Present;  // [row index]
+		};
+
+		std::vector<uint32_t> m_ids;  // sorted
+		std::map<Language, LanguageData> m_languageData;
+		std::deque<std::string> m_strings;  // [0] is always an empty string; deque keeps m_stringIndices keys valid
+		std::unordered_map<std::string_view, uint32_t> m_stringIndices;
+
 	public:
 		const std::string Name;
 		const std::vector<Exh::Column> Columns;
 		const Exh::ExhFlag Flags;
 		const uint32_t FixedDataSize;
-		std::map<uint32_t, std::map<Language, std::vector<ExdColumn>>> Data;
 		std::set<uint32_t> DivideAtIds;
 		std::vector<Language> Languages;
 		std::vector<Language> FillMissingLanguageFrom;
 
 		Depth2ExhExdCreator(std::string name, std::vector<Exh::Column> columns, const Exh::ExhFlag& flag);
+		Depth2ExhExdCreator(Depth2ExhExdCreator&&) = delete;
+		Depth2ExhExdCreator(const Depth2ExhExdCreator&) = delete;
+		Depth2ExhExdCreator& operator=(Depth2ExhExdCreator&&) = delete;
+		Depth2ExhExdCreator& operator=(const Depth2ExhExdCreator&) = delete;
 
 		void AddLanguage(Language language);
 
-		const std::vector<ExdColumn>& GetRow(uint32_t id, Language language) const;
+		// Includes ids whose rows have been set to empty in every language.
+		[[nodiscard]] const std::vector<uint32_t>& GetIds() const { return m_ids; }
+
+		[[nodiscard]] bool HasRow(uint32_t id) const;
+		[[nodiscard]] std::optional<std::vector<ExdColumn>> TryGetRow(uint32_t id, Language language) const;
+		[[nodiscard]] std::vector<ExdColumn> GetRow(uint32_t id, Language language) const;
+		[[nodiscard]] std::map<Language, std::vector<ExdColumn>> GetRowSet(uint32_t id) const;
+
+		// An empty row removes the row in the given language.
 		void SetRow(uint32_t id, Language language, std::vector<ExdColumn> row, bool replace = true);
 
 	private:
-		std::pair<Sqpack::EntryPathSpec, std::vector<char>> Flush(uint32_t startId, std::map<uint32_t, std::vector<char>> rows, Language language);
+		[[nodiscard]] size_t FindRowIndex(uint32_t id) const;
+		size_t EnsureRowIndex(uint32_t id);
+		uint32_t InternString(const std::string& s);
+
+		[[nodiscard]] std::vector<ExdColumn> DecodeRow(const LanguageData& data, size_t rowIndex) const;
+		void AppendEncodedRow(std::vector<char>& out, const LanguageData& data, size_t rowIndex) const;
+
+		[[nodiscard]] std::optional<std::pair<Sqpack::EntryPathSpec, std::vector<char>>> Flush(uint32_t startId, size_t fromRowIndex, size_t toRowIndex, Language language) const;
 
 	public:
-		std::map<Sqpack::EntryPathSpec, std::vector<char>, Sqpack::EntryPathSpec::FullPathComparator> Compile(size_t divideUnit = SIZE_MAX);
+		[[nodiscard]] std::map<Sqpack::EntryPathSpec, std::vector<char>, Sqpack::EntryPathSpec::FullPathComparator> Compile(size_t divideUnit = SIZE_MAX) const;
 	};
 }
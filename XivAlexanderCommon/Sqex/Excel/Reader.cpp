@@ -109,17 +109,79 @@ void Sqex::Excel::ExhReader::Dump() const {
 			std::cout << std::format("Example Entry: {}\n", GetDataPathSpec(page, lang));
 }
 
+Sqex::Excel::ExdReader::RowView::RowView(const ExdReader* reader, uint32_t id, uint16_t subRowCount, std::span<const char> data)
+	: m_reader(reader)
+	, Id(id)
+	, SubRowCount(subRowCount)
+	, Data(data) {
+}
+
+std::span<const char> Sqex::Excel::ExdReader::RowView::GetFixedData(size_t subRowIndex) const {
+	if (m_reader->m_depth == Exh::Level3) {
+		if (subRowIndex >= SubRowCount)
+			throw std::out_of_range("subRowIndex out of range");
+		return Data.subspan(2 + subRowIndex * (2 + m_reader->m_fixedDataSize), m_reader->m_fixedDataSize);
+	}
+	if (subRowIndex)
+		throw std::out_of_range("subRowIndex out of range");
+	return Data.subspan(0, m_reader->m_fixedDataSize);
+}
+
+Sqex::Excel::ExdColumn Sqex::Excel::ExdReader::RowView::GetColumn(size_t columnIndex, size_t subRowIndex) const {
+	return m_reader->TranslateColumn(m_reader->ColumnDefinitions->at(columnIndex), GetFixedData(subRowIndex), Data);
+}
+
+std::string_view Sqex::Excel::ExdReader::RowView::GetStringView(size_t columnIndex, size_t subRowIndex) const {
+	const auto& columnDefinition = m_reader->ColumnDefinitions->at(columnIndex);
+	if (!columnDefinition.IsString())
+		throw std::invalid_argument("Not a string column");
+
+	BE<uint32_t> stringOffset;
+	std::copy_n(&GetFixedData(subRowIndex)[columnDefinition.Offset], 4, reinterpret_cast<char*>(&stringOffset));
+	const auto from = m_reader->m_fixedDataSize + stringOffset;
+	if (from >= Data.size())
+		throw CorruptDataException("String offset out of range");
+	const auto strings = Data.subspan(from);
+	return {strings.data(), static_cast<size_t>(std::find(strings.begin(), strings.end(), '\0') - strings.begin())};
+}
+
 Sqex::Excel::ExdReader::ExdReader(const ExhReader& exh, std::shared_ptr<const RandomAccessStream> stream, bool strict): m_stream(std::move(stream))
 	, m_fixedDataSize(exh.Header.FixedDataSize)
 	, m_depth(exh.Header.Depth)
 	, Header(m_stream->ReadStream<Exd::Header>(0))
 	, ColumnDefinitions(exh.Columns) {
+	// Rows get served straight out of a single page buffer, so that reading a row does not involve any further reads or allocations.
+	if (const auto view = m_stream->GetDirectView(); !view.empty()) {
+		m_data = {reinterpret_cast<const char*>(view.data()), view.size()};
+	} else {
+		m_ownedData.resize(static_cast<size_t>(m_stream->StreamSize()));
+		m_stream->ReadStream(0, std::span(m_ownedData));
+		m_data = std::span(m_ownedData);
+	}
+
 	const auto count = Header.IndexSize / sizeof Exd::RowLocator;
+	if (sizeof Header + count * sizeof Exd::RowLocator > m_data.size())
+		throw CorruptDataException("Row index out of range");
+
+	const auto locators = std::span(reinterpret_cast<const Exd::RowLocator*>(&m_data[sizeof Header]), count);
 	m_rowLocators.reserve(count);
-	for (const auto& locator : m_stream->ReadStreamIntoVector<Exd::RowLocator>(sizeof Header, count)) {
-		m_rowLocators.emplace_back(std::make_pair(locator.RowId.Value(), locator.Offset.Value()));
+	for (const auto& locator : locators) {
+		const auto offset = locator.Offset.Value();
+		if (offset + sizeof Exd::RowHeader > m_data.size())
+			throw CorruptDataException("Row offset out of range");
+		m_rowLocators.emplace_back(std::make_pair(locator.RowId.Value(), offset));
 	}
 	std::ranges::sort(m_rowLocators);
+
+	// Most sheets use contiguous row ids; index those directly instead of binary searching.
+	if (!m_rowLocators.empty()) {
+		const auto span = static_cast<size_t>(m_rowLocators.back().first - m_rowLocators.front().first) + 1;
+		if (span <= m_rowLocators.size() * 2) {
+			m_denseIndex.resize(span);
+			for (size_t i = 0; i < m_rowLocators.size(); ++i)
+				m_denseIndex[m_rowLocators[i].first - m_rowLocators.front().first] = static_cast<uint32_t>(i + 1);
+		}
+	}
 }
 
 Sqex::Excel::ExdColumn Sqex::Excel::ExdReader::TranslateColumn(const Exh::Column& columnDefinition, std::span<const char> fixedData, std::span<const char> fullData) const {
@@ -176,30 +238,57 @@ Sqex::Excel::ExdColumn Sqex::Excel::ExdReader::TranslateColumn(const Exh::Column
 	return column;
 }
 
-std::pair<Sqex::Excel::Exd::RowHeader, std::vector<char>> Sqex::Excel::ExdReader::ReadRowRaw(uint32_t index) const {
-	const auto it = std::ranges::lower_bound(m_rowLocators, std::make_pair(index, 0U), [](const auto& l, const auto& r) {
-		return l.first < r.first;
-	});
-	if (it == m_rowLocators.end() || it->first != index)
-		throw std::out_of_range("index out of range");
+const std::pair<uint32_t, uint32_t>* Sqex::Excel::ExdReader::FindRowLocator(uint32_t id) const {
+	if (m_rowLocators.empty() || id < m_rowLocators.front().first)
+		return nullptr;
+
+	if (!m_denseIndex.empty()) {
+		const auto i = static_cast<size_t>(id - m_rowLocators.front().first);
+		if (i >= m_denseIndex.size() || !m_denseIndex[i])
+			return nullptr;
+		return &m_rowLocators[m_denseIndex[i] - 1];
+	}
+
+	const auto it = std::ranges::lower_bound(m_rowLocators, id, {}, [](const auto& l) { return l.first; });
+	if (it == m_rowLocators.end() || it->first != id)
+		return nullptr;
+	return &*it;
+}
+
+Sqex::Excel::ExdReader::RowView Sqex::Excel::ExdReader::MakeRowView(const std::pair<uint32_t, uint32_t>& locator) const {
+	Exd::RowHeader rowHeader;
+	std::copy_n(&m_data[locator.second], sizeof rowHeader, reinterpret_cast<char*>(&rowHeader));
+	const auto from = locator.second + sizeof rowHeader;
+	if (from + rowHeader.DataSize > m_data.size())
+		throw CorruptDataException("Row data out of range");
+	return {this, locator.first, rowHeader.SubRowCount, m_data.subspan(from, rowHeader.DataSize)};
+}
+
+std::optional<Sqex::Excel::ExdReader::RowView> Sqex::Excel::ExdReader::TryGetRow(uint32_t id) const {
+	if (const auto locator = FindRowLocator(id))
+		return MakeRowView(*locator);
+	return std::nullopt;
+}
 
-	const auto rowHeader = m_stream->ReadStream<Exd::RowHeader>(it->second);
-	return std::make_pair(rowHeader, m_stream->ReadStreamIntoVector<char>(it->second + sizeof rowHeader, rowHeader.DataSize));
+Sqex::Excel::ExdReader::RowView Sqex::Excel::ExdReader::GetRow(uint32_t id) const {
+	if (const auto locator = FindRowLocator(id))
+		return MakeRowView(*locator);
+	throw std::out_of_range("index out of range");
 }
 
 std::vector<Sqex::Excel::ExdColumn> Sqex::Excel::ExdReader::ReadDepth2(uint32_t index) const {
 	if (m_depth != Exh::Level2)
 		throw std::invalid_argument("Not a 2nd depth sheet");
 
-	std::vector<ExdColumn> result;
-	const auto [rowHeader, buffer] = ReadRowRaw(index);
-	const auto fixedData = std::span(buffer).subspan(0, m_fixedDataSize);
-
-	if (rowHeader.SubRowCount != 1)
+	const auto row = GetRow(index);
+	if (row.SubRowCount != 1)
 		throw CorruptDataException("SubRowCount > 1 on 2nd depth sheet");
 
+	const auto fixedData = row.GetFixedData();
+	std::vector<ExdColumn> result;
+	result.reserve(ColumnDefinitions->size());
 	for (const auto& columnDefinition : *ColumnDefinitions)
-		result.emplace_back(TranslateColumn(columnDefinition, fixedData, std::span(buffer)));
+		result.emplace_back(TranslateColumn(columnDefinition, fixedData, row.Data));
 
 	return result;
 }
@@ -208,17 +297,17 @@ std::vector<std::vector<Sqex::Excel::ExdColumn>> Sqex::Excel::ExdReader::ReadDep
 	if (m_depth != Exh::Level3)
 		throw std::invalid_argument("Not a 3rd depth sheet");
 
+	const auto row = GetRow(index);
 	std::vector<std::vector<ExdColumn>> result;
-	const auto [rowHeader, buffer] = ReadRowRaw(index);
-
-	for (size_t i = 0, i_ = rowHeader.SubRowCount; i < i_; ++i) {
-		const auto baseOffset = i * (2 + m_fixedDataSize);
-		const auto fixedData = std::span(buffer).subspan(2 + baseOffset, m_fixedDataSize);
+	result.reserve(row.SubRowCount);
+	for (size_t i = 0, i_ = row.SubRowCount; i < i_; ++i) {
+		const auto fixedData = row.GetFixedData(i);
 
-		std::vector<ExdColumn> row;
+		std::vector<ExdColumn> subRow;
+		subRow.reserve(ColumnDefinitions->size());
 		for (const auto& columnDefinition : *ColumnDefinitions)
-			row.emplace_back(TranslateColumn(columnDefinition, fixedData, std::span(buffer)));
-		result.emplace_back(std::move(row));
+			subRow.emplace_back(TranslateColumn(columnDefinition, fixedData, row.Data));
+		result.emplace_back(std::move(subRow));
 	}
 	return result;
 }
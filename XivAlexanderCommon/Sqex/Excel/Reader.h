@@ -1,4 +1,8 @@
 #pragma once
+
+#include <optional>
+#include <string_view>
+
 #include "XivAlexanderCommon/Sqex.h"
 #include "XivAlexanderCommon/Sqex/Excel.h"
 #include "XivAlexanderCommon/Sqex/Sqpack.h"
@@ -56,27 +60,65 @@ namespace Sqex::Excel {
 	};
 
 	class ExdReader {
+	public:
+		// Borrows from the page buffer of the ExdReader that created it; valid for as long as the reader is.
+		class RowView {
+			const ExdReader* m_reader = nullptr;
+
+		public:
+			uint32_t Id{};
+			uint16_t SubRowCount{};
+			std::span<const char> Data;  // excludes row header
+
+			RowView() = default;
+			RowView(const ExdReader* reader, uint32_t id, uint16_t subRowCount, std::span<const char> data);
+
+			// Level3 sheets prefix each subrow with its 2-byte id.
+			[[nodiscard]] std::span<const char> GetFixedData(size_t subRowIndex = 0) const;
+
+			[[nodiscard]] ExdColumn GetColumn(size_t columnIndex, size_t subRowIndex = 0) const;
+
+			// Returns the escaped string without copying; throws if the column is not a string.
+			[[nodiscard]] std::string_view GetStringView(size_t columnIndex, size_t subRowIndex = 0) const;
+		};
+
+	private:
 		const std::shared_ptr<const RandomAccessStream> m_stream;
 		const size_t m_fixedDataSize;
 		const Exh::Depth m_depth;
-		std::vector<std::pair<uint32_t, uint32_t>> m_rowLocators;
+		std::vector<char> m_ownedData;  // used only if m_stream does not provide a direct view
+		std::span<const char> m_data;
+		std::vector<std::pair<uint32_t, uint32_t>> m_rowLocators;  // sorted by row id
+		std::vector<uint32_t> m_denseIndex;  // [row id - first row id] = index into m_rowLocators + 1, or 0 if missing; empty if row ids are sparse
 
 	public:
 		const Exd::Header Header;
 		const std::shared_ptr<std::vector<Exh::Column>> ColumnDefinitions;
 
 		ExdReader(const ExhReader& exh, std::shared_ptr<const RandomAccessStream> stream, bool strict = false);
+		ExdReader(ExdReader&&) = delete;
+		ExdReader(const ExdReader&) = delete;
+		ExdReader& operator=(ExdReader&&) = delete;
+		ExdReader& operator=(const ExdReader&) = delete;
 
 	private:
 		[[nodiscard]] ExdColumn TranslateColumn(const Exh::Column& columnDefinition, std::span<const char> fixedData, std::span<const char> fullData) const;
 
-		[[nodiscard]] std::pair<Exd::RowHeader, std::vector<char>> ReadRowRaw(uint32_t index) const;
+		[[nodiscard]] const std::pair<uint32_t, uint32_t>* FindRowLocator(uint32_t id) const;
+
+		[[nodiscard]] RowView MakeRowView(const std::pair<uint32_t, uint32_t>& locator) const;
 
 	public:
+		[[nodiscard]] std::optional<RowView> TryGetRow(uint32_t id) const;
+
+		[[nodiscard]] RowView GetRow(uint32_t id) const;
+
 		[[nodiscard]] std::vector<ExdColumn> ReadDepth2(uint32_t index) const;
 
 		[[nodiscard]] std::vector<std::vector<ExdColumn>> ReadDepth3(uint32_t index) const;
 
+		[[nodiscard]] size_t GetRowCount() const { return m_rowLocators.size(); }
+
 		[[nodiscard]] std::vector<uint32_t> GetIds() const;
 	};
 }
@@ -0,0 +1,310 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/AtlasPacker.h"
+
+struct Sqex::FontCsv::AtlasPacker::Page {
+	struct Candidate {
+		uint16_t X;
+		uint16_t Y;
+
+		// Smaller is better; Score2 breaks ties of Score1.
+		uint32_t Score1;
+		uint32_t Score2;
+
+		// Lets Place skip looking up what Find has already found.
+		size_t Hint;
+
+		bool operator<(const Candidate& r) const {
+			return Score1 == r.Score1 ? Score2 < r.Score2 : Score1 < r.Score1;
+		}
+	};
+
+	const uint16_t Width;
+	const uint16_t Height;
+
+	Page(uint16_t width, uint16_t height)
+		: Width(width)
+		, Height(height) {
+	}
+
+	virtual ~Page() = default;
+
+	virtual bool Find(uint16_t width, uint16_t height, Candidate& candidate) const = 0;
+	virtual void Place(const Candidate& candidate, uint16_t width, uint16_t height) = 0;
+};
+
+struct Sqex::FontCsv::AtlasPacker::ShelfPage : Page {
+	uint16_t CurrentX = 0;
+	uint16_t CurrentY = 0;
+	uint16_t CurrentLineHeight = 0;
+
+	using Page::Page;
+
+	bool Find(uint16_t width, uint16_t height, Candidate& candidate) const override {
+		uint32_t x = CurrentX, y = CurrentY;
+		if (x + width > Width) {
+			x = 0;
+			y += CurrentLineHeight;
+		}
+		if (y + height > Height)
+			return false;
+
+		candidate = {static_cast<uint16_t>(x), static_cast<uint16_t>(y), 0, 0, 0};
+		return true;
+	}
+
+	void Place(const Candidate& candidate, uint16_t width, uint16_t height) override {
+		if (candidate.Y != CurrentY) {
+			CurrentY = candidate.Y;
+			CurrentLineHeight = 0;
+		}
+		CurrentX = static_cast<uint16_t>(candidate.X + width);
+		CurrentLineHeight = std::max(CurrentLineHeight, height);
+	}
+};
+
+struct Sqex::FontCsv::AtlasPacker::SkylinePage : Page {
+	struct Segment {
+		uint16_t X;
+		uint16_t Y;
+		uint16_t Width;
+	};
+
+	const bool MinWaste;
+
+	// Sorted by X, covering the whole width without overlaps.
+	std::vector<Segment> Skyline;
+
+	SkylinePage(uint16_t width, uint16_t height, bool minWaste)
+		: Page(width, height)
+		, MinWaste(minWaste)
+		, Skyline{{0, 0, width}} {
+	}
+
+	bool Find(uint16_t width, uint16_t height, Candidate& candidate) const override {
+		auto found = false;
+		for (size_t i = 0; i < Skyline.size(); ++i) {
+			const auto x = Skyline[i].X;
+			if (x + width > Width)
+				break;
+
+			// The rectangle rests on the highest segment under it.
+			uint32_t y = 0;
+			for (size_t j = i, remaining = width; remaining > 0; ++j) {
+				y = std::max<uint32_t>(y, Skyline[j].Y);
+				remaining -= std::min<size_t>(remaining, Skyline[j].Width);
+			}
+			if (y + height > Height)
+				continue;
+
+			Candidate current{x, static_cast<uint16_t>(y), 0, 0, i};
+			if (MinWaste) {
+				// Area between the rectangle and the segments under it, which will never be used.
+				uint32_t waste = 0;
+				for (size_t j = i, remaining = width; remaining > 0; ++j) {
+					const auto segmentWidth = std::min<size_t>(remaining, Skyline[j].Width);
+					waste += static_cast<uint32_t>((y - Skyline[j].Y) * segmentWidth);
+					remaining -= segmentWidth;
+				}
+				current.Score1 = waste;
+				current.Score2 = y + height;
+			} else {
+				current.Score1 = y + height;
+				current.Score2 = Skyline[i].Width;
+			}
+
+			if (!found || current < candidate) {
+				candidate = current;
+				found = true;
+			}
+		}
+		return found;
+	}
+
+	void Place(const Candidate& candidate, uint16_t width, uint16_t height) override {
+		const auto index = candidate.Hint;
+		Skyline.insert(Skyline.begin() + static_cast<ptrdiff_t>(index), Segment{candidate.X, static_cast<uint16_t>(candidate.Y + height), width});
+
+		// Trim the segments now covered by the new one.
+		for (auto i = index + 1; i < Skyline.size();) {
+			const auto prevRight = Skyline[i - 1].X + Skyline[i - 1].Width;
+			auto& segment = Skyline[i];
+			if (segment.X >= prevRight)
+				break;
+
+			const auto overlap = static_cast<uint16_t>(prevRight - segment.X);
+			if (segment.Width > overlap) {
+				segment.X += overlap;
+				segment.Width -= overlap;
+				break;
+			}
+			Skyline.erase(Skyline.begin() + static_cast<ptrdiff_t>(i));
+		}
+
+		for (size_t i = 1; i < Skyline.size();) {
+			if (Skyline[i - 1].Y == Skyline[i].Y) {
+				Skyline[i - 1].Width += Skyline[i].Width;
+				Skyline.erase(Skyline.begin() + static_cast<ptrdiff_t>(i));
+			} else
+				++i;
+		}
+	}
+};
+
+struct Sqex::FontCsv::AtlasPacker::MaxRectsPage : Page {
+	struct Rect {
+		uint16_t X;
+		uint16_t Y;
+		uint16_t Width;
+		uint16_t Height;
+
+		[[nodiscard]] uint32_t Right() const { return static_cast<uint32_t>(X) + Width; }
+		[[nodiscard]] uint32_t Bottom() const { return static_cast<uint32_t>(Y) + Height; }
+
+		[[nodiscard]] bool Intersects(const Rect& r) const {
+			return X < r.Right() && r.X < Right() && Y < r.Bottom() && r.Y < Bottom();
+		}
+
+		[[nodiscard]] bool Contains(const Rect& r) const {
+			return X <= r.X && Y <= r.Y && r.Right() <= Right() && r.Bottom() <= Bottom();
+		}
+	};
+
+	const bool AreaFit;
+
+	// Maximal free rectangles; they may overlap each other, but none contains another.
+	std::vector<Rect> FreeRects;
+
+	MaxRectsPage(uint16_t width, uint16_t height, bool areaFit)
+		: Page(width, height)
+		, AreaFit(areaFit)
+		, FreeRects{{0, 0, width, height}} {
+	}
+
+	bool Find(uint16_t width, uint16_t height, Candidate& candidate) const override {
+		auto found = false;
+		for (const auto& rect : FreeRects) {
+			if (rect.Width < width || rect.Height < height)
+				continue;
+
+			const auto leftoverX = static_cast<uint32_t>(rect.Width - width);
+			const auto leftoverY = static_cast<uint32_t>(rect.Height - height);
+			const auto shortSide = std::min(leftoverX, leftoverY);
+			const auto longSide = std::max(leftoverX, leftoverY);
+
+			Candidate current{rect.X, rect.Y, 0, 0, 0};
+			if (AreaFit) {
+				current.Score1 = static_cast<uint32_t>(rect.Width) * rect.Height - static_cast<uint32_t>(width) * height;
+				current.Score2 = shortSide;
+			} else {
+				current.Score1 = shortSide;
+				current.Score2 = longSide;
+			}
+
+			if (!found || current < candidate) {
+				candidate = current;
+				found = true;
+			}
+		}
+		return found;
+	}
+
+	void Place(const Candidate& candidate, uint16_t width, uint16_t height) override {
+		const Rect used{candidate.X, candidate.Y, width, height};
+
+		// Replace every free rectangle overlapping the used one with the up to 4 maximal rectangles left around it.
+		std::vector<Rect> splits;
+		for (size_t i = 0; i < FreeRects.size();) {
+			const auto rect = FreeRects[i];
+			if (!rect.Intersects(used)) {
+				++i;
+				continue;
+			}
+
+			if (used.X > rect.X)
+				splits.emplace_back(Rect{rect.X, rect.Y, static_cast<uint16_t>(used.X - rect.X), rect.Height});
+			if (used.Right() < rect.Right())
+				splits.emplace_back(Rect{static_cast<uint16_t>(used.Right()), rect.Y, static_cast<uint16_t>(rect.Right() - used.Right()), rect.Height});
+			if (used.Y > rect.Y)
+				splits.emplace_back(Rect{rect.X, rect.Y, rect.Width, static_cast<uint16_t>(used.Y - rect.Y)});
+			if (used.Bottom() < rect.Bottom())
+				splits.emplace_back(Rect{rect.X, static_cast<uint16_t>(used.Bottom()), rect.Width, static_cast<uint16_t>(rect.Bottom() - used.Bottom())});
+
+			FreeRects[i] = FreeRects.back();
+			FreeRects.pop_back();
+		}
+
+		// Untouched free rectangles cannot be inside any of the new ones, as each new one lies inside a removed one.
+		std::erase_if(splits, [this](const Rect& split) {
+			return std::ranges::any_of(FreeRects, [&split](const Rect& rect) { return rect.Contains(split); });
+		});
+		for (size_t i = 0; i < splits.size(); ++i) {
+			for (size_t j = 0; j < splits.size();) {
+				if (i != j && splits[i].Contains(splits[j])) {
+					splits.erase(splits.begin() + static_cast<ptrdiff_t>(j));
+					if (j < i)
+						--i;
+				} else
+					++j;
+			}
+		}
+		FreeRects.insert(FreeRects.end(), splits.begin(), splits.end());
+	}
+};
+
+Sqex::FontCsv::AtlasPacker::AtlasPacker(uint16_t width, uint16_t height, CreateConfig::PackingHeuristic heuristic)
+	: m_width(width)
+	, m_height(height)
+	, m_heuristic(heuristic) {
+	if (!width || !height)
+		throw std::invalid_argument("Page size must not be zero");
+}
+
+Sqex::FontCsv::AtlasPacker::~AtlasPacker() = default;
+
+Sqex::FontCsv::AtlasPacker::Placement Sqex::FontCsv::AtlasPacker::Insert(uint16_t width, uint16_t height) {
+	if (width > m_width || height > m_height)
+		throw std::invalid_argument(std::format("{}x{} does not fit in a page of {}x{}", width, height, m_width, m_height));
+
+	// Shelves are filled like rows of text, never going back to an earlier page.
+	const auto firstIndex = m_heuristic == CreateConfig::PackingHeuristic::Shelf && !m_pages.empty() ? m_pages.size() - 1 : 0;
+
+	Page::Candidate best{};
+	size_t bestIndex = SIZE_MAX;
+	for (auto i = firstIndex; i < m_pages.size(); ++i) {
+		if (Page::Candidate candidate{}; m_pages[i]->Find(width, height, candidate) && (bestIndex == SIZE_MAX || candidate < best)) {
+			best = candidate;
+			bestIndex = i;
+		}
+	}
+
+	if (bestIndex == SIZE_MAX) {
+		switch (m_heuristic) {
+			case CreateConfig::PackingHeuristic::Shelf:
+				m_pages.emplace_back(std::make_unique<ShelfPage>(m_width, m_height));
+				break;
+
+			case CreateConfig::PackingHeuristic::SkylineBottomLeft:
+			case CreateConfig::PackingHeuristic::SkylineMinWaste:
+				m_pages.emplace_back(std::make_unique<SkylinePage>(m_width, m_height, m_heuristic == CreateConfig::PackingHeuristic::SkylineMinWaste));
+				break;
+
+			case CreateConfig::PackingHeuristic::MaxRectsBestShortSideFit:
+			case CreateConfig::PackingHeuristic::MaxRectsBestAreaFit:
+				m_pages.emplace_back(std::make_unique<MaxRectsPage>(m_width, m_height, m_heuristic == CreateConfig::PackingHeuristic::MaxRectsBestAreaFit));
+				break;
+
+			default:
+				throw std::invalid_argument("Unsupported packing heuristic");
+		}
+		bestIndex = m_pages.size() - 1;
+		if (!m_pages.back()->Find(width, height, best))
+			throw std::runtime_error(std::format("{}x{} does not fit in an empty page of {}x{}", width, height, m_width, m_height));
+	}
+
+	m_pages[bestIndex]->Place(best, width, height);
+	return {static_cast<uint16_t>(bestIndex), best.X, best.Y};
+}
+
+size_t Sqex::FontCsv::AtlasPacker::PageCount() const {
+	return m_pages.size();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+
+#include "XivAlexanderCommon/Sqex/FontCsv/CreateConfig.h"
+
+namespace Sqex::FontCsv {
+	// Places rectangles onto pages of fixed size, adding a page whenever none of the existing ones have room left.
+	class AtlasPacker {
+		struct Page;
+		struct ShelfPage;
+		struct SkylinePage;
+		struct MaxRectsPage;
+
+		const uint16_t m_width;
+		const uint16_t m_height;
+		const CreateConfig::PackingHeuristic m_heuristic;
+		std::vector<std::unique_ptr<Page>> m_pages;
+
+	public:
+		struct Placement {
+			uint16_t Index;
+			uint16_t X;
+			uint16_t Y;
+		};
+
+		AtlasPacker(uint16_t width, uint16_t height, CreateConfig::PackingHeuristic heuristic);
+		~AtlasPacker();
+
+		// Placed rectangles never move; pages are packed the tightest if rectangles are inserted from the tallest.
+		// Shelf only ever tries the last page, while the others try every page before adding one.
+		Placement Insert(uint16_t width, uint16_t height);
+
+		[[nodiscard]] size_t PageCount() const;
+	};
+}
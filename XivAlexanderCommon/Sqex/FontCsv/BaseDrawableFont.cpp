@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/BaseDrawableFont.h"
+
+namespace {
+	// Every function below works on 16-bit lanes holding values in [0, 255], so that products never exceed 255 * 255.
+
+	// floor(x / 255) for every x in [0, 255 * 255].
+	__m128i Div255(__m128i x) {
+		return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16(static_cast<short>(0x8081))), 7);
+	}
+
+	// (a * (255 - w) + b * w) / 255
+	__m128i Mix(__m128i a, __m128i b, __m128i w) {
+		return Div255(_mm_add_epi16(_mm_mullo_epi16(a, _mm_sub_epi16(_mm_set1_epi16(255), w)), _mm_mullo_epi16(b, w)));
+	}
+
+	// 255 - (255 - a) * (255 - b) / 255
+	__m128i CombineAlpha(__m128i a, __m128i b) {
+		const auto max = _mm_set1_epi16(255);
+		return _mm_sub_epi16(max, Div255(_mm_mullo_epi16(_mm_sub_epi16(max, a), _mm_sub_epi16(max, b))));
+	}
+
+	// Lanes hold two pixels in R, G, B, A order.
+	__m128i BroadcastAlpha(__m128i pixels) {
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	__m128i WithAlpha(__m128i rgb, __m128i alpha) {
+		const auto alphaMask = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+		return _mm_or_si128(_mm_andnot_si128(alphaMask, rgb), _mm_and_si128(alphaMask, alpha));
+	}
+
+	__m128i SpreadColor(Sqex::Texture::RGBA8888 color) {
+		return _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color.Value)), _mm_setzero_si128());
+	}
+
+	// Calls blend with 16-bit lanes of 8 pixels at a time, and stores the results back.
+	template<typename Fn>
+	void ForEachL8Chunk(uint8_t* dest, const uint8_t* opacity, size_t width, const Fn& blend) {
+		const auto zero = _mm_setzero_si128();
+		const auto blend16 = [&](uint8_t* d, const uint8_t* o) {
+			const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+			const auto opacities = _mm_loadu_si128(reinterpret_cast<const __m128i*>(o));
+			const auto low = blend(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(opacities, zero));
+			const auto high = blend(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(opacities, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_packus_epi16(low, high));
+		};
+
+		for (; width >= 16; width -= 16, dest += 16, opacity += 16)
+			blend16(dest, opacity);
+
+		if (width) {
+			uint8_t d[16]{}, o[16]{};
+			std::copy_n(dest, width, d);
+			std::copy_n(opacity, width, o);
+			blend16(d, o);
+			std::copy_n(d, width, dest);
+		}
+	}
+
+	// Calls blend with 16-bit lanes of 2 pixels at a time, along with the opacity of each pixel spread to its lanes.
+	template<typename Fn>
+	void ForEachRgba8888Chunk(Sqex::Texture::RGBA8888* dest, const uint8_t* opacity, size_t width, const Fn& blend) {
+		const auto zero = _mm_setzero_si128();
+		const auto blend4 = [&](Sqex::Texture::RGBA8888* d, const uint8_t* o) {
+			const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+			auto opacities = _mm_cvtsi32_si128(static_cast<int>(o[0] | (o[1] << 8) | (o[2] << 16) | (o[3] << 24)));
+			opacities = _mm_unpacklo_epi8(opacities, opacities);
+			opacities = _mm_unpacklo_epi16(opacities, opacities);
+			const auto low = blend(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(opacities, zero));
+			const auto high = blend(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(opacities, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_packus_epi16(low, high));
+		};
+
+		for (; width >= 4; width -= 4, dest += 4, opacity += 4)
+			blend4(dest, opacity);
+
+		if (width) {
+			Sqex::Texture::RGBA8888 d[4]{};
+			uint8_t o[4]{};
+			std::copy_n(dest, width, d);
+			std::copy_n(opacity, width, o);
+			blend4(d, o);
+			std::copy_n(d, width, dest);
+		}
+	}
+}
+
+const std::array<uint8_t, 256>& Sqex::FontCsv::GetGammaTable(double gamma) {
+	static std::mutex s_mtx;
+	static std::map<double, std::unique_ptr<std::array<uint8_t, 256>>> s_tables;
+
+	const auto lock = std::lock_guard(s_mtx);
+	auto& table = s_tables[gamma];
+	if (!table) {
+		table = std::make_unique<std::array<uint8_t, 256>>();
+		for (size_t i = 0; i < table->size(); ++i)
+			(*table)[i] = static_cast<uint8_t>(static_cast<uint32_t>(std::pow(1.0 * i / 255, gamma) * 255));
+	}
+	return *table;
+}
+
+void Sqex::FontCsv::BlendRowL8(uint8_t* dest, const uint8_t* opacity, size_t width, uint8_t fgColor, uint8_t bgColor, uint8_t fgOpacity, uint8_t bgOpacity) {
+	const auto fg = _mm_set1_epi16(fgColor);
+	const auto bg = _mm_set1_epi16(bgColor);
+	const auto fgO = _mm_set1_epi16(fgOpacity);
+	const auto bgO = _mm_set1_epi16(bgOpacity);
+	ForEachL8Chunk(dest, opacity, width, [&](__m128i d, __m128i o) {
+		return Mix(Mix(d, bg, bgO), Mix(d, fg, fgO), o);
+	});
+}
+
+void Sqex::FontCsv::BlendRowL8BinaryOpacity(uint8_t* dest, const uint8_t* opacity, size_t width, uint8_t color, bool colorIsForeground) {
+	const auto c = _mm_set1_epi16(color);
+	const auto max = _mm_set1_epi16(255);
+	ForEachL8Chunk(dest, opacity, width, [&](__m128i d, __m128i o) {
+		return Mix(d, c, colorIsForeground ? o : _mm_sub_epi16(max, o));
+	});
+}
+
+void Sqex::FontCsv::BlendRowRgba8888(Texture::RGBA8888* dest, const uint8_t* opacity, size_t width, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor) {
+	const auto fg = SpreadColor(fgColor);
+	const auto bg = SpreadColor(bgColor);
+	const auto fgA = _mm_set1_epi16(static_cast<short>(fgColor.A));
+	const auto bgA = _mm_set1_epi16(static_cast<short>(bgColor.A));
+	ForEachRgba8888Chunk(dest, opacity, width, [&](__m128i d, __m128i o) {
+		const auto dA = BroadcastAlpha(d);
+		const auto blendedBg = WithAlpha(Mix(d, bg, bgA), CombineAlpha(bgA, dA));
+		const auto blendedFg = WithAlpha(Mix(d, fg, fgA), CombineAlpha(fgA, dA));
+		const auto current = Mix(blendedBg, blendedFg, o);
+		const auto currentA = BroadcastAlpha(current);
+		const auto blendedDest = WithAlpha(Mix(current, d, dA), CombineAlpha(dA, currentA));
+		return WithAlpha(Mix(blendedDest, current, currentA), blendedDest);
+	});
+}
+
+void Sqex::FontCsv::BlendRowRgba8888Opaque(Texture::RGBA8888* dest, const uint8_t* opacity, size_t width, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor) {
+	const auto fg = SpreadColor(fgColor);
+	const auto bg = SpreadColor(bgColor);
+	const auto max = _mm_set1_epi16(255);
+	ForEachRgba8888Chunk(dest, opacity, width, [&](__m128i, __m128i o) {
+		return WithAlpha(Mix(bg, fg, o), max);
+	});
+}
+
+void Sqex::FontCsv::BlendRowRgba8888BinaryOpacity(Texture::RGBA8888* dest, const uint8_t* opacity, size_t width, Texture::RGBA8888 color, bool colorIsForeground) {
+	const auto c = SpreadColor(color);
+	const auto max = _mm_set1_epi16(255);
+	ForEachRgba8888Chunk(dest, opacity, width, [&](__m128i d, __m128i o) {
+		if (!colorIsForeground)
+			o = _mm_sub_epi16(max, o);
+
+		// Pixels with no opacity are left untouched.
+		const auto dA = BroadcastAlpha(d);
+		const auto blendedDest = WithAlpha(Mix(c, d, dA), CombineAlpha(dA, o));
+		const auto result = WithAlpha(Mix(blendedDest, c, o), blendedDest);
+		const auto untouched = _mm_cmpeq_epi16(o, _mm_setzero_si128());
+		return _mm_or_si128(_mm_and_si128(untouched, d), _mm_andnot_si128(untouched, result));
+	});
+}
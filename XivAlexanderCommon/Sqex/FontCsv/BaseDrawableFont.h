@@ -6,6 +6,17 @@
 #include "XivAlexanderCommon/Sqex/Texture/Mipmap.h"
 
 namespace Sqex::FontCsv {
+	// Maps opacity in [0, 255] to pow(opacity / 255, gamma) * 255, truncated. Tables are built once per distinct gamma value.
+	const std::array<uint8_t, 256>& GetGammaTable(double gamma);
+
+	// SIMD versions of the row blending functions in RgbBitmapCopy, taking gamma corrected opacity.
+	// Results are identical to the scalar versions.
+	void BlendRowL8(uint8_t* dest, const uint8_t* opacity, size_t width, uint8_t fgColor, uint8_t bgColor, uint8_t fgOpacity, uint8_t bgOpacity);
+	void BlendRowL8BinaryOpacity(uint8_t* dest, const uint8_t* opacity, size_t width, uint8_t color, bool colorIsForeground);
+	void BlendRowRgba8888(Texture::RGBA8888* dest, const uint8_t* opacity, size_t width, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor);
+	void BlendRowRgba8888Opaque(Texture::RGBA8888* dest, const uint8_t* opacity, size_t width, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor);
+	void BlendRowRgba8888BinaryOpacity(Texture::RGBA8888* dest, const uint8_t* opacity, size_t width, Texture::RGBA8888 color, bool colorIsForeground);
+
 	template<
 		typename SrcPixFmt,
 		uint32_t ResolverFunction(const SrcPixFmt&),
@@ -17,10 +28,20 @@ namespace Sqex::FontCsv {
 
 		static constexpr auto Scaler = 0xFFUL;
 		static constexpr auto MaxOpacity = std::numeric_limits<OpacityType>::max();
+		static constexpr auto IsL8 = std::is_same_v<DestPixFmt, uint8_t> && std::is_same_v<OpacityType, uint8_t>;
+		static constexpr auto IsRgba8888 = std::is_same_v<DestPixFmt, Texture::RGBA8888>;
+
+		static inline void ResolveOpacity(uint8_t* opacityPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const std::array<uint8_t, 256>& gammaTable) {
+			while (regionWidth--)
+				*opacityPtr++ = gammaTable[ResolverFunction(*srcPtr++)];
+		}
+
+		static inline void DrawLineToRgb(DestPixFmt* destPtr, const uint8_t* opacityPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor) {
+			if constexpr (IsRgba8888)
+				return BlendRowRgba8888(destPtr, opacityPtr, regionWidth, fgColor, bgColor);
 
-		static inline void DrawLineToRgb(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
 			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+				const uint32_t opacityScaled = *opacityPtr;
 				const auto blendedBgColor = DestPixFmt{
 					(bgColor.R * bgColor.A + destPtr->R * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
 					(bgColor.G * bgColor.A + destPtr->G * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
@@ -50,26 +71,32 @@ namespace Sqex::FontCsv {
 				destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - currentColor.A) + currentColor.B * currentColor.A) / DestPixFmt::MaxB;
 				destPtr->A = blendedDestColor.A;
 				++destPtr;
-				++srcPtr;
+				++opacityPtr;
 			}
 		}
 
-		static inline void DrawLineToRgbOpaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
+		static inline void DrawLineToRgbOpaque(DestPixFmt* destPtr, const uint8_t* opacityPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor) {
+			if constexpr (IsRgba8888)
+				return BlendRowRgba8888Opaque(destPtr, opacityPtr, regionWidth, fgColor, bgColor);
+
 			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+				const uint32_t opacityScaled = *opacityPtr;
 				destPtr->R = (bgColor.R * (Scaler - opacityScaled) + fgColor.R * opacityScaled) / Scaler;
 				destPtr->G = (bgColor.G * (Scaler - opacityScaled) + fgColor.G * opacityScaled) / Scaler;
 				destPtr->B = (bgColor.B * (Scaler - opacityScaled) + fgColor.B * opacityScaled) / Scaler;
 				destPtr->A = DestPixFmt::MaxA;
 				++destPtr;
-				++srcPtr;
+				++opacityPtr;
 			}
 		}
 
 		template<bool ColorIsForeground>
-		static inline void DrawLineToRgbBinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
+		static inline void DrawLineToRgbBinaryOpacity(DestPixFmt* destPtr, const uint8_t* opacityPtr, size_t regionWidth, const DestPixFmt& color) {
+			if constexpr (IsRgba8888)
+				return BlendRowRgba8888BinaryOpacity(destPtr, opacityPtr, regionWidth, color, ColorIsForeground);
+
 			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+				const uint32_t opacityScaled = *opacityPtr;
 				const auto opacity = DestPixFmt::MaxA * (ColorIsForeground ? opacityScaled : Scaler - opacityScaled) / Scaler;
 				if (opacity) {
 					const auto blendedDestColor = DestPixFmt{
@@ -84,88 +111,92 @@ namespace Sqex::FontCsv {
 					destPtr->A = blendedDestColor.A;
 				}
 				++destPtr;
-				++srcPtr;
+				++opacityPtr;
 			}
 		}
 
-		static inline void DrawLineToL8(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
-			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+		static inline void DrawLineToL8(DestPixFmt* destPtr, const uint8_t* opacityPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity, OpacityType bgOpacity) {
+			if constexpr (IsL8)
+				return BlendRowL8(destPtr, opacityPtr, regionWidth, fgColor, bgColor, fgOpacity, bgOpacity);
 
 			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+				const uint32_t opacityScaled = *opacityPtr;
 				const auto blendedBgColor = (1 * bgColor * bgOpacity + 1 * *destPtr * (MaxOpacity - bgOpacity)) / MaxOpacity;
 				const auto blendedFgColor = (1 * fgColor * fgOpacity + 1 * *destPtr * (MaxOpacity - fgOpacity)) / MaxOpacity;
 				*destPtr = static_cast<DestPixFmt>((blendedBgColor * (Scaler - opacityScaled) + blendedFgColor * opacityScaled) / Scaler);
 				++destPtr;
-				++srcPtr;
+				++opacityPtr;
 			}
 		}
 
-		static inline void DrawLineToL8Opaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, double gamma) {
-			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+		static inline void DrawLineToL8Opaque(DestPixFmt* destPtr, const uint8_t* opacityPtr, size_t regionWidth) {
+			// MaxOpacity * opacityScaled / Scaler is opacityScaled itself.
+			if constexpr (IsL8) {
+				std::copy_n(opacityPtr, regionWidth, destPtr);
+				return;
+			}
 
 			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+				const uint32_t opacityScaled = *opacityPtr;
 				*destPtr = static_cast<DestPixFmt>(MaxOpacity * opacityScaled / Scaler);
 				++destPtr;
-				++srcPtr;
+				++opacityPtr;
 			}
 		}
 
 		template<bool ColorIsForeground>
-		static inline void DrawLineToL8BinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
-			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+		static inline void DrawLineToL8BinaryOpacity(DestPixFmt* destPtr, const uint8_t* opacityPtr, size_t regionWidth, const DestPixFmt& color) {
+			if constexpr (IsL8)
+				return BlendRowL8BinaryOpacity(destPtr, opacityPtr, regionWidth, color, ColorIsForeground);
 
 			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+				const uint32_t opacityScaled = *opacityPtr;
 				const auto opacityScaled2 = ColorIsForeground ? opacityScaled : Scaler - opacityScaled;
 				*destPtr = static_cast<DestPixFmt>((*destPtr * (Scaler - opacityScaled2) + 1 * color * opacityScaled2) / Scaler);
 				++destPtr;
-				++srcPtr;
+				++opacityPtr;
 			}
 		}
 
 	public:
-		static inline void CopyTo(const GlyphMeasurement& src, const GlyphMeasurement& dest, const SrcPixFmt* srcBuf, DestPixFmt* destBuf, SSIZE_T srcWidth, SSIZE_T srcHeight, SSIZE_T destWidth, DestPixFmt fgColor, DestPixFmt bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
+		static inline void CopyTo(const GlyphMeasurement& src, const GlyphMeasurement& dest, const SrcPixFmt* srcBuf, DestPixFmt* destBuf, SSIZE_T srcWidth, SSIZE_T srcHeight, SSIZE_T destWidth, DestPixFmt fgColor, DestPixFmt bgColor, OpacityType fgOpacity, OpacityType bgOpacity, const std::array<uint8_t, 256>& gammaTable) {
 			auto destPtrBegin = &destBuf[static_cast<size_t>(1) * dest.top * destWidth + dest.left];
 			auto srcPtrBegin = &srcBuf[static_cast<size_t>(1) * (VerticalDirection == 1 ? src.top : srcHeight - src.top - 1) * srcWidth + src.left];
 			const auto srcPtrDelta = srcWidth * VerticalDirection;
 			const auto regionWidth = src.right - src.left;
 			const auto regionHeight = src.bottom - src.top;
 
-			gamma = 1.0 / gamma;
+			std::vector<uint8_t> opacity(static_cast<size_t>(std::max<SSIZE_T>(0, regionWidth)));
+			const auto forEachLine = [&](const auto& drawLine) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta) {
+					ResolveOpacity(opacity.data(), srcPtrBegin, regionWidth, gammaTable);
+					drawLine(destPtrBegin, opacity.data());
+				}
+			};
 
 			if constexpr (std::is_integral_v<DestPixFmt>) {
 				constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
 
 				if (fgOpacity == MaxOpacity && bgOpacity == MaxOpacity && fgColor == DestPixFmtMax && bgColor == 0) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8Opaque(destPtrBegin, srcPtrBegin, regionWidth, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToL8Opaque(destPtr, opacityPtr, regionWidth); });
 				} else if (fgOpacity == MaxOpacity && bgOpacity == 0) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8BinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToL8BinaryOpacity<true>(destPtr, opacityPtr, regionWidth, fgColor); });
 				} else if (fgOpacity == 0 && bgOpacity == MaxOpacity) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8BinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToL8BinaryOpacity<false>(destPtr, opacityPtr, regionWidth, bgColor); });
 				} else {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToL8(destPtr, opacityPtr, regionWidth, fgColor, bgColor, fgOpacity, bgOpacity); });
 				}
 			} else {
 				fgColor.A = fgColor.A * fgOpacity / std::numeric_limits<OpacityType>::max();
 				bgColor.A = bgColor.A * bgOpacity / std::numeric_limits<OpacityType>::max();
 				if (fgColor.A == DestPixFmt::MaxA && bgColor.A == DestPixFmt::MaxA) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgbOpaque(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToRgbOpaque(destPtr, opacityPtr, regionWidth, fgColor, bgColor); });
 				} else if (fgColor.A == DestPixFmt::MaxA && bgColor.A == 0) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgbBinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToRgbBinaryOpacity<true>(destPtr, opacityPtr, regionWidth, fgColor); });
 				} else if (fgColor.A == 0 && bgColor.A == DestPixFmt::MaxA) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgbBinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToRgbBinaryOpacity<false>(destPtr, opacityPtr, regionWidth, bgColor); });
 				} else {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgb(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+					forEachLine([&](DestPixFmt* destPtr, const uint8_t* opacityPtr) { DrawLineToRgb(destPtr, opacityPtr, regionWidth, fgColor, bgColor); });
 				}
 			}
 		}
@@ -180,6 +211,9 @@ namespace Sqex::FontCsv {
 	protected:
 		double m_gamma = 1.0;
 
+		// Looked up once per font, as GetGammaTable takes a lock.
+		const std::array<uint8_t, 256>* m_gammaTable = &GetGammaTable(1.0);
+
 	public:
 		BaseFont& Base;
 
@@ -187,10 +221,15 @@ namespace Sqex::FontCsv {
 			: Base(*font) {
 		}
 
-		void Gamma(double gamma) { m_gamma = gamma; }
+		void Gamma(double gamma) {
+			m_gamma = gamma;
+			m_gammaTable = &GetGammaTable(1.0 / gamma);
+		}
 
 		double Gamma() const { return m_gamma; }
 
+		const std::array<uint8_t, 256>& GammaTable() const { return *m_gammaTable; }
+
 		virtual GlyphMeasurement Draw(Texture::MemoryBackedMipmap* to, SSIZE_T x, SSIZE_T y, char32_t c, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity = MaxOpacity, OpacityType bgOpacity = MaxOpacity) const = 0;
 
 		virtual GlyphMeasurement Draw(Texture::MemoryBackedMipmap* to, SSIZE_T x, SSIZE_T y, const std::u32string& s, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity = MaxOpacity, OpacityType bgOpacity = MaxOpacity) const {
@@ -381,7 +420,7 @@ namespace Sqex::FontCsv {
 			destSize.Translate(x, y);
 			auto destBuf = to->View<DestPixFmt>();
 
-			RgbBitmapCopy<uint8_t, ResolverFunction, DestPixFmt, OpacityType>::CopyTo(size2, destSize, &buf2[0], &destBuf[0], tex2.Width, tex2.Height, to->Width, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::Gamma());
+			RgbBitmapCopy<uint8_t, ResolverFunction, DestPixFmt, OpacityType>::CopyTo(size2, destSize, &buf2[0], &destBuf[0], tex2.Width, tex2.Height, to->Width, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
 			return destSize;
 		}
 	};
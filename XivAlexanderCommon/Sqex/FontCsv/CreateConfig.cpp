@@ -522,13 +522,57 @@ void Sqex::FontCsv::CreateConfig::from_json(const nlohmann::json& j, SingleTextu
 	o.fontTargets = j.get<decltype(o.fontTargets)>();
 }
 
+void Sqex::FontCsv::CreateConfig::to_json(nlohmann::json& j, const PackingHeuristic& o) {
+	switch (o) {
+		case PackingHeuristic::Shelf:
+			j = "shelf";
+			break;
+
+		case PackingHeuristic::SkylineBottomLeft:
+			j = "skylineBottomLeft";
+			break;
+
+		case PackingHeuristic::SkylineMinWaste:
+			j = "skylineMinWaste";
+			break;
+
+		case PackingHeuristic::MaxRectsBestShortSideFit:
+			j = "maxRectsBestShortSideFit";
+			break;
+
+		case PackingHeuristic::MaxRectsBestAreaFit:
+			j = "maxRectsBestAreaFit";
+			break;
+	}
+}
+
+void Sqex::FontCsv::CreateConfig::from_json(const nlohmann::json& j, PackingHeuristic& o) {
+	auto s = j.get<std::string>();
+	CharUpperA(&s[0]);
+
+	if (s == "SHELF")
+		o = PackingHeuristic::Shelf;
+	else if (s == "SKYLINEBOTTOMLEFT")
+		o = PackingHeuristic::SkylineBottomLeft;
+	else if (s == "SKYLINEMINWASTE")
+		o = PackingHeuristic::SkylineMinWaste;
+	else if (s == "MAXRECTSBESTSHORTSIDEFIT")
+		o = PackingHeuristic::MaxRectsBestShortSideFit;
+	else if (s == "MAXRECTSBESTAREAFIT")
+		o = PackingHeuristic::MaxRectsBestAreaFit;
+	else
+		throw std::invalid_argument(std::format("Unexpected value {} for packing heuristic (tried to interpret from {})", j.get<std::string>(), s));
+}
+
 void Sqex::FontCsv::CreateConfig::to_json(nlohmann::json& j, const FontCreateConfig& o) {
 	j = nlohmann::json::object({
 		{"glyphGap", o.glyphGap},
 		{"compactLayout", o.compactLayout},
+		{"packingHeuristic", o.packingHeuristic},
 		{"textureWidth", o.textureWidth},
 		{"textureHeight", o.textureHeight},
 		{"textureFormat", o.textureFormat},
+		{"mipmapCount", o.mipmapCount},
 		{"gameIndexFiles", o.gameIndexFiles},
 		{"fontRequirements", o.fontRequirements},
 		{"sources", nlohmann::json::object()},
@@ -553,6 +597,7 @@ void Sqex::FontCsv::CreateConfig::from_json(const nlohmann::json& j, FontCreateC
 	try {
 		o.glyphGap = j.value<uint16_t>(lastAttempt = "glyphGap", 1);
 		o.compactLayout = j.value(lastAttempt = "compactLayout", false);
+		o.packingHeuristic = j.value(lastAttempt = "packingHeuristic", PackingHeuristic::Shelf);
 		o.textureWidth = j.value<uint16_t>(lastAttempt = "textureWidth", 1024);
 		o.textureHeight = j.value<uint16_t>(lastAttempt = "textureHeight", 1024);
 		o.textureFormat = Texture::Format::A4R4G4B4;
@@ -563,6 +608,9 @@ void Sqex::FontCsv::CreateConfig::from_json(const nlohmann::json& j, FontCreateC
 		}
 		if (o.textureFormat != Texture::Format::A4R4G4B4 && o.textureFormat != Texture::Format::A8R8G8B8 && o.textureFormat != Texture::Format::X8R8G8B8)
 			throw std::invalid_argument("Only RGBA4444 and RGBA8888 are supported");
+		o.mipmapCount = j.value<uint16_t>(lastAttempt = "mipmapCount", 1);
+		if (!o.mipmapCount)
+			throw std::invalid_argument("mipmapCount must be a positive integer");
 		o.gameIndexFiles = j.value(lastAttempt = "gameIndexFiles", decltype(o.gameIndexFiles)());
 		o.fontRequirements = j.value(lastAttempt = "fontRequirements", decltype(o.fontRequirements)());
 		for (const auto& [key, value] : j.at(lastAttempt = "sources").items()) {
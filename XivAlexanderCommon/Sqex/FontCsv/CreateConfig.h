@@ -158,12 +158,24 @@ namespace Sqex::FontCsv::CreateConfig {
 	void to_json(nlohmann::json& j, const SingleTextureTarget& o);
 	void from_json(const nlohmann::json& j, SingleTextureTarget& o);
 
+	enum class PackingHeuristic {
+		Shelf,  // rows of glyphs, each as tall as the tallest glyph in it, in the order fonts and glyphs come in
+		SkylineBottomLeft,  // lowest position along the skyline
+		SkylineMinWaste,  // position along the skyline that leaves the least unusable space below
+		MaxRectsBestShortSideFit,  // free rectangle with the smallest leftover on the shorter side
+		MaxRectsBestAreaFit,  // smallest free rectangle that fits
+	};
+	void to_json(nlohmann::json& j, const PackingHeuristic& o);
+	void from_json(const nlohmann::json& j, PackingHeuristic& o);
+
 	struct FontCreateConfig {
 		uint16_t glyphGap{};
 		bool compactLayout{};
+		PackingHeuristic packingHeuristic{};
 		uint16_t textureWidth{};
 		uint16_t textureHeight{};
 		Texture::Format textureFormat{};
+		uint16_t mipmapCount{};  // 1 to keep only the full size level
 		std::map<std::string, GameIndexFile> gameIndexFiles;
 		std::vector<FontRequirement> fontRequirements;
 		std::map<std::string, InputFontSource> sources;
@@ -1,10 +1,12 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/FontCsv/Creator.h"
 
+#include "XivAlexanderCommon/Sqex/FontCsv/AtlasPacker.h"
 #include "XivAlexanderCommon/Sqex/FontCsv/DirectWriteFont.h"
 #include "XivAlexanderCommon/Sqex/FontCsv/FdtFont.h"
 #include "XivAlexanderCommon/Sqex/FontCsv/FreeTypeFont.h"
 #include "XivAlexanderCommon/Sqex/FontCsv/GdiFont.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/GlyphCache.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/EntryRawStream.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/Reader.h"
 #include "XivAlexanderCommon/Utils/Win32/Process.h"
@@ -133,6 +135,17 @@ struct Sqex::FontCsv::FontCsvCreator::Implementation {
 		SSIZE_T globalOffsetY = 0;
 		uint8_t boundingHeight = 0;
 	} Step0Result;
+
+	// Font entries waiting for RenderTarget::Pack to decide where their glyphs go.
+	struct LayoutEntry {
+		char32_t Character;
+		size_t Ticket;
+		uint8_t BoundingWidth;
+		uint8_t BoundingHeight;
+		int8_t NextOffsetX;
+		int8_t CurrentOffsetY;
+	};
+	std::vector<LayoutEntry> LayoutEntries;
 };
 
 Sqex::FontCsv::FontCsvCreator::FontCsvCreator(const Win32::Semaphore& semaphore)
@@ -203,12 +216,27 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 	const uint16_t TextureWidth;
 	const uint16_t TextureHeight;
 	const uint16_t GlyphGap;
-	uint16_t CurrentX;
-	uint16_t CurrentY;
-	uint16_t CurrentLineHeight;
+	const CreateConfig::PackingHeuristic Heuristic;
 
 	std::vector<std::shared_ptr<Texture::MemoryBackedMipmap>> Mipmaps;
-	std::map<std::tuple<char32_t, const BaseDrawableFont<uint8_t>*, uint8_t, uint8_t, uint8_t, uint8_t>, AllocatedSpace> DrawnGlyphs;
+
+	struct SpaceRequest {
+		char32_t c;
+		const BaseDrawableFont<uint8_t>* font;
+		SSIZE_T drawOffsetX;
+		SSIZE_T drawOffsetY;
+		uint8_t boundingWidth;
+		uint8_t boundingHeight;
+		uint8_t borderThickness;
+		uint8_t borderOpacity;
+		size_t layoutOrder;
+		size_t glyphIndex;
+		AllocatedSpace space;
+	};
+
+	std::mutex RequestMtx;
+	std::map<std::tuple<char32_t, const BaseDrawableFont<uint8_t>*, SSIZE_T, SSIZE_T, uint8_t, uint8_t, uint8_t, uint8_t>, size_t> RequestIndices;
+	std::deque<SpaceRequest> Requests;
 
 	struct WorkItem {
 		Texture::MemoryBackedMipmap* mipmap;
@@ -233,47 +261,76 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 	std::deque<WorkItem> WorkItems;
 	std::atomic_size_t ProcessedWorkItemIndex;
 
-	std::pair<AllocatedSpace, bool> AllocateSpace(char32_t c, const BaseDrawableFont<uint8_t>* font, uint8_t boundingWidth, uint8_t boundingHeight, uint8_t borderThickness, uint8_t borderOpacity) {
-		const auto actualGlyphGap = static_cast<uint16_t>(GlyphGap + borderThickness);
-
-		const auto [it, isNewEntry] = DrawnGlyphs.emplace(std::make_tuple(c, font, borderThickness, borderOpacity, boundingWidth, boundingHeight), AllocatedSpace{});
-		if (isNewEntry) {
-			auto newTargetRequired = false;
-			if (Mipmaps.empty())
-				newTargetRequired = true;
-			else {
-				if (static_cast<size_t>(0) + CurrentX + boundingWidth + actualGlyphGap >= TextureWidth) {
-					CurrentX = actualGlyphGap;
-					CurrentY += CurrentLineHeight + actualGlyphGap + 1;  // Account for rounding errors
-					CurrentLineHeight = 0;
-				}
-				if (CurrentY + boundingHeight + actualGlyphGap + 1 >= TextureHeight)
-					newTargetRequired = true;
-			}
+	Implementation(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap, CreateConfig::PackingHeuristic heuristic)
+		: TextureWidth(textureWidth)
+		, TextureHeight(textureHeight)
+		, GlyphGap(glyphGap)
+		, Heuristic(heuristic) {
+	}
 
-			if (newTargetRequired) {
-				Mipmaps.emplace_back(std::make_shared<Texture::MemoryBackedMipmap>(TextureWidth, TextureHeight, 1, Texture::Format::L8));
-				CurrentX = CurrentY = GlyphGap;
-				CurrentLineHeight = 0;
-			}
+	size_t RequestSpace(char32_t c, const BaseDrawableFont<uint8_t>* font, SSIZE_T drawOffsetX, SSIZE_T drawOffsetY, uint8_t boundingWidth, uint8_t boundingHeight, uint8_t borderThickness, uint8_t borderOpacity, size_t layoutOrder, size_t glyphIndex) {
+		const auto lock = std::lock_guard(RequestMtx);
+		const auto [it, isNewEntry] = RequestIndices.emplace(std::make_tuple(c, font, drawOffsetX, drawOffsetY, boundingWidth, boundingHeight, borderThickness, borderOpacity), Requests.size());
+		if (isNewEntry)
+			Requests.emplace_back(SpaceRequest{c, font, drawOffsetX, drawOffsetY, boundingWidth, boundingHeight, borderThickness, borderOpacity, layoutOrder, glyphIndex});
+		else if (auto& request = Requests[it->second]; std::tie(layoutOrder, glyphIndex) < std::tie(request.layoutOrder, request.glyphIndex)) {
+			// Shared glyphs belong to whichever font would have requested them first if fonts were laid out one by one.
+			request.layoutOrder = layoutOrder;
+			request.glyphIndex = glyphIndex;
+		}
+		return it->second;
+	}
+
+	void Pack() {
+		// Leave a gap at the right and the bottom of every glyph, and at the left and the top of every texture.
+		if (TextureWidth <= GlyphGap + 1 || TextureHeight <= GlyphGap + 1)
+			throw std::invalid_argument("Glyph gap is too big for the texture");
+		AtlasPacker packer(static_cast<uint16_t>(TextureWidth - GlyphGap - 1), static_cast<uint16_t>(TextureHeight - GlyphGap - 1), Heuristic);
+
+		std::vector<SpaceRequest*> sortedRequests;
+		sortedRequests.reserve(Requests.size());
+		for (auto& request : Requests)
+			sortedRequests.emplace_back(&request);
+
+		const auto byOrigin = [](const SpaceRequest* l, const SpaceRequest* r) {
+			return std::tie(l->layoutOrder, l->glyphIndex, l->c) < std::tie(r->layoutOrder, r->glyphIndex, r->c);
+		};
+		if (Heuristic == CreateConfig::PackingHeuristic::Shelf) {
+			// Font by font, and glyphs of each font by code point, as they were laid out before fonts were laid out in parallel.
+			std::ranges::sort(sortedRequests, byOrigin);
+		} else {
+			std::ranges::sort(sortedRequests, [&byOrigin](const SpaceRequest* l, const SpaceRequest* r) {
+				const auto lh = l->boundingHeight + l->borderThickness, rh = r->boundingHeight + r->borderThickness;
+				return lh == rh ? byOrigin(l, r) : lh > rh;
+			});
+		}
 
-			if (CurrentX < actualGlyphGap)
-				CurrentX = actualGlyphGap;
-			if (CurrentY < actualGlyphGap)
-				CurrentY = actualGlyphGap;
+		for (const auto request : sortedRequests) {
+			const auto actualGlyphGap = GlyphGap + request->borderThickness;
+			const auto placement = packer.Insert(
+				static_cast<uint16_t>(request->boundingWidth + actualGlyphGap),
+				static_cast<uint16_t>(request->boundingHeight + actualGlyphGap + 1));  // Account for rounding errors
 
-			it->second = AllocatedSpace{
-				.Index = static_cast<uint16_t>(Mipmaps.size() - 1),
-				.X = CurrentX,
-				.Y = CurrentY,
-				.BoundingHeight = boundingHeight,
+			while (Mipmaps.size() < packer.PageCount())
+				Mipmaps.emplace_back(std::make_shared<Texture::MemoryBackedMipmap>(TextureWidth, TextureHeight, 1, Texture::Format::L8));
+
+			request->space = AllocatedSpace{
+				.Index = placement.Index,
+				.X = static_cast<uint16_t>(placement.X + GlyphGap),
+				.Y = static_cast<uint16_t>(placement.Y + GlyphGap),
+				.BoundingHeight = request->boundingHeight,
 			};
 
-			CurrentX += boundingWidth + GlyphGap;
-			CurrentLineHeight = std::max<uint16_t>(CurrentLineHeight, boundingHeight);
+			WorkItems.emplace_back(WorkItem{
+				.mipmap = Mipmaps[placement.Index].get(),
+				.x = request->space.X + request->drawOffsetX,
+				.y = request->space.Y + request->drawOffsetY,
+				.c = request->c,
+				.font = request->font,
+				.borderThickness = request->borderThickness,
+				.borderOpacity = request->borderOpacity,
+			});
 		}
-
-		return std::make_pair(it->second, isNewEntry);
 	}
 
 	template<typename TextureTypeSupportingRGBA = Texture::RGBA4444, Texture::Format TextureFormat = Texture::Format::A4R4G4B4>
@@ -301,8 +358,8 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 	}
 };
 
-Sqex::FontCsv::FontCsvCreator::RenderTarget::RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap)
-	: m_pImpl(std::make_unique<Implementation>(textureWidth, textureHeight, glyphGap, glyphGap, glyphGap, 0)) {
+Sqex::FontCsv::FontCsvCreator::RenderTarget::RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap, CreateConfig::PackingHeuristic packingHeuristic)
+	: m_pImpl(std::make_unique<Implementation>(textureWidth, textureHeight, glyphGap, packingHeuristic)) {
 }
 
 Sqex::FontCsv::FontCsvCreator::RenderTarget::~RenderTarget() = default;
@@ -340,28 +397,23 @@ std::vector<std::shared_ptr<Sqex::Texture::ModifiableTextureStream>> Sqex::FontC
 	return res;
 }
 
-Sqex::FontCsv::FontCsvCreator::RenderTarget::AllocatedSpace Sqex::FontCsv::FontCsvCreator::RenderTarget::QueueDraw(
+void Sqex::FontCsv::FontCsvCreator::RenderTarget::Pack() {
+	m_pImpl->Pack();
+}
+
+size_t Sqex::FontCsv::FontCsvCreator::RenderTarget::RequestSpace(
 	char32_t c,
 	const BaseDrawableFont<uint8_t>* font,
 	SSIZE_T drawOffsetX, SSIZE_T drawOffsetY,
 	uint8_t boundingWidth, uint8_t boundingHeight,
-	uint8_t borderThickness, uint8_t borderOpacity
+	uint8_t borderThickness, uint8_t borderOpacity,
+	size_t layoutOrder, size_t glyphIndex
 ) {
-	const auto [space, drawRequired] = m_pImpl->AllocateSpace(c, font, boundingWidth, boundingHeight, borderThickness, borderOpacity);
-
-	if (drawRequired) {
-		m_pImpl->WorkItems.emplace_back(Implementation::WorkItem{
-			.mipmap = m_pImpl->Mipmaps[space.Index].get(),
-			.x = space.X + drawOffsetX,
-			.y = space.Y + drawOffsetY,
-			.c = c,
-			.font = font,
-			.borderThickness = borderThickness,
-			.borderOpacity = borderOpacity,
-		});
-	}
+	return m_pImpl->RequestSpace(c, font, drawOffsetX, drawOffsetY, boundingWidth, boundingHeight, borderThickness, borderOpacity, layoutOrder, glyphIndex);
+}
 
-	return space;
+const Sqex::FontCsv::FontCsvCreator::RenderTarget::AllocatedSpace& Sqex::FontCsv::FontCsvCreator::RenderTarget::GetAllocatedSpace(size_t ticket) const {
+	return m_pImpl->Requests[ticket].space;
 }
 
 bool Sqex::FontCsv::FontCsvCreator::RenderTarget::WorkOnNextItem() {
@@ -523,12 +575,17 @@ void Sqex::FontCsv::FontCsvCreator::Step2_Layout(RenderTarget& renderTarget) {
 			currentOffsetY += static_cast<int8_t>(plan.OffsetYModifier());
 
 			boundingHeight += static_cast<SSIZE_T>(2) * borderThickness;
-			const auto space = renderTarget.QueueDraw(plan.Character(), plan.Font,
-				m_pImpl->Step0Result.globalOffsetX, drawOffsetY,
-				boundingWidth, boundingHeight, borderThickness, borderOpacity);
-
-			boundingHeight = std::min(space.BoundingHeight, boundingHeight);
-			m_pImpl->Result->AddFontEntry(plan.Character(), space.Index, space.X, space.Y, boundingWidth, boundingHeight, nextOffsetX, currentOffsetY);
+			m_pImpl->LayoutEntries.emplace_back(Implementation::LayoutEntry{
+				.Character = plan.Character(),
+				.Ticket = renderTarget.RequestSpace(plan.Character(), plan.Font,
+					m_pImpl->Step0Result.globalOffsetX, drawOffsetY,
+					boundingWidth, boundingHeight, borderThickness, borderOpacity,
+					LayoutOrder, m_pImpl->LayoutEntries.size()),
+				.BoundingWidth = boundingWidth,
+				.BoundingHeight = boundingHeight,
+				.NextOffsetX = nextOffsetX,
+				.CurrentOffsetY = currentOffsetY,
+			});
 		}
 	} catch (const std::exception& e) {
 		OnError(e);
@@ -538,6 +595,11 @@ void Sqex::FontCsv::FontCsvCreator::Step2_Layout(RenderTarget& renderTarget) {
 
 void Sqex::FontCsv::FontCsvCreator::Step3_Draw(RenderTarget& target) {
 	try {
+		for (const auto& entry : m_pImpl->LayoutEntries) {
+			const auto& space = target.GetAllocatedSpace(entry.Ticket);
+			m_pImpl->Result->AddFontEntry(entry.Character, space.Index, space.X, space.Y, entry.BoundingWidth, std::min(space.BoundingHeight, entry.BoundingHeight), entry.NextOffsetX, entry.CurrentOffsetY);
+		}
+
 		for (size_t i = 0; i < m_pImpl->WorkPool.ThreadCount(); ++i) {
 			m_pImpl->WorkPool.SubmitWork([&]() {
 				try {
@@ -601,6 +663,9 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 	std::map<std::string, std::shared_ptr<const BaseDrawableFont<uint8_t>>> SourceFonts;
 	std::map<std::string, std::filesystem::path> ResolvedGameIndexFiles;
 
+	std::filesystem::path GlyphCacheDirectory;
+	std::vector<std::shared_ptr<GlyphCache>> GlyphCaches;
+
 	ResultFontSets Result;
 	std::mutex ResultMtx;
 	std::map<std::string, std::map<std::string, std::unique_ptr<FontCsvCreator>>> ResultWork;
@@ -632,6 +697,15 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 		});
 	}
 
+	template<typename T>
+	static std::filesystem::path TryGetFontFile(const T& font) {
+		try {
+			return std::get<0>(font.GetFontFile());
+		} catch (const std::exception&) {
+			return {};
+		}
+	}
+
 	const BaseDrawableFont<uint8_t>& GetSourceFont(const std::string& name) {
 		{
 			const auto lock = std::lock_guard(SourceFontMapAccessMtx);
@@ -649,6 +723,7 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 			}
 
 			std::shared_ptr<BaseDrawableFont<uint8_t>> newFont;
+			std::filesystem::path fontFile;  // where glyphs come from, if known; only looked up to name glyph cache files
 			const auto& inputFontSource = Config.sources.at(name);
 			if (inputFontSource.gameSource) {
 				const auto& source = *inputFontSource.gameSource;
@@ -702,7 +777,10 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 			} else if (inputFontSource.gdiSource) {
 				auto source{ *inputFontSource.gdiSource };
 				source.lfHeight *= source.oversampleScale;
-				newFont = std::make_shared<GdiDrawingFont<uint8_t>>(source);
+				auto font = std::make_shared<GdiDrawingFont<uint8_t>>(source);
+				if (!GlyphCacheDirectory.empty())
+					fontFile = TryGetFontFile(*font);
+				newFont = std::move(font);
 				newFont->Base.AdvanceWidthDelta(source.advanceWidthDelta);
 				newFont->Gamma(source.gamma);
 
@@ -746,6 +824,8 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 
 				if (source.measureUsingFreeType)
 					dfont->SetMeasureWithFreeType();
+				if (!GlyphCacheDirectory.empty())
+					fontFile = TryGetFontFile(*dfont);
 				newFont = std::move(dfont);
 				newFont->Base.AdvanceWidthDelta(source.advanceWidthDelta * source.oversampleScale);
 				newFont->Gamma(source.gamma);
@@ -758,10 +838,11 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 				if (source.fontFile.empty() && source.familyName.empty())
 					throw std::invalid_argument("Neither of fontFile nor familyName was specified.");
 
+				std::shared_ptr<FreeTypeDrawingFont<uint8_t>> ftfont;
 				std::string accumulatedError;
 				if (!source.fontFile.empty()) {
 					try {
-						newFont = std::make_shared<FreeTypeDrawingFont<uint8_t>>(
+						ftfont = std::make_shared<FreeTypeDrawingFont<uint8_t>>(
 							source.fontFile, source.faceIndex, static_cast<float>(source.height * source.oversampleScale), source.loadFlags
 						);
 					} catch (const std::exception& e) {
@@ -771,9 +852,9 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 					}
 				}
 
-				if (!newFont && !source.familyName.empty()) {
+				if (!ftfont && !source.familyName.empty()) {
 					try {
-						newFont = std::make_shared<FreeTypeDrawingFont<uint8_t>>(
+						ftfont = std::make_shared<FreeTypeDrawingFont<uint8_t>>(
 							FromUtf8(source.familyName).c_str(), static_cast<float>(source.height * source.oversampleScale), static_cast<DWRITE_FONT_WEIGHT>(source.weight), source.stretch, source.style, source.loadFlags
 						);
 					} catch (const std::exception& e) {
@@ -783,9 +864,12 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 					}
 				}
 
-				if (!newFont)
+				if (!ftfont)
 					throw std::invalid_argument(accumulatedError);
 
+				if (!GlyphCacheDirectory.empty())
+					fontFile = TryGetFontFile(*ftfont);
+				newFont = std::move(ftfont);
 				newFont->Base.AdvanceWidthDelta(source.advanceWidthDelta* source.oversampleScale);
 				newFont->Gamma(source.gamma);
 
@@ -795,6 +879,23 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 			} else
 				throw std::invalid_argument("Could not identify which font to load.");
 
+			// Glyphs of game fonts are copied from game textures as they are, so there is nothing to save by caching them.
+			// Fonts found by name are cached under the contents of the file they have been loaded from, which changes when the font gets updated;
+			// if the file cannot be found, there would be no telling when cached glyphs go stale.
+			if (!inputFontSource.gameSource && !GlyphCacheDirectory.empty() && !fontFile.empty()) {
+				std::string sourceDescription;
+				if (inputFontSource.directWriteSource)
+					sourceDescription = nlohmann::json(*inputFontSource.directWriteSource).dump();
+				else if (inputFontSource.freeTypeSource)
+					sourceDescription = nlohmann::json(*inputFontSource.freeTypeSource).dump();
+				else if (inputFontSource.gdiSource)
+					sourceDescription = nlohmann::json(*inputFontSource.gdiSource).dump();
+
+				auto cache = std::make_shared<GlyphCache>(GlyphCacheDirectory / GlyphCache::MakeFileName(sourceDescription, fontFile));
+				GlyphCaches.emplace_back(cache);
+				newFont = std::make_shared<CachedDrawableFont<uint8_t>>(std::move(newFont), std::move(cache));
+			}
+
 			// preload for multithreading
 			void(newFont->Base.GetAllCharacters());
 			void(newFont->Base.GetKerningTable());
@@ -811,7 +912,7 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 		for (const auto& target : Config.targets) {
 			const auto& textureGroupFilenamePattern = target.first;
 			const auto& fonts = target.second;
-			renderTargets.emplace(textureGroupFilenamePattern, std::make_unique<FontCsvCreator::RenderTarget>(Config.textureWidth, Config.textureHeight, Config.glyphGap));
+			renderTargets.emplace(textureGroupFilenamePattern, std::make_unique<FontCsvCreator::RenderTarget>(Config.textureWidth, Config.textureHeight, Config.glyphGap, Config.packingHeuristic));
 			TextureGroupWorkPools.emplace(textureGroupFilenamePattern, std::make_unique<Win32::TpEnvironment>(L"FontCsvCreator::Implementation::TextureGroupWorkPools"));
 			Result.Result.emplace(textureGroupFilenamePattern, ResultFontSet{});
 			auto& remainingFonts = ResultWork.emplace(textureGroupFilenamePattern, std::map<std::string, std::unique_ptr<FontCsvCreator>>()).first->second;
@@ -845,10 +946,15 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 				for (const auto& i : fonts.fontTargets | std::views::keys)
 					sortedRemainingFontList.emplace_back(i);
 
-				// Need to calculate/render small items first to avoid small components in big fonts reserving heights
-				std::ranges::sort(sortedRemainingFontList, [&](const auto& l, const auto& r) {
+				// Lay out small fonts first to avoid small components in big fonts reserving heights.
+				std::ranges::stable_sort(sortedRemainingFontList, [&](const auto& l, const auto& r) {
 					return fonts.fontTargets.at(l).height < fonts.fontTargets.at(r).height;
 				});
+				for (size_t i = 0; i < sortedRemainingFontList.size(); ++i)
+					remainingFonts.at(sortedRemainingFontList[i])->LayoutOrder = i;
+
+				// Start processing from bigger fonts, as they take longer.
+				std::ranges::reverse(sortedRemainingFontList);
 
 				try {
 					// Step 0. Calculate max progress value.
@@ -940,13 +1046,31 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 					}
 					textureGroupWorkPool.WaitOutstanding();
 
-					// Step 2. Calculate where to put each glyph. Cannot be serialized.
+					// Step 2. Measure where each glyph should be drawn relative to its own space.
 					for (const auto& fontName : sortedRemainingFontList) {
-						if (Cancelled)
-							return;
+						textureGroupWorkPool.SubmitWork([this, &target, &creator = *remainingFonts.at(fontName)]() {
+							try {
+								const auto semaphoreHolder = WaitSemaphore();
+								if (Cancelled)
+									return;
+
+								creator.Step2_Layout(target);
+							} catch (const std::exception& e) {
+								if (LastErrorMessage.empty()) {
+									LastErrorMessage = e.what() && *e.what() ? e.what() : "Unknown error";
+									void(Win32::Thread(L"Canceller", [this]() { Cancel(false); }));
 
-						remainingFonts.at(fontName)->Step2_Layout(target);
+									DebugThrowError(e);
+								}
+							}
+						});
 					}
+					textureGroupWorkPool.WaitOutstanding();
+					if (Cancelled)
+						return;
+
+					// Step 2-1. Decide where to put each glyph, with all the glyphs of every font in the texture group at once.
+					target.Pack();
 
 					// Step 3. Draw glyphs onto mipmaps.
 					for (const auto& fontName : sortedRemainingFontList) {
@@ -976,6 +1100,12 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 								target.Finalize(Config.textureFormat);
 
 								resultSet.Textures = target.AsTextureStreamVector();
+
+								// Glyph coverage is not sRGB encoded, so it is filtered as is.
+								if (Config.mipmapCount > 1) {
+									for (const auto& texture : resultSet.Textures)
+										texture->GenerateMipmaps(Config.textureFormat, { .Srgb = false }, Config.mipmapCount);
+								}
 							} catch (const std::exception& e) {
 								if (LastErrorMessage.empty()) {
 									LastErrorMessage = e.what() && *e.what() ? e.what() : "Unknown error";
@@ -999,6 +1129,22 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 		}
 
 		WorkPool.WaitOutstanding();
+
+		if (!Cancelled) {
+			for (const auto& cache : GlyphCaches) {
+				try {
+					cache->Save();
+				} catch (const std::exception&) {
+					// whatever; glyphs will be rendered again next time
+				}
+			}
+
+			try {
+				GlyphCache::RemoveUnused(GlyphCacheDirectory);
+			} catch (const std::exception&) {
+				// whatever; try again next time
+			}
+		}
 	}
 
 	void Cancel(bool wait = true) {
@@ -1047,6 +1193,10 @@ void Sqex::FontCsv::FontSetsCreator::ProvideGameDirectory(Sqex::GameReleaseRegio
 	m_pImpl->GameRootDirectories.emplace(region, std::move(path));
 }
 
+void Sqex::FontCsv::FontSetsCreator::SetGlyphCacheDirectory(std::filesystem::path path) {
+	m_pImpl->GlyphCacheDirectory = std::move(path);
+}
+
 void Sqex::FontCsv::FontSetsCreator::VerifyRequirements(
 	const std::function<std::filesystem::path(const CreateConfig::GameIndexFile&)>& promptGameIndexFile,
 	const std::function<bool(const CreateConfig::FontRequirement&)>& promptFontRequirement
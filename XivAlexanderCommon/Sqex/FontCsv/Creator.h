@@ -51,6 +51,9 @@ namespace Sqex::FontCsv {
 		uint8_t BorderOpacity = 0;
 		bool CompactLayout = false;
 
+		// Glyphs of fonts with smaller values get placed first, when fonts share a render target.
+		size_t LayoutOrder = 0;
+
 		FontCsvCreator(const Win32::Semaphore& semaphore = nullptr);
 		~FontCsvCreator();
 
@@ -69,9 +72,12 @@ namespace Sqex::FontCsv {
 			const std::unique_ptr<Implementation> m_pImpl;
 
 		public:
-			RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap);
+			RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap, CreateConfig::PackingHeuristic packingHeuristic = CreateConfig::PackingHeuristic::Shelf);
 			~RenderTarget();
 
+			// Places every glyph requested from Step2_Layout of each font. Call after all of them, and before any Step3_Draw.
+			void Pack();
+
 			void Finalize(Texture::Format textureFormat = Texture::Format::A4R4G4B4);
 
 			[[nodiscard]] std::vector<std::shared_ptr<const Texture::MipmapStream>> AsMipmapStreamVector() const;
@@ -88,7 +94,10 @@ namespace Sqex::FontCsv {
 				uint8_t BoundingHeight;
 			};
 
-			AllocatedSpace QueueDraw(char32_t c, const BaseDrawableFont<uint8_t>* font, SSIZE_T drawOffsetX, SSIZE_T drawOffsetY, uint8_t boundingWidth, uint8_t boundingHeight, uint8_t borderThickness, uint8_t borderOpacity);
+			// Returns a ticket for GetAllocatedSpace, which becomes usable after Pack. Safe to call from multiple threads.
+			// Pack goes through requests by layoutOrder and then glyphIndex, so that the result does not depend on which thread came first.
+			size_t RequestSpace(char32_t c, const BaseDrawableFont<uint8_t>* font, SSIZE_T drawOffsetX, SSIZE_T drawOffsetY, uint8_t boundingWidth, uint8_t boundingHeight, uint8_t borderThickness, uint8_t borderOpacity, size_t layoutOrder, size_t glyphIndex);
+			[[nodiscard]] const AllocatedSpace& GetAllocatedSpace(size_t ticket) const;
 			bool WorkOnNextItem();
 		};
 
@@ -122,6 +131,9 @@ namespace Sqex::FontCsv {
 		};
 		
 		void ProvideGameDirectory(Sqex::GameReleaseRegion, std::filesystem::path);
+
+		// Keep rendered glyphs of non-game fonts in given directory, so that unchanged fonts do not have to be rendered again.
+		void SetGlyphCacheDirectory(std::filesystem::path);
 		void VerifyRequirements(
 			const std::function<std::filesystem::path(const CreateConfig::GameIndexFile&)>& promptGameIndexFile,
 			const std::function<bool(const CreateConfig::FontRequirement&)>& promptFontRequirement
@@ -283,11 +283,30 @@ Sqex::FontCsv::GlyphMeasurement Sqex::FontCsv::DirectWriteFont::DrawCharacter(ch
 }
 
 std::tuple<std::filesystem::path, int> Sqex::FontCsv::DirectWriteFont::GetFontFile() const {
-	if (!m_pImpl->Face3)
+	return GetFontFile(m_pImpl->Face3);
+}
+
+std::tuple<std::filesystem::path, int> Sqex::FontCsv::DirectWriteFont::GetFontFile(HDC hdc) {
+	IDWriteFactory3Ptr factory;
+	Succ(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory3), reinterpret_cast<IUnknown**>(&factory)));
+
+	IDWriteGdiInteropPtr interop;
+	Succ(factory->GetGdiInterop(&interop));
+
+	IDWriteFontFacePtr fontFace;
+	Succ(interop->CreateFontFaceFromHdc(hdc, &fontFace));
+
+	IDWriteFontFace3Ptr fontFace3;
+	fontFace.QueryInterface(decltype(fontFace3)::GetIID(), &fontFace3);
+	return GetFontFile(fontFace3);
+}
+
+std::tuple<std::filesystem::path, int> Sqex::FontCsv::DirectWriteFont::GetFontFile(IDWriteFontFace3* face) {
+	if (!face)
 		throw std::runtime_error("Unsupported on this version of Windows");
 
 	IDWriteFontFaceReferencePtr ref;
-	Succ(m_pImpl->Face3->GetFontFaceReference(&ref));
+	Succ(face->GetFontFaceReference(&ref));
 
 	IDWriteFontFilePtr file;
 	Succ(ref->GetFontFile(&file));
@@ -41,6 +41,12 @@ namespace Sqex::FontCsv {
 
 		std::tuple<std::filesystem::path, int> GetFontFile() const;
 
+		// Finds the file of the font selected into a GDI device context.
+		static std::tuple<std::filesystem::path, int> GetFontFile(HDC hdc);
+
+	private:
+		static std::tuple<std::filesystem::path, int> GetFontFile(IDWriteFontFace3* face);
+
 	protected:
 		class DwriteRenderBufferCtxMgr {
 			Implementation* m_pImpl;
@@ -120,7 +126,7 @@ namespace Sqex::FontCsv {
 
 				if (!src.EffectivelyEmpty() && !dest.EffectivelyEmpty()) {
 					auto destBuf = to->View<DestPixFmt>();
-					RgbBitmapCopy<uint8_t, GetEffectiveOpacity, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::Gamma());
+					RgbBitmapCopy<uint8_t, GetEffectiveOpacity, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
 				}
 			}
 			return bbox;
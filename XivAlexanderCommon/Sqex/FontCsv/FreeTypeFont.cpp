@@ -161,6 +161,10 @@ Sqex::FontCsv::GlyphMeasurement Sqex::FontCsv::FreeTypeFont::Measure(SSIZE_T x,
 	return GetFace(c).ToMeasurement(x, y);
 }
 
+std::tuple<std::filesystem::path, int> Sqex::FontCsv::FreeTypeFont::GetFontFile() const {
+	return {m_pImpl->File.GetPathName(), m_pImpl->FaceIndex};
+}
+
 Sqex::FontCsv::FreeTypeFont::FtFaceCtxMgr::FtFaceCtxMgr(const FreeTypeFont* owner, Implementation* impl, FT_Face face)
 	: m_owner(owner)
 	, m_impl(impl)
@@ -45,6 +45,8 @@ namespace Sqex::FontCsv {
 		[[nodiscard]] const std::map<std::pair<char32_t, char32_t>, SSIZE_T>& GetKerningTable() const override;
 		[[nodiscard]] GlyphMeasurement Measure(SSIZE_T x, SSIZE_T y, char32_t c) const override;
 
+		std::tuple<std::filesystem::path, int> GetFontFile() const;
+
 	protected:
 		class FtFaceCtxMgr {
 			const FreeTypeFont* m_owner;
@@ -183,16 +185,16 @@ namespace Sqex::FontCsv {
 					auto destBuf = to->View<DestPixFmt>();
 					switch (target.num_grays) {
 						case 2:
-							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<2>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::Gamma());
+							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<2>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
 							break;
 						case 4:
-							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<4>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::Gamma());
+							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<4>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
 							break;
 						case 16:
-							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<16>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::Gamma());
+							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<16>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
 							break;
 						case 256:
-							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<256>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::Gamma());
+							RgbBitmapCopy<uint8_t, FreeTypeDrawingFont_GetEffectiveOpacity<256>, DestPixFmt, OpacityType>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
 							break;
 						default:
 							throw std::invalid_argument("invalid num_grays");
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/FontCsv/GdiFont.h"
 
+#include "XivAlexanderCommon/Sqex/FontCsv/DirectWriteFont.h"
+
 struct Sqex::FontCsv::GdiFont::Implementation {
 	const LOGFONTW LogFont;
 	std::mutex WrapperMtx;
@@ -92,6 +94,10 @@ Sqex::FontCsv::GlyphMeasurement Sqex::FontCsv::GdiFont::Measure(SSIZE_T x, SSIZE
 	return AllocateDeviceContext()->Measure(x, y, c);
 }
 
+std::tuple<std::filesystem::path, int> Sqex::FontCsv::GdiFont::GetFontFile() const {
+	return DirectWriteFont::GetFontFile(AllocateDeviceContext()->GetDC());
+}
+
 Sqex::FontCsv::GdiFont::DeviceContextWrapper::DeviceContextWrapper(const GdiFont* owner, const LOGFONTW& logfont)
 	: m_owner(owner)
 	, m_hdc(CreateCompatibleDC(nullptr))
@@ -21,6 +21,9 @@ namespace Sqex::FontCsv {
 		using BaseFont::Measure;
 		[[nodiscard]] GlyphMeasurement Measure(SSIZE_T x, SSIZE_T y, char32_t c) const override;
 
+		// Finds the file GDI has picked for the font, through DirectWrite.
+		std::tuple<std::filesystem::path, int> GetFontFile() const;
+
 	protected:
 		class DeviceContextWrapper {
 			const GdiFont* const m_owner;
@@ -135,7 +138,7 @@ namespace Sqex::FontCsv {
 
 			if (!src.empty && !dest.empty) {
 				auto destBuf = to->View<DestPixFmt>();
-				RgbBitmapCopy<Texture::RGBA8888, GetEffectiveOpacity, DestPixFmt, OpacityType, -1>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::Gamma());
+				RgbBitmapCopy<Texture::RGBA8888, GetEffectiveOpacity, DestPixFmt, OpacityType, -1>::CopyTo(src, dest, &srcBuf[0], &destBuf[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
 			}
 			return bbox;
 		}
@@ -0,0 +1,222 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/GlyphCache.h"
+
+#include "XivAlexanderCommon/Utils/Win32/Handle.h"
+
+namespace {
+	// Change whenever the file layout, or the way glyphs get rendered, changes.
+	constexpr char FileSignature[8] = {'X', 'A', 'G', 'L', 'Y', 'P', 'H', '1'};
+
+	struct FileHeader {
+		char Signature[8];
+		uint32_t MeasurementCount;
+		uint32_t RenderedGlyphCount;
+	};
+
+	// Each rendered glyph is followed by its coverage.
+	struct GlyphEntry {
+		uint32_t Character;
+		uint32_t Empty;
+		int32_t Left;
+		int32_t Top;
+		int32_t Right;
+		int32_t Bottom;
+		int32_t AdvanceX;
+
+		GlyphEntry() = default;
+
+		GlyphEntry(char32_t c, const Sqex::FontCsv::GlyphMeasurement& m)
+			: Character(c)
+			, Empty(m.empty ? 1 : 0)
+			, Left(static_cast<int32_t>(m.left))
+			, Top(static_cast<int32_t>(m.top))
+			, Right(static_cast<int32_t>(m.right))
+			, Bottom(static_cast<int32_t>(m.bottom))
+			, AdvanceX(static_cast<int32_t>(m.advanceX)) {
+		}
+
+		[[nodiscard]] Sqex::FontCsv::GlyphMeasurement ToMeasurement() const {
+			return {!!Empty, Left, Top, Right, Bottom, AdvanceX};
+		}
+	};
+}
+
+struct Sqex::FontCsv::GlyphCache::Implementation {
+	const std::filesystem::path Path;
+
+	mutable std::mutex Mtx;
+	std::map<char32_t, GlyphMeasurement> Measurements;
+	std::map<char32_t, std::shared_ptr<const RenderedGlyph>> RenderedGlyphs;
+	mutable bool Dirty = false;
+
+	Implementation(std::filesystem::path path)
+		: Path(std::move(path)) {
+	}
+
+	void Load() {
+		const auto file = Win32::Handle::FromCreateFile(Path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+		const auto data = file.Read<uint8_t>(0, static_cast<size_t>(file.GetFileSize()));
+
+		size_t offset = 0;
+		const auto read = [&]<typename T>(T& value) {
+			if (data.size() - offset < sizeof value)
+				throw CorruptDataException("Glyph cache file is truncated");
+			memcpy(&value, &data[offset], sizeof value);
+			offset += sizeof value;
+		};
+
+		FileHeader header;
+		read(header);
+		if (memcmp(header.Signature, FileSignature, sizeof FileSignature) != 0)
+			throw CorruptDataException("Glyph cache file has an unexpected signature");
+
+		for (uint32_t i = 0; i < header.MeasurementCount; ++i) {
+			GlyphEntry entry;
+			read(entry);
+			Measurements.emplace(entry.Character, entry.ToMeasurement());
+		}
+
+		for (uint32_t i = 0; i < header.RenderedGlyphCount; ++i) {
+			GlyphEntry entry;
+			read(entry);
+
+			auto glyph = std::make_shared<RenderedGlyph>();
+			glyph->Bbox = entry.ToMeasurement();
+			if (!glyph->Bbox.EffectivelyEmpty()) {
+				if (glyph->Bbox.Width() < 0 || glyph->Bbox.Height() < 0)
+					throw CorruptDataException("Glyph cache file has an invalid bounding box");
+				const auto size = static_cast<size_t>(glyph->Bbox.Area());
+				if (data.size() - offset < size)
+					throw CorruptDataException("Glyph cache file is truncated");
+				glyph->Coverage.assign(data.begin() + static_cast<ptrdiff_t>(offset), data.begin() + static_cast<ptrdiff_t>(offset + size));
+				offset += size;
+			}
+			RenderedGlyphs.emplace(entry.Character, std::move(glyph));
+		}
+	}
+};
+
+Sqex::FontCsv::GlyphCache::GlyphCache(std::filesystem::path path)
+	: m_pImpl(std::make_unique<Implementation>(std::move(path))) {
+	if (m_pImpl->Path.empty() || !exists(m_pImpl->Path))
+		return;
+
+	try {
+		m_pImpl->Load();
+
+		// Mark as in use, so that RemoveUnused keeps it.
+		std::filesystem::last_write_time(m_pImpl->Path, std::filesystem::file_time_type::clock::now());
+	} catch (const std::exception&) {
+		// Start over; the file will be overwritten on Save.
+		m_pImpl->Measurements.clear();
+		m_pImpl->RenderedGlyphs.clear();
+		m_pImpl->Dirty = true;
+	}
+}
+
+Sqex::FontCsv::GlyphCache::~GlyphCache() = default;
+
+bool Sqex::FontCsv::GlyphCache::TryGetMeasurement(char32_t c, GlyphMeasurement& measurement) const {
+	const auto lock = std::lock_guard(m_pImpl->Mtx);
+	const auto it = m_pImpl->Measurements.find(c);
+	if (it == m_pImpl->Measurements.end())
+		return false;
+
+	measurement = it->second;
+	return true;
+}
+
+void Sqex::FontCsv::GlyphCache::SetMeasurement(char32_t c, const GlyphMeasurement& measurement) {
+	const auto lock = std::lock_guard(m_pImpl->Mtx);
+	m_pImpl->Measurements.insert_or_assign(c, measurement);
+	m_pImpl->Dirty = true;
+}
+
+std::shared_ptr<const Sqex::FontCsv::GlyphCache::RenderedGlyph> Sqex::FontCsv::GlyphCache::GetRenderedGlyph(char32_t c) const {
+	const auto lock = std::lock_guard(m_pImpl->Mtx);
+	const auto it = m_pImpl->RenderedGlyphs.find(c);
+	return it == m_pImpl->RenderedGlyphs.end() ? nullptr : it->second;
+}
+
+void Sqex::FontCsv::GlyphCache::SetRenderedGlyph(char32_t c, std::shared_ptr<const RenderedGlyph> glyph) {
+	const auto lock = std::lock_guard(m_pImpl->Mtx);
+	m_pImpl->RenderedGlyphs.insert_or_assign(c, std::move(glyph));
+	m_pImpl->Dirty = true;
+}
+
+void Sqex::FontCsv::GlyphCache::Save() const {
+	const auto lock = std::lock_guard(m_pImpl->Mtx);
+	if (m_pImpl->Path.empty() || !m_pImpl->Dirty)
+		return;
+
+	std::vector<uint8_t> data;
+	const auto write = [&data](const void* p, size_t size) {
+		data.insert(data.end(), static_cast<const uint8_t*>(p), static_cast<const uint8_t*>(p) + size);
+	};
+
+	FileHeader header{};
+	memcpy(header.Signature, FileSignature, sizeof FileSignature);
+	header.MeasurementCount = static_cast<uint32_t>(m_pImpl->Measurements.size());
+	header.RenderedGlyphCount = static_cast<uint32_t>(m_pImpl->RenderedGlyphs.size());
+	write(&header, sizeof header);
+
+	for (const auto& [c, measurement] : m_pImpl->Measurements) {
+		const GlyphEntry entry(c, measurement);
+		write(&entry, sizeof entry);
+	}
+
+	for (const auto& [c, glyph] : m_pImpl->RenderedGlyphs) {
+		const GlyphEntry entry(c, glyph->Bbox);
+		write(&entry, sizeof entry);
+		write(glyph->Coverage.data(), glyph->Coverage.size());
+	}
+
+	create_directories(m_pImpl->Path.parent_path());
+	const auto tempPath = std::filesystem::path(m_pImpl->Path).concat(L".tmp");
+	Win32::Handle::FromCreateFile(tempPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, 0).Write(0, std::span(data));
+	std::filesystem::rename(tempPath, m_pImpl->Path);
+	m_pImpl->Dirty = false;
+}
+
+std::filesystem::path Sqex::FontCsv::GlyphCache::MakeFileName(const std::string& sourceDescription, const std::filesystem::path& fontFile) {
+	CryptoPP::SHA1 sha1;
+	sha1.Update(reinterpret_cast<const CryptoPP::byte*>(FileSignature), sizeof FileSignature);
+	sha1.Update(reinterpret_cast<const CryptoPP::byte*>(sourceDescription.data()), sourceDescription.size());
+
+	if (!fontFile.empty() && exists(fontFile)) {
+		const auto file = Win32::Handle::FromCreateFile(fontFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+		std::vector<uint8_t> buf(1048576);
+		for (uint64_t offset = 0, size = file.GetFileSize(); offset < size; ) {
+			const auto read = file.Read(offset, std::span(buf), Win32::Handle::PartialIoMode::AllowPartial);
+			if (!read)
+				break;
+			sha1.Update(buf.data(), read);
+			offset += read;
+		}
+	}
+
+	CryptoPP::byte digest[CryptoPP::SHA1::DIGESTSIZE];
+	sha1.Final(digest);
+
+	std::string name;
+	for (const auto b : digest)
+		name += std::format("{:02x}", b);
+	return name + ".glyphs";
+}
+
+void Sqex::FontCsv::GlyphCache::RemoveUnused(const std::filesystem::path& directory, std::chrono::hours maxAge) {
+	if (directory.empty() || !exists(directory))
+		return;
+
+	const auto threshold = std::filesystem::file_time_type::clock::now() - maxAge;
+	for (const auto& item : std::filesystem::directory_iterator(directory)) {
+		const auto ext = item.path().extension();
+		const auto isCache = ext == ".glyphs" || (ext == ".tmp" && item.path().stem().extension() == ".glyphs");
+		if (!isCache || !item.is_regular_file())
+			continue;
+
+		std::error_code ec;
+		if (const auto writeTime = item.last_write_time(ec); !ec && writeTime < threshold)
+			std::filesystem::remove(item.path(), ec);
+	}
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "XivAlexanderCommon/Sqex/FontCsv/BaseDrawableFont.h"
+
+namespace Sqex::FontCsv {
+	// Measurements and rendered coverage of glyphs of a font, which can be stored in a file to skip rendering them again.
+	class GlyphCache {
+	public:
+		struct RenderedGlyph {
+			// As returned from drawing the glyph at (0, 0).
+			GlyphMeasurement Bbox;
+
+			// Opacity of each pixel in Bbox, with gamma already applied; empty if Bbox is effectively empty.
+			std::vector<uint8_t> Coverage;
+		};
+
+	private:
+		struct Implementation;
+		const std::unique_ptr<Implementation> m_pImpl;
+
+	public:
+		// Loads glyphs stored in path if it exists. If path is empty, glyphs are only kept in memory.
+		GlyphCache(std::filesystem::path path = {});
+		~GlyphCache();
+
+		bool TryGetMeasurement(char32_t c, GlyphMeasurement& measurement) const;
+		void SetMeasurement(char32_t c, const GlyphMeasurement& measurement);
+
+		[[nodiscard]] std::shared_ptr<const RenderedGlyph> GetRenderedGlyph(char32_t c) const;
+		void SetRenderedGlyph(char32_t c, std::shared_ptr<const RenderedGlyph> glyph);
+
+		// Writes to the file if anything has been added since it was loaded.
+		void Save() const;
+
+		// Names a file after everything that affects how glyphs look: the description of the font source, and the contents of its font file if any.
+		[[nodiscard]] static std::filesystem::path MakeFileName(const std::string& sourceDescription, const std::filesystem::path& fontFile);
+
+		// Deletes cache files in directory that have not been loaded or saved for maxAge, such as those of fonts that have since been updated or removed.
+		static void RemoveUnused(const std::filesystem::path& directory, std::chrono::hours maxAge = std::chrono::hours(24 * 30));
+	};
+
+	// Draws glyphs of another font once, and copies the remembered coverage afterwards.
+	template<typename DestPixFmt = Texture::RGBA8888, typename OpacityType = uint8_t>
+	class CachedDrawableFont : public BaseFont, public BaseDrawableFont<DestPixFmt, OpacityType> {
+		const std::shared_ptr<BaseDrawableFont<DestPixFmt, OpacityType>> m_underlying;
+		const std::shared_ptr<GlyphCache> m_cache;
+
+		static uint32_t ResolverFunction(const uint8_t& n) {
+			return n;
+		}
+
+		[[nodiscard]] const BaseFont& UnderlyingBase() const {
+			return m_underlying->BaseDrawableFont<DestPixFmt, OpacityType>::Base;
+		}
+
+		[[nodiscard]] std::shared_ptr<const GlyphCache::RenderedGlyph> Render(char32_t c) const {
+			auto canvasBox = Measure(0, 0, c);
+			auto result = std::make_shared<GlyphCache::RenderedGlyph>();
+
+			// Retry once with a canvas covering what drawing has reported, in case it does not agree with measuring.
+			for (auto retried = false; ; retried = true) {
+				const auto canvasLeft = canvasBox.empty ? 0 : canvasBox.left;
+				const auto canvasTop = canvasBox.empty ? 0 : canvasBox.top;
+				Texture::MemoryBackedMipmap canvas(
+					static_cast<uint16_t>(std::max<SSIZE_T>(1, canvasBox.empty ? 0 : canvasBox.Width())),
+					static_cast<uint16_t>(std::max<SSIZE_T>(1, canvasBox.empty ? 0 : canvasBox.Height())),
+					1, Texture::Format::L8);
+
+				result->Bbox = m_underlying->Draw(&canvas, -canvasLeft, -canvasTop, c, 0xFF, 0x00);
+				if (result->Bbox.empty)
+					return result;
+				result->Bbox.Translate(canvasLeft, canvasTop);
+				if (result->Bbox.EffectivelyEmpty())
+					return result;
+
+				const auto& bbox = result->Bbox;
+				if (!retried && (canvasBox.empty || bbox.left < canvasBox.left || bbox.top < canvasBox.top || bbox.right > canvasBox.right || bbox.bottom > canvasBox.bottom)) {
+					canvasBox.ExpandToFit(bbox);
+					continue;
+				}
+
+				const auto src = canvas.View<uint8_t>();
+				result->Coverage.resize(static_cast<size_t>(bbox.Area()));
+				for (auto y = bbox.top; y < bbox.bottom; ++y) {
+					for (auto x = bbox.left; x < bbox.right; ++x) {
+						const auto canvasX = x - canvasLeft;
+						const auto canvasY = y - canvasTop;
+						if (canvasX >= 0 && canvasY >= 0 && canvasX < canvas.Width && canvasY < canvas.Height)
+							result->Coverage[static_cast<size_t>((y - bbox.top) * bbox.Width() + x - bbox.left)] = src[static_cast<size_t>(canvasY * canvas.Width + canvasX)];
+					}
+				}
+				return result;
+			}
+		}
+
+	public:
+		using BaseDrawableFont<DestPixFmt, OpacityType>::MaxOpacity;
+
+		CachedDrawableFont(std::shared_ptr<BaseDrawableFont<DestPixFmt, OpacityType>> underlying, std::shared_ptr<GlyphCache> cache)
+			: BaseFont()
+			, BaseDrawableFont<DestPixFmt, OpacityType>(this)
+			, m_underlying(std::move(underlying))
+			, m_cache(std::move(cache)) {
+		}
+
+		bool HasCharacter(char32_t c) const override {
+			return UnderlyingBase().HasCharacter(c);
+		}
+
+		float Size() const override {
+			return UnderlyingBase().Size();
+		}
+
+		const std::vector<char32_t>& GetAllCharacters() const override {
+			return UnderlyingBase().GetAllCharacters();
+		}
+
+		uint32_t Ascent() const override {
+			return UnderlyingBase().Ascent();
+		}
+
+		uint32_t LineHeight() const override {
+			return UnderlyingBase().LineHeight();
+		}
+
+		const std::map<std::pair<char32_t, char32_t>, SSIZE_T>& GetKerningTable() const override {
+			return UnderlyingBase().GetKerningTable();
+		}
+
+		SSIZE_T GetKerning(char32_t l, char32_t r, SSIZE_T defaultOffset = 0) const override {
+			return UnderlyingBase().GetKerning(l, r, defaultOffset);
+		}
+
+		using BaseFont::Measure;
+
+		GlyphMeasurement Measure(SSIZE_T x, SSIZE_T y, char32_t c) const override {
+			GlyphMeasurement result;
+			if (!m_cache->TryGetMeasurement(c, result)) {
+				result = UnderlyingBase().Measure(0, 0, c);
+				m_cache->SetMeasurement(c, result);
+			}
+			if (!result.empty)
+				result.Translate(x, y);
+			return result;
+		}
+
+		using BaseDrawableFont<DestPixFmt, OpacityType>::Draw;
+
+		GlyphMeasurement Draw(Texture::MemoryBackedMipmap* to, SSIZE_T x, SSIZE_T y, char32_t c, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity = MaxOpacity, OpacityType bgOpacity = MaxOpacity) const override {
+			auto glyph = m_cache->GetRenderedGlyph(c);
+			if (!glyph) {
+				glyph = Render(c);
+				m_cache->SetRenderedGlyph(c, glyph);
+			}
+
+			auto dest = glyph->Bbox;
+			if (dest.empty)
+				return dest;
+			dest.Translate(x, y);
+			if (dest.EffectivelyEmpty())
+				return dest;
+
+			const auto srcWidth = glyph->Bbox.Width();
+			const auto srcHeight = glyph->Bbox.Height();
+			GlyphMeasurement src = {false, 0, 0, srcWidth, srcHeight};
+			auto clippedDest = dest;
+			src.AdjustToIntersection(clippedDest, srcWidth, srcHeight, to->Width, to->Height);
+			if (!src.EffectivelyEmpty() && !clippedDest.EffectivelyEmpty()) {
+				auto destBuf = to->View<DestPixFmt>();
+
+				// Coverage already has gamma applied, and gamma of this font itself stays at 1.
+				RgbBitmapCopy<uint8_t, ResolverFunction, DestPixFmt, OpacityType>::CopyTo(src, clippedDest, &glyph->Coverage[0], &destBuf[0], srcWidth, srcHeight, to->Width, fgColor, bgColor, fgOpacity, bgOpacity, BaseDrawableFont<DestPixFmt, OpacityType>::GammaTable());
+			}
+			return dest;
+		}
+	};
+}
@@ -41,22 +41,21 @@ std::string Sqex::Network::Structure::XivBundle::Represent() const {
 	);
 }
 
-std::vector<std::vector<uint8_t>> Sqex::Network::Structure::XivBundle::SplitMessages(uint16_t expectedMessageCount, const std::span<const uint8_t>& buf) {
-	std::vector<std::vector<uint8_t>> result;
+std::vector<std::span<uint8_t>> Sqex::Network::Structure::XivBundle::SplitMessages(uint16_t expectedMessageCount, std::span<uint8_t> buf) {
+	std::vector<std::span<uint8_t>> result;
 	result.reserve(expectedMessageCount);
 	for (size_t i = 0; i < buf.size();) {
 		const auto& message = *reinterpret_cast<const XivMessage*>(&buf[i]);
 		if (i + message.Length > buf.size() || !message.Length)
 			throw std::runtime_error("Could not parse game message (sum(message.length for each message) > total message length)");
 
-		const auto sub = buf.subspan(i, static_cast<size_t>(message.Length));
-		result.emplace_back(sub.begin(), sub.end());
+		result.emplace_back(buf.subspan(i, static_cast<size_t>(message.Length)));
 		i += message.Length;
 	}
 	return result;
 }
 
-std::vector<std::vector<uint8_t>> Sqex::Network::Structure::XivBundle::GetMessages(Utils::ZlibReusableInflater& inflater, Utils::Oodle::Oodler& oodler) const {
+std::vector<std::span<uint8_t>> Sqex::Network::Structure::XivBundle::GetMessages(Utils::ZlibReusableInflater& inflater, Utils::Oodle::Oodler& oodler) {
 	const auto view = std::span(Data, TotalLength - sizeof XivBundleHeader);
 
 	switch (CompressionType) {
@@ -247,7 +247,10 @@ namespace Sqex::Network::Structure {
 
 		std::string Represent() const;
 
-		[[nodiscard]] static std::vector<std::vector<uint8_t>> SplitMessages(uint16_t expectedMessageCount, const std::span<const uint8_t>& buf);
-		[[nodiscard]] std::vector<std::vector<uint8_t>> GetMessages(Utils::ZlibReusableInflater&, Utils::Oodle::Oodler&) const;
+		// Returned spans point into buf.
+		[[nodiscard]] static std::vector<std::span<uint8_t>> SplitMessages(uint16_t expectedMessageCount, std::span<uint8_t> buf);
+
+		// Returned spans point into this bundle if uncompressed, or into the buffer of the decoder used otherwise.
+		[[nodiscard]] std::vector<std::span<uint8_t>> GetMessages(Utils::ZlibReusableInflater&, Utils::Oodle::Oodler&);
 	};
 }
@@ -0,0 +1,220 @@
+#include "pch.h"
+#include "XivStream.h"
+
+#include "Structure.h"
+
+using namespace Sqex::Network::Structure;
+
+Sqex::Network::XivStream::XivStream(std::string name, const Utils::Oodle::OodleModule& oodleModule, bool oodleTcp, std::function<void(const std::string&)> onWarning, size_t capacity)
+	: m_name(std::move(name))
+	, m_oodleTcp(oodleTcp)
+	, m_onWarning(std::move(onWarning))
+	, m_oodler(oodleModule, !oodleTcp)
+	, m_unoodler(oodleModule, !oodleTcp) {
+	// A header has to fit, or a bundle could never be recognized.
+	if (!std::has_single_bit(capacity) || capacity < sizeof XivBundleHeader || capacity > MaxCapacity)
+		throw std::invalid_argument(std::format("capacity must be a power of two between {} and {}", sizeof XivBundleHeader, MaxCapacity));
+	m_buffer.resize(capacity);
+}
+
+void Sqex::Network::XivStream::Reserve(size_t capacity) {
+	capacity = std::bit_ceil(capacity);
+	if (capacity <= Capacity())
+		return;
+	if (capacity > MaxCapacity)
+		throw std::length_error(std::format("{}: cannot grow to {} bytes", m_name, capacity));
+
+	const auto available = Available();
+	std::vector<uint8_t> buffer(capacity);
+	ReadBytes(buffer.data(), available);
+	m_buffer = std::move(buffer);
+	m_readPosition = 0;
+	m_writePosition = available;
+	m_growCount++;
+	if (m_onWarning)
+		m_onWarning(std::format("{}: buffer grown to {} bytes", m_name, m_buffer.size()));
+}
+
+void Sqex::Network::XivStream::Wrote(size_t length) {
+	m_writePosition += length;
+	m_highWaterMark = std::max(m_highWaterMark, Available());
+}
+
+void Sqex::Network::XivStream::ConsumeBytes(size_t length) {
+	if (length > Available()) {
+		m_readPosition = m_writePosition;
+		if (m_onWarning)
+			m_onWarning(std::format("{}: overconsuming", m_name));
+	} else
+		m_readPosition += length;
+
+	// Start over from the beginning when empty, so that data is less likely to wrap around.
+	if (m_readPosition == m_writePosition)
+		m_readPosition = m_writePosition = 0;
+}
+
+void Sqex::Network::XivStream::ReadBytes(void* buf, size_t length) {
+	const auto offset = Wrap(m_readPosition);
+	const auto firstLength = std::min(length, Capacity() - offset);
+	memcpy(buf, &m_buffer[offset], firstLength);
+	memcpy(static_cast<uint8_t*>(buf) + firstLength, &m_buffer[0], length - firstLength);
+	ConsumeBytes(length);
+}
+
+std::string Sqex::Network::XivStream::DescribeUsage() const {
+	return std::format("{}(peak={}/{}, stalls={}, grown={})", m_name, m_highWaterMark, Capacity(), m_stallCount, m_growCount);
+}
+
+std::span<uint8_t> Sqex::Network::XivStream::Allocate(size_t maxLength) {
+	const auto offset = Wrap(m_writePosition);
+	return { &m_buffer[offset], std::min({ maxLength, Free(), Capacity() - offset }) };
+}
+
+void Sqex::Network::XivStream::Write(const void* buf, size_t length) {
+	if (Free() < length)
+		throw std::length_error(std::format("{}: writing {} bytes with {} bytes free", m_name, length, Free()));
+
+	const auto uint8buf = static_cast<const uint8_t*>(buf);
+	const auto offset = Wrap(m_writePosition);
+	const auto firstLength = std::min(length, Capacity() - offset);
+	memcpy(&m_buffer[offset], uint8buf, firstLength);
+	memcpy(&m_buffer[0], uint8buf + firstLength, length - firstLength);
+	Wrote(length);
+}
+
+std::span<uint8_t> Sqex::Network::XivStream::PeekContiguous(size_t length) {
+	if (length > Available())
+		throw std::invalid_argument("PeekContiguous: length > Available()");
+
+	const auto offset = Wrap(m_readPosition);
+	if (offset + length <= Capacity())
+		return { &m_buffer[offset], length };
+
+	m_contiguousBuffer.resize(length);
+	const auto firstLength = Capacity() - offset;
+	memcpy(&m_contiguousBuffer[0], &m_buffer[offset], firstLength);
+	memcpy(&m_contiguousBuffer[firstLength], &m_buffer[0], length - firstLength);
+	return m_contiguousBuffer;
+}
+
+void Sqex::Network::XivStream::TunnelXivStream(XivStream& target, const MessageMangler& messageMangler) {
+	while (Available()) {
+		auto head = PeekContiguous(std::min(Available(), sizeof XivBundleHeader));
+
+		if (auto trash = XivBundle::ExtractFrontTrash(head); !trash.empty()) {
+			// Magic may start near the end of what has been looked at.
+			if (head.size() >= sizeof XivBundle::Magic)
+				trash = trash.subspan(0, std::min(trash.size(), head.size() - sizeof XivBundle::Magic + 1));
+			if (target.Free() < trash.size()) {
+				target.Stall();
+				break;
+			}
+			target.Write(trash);
+			Consume(trash.size_bytes());
+			continue;
+		}
+
+		// Incomplete header
+		if (head.size_bytes() < sizeof XivBundleHeader)
+			break;
+
+		const auto bundleHeader = *reinterpret_cast<const XivBundleHeader*>(head.data());
+
+		// Invalid length
+		if (bundleHeader.TotalLength == 0 || bundleHeader.TotalLength > MaxBundleLength || bundleHeader.DecodedBodyLength > MaxBundleLength) {
+			if (!target.Free()) {
+				target.Stall();
+				break;
+			}
+			target.Write(head.subspan(0, 1));
+			Consume(1);
+			continue;
+		}
+
+		// Incomplete data
+		if (Available() < bundleHeader.TotalLength) {
+			Reserve(bundleHeader.TotalLength);
+			break;
+		}
+
+		// Wait until the other side has made room, assuming the worst case of the bundle growing when re-encoded.
+		const auto maxEncodedLength = std::max<size_t>(bundleHeader.TotalLength, sizeof XivBundleHeader + compressBound(bundleHeader.DecodedBodyLength));
+		target.Reserve(maxEncodedLength);
+		if (target.Free() < maxEncodedLength) {
+			target.Stall();
+			break;
+		}
+
+		// Messages get mangled in place, so take a mutable view of the whole bundle.
+		auto* pGamePacket = reinterpret_cast<XivBundle*>(PeekContiguous(bundleHeader.TotalLength).data());
+
+		try {
+			auto messages = pGamePacket->GetMessages(m_inflater, m_unoodler);
+			auto header = *pGamePacket;
+			header.TotalLength = static_cast<uint32_t>(sizeof XivBundleHeader);
+			header.MessageCount = 0;
+			header.CompressionType = pGamePacket->CompressionType;
+			header.DecodedBodyLength = 0;
+
+			auto modified = false;
+			for (auto& message : messages) {
+				if (!messageMangler(reinterpret_cast<XivMessage*>(message.data()), modified)) {
+					message = {};
+					continue;
+				}
+
+				header.DecodedBodyLength += static_cast<uint32_t>(message.size());
+				header.MessageCount += 1;
+			}
+
+			const auto dropped = header.MessageCount != messages.size();
+
+			// Oodle in TCP mode keeps history, which has to stay in sync with what the game has decoded.
+			if (!modified && !dropped && !(m_oodleTcp && header.CompressionType == CompressionType::Oodle)) {
+				target.Write(pGamePacket, pGamePacket->TotalLength);
+
+			} else {
+				std::vector<uint8_t> bodyBuffer;
+				std::span<const uint8_t> body;
+				if (dropped) {
+					bodyBuffer.reserve(header.DecodedBodyLength);
+					for (const auto& message : messages)
+						bodyBuffer.insert(bodyBuffer.end(), message.begin(), message.end());
+					body = bodyBuffer;
+				} else if (!messages.empty()) {
+					// Messages are laid out back to back in the decoded buffer.
+					body = { messages.front().data(), messages.back().data() + messages.back().size() };
+				}
+
+				std::span<const uint8_t> encoded;
+				switch (header.CompressionType) {
+					case CompressionType::None:
+						encoded = body;
+						break;
+					case CompressionType::Deflate:
+						encoded = m_deflater(body);
+						break;
+					case CompressionType::Oodle:
+						encoded = m_oodler.Encode(body);
+						break;
+					default:
+						throw std::runtime_error("Unsupported compression method");
+				}
+
+				// Only happens if DecodedBodyLength was wrong; the bundle as received still fits.
+				if (target.Free() < sizeof XivBundleHeader + encoded.size())
+					throw std::runtime_error(std::format("Re-encoded bundle is {} bytes long, more than expected", sizeof XivBundleHeader + encoded.size()));
+
+				header.TotalLength += static_cast<uint32_t>(encoded.size());
+				target.Write(&header, sizeof XivBundleHeader);
+				target.Write(encoded);
+			}
+		} catch (const std::exception& e) {
+			if (m_onWarning)
+				m_onWarning(std::format("{}: Error: {}\n{}", m_name, e.what(), pGamePacket->Represent()));
+			target.Write(pGamePacket, pGamePacket->TotalLength);
+		}
+
+		Consume(bundleHeader.TotalLength);
+	}
+}
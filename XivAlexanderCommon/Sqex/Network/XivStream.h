@@ -0,0 +1,153 @@
+#pragma once
+
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "XivAlexanderCommon/Utils/Oodle.h"
+#include "XivAlexanderCommon/Utils/ZlibWrapper.h"
+
+namespace Sqex::Network {
+	namespace Structure {
+		struct XivMessage;
+	}
+
+	// Ring buffer holding data going one way through a game connection, which can relay bundles to another stream
+	// while letting message handlers look at, modify, or drop messages in them.
+	class XivStream {
+	public:
+		// Return false to drop the message. Set modified to true after changing the message in place;
+		// bundles with no message dropped or modified are relayed as they were received.
+		typedef std::function<bool(Structure::XivMessage*, bool& modified)> MessageMangler;
+
+		// Capacity must be a power of two, so that positions can be wrapped with a mask.
+		static constexpr size_t DefaultCapacity = 1 << 20;
+
+		// Bundles claiming to be larger than this, compressed or decompressed, are treated as garbage.
+		static constexpr size_t MaxBundleLength = 1 << 25;
+
+		// A stream only grows past the capacity it was created with to hold a single bundle that does not fit otherwise,
+		// so it never has to grow beyond a bundle of MaxBundleLength bytes, re-encoded in the worst case.
+		static constexpr size_t MaxCapacity = 1 << 26;
+
+	private:
+		const std::string m_name;
+		const bool m_oodleTcp;
+		const std::function<void(const std::string&)> m_onWarning;
+		Utils::ZlibReusableDeflater m_deflater;
+		Utils::ZlibReusableInflater m_inflater;
+		Utils::Oodle::Oodler m_oodler, m_unoodler;
+
+		// Ring buffer; positions only ever increase, and get wrapped on access.
+		std::vector<uint8_t> m_buffer;
+		uint64_t m_readPosition = 0;
+		uint64_t m_writePosition = 0;
+
+		// Holds a copy of data that wraps around the end of m_buffer, when it has to be looked at in one piece.
+		std::vector<uint8_t> m_contiguousBuffer;
+
+		size_t m_highWaterMark = 0;
+		size_t m_stallCount = 0;
+		size_t m_growCount = 0;
+
+		[[nodiscard]] size_t Wrap(uint64_t position) const {
+			return static_cast<size_t>(position & (m_buffer.size() - 1));
+		}
+
+		void Reserve(size_t capacity);
+		void Wrote(size_t length);
+		void ConsumeBytes(size_t length);
+		void ReadBytes(void* buf, size_t length);
+
+	public:
+		// onWarning receives messages about unexpected data and buffer usage, with the name of this stream in them.
+		XivStream(std::string name, const Utils::Oodle::OodleModule& oodleModule, bool oodleTcp, std::function<void(const std::string&)> onWarning = nullptr, size_t capacity = DefaultCapacity);
+		XivStream(const XivStream&) = delete;
+		XivStream(XivStream&&) = delete;
+		XivStream& operator=(const XivStream&) = delete;
+		XivStream& operator=(XivStream&&) = delete;
+
+		[[nodiscard]] size_t Capacity() const {
+			return m_buffer.size();
+		}
+
+		[[nodiscard]] size_t Free() const {
+			return Capacity() - Available();
+		}
+
+		template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
+		[[nodiscard]] size_t Available() const {
+			return static_cast<size_t>(m_writePosition - m_readPosition) / sizeof(T);
+		}
+
+		// Record that data could not be moved because there was no room for it.
+		void Stall() {
+			m_stallCount++;
+		}
+
+		[[nodiscard]] size_t HighWaterMark() const {
+			return m_highWaterMark;
+		}
+
+		[[nodiscard]] size_t StallCount() const {
+			return m_stallCount;
+		}
+
+		[[nodiscard]] size_t GrowCount() const {
+			return m_growCount;
+		}
+
+		[[nodiscard]] std::string DescribeUsage() const;
+
+		// Contiguous free space to directly write into, which may be shorter than what is free in total. Call Commit after writing.
+		[[nodiscard]] std::span<uint8_t> Allocate(size_t maxLength);
+
+		void Commit(size_t length) {
+			Wrote(length);
+		}
+
+		// Throws if there is not enough free space; check Free first.
+		void Write(const void* buf, size_t length);
+
+		template<typename T, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
+		void Write(const T& data) {
+			Write(&data, sizeof data);
+		}
+
+		template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
+		void Write(const std::span<T>& data) {
+			Write(data.data(), data.size_bytes());
+		}
+
+		// Returns data up to the end of m_buffer; the rest becomes visible once this part has been consumed.
+		template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
+		[[nodiscard]] std::span<const T> Peek(size_t count = SIZE_MAX) const {
+			const auto offset = Wrap(m_readPosition);
+			return {
+				reinterpret_cast<const T*>(&m_buffer[offset]),
+				std::min(count, std::min(Available(), Capacity() - offset) / sizeof(T))
+			};
+		}
+
+		// Returns the first length bytes in one piece, copying them out if they wrap around. Stays valid until the next call that modifies this stream.
+		[[nodiscard]] std::span<uint8_t> PeekContiguous(size_t length);
+
+		template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
+		void Consume(size_t count) {
+			ConsumeBytes(count * sizeof(T));
+		}
+
+		template<typename T, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
+		size_t Read(T* buf, size_t count) {
+			count = std::min(count, Available<T>());
+			ReadBytes(buf, count * sizeof(T));
+			return count;
+		}
+
+		// Moves complete bundles into target, passing each message in them through messageMangler.
+		// Data that is not a bundle is passed through as-is. Stops when a bundle is incomplete, or target does not have room for it;
+		// either stream grows only if a single bundle would not fit in it even when empty.
+		void TunnelXivStream(XivStream& target, const MessageMangler& messageMangler);
+	};
+}
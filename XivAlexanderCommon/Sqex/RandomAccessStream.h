@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Sqex {
+	// Only depends on the standard library, so that code built on top of it can be used outside Windows.
+	class RandomAccessStream : public std::enable_shared_from_this<RandomAccessStream> {
+	public:
+		RandomAccessStream();
+		RandomAccessStream(RandomAccessStream&&) = delete;
+		RandomAccessStream(const RandomAccessStream&) = delete;
+		RandomAccessStream& operator=(RandomAccessStream&&) = delete;
+		RandomAccessStream& operator=(const RandomAccessStream&) = delete;
+		virtual ~RandomAccessStream();
+
+		[[nodiscard]] virtual uint64_t StreamSize() const = 0;
+		virtual uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const = 0;
+
+		void ReadStream(uint64_t offset, void* buf, uint64_t length) const;
+
+		template<typename T>
+		T ReadStream(uint64_t offset) const {
+			T buf;
+			ReadStream(offset, &buf, sizeof(T));
+			return buf;
+		}
+
+		template<typename T>
+		void ReadStream(uint64_t offset, std::span<T> buf) const {
+			ReadStream(offset, buf.data(), buf.size_bytes());
+		}
+
+		template<typename T>
+		std::vector<T> ReadStreamIntoVector(uint64_t offset, size_t count = SIZE_MAX, size_t maxCount = SIZE_MAX) const {
+			if (count > maxCount)
+				throw std::runtime_error("trying to read too many");
+			if (count == SIZE_MAX)
+				count = static_cast<size_t>(StreamSize() / sizeof(T));
+			std::vector<T> result(count);
+			ReadStream(offset, std::span(result));
+			return result;
+		}
+
+		template<typename T>
+		std::function<std::span<T>(size_t len, bool throwOnIncompleteRead)> AsLinearReader() const {
+			return [this, buf = std::vector<T>(), ptr = uint64_t(), to = StreamSize()](size_t len, bool throwOnIncompleteRead) mutable {
+				if (ptr == to)
+					return std::span<T>();
+				buf.resize(static_cast<size_t>(std::min<uint64_t>(len, to - ptr)));
+				const auto read = ReadStreamPartial(ptr, buf.data(), buf.size());
+				if (read < buf.size() && throwOnIncompleteRead)
+					throw std::runtime_error("incomplete read");
+				ptr += buf.size();
+				return std::span(buf);
+			};
+		}
+
+		virtual std::string DescribeState() const { return {}; }
+
+		// Returns the whole content if the stream is backed by addressable memory; empty span otherwise.
+		[[nodiscard]] virtual std::span<const uint8_t> GetDirectView() const { return {}; }
+
+		// Returns the offset where data logically related to the one at the given offset ends; read-ahead should not go past it.
+		[[nodiscard]] virtual uint64_t ReadAheadBoundary(uint64_t offset) const { return StreamSize(); }
+
+		virtual void EnableBuffering(bool bEnable) {}
+
+		virtual void Flush() const {}
+	};
+}
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/Sound/MusicImporter.h"
 
+#include "XivAlexanderCommon/Sqex/Sound/ParallelVorbisEncoder.h"
+#include "XivAlexanderCommon/Sqex/Sound/PcmDecoder.h"
 #include "XivAlexanderCommon/Sqex/Sound/Writer.h"
 #include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
 
@@ -208,6 +210,13 @@ static Utils::Win32::Thread StderrRelayer(Utils::Win32::Handle hStderrRead, std:
 
 struct Sqex::Sound::MusicImporter::Implementation {
 	class FloatPcmSource {
+	public:
+		virtual ~FloatPcmSource() = default;
+
+		virtual std::span<const float> operator()(size_t len, bool throwOnIncompleteRead) = 0;
+	};
+
+	class FfmpegFloatPcmSource : public FloatPcmSource {
 		Utils::Win32::Process m_hReaderProcess;
 		Utils::Win32::Handle m_hStdoutReader;
 		Utils::Win32::Thread m_hStdinWriterThread;
@@ -217,7 +226,7 @@ struct Sqex::Sound::MusicImporter::Implementation {
 		size_t m_unusedBytes = 0;
 
 	public:
-		FloatPcmSource(
+		FfmpegFloatPcmSource(
 			const MusicImportSourceItem& sourceItem,
 			std::vector<std::filesystem::path> resolvedPaths,
 			std::function<std::span<uint8_t>(size_t len, bool throwOnIncompleteRead)> linearReader, const char* linearReaderType,
@@ -226,9 +235,31 @@ struct Sqex::Sound::MusicImporter::Implementation {
 			int forceSamplingRate = 0, std::string audioFilters = {}
 		);
 
-		~FloatPcmSource();
+		~FfmpegFloatPcmSource() override;
+
+		std::span<const float> operator()(size_t len, bool throwOnIncompleteRead) override;
+	};
+
+	class DecodedFloatPcmSource : public FloatPcmSource {
+		const std::unique_ptr<PcmDecoder> m_decoder;
+		std::vector<float> m_buffer;
+
+		// Opens the same source through ffmpeg, for when the decoder fails midway.
+		const std::function<std::unique_ptr<FloatPcmSource>()> m_fallbackOpener;
+		const std::function<void(const std::string&)> m_warningCallback;
+		std::unique_ptr<FloatPcmSource> m_fallback;
+		uint64_t m_decodedSampleCount = 0;
+
+		void SwitchToFallback(const std::exception& e);
 
-		std::span<float> operator()(size_t len, bool throwOnIncompleteRead);
+	public:
+		DecodedFloatPcmSource(std::unique_ptr<PcmDecoder> decoder, std::function<std::unique_ptr<FloatPcmSource>()> fallbackOpener, std::function<void(const std::string&)> warningCallback)
+			: m_decoder(std::move(decoder))
+			, m_fallbackOpener(std::move(fallbackOpener))
+			, m_warningCallback(std::move(warningCallback)) {
+		}
+
+		std::span<const float> operator()(size_t len, bool throwOnIncompleteRead) override;
 	};
 
 	static nlohmann::json RunProbe(const std::filesystem::path& path, const std::filesystem::path& ffprobePath, std::function<void(const std::string&)> stderrCallback);
@@ -263,6 +294,8 @@ struct Sqex::Sound::MusicImporter::Implementation {
 	constexpr static auto SamplingRate_UseHighestAvailable = 0;
 	int SamplingRate = SamplingRate_UseHighestAvailable;
 
+	bool UseInProcessDecoder = true;
+
 	Implementation(MusicImporter* this_, std::map<std::string, MusicImportSourceItem> sourceItems, MusicImportTarget target, std::filesystem::path ffmpeg, std::filesystem::path ffprobe, Utils::Win32::Event cancelEvent)
 		: this_(*this_)
 		, SourceItems(std::move(sourceItems))
@@ -282,6 +315,13 @@ struct Sqex::Sound::MusicImporter::Implementation {
 		}
 	}
 
+	// Returns nullptr if the file has to go through ffmpeg. Empty path refers to originalData.
+	std::unique_ptr<PcmDecoder> TryOpenDecoder(const std::filesystem::path& path, std::shared_ptr<const RandomAccessStream> originalData);
+
+	std::unique_ptr<FloatPcmSource> OpenSource(const std::string& name, std::shared_ptr<const RandomAccessStream> originalData, const char* originalFormat, uint32_t targetRate, const std::string& audioFilters);
+
+	std::unique_ptr<FloatPcmSource> OpenFfmpegSource(const std::string& name, std::shared_ptr<const RandomAccessStream> originalData, const char* originalFormat, uint32_t targetRate, const std::string& audioFilters);
+
 	void AppendReader(std::shared_ptr<Sqex::Sound::ScdReader> reader);
 
 	bool ResolveSources(std::string dirName, const std::filesystem::path& dir);
@@ -289,7 +329,7 @@ struct Sqex::Sound::MusicImporter::Implementation {
 	void Merge(const std::function<void(const std::filesystem::path& path, std::vector<uint8_t>)>& cb);
 };
 
-Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::FloatPcmSource(
+Sqex::Sound::MusicImporter::Implementation::FfmpegFloatPcmSource::FfmpegFloatPcmSource(
 	const MusicImportSourceItem& sourceItem,
 	std::vector<std::filesystem::path> resolvedPaths,
 	std::function<std::span<uint8_t>(size_t len, bool throwOnIncompleteRead)> linearReader, const char* linearReaderType,
@@ -367,7 +407,7 @@ Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::FloatPcmSource(
 	});
 }
 
-Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::~FloatPcmSource() {
+Sqex::Sound::MusicImporter::Implementation::FfmpegFloatPcmSource::~FfmpegFloatPcmSource() {
 	if (m_hReaderProcess)
 		m_hReaderProcess.Terminate(0);
 	if (m_hStdinWriterThread)
@@ -376,7 +416,7 @@ Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::~FloatPcmSource() {
 		m_hStderrReaderThread.Wait();
 }
 
-std::span<float> Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::operator()(size_t len, bool throwOnIncompleteRead) {
+std::span<const float> Sqex::Sound::MusicImporter::Implementation::FfmpegFloatPcmSource::operator()(size_t len, bool throwOnIncompleteRead) {
 	std::move(m_buffer.end() - m_unusedBytes, m_buffer.end(), m_buffer.begin());
 	m_buffer.resize(std::max(m_unusedBytes, len * sizeof(float)));
 	try {
@@ -400,6 +440,54 @@ std::span<float> Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::ope
 	return span_cast<float>(m_buffer, 0, availableSampleCount);
 }
 
+void Sqex::Sound::MusicImporter::Implementation::DecodedFloatPcmSource::SwitchToFallback(const std::exception& e) {
+	m_warningCallback(std::format("Switching to ffmpeg after {} samples: {}", m_decodedSampleCount, e.what()));
+	m_fallback = m_fallbackOpener();
+
+	// Skip what has been decoded already, so that ffmpeg continues from where the decoder has stopped.
+	for (auto remaining = m_decodedSampleCount; remaining;) {
+		const auto skipped = (*m_fallback)(static_cast<size_t>(std::min<uint64_t>(remaining, 65536)), false);
+		if (skipped.empty())
+			throw std::runtime_error(std::format("ffmpeg returned fewer samples than the {} decoded already", m_decodedSampleCount));
+		remaining -= skipped.size();
+	}
+}
+
+std::span<const float> Sqex::Sound::MusicImporter::Implementation::DecodedFloatPcmSource::operator()(size_t len, bool throwOnIncompleteRead) {
+	if (m_fallback)
+		return (*m_fallback)(len, throwOnIncompleteRead);
+
+	const auto channels = m_decoder->Channels();
+	if (!throwOnIncompleteRead) {
+		try {
+			const auto read = m_decoder->Read(std::max<size_t>(1, len / channels));
+			m_decodedSampleCount += read.size();
+			return read;
+		} catch (const std::exception& e) {
+			SwitchToFallback(e);
+			return (*m_fallback)(len, false);
+		}
+	}
+
+	m_buffer.clear();
+	while (m_buffer.size() < len) {
+		std::span<const float> read;
+		try {
+			read = m_decoder->Read((len - m_buffer.size() + channels - 1) / channels);
+		} catch (const std::exception& e) {
+			SwitchToFallback(e);
+			const auto rest = (*m_fallback)(len - m_buffer.size(), true);
+			m_buffer.insert(m_buffer.end(), rest.begin(), rest.end());
+			break;
+		}
+		if (read.empty())
+			throw std::runtime_error("EOF");
+		m_decodedSampleCount += read.size();
+		m_buffer.insert(m_buffer.end(), read.begin(), read.end());
+	}
+	return std::span(m_buffer).subspan(0, len);
+}
+
 nlohmann::json Sqex::Sound::MusicImporter::Implementation::RunProbe(const std::filesystem::path& path, const std::filesystem::path& ffprobePath, std::function<void(const std::string&)> stderrCallback) {
 	auto [hStdoutRead, hStdoutWrite] = Utils::Win32::Handle::FromCreatePipe();
 	auto [hStderrRead, hStderrWrite] = Utils::Win32::Handle::FromCreatePipe();
@@ -492,6 +580,52 @@ nlohmann::json Sqex::Sound::MusicImporter::Implementation::RunProbe(const char*
 	return nlohmann::json::parse(str);
 }
 
+std::unique_ptr<Sqex::Sound::PcmDecoder> Sqex::Sound::MusicImporter::Implementation::TryOpenDecoder(const std::filesystem::path& path, std::shared_ptr<const RandomAccessStream> originalData) {
+	if (!UseInProcessDecoder)
+		return nullptr;
+
+	try {
+		std::shared_ptr<const RandomAccessStream> stream;
+		if (path.empty())
+			stream = std::move(originalData);
+		else
+			stream = std::make_shared<MemoryMappedRandomAccessStream>(path);
+		return PcmDecoder::TryCreate(std::move(stream));
+	} catch (const std::exception& e) {
+		this_.OnWarningLog(std::format("Using ffmpeg for {}: {}", path.empty() ? std::filesystem::path(OriginalSource) : path, e.what()));
+		return nullptr;
+	}
+}
+
+std::unique_ptr<Sqex::Sound::MusicImporter::Implementation::FloatPcmSource> Sqex::Sound::MusicImporter::Implementation::OpenSource(const std::string& name, std::shared_ptr<const RandomAccessStream> originalData, const char* originalFormat, uint32_t targetRate, const std::string& audioFilters) {
+	const auto& sourceItem = SourceItems.at(name);
+	const auto& sourcePaths = SourcePaths.at(name);
+
+	// Filters need ffmpeg.
+	if (sourceItem.filterComplex.empty() && audioFilters.empty() && sourceItem.inputFiles.size() == 1) {
+		if (auto decoder = TryOpenDecoder(sourceItem.inputFiles[0].empty() ? std::filesystem::path() : sourcePaths[0], originalData)) {
+			try {
+				return std::make_unique<DecodedFloatPcmSource>(
+					PcmDecoder::Resample(std::move(decoder), targetRate),
+					[this, name, originalData, originalFormat, targetRate, audioFilters]() { return OpenFfmpegSource(name, originalData, originalFormat, targetRate, audioFilters); },
+					[this, name](const std::string& msg) { this_.OnWarningLog(std::format("{}: {}", name, msg)); });
+			} catch (const std::exception& e) {
+				this_.OnWarningLog(std::format("Using ffmpeg for {}: {}", name, e.what()));
+			}
+		}
+	}
+
+	return OpenFfmpegSource(name, std::move(originalData), originalFormat, targetRate, audioFilters);
+}
+
+std::unique_ptr<Sqex::Sound::MusicImporter::Implementation::FloatPcmSource> Sqex::Sound::MusicImporter::Implementation::OpenFfmpegSource(const std::string& name, std::shared_ptr<const RandomAccessStream> originalData, const char* originalFormat, uint32_t targetRate, const std::string& audioFilters) {
+	// The reader gets used from the thread feeding ffmpeg, which may outlive the caller; keep the stream alive along with it.
+	auto reader = [originalData, read = originalData->AsLinearReader<uint8_t>()](size_t len, bool throwOnIncompleteRead) mutable {
+		return read(len, throwOnIncompleteRead);
+	};
+	return std::make_unique<FfmpegFloatPcmSource>(SourceItems.at(name), SourcePaths.at(name), std::move(reader), originalFormat, FFmpeg, [this](const std::string& msg) { this_.OnWarningLog(msg); }, targetRate, audioFilters);
+}
+
 void Sqex::Sound::MusicImporter::Implementation::AppendReader(std::shared_ptr<Sqex::Sound::ScdReader> reader) {
 	TargetOriginals.emplace_back(std::move(reader));
 }
@@ -522,11 +656,18 @@ bool Sqex::Sound::MusicImporter::Implementation::ResolveSources(std::string dirN
 			auto found = false;
 			if (occurrences.size() == 1) {
 				try {
-					const auto probe(RunProbe(*occurrences.begin(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
-					SourceInfo[sourceName] = {
-						.Rate = static_cast<uint32_t>(std::strtoul(probe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
-						.Channels = probe.at("channels").get<uint32_t>(),
-					};
+					if (const auto decoder = TryOpenDecoder(*occurrences.begin(), {})) {
+						SourceInfo[sourceName] = {
+							.Rate = decoder->Rate(),
+							.Channels = decoder->Channels(),
+						};
+					} else {
+						const auto probe(RunProbe(*occurrences.begin(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
+						SourceInfo[sourceName] = {
+							.Rate = static_cast<uint32_t>(std::strtoul(probe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
+							.Channels = probe.at("channels").get<uint32_t>(),
+						};
+					}
 					SourcePaths[sourceName][i] = *occurrences.begin();
 					found = true;
 				} catch (const std::exception& e) {
@@ -556,40 +697,55 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 		auto& originalInfo = SourceInfo[OriginalSource];
 		if (!TargetOriginals.front())
 			throw std::runtime_error(std::format("file {} not found", Target.path[0].wstring()));
-		const auto originalEntry = TargetOriginals.front()->GetSoundEntry(0);
+		// Check the format from the header alone, before reading the whole entry.
+		const auto originalEntryView = TargetOriginals.front()->GetSoundEntryView(0);
+		if (const auto format = originalEntryView.Header().Format.Value();
+			format != Sqex::Sound::SoundEntryHeader::EntryFormat_WaveFormatAdpcm && format != Sqex::Sound::SoundEntryHeader::EntryFormat_Ogg)
+			throw std::runtime_error(std::format("unsupported sound entry format {}", static_cast<uint32_t>(format)));
+		const auto originalEntry = originalEntryView.Read();
 		const char* originalEntryFormat = nullptr;
 
-		std::vector<uint8_t> originalData;
+		std::vector<uint8_t> originalBytes;
 		switch (originalEntry.Header->Format) {
 			case Sqex::Sound::SoundEntryHeader::EntryFormat_WaveFormatAdpcm:
-				originalData = originalEntry.GetMsAdpcmWavFile();
+				originalBytes = originalEntry.GetMsAdpcmWavFile();
 				originalEntryFormat = "wav";
 				break;
 
 			case Sqex::Sound::SoundEntryHeader::EntryFormat_Ogg:
-				originalData = originalEntry.GetOggFile();
+				originalBytes = originalEntry.GetOggFile();
 				originalEntryFormat = "ogg";
 				break;
 		}
-		const auto originalDataStream = Sqex::MemoryRandomAccessStream(originalData);
-
+		const auto originalData = std::make_shared<const MemoryRandomAccessStream>(std::move(originalBytes));
 		lastStepDescription = "ProbeOriginal";
 		uint32_t loopStartBlockIndex = 0;
 		uint32_t loopEndBlockIndex = 0;
 		{
-			const auto originalProbe(RunProbe(originalEntryFormat, originalDataStream.AsLinearReader<uint8_t>(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
-			originalInfo = {
-				.Rate = static_cast<uint32_t>(std::strtoul(originalProbe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
-				.Channels = originalProbe.at("channels").get<uint32_t>(),
-			};
-			if (const auto it = originalProbe.find("tags"); it != originalProbe.end()) {
-				for (const auto& item : it->get<nlohmann::json::object_t>()) {
-					if (_strnicmp(item.first.c_str(), "LoopStart", 9) == 0)
-						loopStartBlockIndex = std::strtoul(item.second.get<std::string>().c_str(), nullptr, 10);
-					else if (_strnicmp(item.first.c_str(), "LoopEnd", 7) == 0)
-						loopEndBlockIndex = std::strtoul(item.second.get<std::string>().c_str(), nullptr, 10);
+			std::map<std::string, std::string> tags;
+			if (const auto decoder = TryOpenDecoder({}, originalData)) {
+				originalInfo = {
+					.Rate = decoder->Rate(),
+					.Channels = decoder->Channels(),
+				};
+				tags = decoder->Tags();
+			} else {
+				const auto originalProbe(RunProbe(originalEntryFormat, originalData->AsLinearReader<uint8_t>(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
+				originalInfo = {
+					.Rate = static_cast<uint32_t>(std::strtoul(originalProbe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
+					.Channels = originalProbe.at("channels").get<uint32_t>(),
+				};
+				if (const auto it = originalProbe.find("tags"); it != originalProbe.end()) {
+					for (const auto& item : it->get<nlohmann::json::object_t>())
+						tags.emplace(item.first, item.second.get<std::string>());
 				}
 			}
+			for (const auto& [key, value] : tags) {
+				if (_strnicmp(key.c_str(), "LoopStart", 9) == 0)
+					loopStartBlockIndex = std::strtoul(value.c_str(), nullptr, 10);
+				else if (_strnicmp(key.c_str(), "LoopEnd", 7) == 0)
+					loopEndBlockIndex = std::strtoul(value.c_str(), nullptr, 10);
+			}
 		}
 
 		lastStepDescription = "ResolveSampleRate";
@@ -645,61 +801,12 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 		uint32_t loopEndOffset = 0;
 
 		std::vector<uint32_t> oggDataSeekTable;
-		vorbis_info vi{};
-		vorbis_dsp_state vd{};
-		vorbis_block vb{};
-		ogg_stream_state os{};
-		ogg_page og{};
-		ogg_packet op{};
-		Utils::CallOnDestruction::Multiple oggCleanup;
-		uint64_t oggGranulePosOffset = 0;
+		std::optional<ParallelVorbisEncoder> encoder;
 
 		std::vector<std::vector<float>> wavBuffers;
 		std::vector<float*> wavBufferPtrs;
 		if (originalEntry.Header->Format == Sqex::Sound::SoundEntryHeader::EntryFormat_Ogg) {
-			vorbis_info_init(&vi);
-			if (const auto res = vorbis_encode_init_vbr(&vi, originalInfo.Channels, targetRate, 1))
-				throw std::runtime_error(std::format("vorbis_encode_init_vbr: {}", res));
-			oggCleanup += Utils::CallOnDestruction([&vi] { vorbis_info_clear(&vi); });
-
-			if (const auto res = vorbis_analysis_init(&vd, &vi))
-				throw std::runtime_error(std::format("vorbis_analysis_init: {}", res));
-			oggCleanup += Utils::CallOnDestruction([&vd] { vorbis_dsp_clear(&vd); });
-
-			if (const auto res = vorbis_block_init(&vd, &vb))
-				throw std::runtime_error(std::format("vorbis_block_init: {}", res));
-			oggCleanup += Utils::CallOnDestruction([&vb] { vorbis_block_clear(&vb); });
-
-			if (const auto res = ogg_stream_init(&os, 0))
-				throw std::runtime_error(std::format("ogg_stream_init: {}", res));
-			oggCleanup += Utils::CallOnDestruction([&os] { ogg_stream_clear(&os); });
-
-			vorbis_comment vc{};
-			vorbis_comment_init(&vc);
-			const auto vcCleanup = Utils::CallOnDestruction([&vc] { vorbis_comment_clear(&vc); });
-			if (loopStartBlockIndex || loopEndBlockIndex) {
-				vorbis_comment_add_tag(&vc, "LoopStart", std::format("{}", loopStartBlockIndex).c_str());
-				vorbis_comment_add_tag(&vc, "LoopEnd", std::format("{}", loopEndBlockIndex).c_str());
-			}
-
-			ogg_packet header{};
-			ogg_packet headerComments{};
-			ogg_packet headerCode{};
-			vorbis_analysis_headerout(&vd, &vc, &header, &headerComments, &headerCode);
-			ogg_stream_packetin(&os, &header);
-			ogg_stream_packetin(&os, &headerComments);
-			ogg_stream_packetin(&os, &headerCode);
-
-			headerBuffer.reserve(8192);
-			while (true) {
-				if (const auto res = ogg_stream_flush_fill(&os, &og, 0); res < 0)
-					throw std::runtime_error(std::format("ogg_stream_flush_fill: {}", res));
-				else if (res == 0)
-					break;
-
-				headerBuffer.insert(headerBuffer.end(), og.header, og.header + og.header_len);
-				headerBuffer.insert(headerBuffer.end(), og.body, og.body + og.body_len);
-			}
+			encoder.emplace(originalInfo.Channels, targetRate, 1.f);
 		} else {
 			wavBuffers.resize(originalInfo.Channels);
 			wavBufferPtrs.resize(originalInfo.Channels);
@@ -722,7 +829,7 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 				const auto ffmpegFilter = segment.sourceFilters.contains(name) ? segment.sourceFilters.at(name) : std::string();
 				uint32_t minBlockIndex = 0;
 				double threshold = 0.1;
-				info.Reader = std::make_unique<FloatPcmSource>(SourceItems.at(name), SourcePaths.at(name), originalDataStream.AsLinearReader<uint8_t>(), originalEntryFormat, FFmpeg, [this](const std::string& msg) { this_.OnWarningLog(msg); }, targetRate, ffmpegFilter);
+				info.Reader = OpenSource(name, originalData, originalEntryFormat, targetRate, ffmpegFilter);
 				if (segment.sourceOffsets.contains(name))
 					minBlockIndex = static_cast<uint32_t>(targetRate * segment.sourceOffsets.at(name));
 				else if (name == OriginalSource)
@@ -814,8 +921,8 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 					if (CancelEvent.Wait(0) == WAIT_OBJECT_0)
 						return;
 
-					if (originalEntry.Header->Format == Sqex::Sound::SoundEntryHeader::EntryFormat_Ogg)
-						buf = vorbis_analysis_buffer(&vd, BufferedBlockCount);
+					if (encoder)
+						buf = encoder->Buffer(BufferedBlockCount);
 					else {
 						wavBufferPtrs.clear();
 						for (auto& wavBuffer : wavBuffers) {
@@ -824,8 +931,6 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 						}
 						buf = &wavBufferPtrs[0];
 					}
-					if (!buf)
-						throw std::runtime_error("vorbis_analysis_buffer: fail");
 					bufptr = 0;
 				}
 				for (size_t i = 0; i < originalInfo.Channels; ++i) {
@@ -866,115 +971,11 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 				stopSegment |= currentBlockIndex == segmentEndBlockIndex;
 				stopSegment |= loopEndBlockIndex && currentBlockIndex == loopEndBlockIndex;
 
-				if (bufptr == BufferedBlockCount || stopSegment || currentBlockIndex == loopStartBlockIndex) {
+				if (bufptr == BufferedBlockCount || stopSegment) {
 
-					if (originalEntry.Header->Format == Sqex::Sound::SoundEntryHeader::EntryFormat_Ogg) {
-						if (const auto res = vorbis_analysis_wrote(&vd, static_cast<int>(bufptr)); res < 0)
-							throw std::runtime_error(std::format("vorbis_analysis_wrote: {}", res));
+					if (encoder) {
+						encoder->Wrote(bufptr);
 						buf = nullptr;
-
-						if (stopSegment && segmentIndex == Target.segments.size() - 1) {
-							if (const auto res = vorbis_analysis_wrote(&vd, 0); res < 0)
-								throw std::runtime_error(std::format("vorbis_analysis_wrote: {}", res));
-						}
-
-						while (!ogg_page_eos(&og)) {
-							if (const auto res = vorbis_analysis_blockout(&vd, &vb); res < 0)
-								throw std::runtime_error(std::format("vorbis_analysis_blockout: {}", res));
-							else if (res == 0)
-								break;
-
-							if (const auto res = vorbis_analysis(&vb, nullptr); res < 0)
-								throw std::runtime_error(std::format("vorbis_analysis: {}", res));
-							if (const auto res = vorbis_bitrate_addblock(&vb); res < 0)
-								throw std::runtime_error(std::format("vorbis_bitrate_addblock: {}", res));
-
-							while (!ogg_page_eos(&og)) {
-								if (const auto res = vorbis_bitrate_flushpacket(&vd, &op); res < 0)
-									throw std::runtime_error(std::format("vorbis_bitrate_flushpacket: {}", res));
-								else if (res == 0)
-									break;
-
-								if (const auto res = ogg_stream_packetin(&os, &op); res < 0)
-									throw std::runtime_error(std::format("ogg_stream_packetin: {}", res));
-
-								while (!ogg_page_eos(&og)) {
-									if (const auto res = ogg_stream_pageout_fill(&os, &og, 65307);
-										res < 0)
-										throw std::runtime_error(std::format("ogg_stream_pageout_fill(65307): {}", res));
-									else if (res == 0)
-										break;
-
-									dataBuffers.emplace_back();
-									dataBuffers.back().reserve(static_cast<size_t>(og.header_len) + og.body_len);
-									dataBuffers.back().insert(dataBuffers.back().end(), og.header, og.header + og.header_len);
-									dataBuffers.back().insert(dataBuffers.back().end(), og.body, og.body + og.body_len);
-									oggDataSeekTable.push_back(dataBufferTotalSize);
-									dataBufferTotalSize += og.header_len + og.body_len;
-								}
-							}
-						}
-
-						if (currentBlockIndex == loopStartBlockIndex) {
-							while (!ogg_page_eos(&og)) {
-								if (const auto res = ogg_stream_flush_fill(&os, &og, 0); res < 0)
-									throw std::runtime_error(std::format("ogg_stream_flush_fill(0): {}", res));
-								else if (res == 0)
-									break;
-
-								dataBuffers.emplace_back();
-								dataBuffers.back().reserve(static_cast<size_t>(og.header_len) + og.body_len);
-								dataBuffers.back().insert(dataBuffers.back().end(), og.header, og.header + og.header_len);
-								dataBuffers.back().insert(dataBuffers.back().end(), og.body, og.body + og.body_len);
-								oggDataSeekTable.push_back(dataBufferTotalSize);
-								dataBufferTotalSize += og.header_len + og.body_len;
-							}
-
-							loopStartOffset = oggDataSeekTable.empty() ? 0 : oggDataSeekTable.back();
-
-							if (const auto offset = static_cast<uint32_t>(loopStartBlockIndex - ogg_page_granulepos(&og))) {
-								// ogg packet sample block index and loop start don't align.
-								// pull loop start forward so that it matches ogg packet sample block index.
-
-								loopStartBlockIndex -= offset;
-								loopEndBlockIndex -= offset;
-
-								// adjust loopstart/loopend in ogg metadata.
-								// unnecessary, but for the sake of completeness.
-
-								vorbis_comment vc{};
-								vorbis_comment_init(&vc);
-								const auto vcCleanup = Utils::CallOnDestruction([&vc] { vorbis_comment_clear(&vc); });
-								if (loopStartBlockIndex || loopEndBlockIndex) {
-									vorbis_comment_add_tag(&vc, "LoopStart", std::format("{}", loopStartBlockIndex).c_str());
-									vorbis_comment_add_tag(&vc, "LoopEnd", std::format("{}", loopEndBlockIndex).c_str());
-								}
-
-								ogg_stream_state os{};
-								if (const auto res = ogg_stream_init(&os, 0))
-									throw std::runtime_error(std::format("ogg_stream_init(reloop): {}", res));
-								auto osCleanup = Utils::CallOnDestruction([&os] { ogg_stream_clear(&os); });
-
-								ogg_packet header{};
-								ogg_packet headerComments{};
-								ogg_packet headerCode{};
-								vorbis_analysis_headerout(&vd, &vc, &header, &headerComments, &headerCode);
-								ogg_stream_packetin(&os, &header);
-								ogg_stream_packetin(&os, &headerComments);
-								ogg_stream_packetin(&os, &headerCode);
-
-								headerBuffer.clear();
-								while (true) {
-									if (const auto res = ogg_stream_flush_fill(&os, &og, 0); res < 0)
-										throw std::runtime_error(std::format("ogg_stream_flush_fill(reloop): {}", res));
-									else if (res == 0)
-										break;
-
-									headerBuffer.insert(headerBuffer.end(), og.header, og.header + og.header_len);
-									headerBuffer.insert(headerBuffer.end(), og.body, og.body + og.body_len);
-								}
-							}
-						}
 					} else {
 						dataBuffers.emplace_back();
 						dataBuffers.back().resize(sizeof int16_t * originalInfo.Channels * bufptr);
@@ -990,6 +991,101 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 			}
 		}
 
+		if (encoder) {
+			lastStepDescription = "EncodeFinish";
+			encoder->Wrote(0);
+			const auto& packets = encoder->Packets();
+
+			lastStepDescription = "EncodeLoopStart";
+			size_t loopStartPacketCount = 0;
+			if (loopStartBlockIndex && !packets.empty()) {
+				while (loopStartPacketCount < packets.size() && packets[loopStartPacketCount].GranulePos <= loopStartBlockIndex)
+					loopStartPacketCount++;
+
+				// If even the first packet ends past loop start, there is nothing to snap it to.
+				if (const auto offset = loopStartPacketCount ? static_cast<uint32_t>(loopStartBlockIndex - packets[loopStartPacketCount - 1].GranulePos) : 0) {
+					// ogg packet sample block index and loop start don't align.
+					// pull loop start forward so that it matches ogg packet sample block index.
+
+					loopStartBlockIndex -= offset;
+					loopEndBlockIndex -= offset;
+				}
+			}
+
+			lastStepDescription = "EncodeHeader";
+			vorbis_comment vc{};
+			vorbis_comment_init(&vc);
+			const auto vcCleanup = Utils::CallOnDestruction([&vc] { vorbis_comment_clear(&vc); });
+			if (loopStartBlockIndex || loopEndBlockIndex) {
+				vorbis_comment_add_tag(&vc, "LoopStart", std::format("{}", loopStartBlockIndex).c_str());
+				vorbis_comment_add_tag(&vc, "LoopEnd", std::format("{}", loopEndBlockIndex).c_str());
+			}
+
+			ogg_stream_state os{};
+			if (const auto res = ogg_stream_init(&os, 0))
+				throw std::runtime_error(std::format("ogg_stream_init: {}", res));
+			const auto osCleanup = Utils::CallOnDestruction([&os] { ogg_stream_clear(&os); });
+
+			ogg_packet header{};
+			ogg_packet headerComments{};
+			ogg_packet headerCode{};
+			encoder->HeaderOut(vc, header, headerComments, headerCode);
+			ogg_stream_packetin(&os, &header);
+			ogg_stream_packetin(&os, &headerComments);
+			ogg_stream_packetin(&os, &headerCode);
+
+			ogg_page og{};
+			headerBuffer.reserve(8192);
+			while (true) {
+				if (const auto res = ogg_stream_flush_fill(&os, &og, 0); res < 0)
+					throw std::runtime_error(std::format("ogg_stream_flush_fill: {}", res));
+				else if (res == 0)
+					break;
+
+				headerBuffer.insert(headerBuffer.end(), og.header, og.header + og.header_len);
+				headerBuffer.insert(headerBuffer.end(), og.body, og.body + og.body_len);
+			}
+
+			lastStepDescription = "EncodeData";
+			const auto writePages = [&](bool flush) {
+				while (true) {
+					if (const auto res = flush ? ogg_stream_flush_fill(&os, &og, 0) : ogg_stream_pageout_fill(&os, &og, 65307); res < 0)
+						throw std::runtime_error(std::format("ogg_stream_{}: {}", flush ? "flush_fill(0)" : "pageout_fill(65307)", res));
+					else if (res == 0)
+						break;
+
+					dataBuffers.emplace_back();
+					dataBuffers.back().reserve(static_cast<size_t>(og.header_len) + og.body_len);
+					dataBuffers.back().insert(dataBuffers.back().end(), og.header, og.header + og.header_len);
+					dataBuffers.back().insert(dataBuffers.back().end(), og.body, og.body + og.body_len);
+					oggDataSeekTable.push_back(dataBufferTotalSize);
+					dataBufferTotalSize += og.header_len + og.body_len;
+				}
+			};
+
+			for (size_t i = 0; i <= packets.size(); ++i) {
+				if (loopStartPacketCount && i == loopStartPacketCount) {
+					// loop start has to be where a page ends.
+					writePages(true);
+					loopStartOffset = oggDataSeekTable.empty() ? 0 : oggDataSeekTable.back();
+				}
+				if (i == packets.size())
+					break;
+
+				ogg_packet op{
+					.packet = const_cast<uint8_t*>(packets[i].Data.data()),
+					.bytes = static_cast<long>(packets[i].Data.size()),
+					.e_o_s = packets[i].EndOfStream ? 1 : 0,
+					.granulepos = packets[i].GranulePos,
+					.packetno = static_cast<ogg_int64_t>(3 + i),
+				};
+				if (const auto res = ogg_stream_packetin(&os, &op); res < 0)
+					throw std::runtime_error(std::format("ogg_stream_packetin: {}", res));
+				writePages(false);
+			}
+			writePages(true);
+		}
+
 		if (loopEndBlockIndex && !loopEndOffset)
 			loopEndOffset = dataBufferTotalSize;
 
@@ -1065,6 +1161,11 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 			info.Reader = nullptr;
 
 		lastStepDescription = std::format("ToScd");
+
+		// Serialize once, and have every target share it.
+		std::vector<uint8_t> encodedEntryBytes;
+		soundEntry.ExportTo(encodedEntryBytes);
+		const auto encodedEntry = Sqex::Sound::ScdReader::SoundEntryView(std::make_shared<MemoryRandomAccessStream>(std::move(encodedEntryBytes)));
 		for (size_t pathIndex = 0; pathIndex < Target.path.size(); pathIndex++) {
 			const auto& path = Target.path.at(pathIndex);
 			const auto& scdReader = TargetOriginals.at(pathIndex);
@@ -1072,7 +1173,7 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 			writer.SetTable1(scdReader->ReadTable1Entries());
 			writer.SetTable4(scdReader->ReadTable4Entries());
 			writer.SetTable2(scdReader->ReadTable2Entries());
-			writer.SetSoundEntry(0, soundEntry);
+			writer.SetSoundEntry(0, encodedEntry);
 			cb(path, writer.Export());
 		}
 	} catch (const std::runtime_error& e) {
@@ -1090,6 +1191,10 @@ void Sqex::Sound::MusicImporter::SetSamplingRate(int samplingRate) {
 	m_pImpl->SamplingRate = samplingRate;
 }
 
+void Sqex::Sound::MusicImporter::SetUseInProcessDecoder(bool enable) {
+	m_pImpl->UseInProcessDecoder = enable;
+}
+
 void Sqex::Sound::MusicImporter::AppendReader(std::shared_ptr<Sqex::Sound::ScdReader> reader) {
 	return m_pImpl->AppendReader(std::move(reader));
 }
@@ -94,6 +94,9 @@ namespace Sqex::Sound {
 
 		void SetSamplingRate(int samplingRate);
 
+		// Decode WAV, FLAC, and Ogg Vorbis files without going through ffmpeg, unless filters are specified. Enabled by default.
+		void SetUseInProcessDecoder(bool enable);
+
 		void AppendReader(std::shared_ptr<Sqex::Sound::ScdReader> reader);
 
 		bool ResolveSources(std::string dirName, const std::filesystem::path& dir);
@@ -0,0 +1,331 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Sound/ParallelVorbisEncoder.h"
+
+#include "XivAlexanderCommon/Utils/CallOnDestruction.h"
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
+namespace {
+	// Encoders decide on different block sizes when given fewer samples at a time, so every encoder gets fed
+	// pieces of this many sample blocks, counted from where it starts.
+	constexpr int64_t FeedBlockCount = 8192;
+
+	// Bounds memory in use, as the samples of every chunk in a batch are kept until the whole batch gets encoded.
+	constexpr size_t MaxChunksPerBatch = 8;
+
+	// Chunk length, how far before its start a chunk starts encoding, and how far past its end the previous chunk
+	// keeps encoding looking for a block to join at.
+	constexpr int64_t ChunkMilliseconds = 20000;
+	constexpr int64_t PreRollMilliseconds = 500;
+	constexpr int64_t OverlapMilliseconds = 250;
+
+	class VorbisAnalysis {
+		vorbis_info m_vi{};
+		vorbis_dsp_state m_vd{};
+		vorbis_block m_vb{};
+		Utils::CallOnDestruction::Multiple m_cleanup;
+
+	public:
+		VorbisAnalysis(uint32_t channels, uint32_t rate, float baseQuality) {
+			vorbis_info_init(&m_vi);
+			m_cleanup += [this] { vorbis_info_clear(&m_vi); };
+			if (const auto res = vorbis_encode_init_vbr(&m_vi, channels, rate, baseQuality))
+				throw std::runtime_error(std::format("vorbis_encode_init_vbr: {}", res));
+
+			if (const auto res = vorbis_analysis_init(&m_vd, &m_vi))
+				throw std::runtime_error(std::format("vorbis_analysis_init: {}", res));
+			m_cleanup += [this] { vorbis_dsp_clear(&m_vd); };
+
+			if (const auto res = vorbis_block_init(&m_vd, &m_vb))
+				throw std::runtime_error(std::format("vorbis_block_init: {}", res));
+			m_cleanup += [this] { vorbis_block_clear(&m_vb); };
+		}
+
+		VorbisAnalysis(const VorbisAnalysis&) = delete;
+		VorbisAnalysis& operator=(const VorbisAnalysis&) = delete;
+
+		[[nodiscard]] vorbis_info& Info() {
+			return m_vi;
+		}
+
+		[[nodiscard]] vorbis_dsp_state& Dsp() {
+			return m_vd;
+		}
+
+		// Feeds count blocks starting at offset, or marks the end of the stream if count is 0.
+		// Calls onBlock for every block that can be decided with what has been fed so far.
+		void Feed(const std::vector<std::vector<float>>& pcm, size_t offset, size_t count, const std::function<void(vorbis_block&)>& onBlock) {
+			if (count) {
+				const auto buf = vorbis_analysis_buffer(&m_vd, static_cast<int>(count));
+				if (!buf)
+					throw std::runtime_error("vorbis_analysis_buffer: fail");
+				for (size_t i = 0; i < pcm.size(); ++i)
+					std::copy_n(&pcm[i][offset], count, buf[i]);
+			}
+			if (const auto res = vorbis_analysis_wrote(&m_vd, static_cast<int>(count)); res < 0)
+				throw std::runtime_error(std::format("vorbis_analysis_wrote: {}", res));
+
+			while (true) {
+				if (const auto res = vorbis_analysis_blockout(&m_vd, &m_vb); res < 0)
+					throw std::runtime_error(std::format("vorbis_analysis_blockout: {}", res));
+				else if (res == 0)
+					break;
+				onBlock(m_vb);
+			}
+		}
+	};
+
+	struct BlockLayout {
+		int64_t GranulePos;
+		long W;
+		long nW;
+	};
+
+	// Block sizes that an encoder starting at Start would choose, without spending time on encoding them.
+	struct Plan {
+		std::unique_ptr<VorbisAnalysis> Analysis;
+		int64_t Start = 0;
+		int64_t Fed = 0;
+		std::vector<BlockLayout> Blocks;
+	};
+}
+
+struct Sqex::Sound::ParallelVorbisEncoder::Implementation {
+	const uint32_t Channels;
+	const uint32_t Rate;
+	const float BaseQuality;
+	const size_t MaxConcurrency;
+
+	// Only used to generate headers; all encoders share the same setup.
+	VorbisAnalysis HeaderAnalysis;
+
+	// Positions where an encoder may start. Blocks of all encoders land on multiples of this,
+	// given that they start on one; transition between short and long blocks moves by a quarter of a short block.
+	const int64_t Granularity;
+
+	// Number of starting positions to try; a run of long blocks repeats every half of a long block.
+	const int64_t PhaseCount;
+
+	std::vector<std::vector<float>> Pcm;
+	int64_t PcmStart = 0;
+	size_t PendingBlockCount = 0;
+	std::vector<float*> BufferPointers;
+
+	struct Chunk {
+		int64_t Start;
+		int64_t End;
+		bool Final;
+
+		// Packets up to this granule position are taken from this chunk, and the rest from the next one.
+		int64_t SeamGranulePos;
+
+		std::vector<Packet> Packets;
+	};
+
+	// The chunk still being written to, and where it would end if the next one can be aligned there.
+	Plan Open;
+	int64_t OpenBoundary = 0;
+
+	std::vector<Chunk> Ready;
+	int64_t LastSeamGranulePos = -1;
+	std::vector<Packet> Output;
+	bool Finished = false;
+
+	Implementation(uint32_t channels, uint32_t rate, float baseQuality, size_t maxConcurrency)
+		: Channels(channels)
+		, Rate(rate)
+		, BaseQuality(baseQuality)
+		, MaxConcurrency(maxConcurrency)
+		, HeaderAnalysis(channels, rate, baseQuality)
+		, Granularity(vorbis_info_blocksize(&HeaderAnalysis.Info(), 0) / 4)
+		, PhaseCount(vorbis_info_blocksize(&HeaderAnalysis.Info(), 1) / 2 / Granularity)
+		, Pcm(channels)
+		, BufferPointers(channels) {
+		if (Granularity <= 0 || PhaseCount <= 0)
+			throw std::runtime_error("vorbis_info_blocksize: fail");
+
+		Open = NewPlan(0);
+		OpenBoundary = static_cast<int64_t>(Rate) * ChunkMilliseconds / 1000;
+	}
+
+	[[nodiscard]] int64_t PcmEnd() const {
+		return PcmStart + static_cast<int64_t>(Pcm[0].size() - PendingBlockCount);
+	}
+
+	[[nodiscard]] Plan NewPlan(int64_t start) const {
+		return {
+			.Analysis = std::make_unique<VorbisAnalysis>(Channels, Rate, BaseQuality),
+			.Start = start,
+			.Fed = start,
+		};
+	}
+
+	// Feeds whole pieces, without going past limit.
+	void FeedPlan(Plan& plan, int64_t limit) const {
+		limit = std::min(limit, PcmEnd());
+		while (plan.Fed + FeedBlockCount <= limit) {
+			plan.Analysis->Feed(Pcm, static_cast<size_t>(plan.Fed - PcmStart), static_cast<size_t>(FeedBlockCount), [&plan](const vorbis_block& vb) {
+				plan.Blocks.emplace_back(BlockLayout{plan.Start + vb.granulepos, vb.W, vb.nW});
+			});
+			plan.Fed += FeedBlockCount;
+		}
+	}
+
+	// Looks for a starting position for the chunk after the open one, so that both agree on a block at or after boundary.
+	// The open plan must have been fed up to end, and samples must be available up to a piece past end.
+	bool TryStartNextChunk(int64_t boundary, int64_t end, Plan& next, int64_t& seamGranulePos) const {
+		const auto base = (boundary - static_cast<int64_t>(Rate) * PreRollMilliseconds / 1000) / Granularity * Granularity;
+		for (int64_t phase = 0; phase < PhaseCount; ++phase) {
+			next = NewPlan(base - phase * Granularity);
+			if (next.Start <= Open.Start)
+				break;
+			FeedPlan(next, end + FeedBlockCount);
+
+			// Both encoders having a block that ends at the same position, with the same sizes for itself and the next block,
+			// means that the later half of the window is the same, so the next block can come from either of them.
+			for (const auto& block : next.Blocks) {
+				if (block.GranulePos < boundary)
+					continue;
+
+				const auto it = std::ranges::lower_bound(Open.Blocks, block.GranulePos, {}, &BlockLayout::GranulePos);
+				if (it == Open.Blocks.end())
+					break;
+				if (it->GranulePos == block.GranulePos && it->W == block.W && it->nW == block.nW) {
+					seamGranulePos = block.GranulePos;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void Process() {
+		while (true) {
+			const auto end = Open.Start + (OpenBoundary + static_cast<int64_t>(Rate) * OverlapMilliseconds / 1000 - Open.Start + FeedBlockCount - 1) / FeedBlockCount * FeedBlockCount;
+			FeedPlan(Open, end);
+			if (Open.Fed < end || PcmEnd() < end + FeedBlockCount)
+				return;
+
+			Plan next;
+			int64_t seamGranulePos;
+			if (!TryStartNextChunk(OpenBoundary, end, next, seamGranulePos)) {
+				// Try again a bit later; if the audio ends before then, the open chunk simply becomes longer.
+				OpenBoundary += Rate / 2;
+				continue;
+			}
+
+			Ready.emplace_back(Chunk{Open.Start, end, false, seamGranulePos});
+			Open = std::move(next);
+			OpenBoundary = seamGranulePos + static_cast<int64_t>(Rate) * ChunkMilliseconds / 1000;
+
+			if (Ready.size() >= std::min(MaxChunksPerBatch, MaxConcurrency))
+				EncodeReadyChunks();
+		}
+	}
+
+	void EncodeChunk(Chunk& chunk) const {
+		VorbisAnalysis analysis(Channels, Rate, BaseQuality);
+		ogg_packet op{};
+		const auto onBlock = [&](vorbis_block& vb) {
+			if (const auto res = vorbis_analysis(&vb, nullptr); res < 0)
+				throw std::runtime_error(std::format("vorbis_analysis: {}", res));
+			if (const auto res = vorbis_bitrate_addblock(&vb); res < 0)
+				throw std::runtime_error(std::format("vorbis_bitrate_addblock: {}", res));
+
+			while (true) {
+				if (const auto res = vorbis_bitrate_flushpacket(&analysis.Dsp(), &op); res < 0)
+					throw std::runtime_error(std::format("vorbis_bitrate_flushpacket: {}", res));
+				else if (res == 0)
+					break;
+
+				chunk.Packets.emplace_back(Packet{
+					.Data = {op.packet, op.packet + op.bytes},
+					.GranulePos = chunk.Start + op.granulepos,
+					.EndOfStream = !!op.e_o_s,
+				});
+			}
+		};
+
+		for (auto offset = chunk.Start; offset < chunk.End; offset += FeedBlockCount)
+			analysis.Feed(Pcm, static_cast<size_t>(offset - PcmStart), static_cast<size_t>(std::min<int64_t>(FeedBlockCount, chunk.End - offset)), onBlock);
+		if (chunk.Final)
+			analysis.Feed(Pcm, 0, 0, onBlock);
+	}
+
+	void EncodeReadyChunks() {
+		Utils::Win32::ParallelFor(Ready.size(), [this](size_t i) {
+			EncodeChunk(Ready[i]);
+		}, MaxConcurrency);
+
+		for (auto& chunk : Ready) {
+			for (auto& packet : chunk.Packets) {
+				if (packet.GranulePos <= LastSeamGranulePos)
+					continue;
+				if (packet.GranulePos > chunk.SeamGranulePos)
+					break;
+				Output.emplace_back(std::move(packet));
+			}
+			LastSeamGranulePos = chunk.SeamGranulePos;
+		}
+		Ready.clear();
+
+		if (Finished) {
+			Pcm.clear();
+			return;
+		}
+
+		// Only the open chunk needs samples from now on.
+		const auto unused = static_cast<ptrdiff_t>(Open.Start - PcmStart);
+		for (auto& channel : Pcm)
+			channel.erase(channel.begin(), channel.begin() + unused);
+		PcmStart = Open.Start;
+	}
+};
+
+Sqex::Sound::ParallelVorbisEncoder::ParallelVorbisEncoder(uint32_t channels, uint32_t rate, float baseQuality, size_t maxConcurrency)
+	: m_pImpl(std::make_unique<Implementation>(channels, rate, baseQuality, std::max<size_t>(1, maxConcurrency))) {
+}
+
+Sqex::Sound::ParallelVorbisEncoder::~ParallelVorbisEncoder() = default;
+
+float** Sqex::Sound::ParallelVorbisEncoder::Buffer(size_t blocks) {
+	if (m_pImpl->Finished)
+		throw std::runtime_error("Encoding has already finished");
+
+	const auto size = m_pImpl->Pcm[0].size() - m_pImpl->PendingBlockCount;
+	for (size_t i = 0; i < m_pImpl->Channels; ++i) {
+		m_pImpl->Pcm[i].resize(size + blocks);
+		m_pImpl->BufferPointers[i] = m_pImpl->Pcm[i].data() + size;
+	}
+	m_pImpl->PendingBlockCount = blocks;
+	return m_pImpl->BufferPointers.data();
+}
+
+void Sqex::Sound::ParallelVorbisEncoder::Wrote(size_t blocks) {
+	if (m_pImpl->Finished)
+		throw std::runtime_error("Encoding has already finished");
+	if (blocks > m_pImpl->PendingBlockCount)
+		throw std::invalid_argument("Wrote more than the buffer");
+
+	for (auto& channel : m_pImpl->Pcm)
+		channel.resize(channel.size() - m_pImpl->PendingBlockCount + blocks);
+	m_pImpl->PendingBlockCount = 0;
+
+	if (blocks) {
+		m_pImpl->Process();
+		return;
+	}
+
+	m_pImpl->Finished = true;
+	m_pImpl->Ready.emplace_back(Implementation::Chunk{m_pImpl->Open.Start, m_pImpl->PcmEnd(), true, INT64_MAX});
+	m_pImpl->EncodeReadyChunks();
+	m_pImpl->Open = {};
+}
+
+void Sqex::Sound::ParallelVorbisEncoder::HeaderOut(vorbis_comment& vc, ogg_packet& header, ogg_packet& comments, ogg_packet& code) {
+	if (const auto res = vorbis_analysis_headerout(&m_pImpl->HeaderAnalysis.Dsp(), &vc, &header, &comments, &code))
+		throw std::runtime_error(std::format("vorbis_analysis_headerout: {}", res));
+}
+
+const std::vector<Sqex::Sound::ParallelVorbisEncoder::Packet>& Sqex::Sound::ParallelVorbisEncoder::Packets() const {
+	return m_pImpl->Output;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <vorbis/codec.h>
+
+namespace Sqex::Sound {
+	// Encodes audio into Vorbis packets, splitting it into chunks that get encoded concurrently.
+	//
+	// Each chunk starts a bit before where it is supposed to, at a position chosen so that its encoder ends up with
+	// the same block sizes and positions as the previous chunk's encoder. Chunks are then joined at a block both
+	// agree on, so that overlapping windows still line up and the result decodes as a single stream.
+	class ParallelVorbisEncoder {
+	public:
+		struct Packet {
+			std::vector<uint8_t> Data;
+			int64_t GranulePos;
+			bool EndOfStream;
+		};
+
+	private:
+		struct Implementation;
+		const std::unique_ptr<Implementation> m_pImpl;
+
+	public:
+		ParallelVorbisEncoder(uint32_t channels, uint32_t rate, float baseQuality, size_t maxConcurrency = SIZE_MAX);
+		~ParallelVorbisEncoder();
+
+		// Same as vorbis_analysis_buffer.
+		float** Buffer(size_t blocks);
+
+		// Same as vorbis_analysis_wrote. Pass 0 to finish encoding.
+		void Wrote(size_t blocks);
+
+		// Same as vorbis_analysis_headerout. Returned packets stay valid until the next call.
+		void HeaderOut(vorbis_comment& vc, ogg_packet& header, ogg_packet& comments, ogg_packet& code);
+
+		// Packets encoded so far; complete after Wrote(0).
+		[[nodiscard]] const std::vector<Packet>& Packets() const;
+	};
+}
@@ -0,0 +1,971 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Sound/PcmDecoder.h"
+
+#include "XivAlexanderCommon/Sqex/Sound.h"
+#include "XivAlexanderCommon/Utils/CallOnDestruction.h"
+
+namespace {
+	template<typename T>
+	T ReadLE(std::span<const uint8_t> data, size_t offset) {
+		if (offset + sizeof(T) > data.size())
+			throw Sqex::CorruptDataException("Unexpected end of audio data");
+		T value;
+		memcpy(&value, &data[offset], sizeof(T));
+		return value;
+	}
+
+	std::span<const uint8_t> GetDirectView(const std::shared_ptr<const Sqex::RandomAccessStream>& stream) {
+		const auto view = stream->GetDirectView();
+		if (view.size() != stream->StreamSize())
+			throw std::invalid_argument("Stream must be backed by memory");
+		return view;
+	}
+
+	// Returns where the data after an ID3v2 tag, which some taggers put in front of FLAC streams too, starts.
+	size_t SkipId3v2Tag(std::span<const uint8_t> data) {
+		if (data.size() < 10 || memcmp(&data[0], "ID3", 3) != 0)
+			return 0;
+		return 10 + (data[5] & 0x10 ? 10 : 0) + ((data[6] & 0x7F) << 21 | (data[7] & 0x7F) << 14 | (data[8] & 0x7F) << 7 | (data[9] & 0x7F));
+	}
+
+	// Decodes a chunk of sample blocks at a time, and hands them out in pieces as requested.
+	class ChunkedPcmDecoder : public Sqex::Sound::PcmDecoder {
+		size_t m_chunkPtr = 0;
+
+	protected:
+		std::vector<float> m_chunk;
+
+		// Appends the next chunk of interleaved samples to m_chunk; returns false at the end of the stream.
+		virtual bool DecodeNextChunk() = 0;
+
+	public:
+		std::span<const float> Read(size_t maxBlocks) override {
+			while (m_chunkPtr == m_chunk.size()) {
+				m_chunk.clear();
+				m_chunkPtr = 0;
+				if (!DecodeNextChunk())
+					return {};
+			}
+
+			const auto count = std::min(m_chunk.size() - m_chunkPtr, std::max<size_t>(1, maxBlocks) * Channels());
+			const auto res = std::span(m_chunk).subspan(m_chunkPtr, count);
+			m_chunkPtr += count;
+			return res;
+		}
+	};
+
+	class WavPcmDecoder : public ChunkedPcmDecoder {
+		static constexpr size_t BlocksPerChunk = 8192;
+		static constexpr int MsAdpcmAdaptationTable[16] = {230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230};
+
+		const std::shared_ptr<const Sqex::RandomAccessStream> m_stream;
+		std::span<const uint8_t> m_remaining;
+
+		std::vector<uint8_t> m_formatBuffer;
+		uint16_t m_formatTag{};
+		uint32_t m_channels{};
+		uint32_t m_rate{};
+		uint16_t m_blockAlign{};
+		uint16_t m_bitsPerSample{};
+
+		void DecodeMsAdpcmBlock(std::span<const uint8_t> block) {
+			const auto& format = *reinterpret_cast<const Sqex::Sound::ADPCMWAVEFORMAT*>(&m_formatBuffer[0]);
+			const auto channels = static_cast<size_t>(m_channels);
+			if (block.size() < 7 * channels)
+				return;  // trailing garbage
+
+			struct ChannelState {
+				int Coef1;
+				int Coef2;
+				int Delta;
+				int Sample1;
+				int Sample2;
+			};
+			std::vector<ChannelState> states(channels);
+			size_t offset = 0;
+			for (auto& state : states) {
+				const auto predictor = block[offset++];
+				if (predictor >= format.wNumCoef)
+					throw Sqex::CorruptDataException("Invalid MS-ADPCM predictor");
+				state.Coef1 = format.aCoef[predictor].iCoef1;
+				state.Coef2 = format.aCoef[predictor].iCoef2;
+			}
+			for (auto& state : states)
+				state.Delta = ReadLE<int16_t>(block, std::exchange(offset, offset + 2));
+			for (auto& state : states)
+				state.Sample1 = ReadLE<int16_t>(block, std::exchange(offset, offset + 2));
+			for (auto& state : states)
+				state.Sample2 = ReadLE<int16_t>(block, std::exchange(offset, offset + 2));
+
+			for (const auto& state : states)
+				m_chunk.push_back(static_cast<float>(state.Sample2) / 32768.f);
+			for (const auto& state : states)
+				m_chunk.push_back(static_cast<float>(state.Sample1) / 32768.f);
+
+			// Nibbles go through channels in turn, upper nibble first.
+			const auto samplesPerChannel = std::min<size_t>(format.wSamplesPerBlock, 2 + (block.size() - offset) * 2 / channels);
+			const auto nibbleCount = (samplesPerChannel - 2) * channels;
+			for (size_t i = 0; i < nibbleCount; ++i) {
+				auto& state = states[i % channels];
+				const auto nibble = (i % 2 == 0 ? block[offset + i / 2] >> 4 : block[offset + i / 2]) & 0xF;
+
+				// Rounds toward zero, as ffmpeg does.
+				auto predicted = (state.Sample1 * state.Coef1 + state.Sample2 * state.Coef2) / 256;
+				predicted += (nibble >= 8 ? nibble - 16 : nibble) * state.Delta;
+				predicted = std::clamp(predicted, -32768, 32767);
+				state.Sample2 = state.Sample1;
+				state.Sample1 = predicted;
+				state.Delta = std::clamp(MsAdpcmAdaptationTable[nibble] * state.Delta >> 8, 16, INT_MAX / 768);
+
+				m_chunk.push_back(static_cast<float>(predicted) / 32768.f);
+			}
+		}
+
+		template<typename T, typename Fn>
+		void DecodeSamples(std::span<const uint8_t> data, const Fn& convert) {
+			const auto count = data.size() / sizeof(T);
+			m_chunk.reserve(m_chunk.size() + count);
+			for (size_t i = 0; i < count; ++i) {
+				T value;
+				memcpy(&value, &data[i * sizeof(T)], sizeof(T));
+				m_chunk.push_back(convert(value));
+			}
+		}
+
+	protected:
+		bool DecodeNextChunk() override {
+			const auto chunkSize = std::min<size_t>(m_remaining.size() / m_blockAlign, m_formatTag == WAVE_FORMAT_ADPCM ? 16 : BlocksPerChunk) * m_blockAlign;
+			const auto data = m_remaining.subspan(0, chunkSize ? chunkSize : m_remaining.size());
+			m_remaining = m_remaining.subspan(data.size());
+			if (data.empty())
+				return false;
+
+			if (m_formatTag == WAVE_FORMAT_ADPCM) {
+				for (size_t i = 0; i < data.size(); i += m_blockAlign)
+					DecodeMsAdpcmBlock(data.subspan(i, std::min<size_t>(m_blockAlign, data.size() - i)));
+
+			} else if (m_formatTag == WAVE_FORMAT_IEEE_FLOAT) {
+				if (m_bitsPerSample == 32)
+					DecodeSamples<float>(data, [](float v) { return v; });
+				else
+					DecodeSamples<double>(data, [](double v) { return static_cast<float>(v); });
+
+			} else {
+				switch (m_bitsPerSample) {
+					case 8:
+						DecodeSamples<uint8_t>(data, [](uint8_t v) { return (static_cast<float>(v) - 128.f) / 128.f; });
+						break;
+					case 16:
+						DecodeSamples<int16_t>(data, [](int16_t v) { return static_cast<float>(v) / 32768.f; });
+						break;
+					case 24:
+						m_chunk.reserve(m_chunk.size() + data.size() / 3);
+						for (size_t i = 0; i + 3 <= data.size(); i += 3)
+							m_chunk.push_back(static_cast<float>(static_cast<int32_t>(static_cast<uint32_t>(data[i]) << 8 | static_cast<uint32_t>(data[i + 1]) << 16 | static_cast<uint32_t>(data[i + 2]) << 24) >> 8) / 8388608.f);
+						break;
+					case 32:
+						DecodeSamples<int32_t>(data, [](int32_t v) { return static_cast<float>(v) / 2147483648.f; });
+						break;
+				}
+			}
+
+			// Drop an incomplete sample block at the end, if any.
+			m_chunk.resize(m_chunk.size() / m_channels * m_channels);
+			return true;
+		}
+
+	public:
+		WavPcmDecoder(std::shared_ptr<const Sqex::RandomAccessStream> stream)
+			: m_stream(std::move(stream)) {
+			const auto data = GetDirectView(m_stream);
+
+			std::span<const uint8_t> format;
+			for (size_t offset = 12; offset + 8 <= data.size();) {
+				const auto code = ReadLE<uint32_t>(data, offset);
+				const auto length = std::min<size_t>(ReadLE<uint32_t>(data, offset + 4), data.size() - offset - 8);
+				const auto body = data.subspan(offset + 8, length);
+				if (code == 0x20746D66U)  // "fmt "
+					format = body;
+				else if (code == 0x61746164U) {  // "data"
+					m_remaining = body;
+					break;
+				}
+				offset += 8 + length + (length & 1);
+			}
+			if (format.size() < 16)
+				throw Sqex::CorruptDataException("No fmt chunk found");
+			if (m_remaining.empty())
+				throw Sqex::CorruptDataException("No data chunk found");
+
+			m_formatBuffer.resize(std::max(format.size(), sizeof(Sqex::Sound::ADPCMWAVEFORMAT)));
+			std::ranges::copy(format, m_formatBuffer.begin());
+			const auto& wfex = *reinterpret_cast<const WAVEFORMATEX*>(&m_formatBuffer[0]);
+			m_formatTag = wfex.wFormatTag;
+			m_channels = wfex.nChannels;
+			m_rate = wfex.nSamplesPerSec;
+			m_blockAlign = wfex.nBlockAlign;
+			m_bitsPerSample = wfex.wBitsPerSample;
+			if (m_formatTag == WAVE_FORMAT_EXTENSIBLE) {
+				// First two bytes of SubFormat are the actual format tag.
+				if (format.size() < 26)
+					throw Sqex::CorruptDataException("WAVEFORMATEXTENSIBLE too small");
+				m_formatTag = ReadLE<uint16_t>(format, 24);
+			}
+
+			if (!m_channels || !m_rate || !m_blockAlign)
+				throw Sqex::CorruptDataException("Invalid wave format");
+
+			switch (m_formatTag) {
+				case WAVE_FORMAT_PCM:
+					if (m_bitsPerSample != 8 && m_bitsPerSample != 16 && m_bitsPerSample != 24 && m_bitsPerSample != 32)
+						throw std::invalid_argument(std::format("{}-bit PCM is not supported", m_bitsPerSample));
+					break;
+
+				case WAVE_FORMAT_IEEE_FLOAT:
+					if (m_bitsPerSample != 32 && m_bitsPerSample != 64)
+						throw std::invalid_argument(std::format("{}-bit float is not supported", m_bitsPerSample));
+					break;
+
+				case WAVE_FORMAT_ADPCM: {
+					const auto& adpcm = *reinterpret_cast<const Sqex::Sound::ADPCMWAVEFORMAT*>(&m_formatBuffer[0]);
+					if (format.size() < 22 || adpcm.wNumCoef <= 0 || adpcm.wNumCoef > 32 || format.size() < 22 + 4 * static_cast<size_t>(adpcm.wNumCoef))
+						throw Sqex::CorruptDataException("Invalid MS-ADPCM header");
+					if (adpcm.wSamplesPerBlock < 2)
+						throw Sqex::CorruptDataException("Invalid MS-ADPCM block size");
+					break;
+				}
+
+				default:
+					throw std::invalid_argument(std::format("Wave format 0x{:04x} is not supported", m_formatTag));
+			}
+		}
+
+		[[nodiscard]] uint32_t Rate() const override {
+			return m_rate;
+		}
+
+		[[nodiscard]] uint32_t Channels() const override {
+			return m_channels;
+		}
+	};
+
+	class FlacDecoder : public ChunkedPcmDecoder {
+		class BitReader {
+			const std::span<const uint8_t> m_data;
+			size_t m_nextByte;
+			uint64_t m_cache = 0;
+			uint32_t m_cacheBits = 0;
+
+			void Refill() {
+				while (m_cacheBits <= 56) {
+					if (m_nextByte < m_data.size())
+						m_cache |= static_cast<uint64_t>(m_data[m_nextByte]) << (56 - m_cacheBits);
+					else if (m_nextByte >= m_data.size() + 8)
+						throw Sqex::CorruptDataException("Unexpected end of FLAC frame");
+					++m_nextByte;
+					m_cacheBits += 8;
+				}
+			}
+
+			void Skip(uint32_t bits) {
+				m_cache = bits == 64 ? 0 : m_cache << bits;
+				m_cacheBits -= bits;
+			}
+
+		public:
+			BitReader(std::span<const uint8_t> data, size_t offset)
+				: m_data(data)
+				, m_nextByte(offset) {
+			}
+
+			[[nodiscard]] size_t ByteOffset() const {
+				return m_nextByte - m_cacheBits / 8;
+			}
+
+			[[nodiscard]] bool Overrun() const {
+				return ByteOffset() > m_data.size();
+			}
+
+			uint32_t Read(uint32_t bits) {
+				if (!bits)
+					return 0;
+				Refill();
+				const auto res = static_cast<uint32_t>(m_cache >> (64 - bits));
+				Skip(bits);
+				return res;
+			}
+
+			int64_t ReadSigned(uint32_t bits) {
+				if (!bits)
+					return 0;
+				uint64_t value = 0;
+				for (auto remaining = bits; remaining;) {
+					const auto n = std::min(remaining, 32U);
+					value = value << n | Read(n);
+					remaining -= n;
+				}
+				return static_cast<int64_t>(value << (64 - bits)) >> (64 - bits);
+			}
+
+			// Counts zero bits before the next one bit, and consumes them along with the one bit.
+			uint32_t ReadUnary() {
+				uint32_t count = 0;
+				while (true) {
+					Refill();
+					if (!m_cache) {
+						count += m_cacheBits;
+						Skip(m_cacheBits);
+						if (Overrun())
+							throw Sqex::CorruptDataException("Unexpected end of FLAC frame");
+						continue;
+					}
+					const auto zeros = static_cast<uint32_t>(std::countl_zero(m_cache));
+					Skip(zeros + 1);
+					return count + zeros;
+				}
+			}
+
+			void AlignToByte() {
+				Skip(m_cacheBits % 8);
+			}
+		};
+
+		const std::shared_ptr<const Sqex::RandomAccessStream> m_stream;
+		const std::span<const uint8_t> m_data;
+		size_t m_offset = 0;
+
+		uint32_t m_rate{};
+		uint32_t m_channels{};
+		uint32_t m_bitsPerSample{};
+		std::map<std::string, std::string> m_tags;
+
+		std::vector<std::vector<int64_t>> m_samples;
+
+		static void ReadResidual(BitReader& reader, std::span<int64_t> out, size_t order) {
+			const auto method = reader.Read(2);
+			if (method > 1)
+				throw Sqex::CorruptDataException("Unsupported FLAC residual coding method");
+			const auto parameterBits = method == 0 ? 4U : 5U;
+			const auto escapeParameter = (1U << parameterBits) - 1;
+
+			const auto partitionOrder = reader.Read(4);
+			const auto partitionSize = out.size() >> partitionOrder;
+			if ((partitionSize << partitionOrder) != out.size() || partitionSize < order)
+				throw Sqex::CorruptDataException("Invalid FLAC residual partition order");
+
+			auto ptr = order;
+			for (size_t partition = 0; partition < (1ULL << partitionOrder); ++partition) {
+				const auto end = (partition + 1) * partitionSize;
+				if (const auto parameter = reader.Read(parameterBits); parameter == escapeParameter) {
+					const auto bits = reader.Read(5);
+					for (; ptr < end; ++ptr)
+						out[ptr] = reader.ReadSigned(bits);
+				} else {
+					for (; ptr < end; ++ptr) {
+						const auto quotient = static_cast<uint64_t>(reader.ReadUnary());
+						const auto value = quotient << parameter | reader.Read(parameter);
+						out[ptr] = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+					}
+				}
+			}
+		}
+
+		static void ReadSubframe(BitReader& reader, std::span<int64_t> out, uint32_t bitsPerSample) {
+			if (reader.Read(1))
+				throw Sqex::CorruptDataException("Invalid FLAC subframe padding");
+
+			const auto type = reader.Read(6);
+			uint32_t wastedBits = 0;
+			if (reader.Read(1))
+				wastedBits = reader.ReadUnary() + 1;
+			if (wastedBits >= bitsPerSample)
+				throw Sqex::CorruptDataException("Invalid FLAC wasted bits");
+			bitsPerSample -= wastedBits;
+
+			if (type == 0) {
+				std::ranges::fill(out, reader.ReadSigned(bitsPerSample));
+
+			} else if (type == 1) {
+				for (auto& sample : out)
+					sample = reader.ReadSigned(bitsPerSample);
+
+			} else if (type >= 8 && type <= 12) {
+				const auto order = static_cast<size_t>(type - 8);
+				if (order > out.size())
+					throw Sqex::CorruptDataException("FLAC predictor order exceeds block size");
+				for (size_t i = 0; i < order; ++i)
+					out[i] = reader.ReadSigned(bitsPerSample);
+				ReadResidual(reader, out, order);
+
+				for (auto i = order; i < out.size(); ++i) {
+					switch (order) {
+						case 1:
+							out[i] += out[i - 1];
+							break;
+						case 2:
+							out[i] += 2 * out[i - 1] - out[i - 2];
+							break;
+						case 3:
+							out[i] += 3 * out[i - 1] - 3 * out[i - 2] + out[i - 3];
+							break;
+						case 4:
+							out[i] += 4 * out[i - 1] - 6 * out[i - 2] + 4 * out[i - 3] - out[i - 4];
+							break;
+					}
+				}
+
+			} else if (type >= 32) {
+				const auto order = static_cast<size_t>(type - 31);
+				if (order > out.size())
+					throw Sqex::CorruptDataException("FLAC predictor order exceeds block size");
+				for (size_t i = 0; i < order; ++i)
+					out[i] = reader.ReadSigned(bitsPerSample);
+
+				const auto precision = reader.Read(4) + 1;
+				if (precision == 16)
+					throw Sqex::CorruptDataException("Invalid FLAC coefficient precision");
+				const auto shift = reader.ReadSigned(5);
+				if (shift < 0)
+					throw Sqex::CorruptDataException("Invalid FLAC coefficient shift");
+
+				int64_t coefficients[32];
+				for (size_t i = 0; i < order; ++i)
+					coefficients[i] = reader.ReadSigned(precision);
+				ReadResidual(reader, out, order);
+
+				for (auto i = order; i < out.size(); ++i) {
+					int64_t sum = 0;
+					for (size_t j = 0; j < order; ++j)
+						sum += coefficients[j] * out[i - j - 1];
+					out[i] += sum >> shift;
+				}
+
+			} else
+				throw Sqex::CorruptDataException(std::format("Invalid FLAC subframe type {}", type));
+
+			if (wastedBits) {
+				for (auto& sample : out)
+					sample <<= wastedBits;
+			}
+		}
+
+		void ReadMetadata() {
+			m_offset = SkipId3v2Tag(m_data);
+			if (m_offset + 4 > m_data.size() || memcmp(&m_data[m_offset], "fLaC", 4) != 0)
+				throw Sqex::CorruptDataException("Not a FLAC stream");
+			m_offset += 4;
+
+			for (auto last = false; !last;) {
+				if (m_offset + 4 > m_data.size())
+					throw Sqex::CorruptDataException("Unexpected end of FLAC metadata");
+				last = !!(m_data[m_offset] & 0x80);
+				const auto type = m_data[m_offset] & 0x7F;
+				const auto length = static_cast<size_t>(m_data[m_offset + 1] << 16 | m_data[m_offset + 2] << 8 | m_data[m_offset + 3]);
+				m_offset += 4;
+				if (m_offset + length > m_data.size())
+					throw Sqex::CorruptDataException("Unexpected end of FLAC metadata");
+				const auto block = m_data.subspan(m_offset, length);
+				m_offset += length;
+
+				if (type == 0) {  // STREAMINFO
+					if (block.size() < 18)
+						throw Sqex::CorruptDataException("FLAC STREAMINFO too small");
+					BitReader reader(block, 10);
+					m_rate = reader.Read(20);
+					m_channels = reader.Read(3) + 1;
+					m_bitsPerSample = reader.Read(5) + 1;
+
+				} else if (type == 4) {  // VORBIS_COMMENT
+					size_t ptr = 0;
+					ptr += 4 + ReadLE<uint32_t>(block, ptr);
+					const auto count = ReadLE<uint32_t>(block, ptr);
+					ptr += 4;
+					for (uint32_t i = 0; i < count; ++i) {
+						const auto commentLength = ReadLE<uint32_t>(block, ptr);
+						ptr += 4;
+						if (ptr + commentLength > block.size())
+							throw Sqex::CorruptDataException("Unexpected end of FLAC VORBIS_COMMENT");
+						const auto comment = std::string(reinterpret_cast<const char*>(&block[ptr]), commentLength);
+						ptr += commentLength;
+						if (const auto eq = comment.find('='); eq != std::string::npos)
+							m_tags.insert_or_assign(comment.substr(0, eq), comment.substr(eq + 1));
+					}
+				}
+			}
+
+			if (!m_rate || !m_channels)
+				throw Sqex::CorruptDataException("FLAC STREAMINFO not found");
+			m_samples.resize(m_channels);
+		}
+
+	protected:
+		bool DecodeNextChunk() override {
+			// Frames start with a 14-bit sync code of all ones but the last, followed by a zero bit.
+			while (m_offset + 2 <= m_data.size() && (m_data[m_offset] != 0xFF || (m_data[m_offset + 1] & 0xFE) != 0xF8))
+				++m_offset;
+			if (m_offset + 2 > m_data.size())
+				return false;
+
+			BitReader reader(m_data, m_offset + 2);
+			const auto blockSizeCode = reader.Read(4);
+			const auto rateCode = reader.Read(4);
+			const auto channelAssignment = reader.Read(4);
+			const auto sampleSizeCode = reader.Read(3);
+			reader.Read(1);
+
+			// Frame or sample number, UTF-8 style.
+			if (const auto first = reader.Read(8); first & 0x80) {
+				for (auto mask = 0x40U; first & mask; mask >>= 1)
+					reader.Read(8);
+			}
+
+			size_t blockSize;
+			if (blockSizeCode == 0)
+				throw Sqex::CorruptDataException("Invalid FLAC block size");
+			else if (blockSizeCode == 1)
+				blockSize = 192;
+			else if (blockSizeCode <= 5)
+				blockSize = 576ULL << (blockSizeCode - 2);
+			else if (blockSizeCode == 6)
+				blockSize = reader.Read(8) + 1ULL;
+			else if (blockSizeCode == 7)
+				blockSize = reader.Read(16) + 1ULL;
+			else
+				blockSize = 256ULL << (blockSizeCode - 8);
+
+			if (rateCode == 12)
+				reader.Read(8);
+			else if (rateCode == 13 || rateCode == 14)
+				reader.Read(16);
+			else if (rateCode == 15)
+				throw Sqex::CorruptDataException("Invalid FLAC sampling rate");
+
+			uint32_t bitsPerSample;
+			switch (sampleSizeCode) {
+				case 0: bitsPerSample = m_bitsPerSample; break;
+				case 1: bitsPerSample = 8; break;
+				case 2: bitsPerSample = 12; break;
+				case 4: bitsPerSample = 16; break;
+				case 5: bitsPerSample = 20; break;
+				case 6: bitsPerSample = 24; break;
+				case 7: bitsPerSample = 32; break;
+				default: throw Sqex::CorruptDataException("Invalid FLAC sample size");
+			}
+
+			const auto channels = channelAssignment <= 7 ? channelAssignment + 1 : 2;
+			if (channelAssignment > 10 || channels != m_channels)
+				throw Sqex::CorruptDataException("Unexpected FLAC channel assignment");
+			reader.Read(8);  // CRC-8
+
+			for (uint32_t i = 0; i < channels; ++i) {
+				// Side channel has one more bit.
+				const auto isSide = (channelAssignment == 8 && i == 1) || (channelAssignment == 9 && i == 0) || (channelAssignment == 10 && i == 1);
+				m_samples[i].resize(blockSize);
+				ReadSubframe(reader, m_samples[i], bitsPerSample + (isSide ? 1 : 0));
+			}
+			reader.AlignToByte();
+			reader.Read(16);  // CRC-16
+			if (reader.Overrun())
+				throw Sqex::CorruptDataException("Unexpected end of FLAC frame");
+			m_offset = reader.ByteOffset();
+
+			auto& left = m_samples[0];
+			switch (channelAssignment) {
+				case 8:
+					for (size_t i = 0; i < blockSize; ++i)
+						m_samples[1][i] = left[i] - m_samples[1][i];
+					break;
+				case 9:
+					for (size_t i = 0; i < blockSize; ++i)
+						left[i] += m_samples[1][i];
+					break;
+				case 10:
+					for (size_t i = 0; i < blockSize; ++i) {
+						const auto side = m_samples[1][i];
+						const auto mid = left[i] * 2 | (side & 1);
+						left[i] = (mid + side) >> 1;
+						m_samples[1][i] = (mid - side) >> 1;
+					}
+					break;
+			}
+
+			const auto scale = 1.f / static_cast<float>(1ULL << (bitsPerSample - 1));
+			m_chunk.resize(blockSize * channels);
+			for (size_t i = 0, ptr = 0; i < blockSize; ++i) {
+				for (uint32_t c = 0; c < channels; ++c)
+					m_chunk[ptr++] = static_cast<float>(m_samples[c][i]) * scale;
+			}
+			return true;
+		}
+
+	public:
+		FlacDecoder(std::shared_ptr<const Sqex::RandomAccessStream> stream)
+			: m_stream(std::move(stream))
+			, m_data(GetDirectView(m_stream)) {
+			ReadMetadata();
+		}
+
+		[[nodiscard]] uint32_t Rate() const override {
+			return m_rate;
+		}
+
+		[[nodiscard]] uint32_t Channels() const override {
+			return m_channels;
+		}
+
+		[[nodiscard]] const std::map<std::string, std::string>& Tags() const override {
+			return m_tags;
+		}
+	};
+
+	class OggVorbisDecoder : public ChunkedPcmDecoder {
+		static constexpr size_t FeedSize = 65536;
+
+		// Vorbis channel order to ffmpeg channel order; ffmpeg channel i comes from Vorbis channel ChannelMap[channels - 1][i].
+		static constexpr uint8_t ChannelMap[8][8] = {
+			{0},
+			{0, 1},
+			{0, 2, 1},
+			{0, 1, 2, 3},
+			{0, 2, 1, 3, 4},
+			{0, 2, 1, 5, 3, 4},
+			{0, 2, 1, 6, 5, 3, 4},
+			{0, 2, 1, 7, 5, 6, 3, 4},
+		};
+
+		const std::shared_ptr<const Sqex::RandomAccessStream> m_stream;
+		const std::span<const uint8_t> m_data;
+		size_t m_offset = 0;
+
+		ogg_sync_state m_oy{};
+		ogg_stream_state m_os{};
+		vorbis_info m_vi{};
+		vorbis_comment m_vc{};
+		vorbis_dsp_state m_vd{};
+		vorbis_block m_vb{};
+		Utils::CallOnDestruction::Multiple m_cleanup;
+
+		std::map<std::string, std::string> m_tags;
+		uint64_t m_decodedSampleBlocks = 0;
+		bool m_ended = false;
+
+		bool ReadPage(ogg_page& og) {
+			while (true) {
+				if (const auto res = ogg_sync_pageout(&m_oy, &og); res == 1)
+					return true;
+				else if (res == -1)
+					continue;  // skipped garbage
+
+				if (m_offset == m_data.size())
+					return false;
+
+				const auto size = std::min(FeedSize, m_data.size() - m_offset);
+				const auto buffer = ogg_sync_buffer(&m_oy, static_cast<long>(size));
+				if (!buffer)
+					throw std::runtime_error("ogg_sync_buffer failed");
+				memcpy(buffer, &m_data[m_offset], size);
+				m_offset += size;
+				if (0 != ogg_sync_wrote(&m_oy, static_cast<long>(size)))
+					throw std::runtime_error("ogg_sync_wrote failed");
+			}
+		}
+
+		bool ReadPacket(ogg_packet& op) {
+			while (true) {
+				if (const auto res = ogg_stream_packetout(&m_os, &op); res == 1)
+					return true;
+				else if (res == -1)
+					continue;  // hole in data
+
+				ogg_page og{};
+				do {
+					if (!ReadPage(og))
+						return false;
+				} while (ogg_page_serialno(&og) != m_os.serialno);
+
+				if (0 != ogg_stream_pagein(&m_os, &og))
+					throw std::runtime_error("ogg_stream_pagein failed");
+			}
+		}
+
+	protected:
+		bool DecodeNextChunk() override {
+			const auto channels = static_cast<size_t>(m_vi.channels);
+
+			while (!m_ended) {
+				ogg_packet op{};
+				if (!ReadPacket(op))
+					return false;
+
+				if (vorbis_synthesis(&m_vb, &op) == 0)
+					vorbis_synthesis_blockin(&m_vd, &m_vb);
+
+				float** pcm = nullptr;
+				auto count = static_cast<size_t>(std::max(0, vorbis_synthesis_pcmout(&m_vd, &pcm)));
+
+				// Last page tells where the stream actually ends.
+				if (op.e_o_s) {
+					m_ended = true;
+					if (op.granulepos >= 0)
+						count = static_cast<size_t>(std::min<uint64_t>(count, std::max<int64_t>(0, op.granulepos - static_cast<int64_t>(m_decodedSampleBlocks))));
+				}
+
+				if (count) {
+					m_chunk.resize(count * channels);
+					for (size_t c = 0; c < channels; ++c) {
+						const auto src = pcm[channels <= 8 ? ChannelMap[channels - 1][c] : c];
+						for (size_t i = 0; i < count; ++i)
+							m_chunk[i * channels + c] = src[i];
+					}
+					vorbis_synthesis_read(&m_vd, static_cast<int>(count));
+					m_decodedSampleBlocks += count;
+					return true;
+				}
+			}
+			return false;
+		}
+
+	public:
+		OggVorbisDecoder(std::shared_ptr<const Sqex::RandomAccessStream> stream)
+			: m_stream(std::move(stream))
+			, m_data(GetDirectView(m_stream)) {
+			ogg_sync_init(&m_oy);
+			m_cleanup += [this] { ogg_sync_clear(&m_oy); };
+
+			vorbis_info_init(&m_vi);
+			m_cleanup += [this] { vorbis_info_clear(&m_vi); };
+
+			vorbis_comment_init(&m_vc);
+			m_cleanup += [this] { vorbis_comment_clear(&m_vc); };
+
+			ogg_page og{};
+			if (!ReadPage(og))
+				throw Sqex::CorruptDataException("No ogg page found");
+			if (0 != ogg_stream_init(&m_os, ogg_page_serialno(&og)))
+				throw std::runtime_error("ogg_stream_init failed");
+			m_cleanup += [this] { ogg_stream_clear(&m_os); };
+			if (0 != ogg_stream_pagein(&m_os, &og))
+				throw std::runtime_error("ogg_stream_pagein failed");
+
+			for (auto i = 0; i < 3; ++i) {
+				ogg_packet op{};
+				if (!ReadPacket(op))
+					throw Sqex::CorruptDataException("Unexpected end of vorbis headers");
+				if (const auto res = vorbis_synthesis_headerin(&m_vi, &m_vc, &op))
+					throw Sqex::CorruptDataException(std::format("vorbis_synthesis_headerin failed: {}", res));
+			}
+			if (m_vi.channels <= 0 || m_vi.rate <= 0)
+				throw Sqex::CorruptDataException("Invalid vorbis header");
+
+			for (auto i = 0; i < m_vc.comments; ++i) {
+				const auto comment = std::string(m_vc.user_comments[i], static_cast<size_t>(m_vc.comment_lengths[i]));
+				if (const auto eq = comment.find('='); eq != std::string::npos)
+					m_tags.insert_or_assign(comment.substr(0, eq), comment.substr(eq + 1));
+			}
+
+			if (const auto res = vorbis_synthesis_init(&m_vd, &m_vi))
+				throw std::runtime_error(std::format("vorbis_synthesis_init failed: {}", res));
+			m_cleanup += [this] { vorbis_dsp_clear(&m_vd); };
+
+			if (const auto res = vorbis_block_init(&m_vd, &m_vb))
+				throw std::runtime_error(std::format("vorbis_block_init failed: {}", res));
+			m_cleanup += [this] { vorbis_block_clear(&m_vb); };
+		}
+
+		[[nodiscard]] uint32_t Rate() const override {
+			return static_cast<uint32_t>(m_vi.rate);
+		}
+
+		[[nodiscard]] uint32_t Channels() const override {
+			return static_cast<uint32_t>(m_vi.channels);
+		}
+
+		[[nodiscard]] const std::map<std::string, std::string>& Tags() const override {
+			return m_tags;
+		}
+	};
+
+	class ResamplingPcmDecoder : public Sqex::Sound::PcmDecoder {
+		// Zero crossings of the sinc function on each side, at the lower of the two rates.
+		static constexpr size_t ZeroCrossings = 24;
+		static constexpr double KaiserBeta = 8.6;
+		static constexpr double PassBand = 0.95;
+
+		// Interpolation ratio such as 160:147 needs as many phases; anything finer than this is not worth a table.
+		static constexpr uint64_t MaxPhases = 4096;
+
+		static constexpr size_t ReadBlocks = 4096;
+
+		const std::unique_ptr<PcmDecoder> m_source;
+		const uint32_t m_rate;
+		const uint64_t m_up;
+		const uint64_t m_down;
+
+		// Taps of phase p are at [p * m_taps, (p + 1) * m_taps), for input samples from (center - m_halfTaps + 1).
+		size_t m_halfTaps{};
+		size_t m_taps{};
+		std::vector<float> m_filter;
+
+		// Planar, with m_history[c][0] being input sample block at m_historyStart.
+		std::vector<std::vector<float>> m_history;
+		int64_t m_historyStart{};
+
+		uint64_t m_inputBlocks = 0;
+		bool m_sourceEnded = false;
+		uint64_t m_nextOutputBlock = 0;
+		std::vector<float> m_output;
+
+		static double BesselI0(double x) {
+			double sum = 1, term = 1;
+			for (int k = 1; term > sum * 1e-12; ++k) {
+				term *= x * x / (4. * k * k);
+				sum += term;
+			}
+			return sum;
+		}
+
+		static float Dot(const float* a, const float* b, size_t count) {
+			auto sum = _mm_setzero_ps();
+			for (size_t i = 0; i < count; i += 4)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+			sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+			sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+			return _mm_cvtss_f32(sum);
+		}
+
+		// Makes sure that input sample blocks up to, but not including, end are in m_history.
+		void FillHistory(int64_t end) {
+			const auto channels = m_history.size();
+			while (m_historyStart + static_cast<int64_t>(m_history[0].size()) < end) {
+				if (m_sourceEnded) {
+					for (auto& h : m_history)
+						h.resize(static_cast<size_t>(end - m_historyStart), 0.f);
+					return;
+				}
+
+				const auto read = m_source->Read(ReadBlocks);
+				if (read.empty()) {
+					m_sourceEnded = true;
+					continue;
+				}
+
+				const auto blocks = read.size() / channels;
+				for (size_t c = 0; c < channels; ++c) {
+					auto& h = m_history[c];
+					const auto base = h.size();
+					h.resize(base + blocks);
+					for (size_t i = 0; i < blocks; ++i)
+						h[base + i] = read[i * channels + c];
+				}
+				m_inputBlocks += blocks;
+			}
+		}
+
+	public:
+		ResamplingPcmDecoder(std::unique_ptr<PcmDecoder> source, uint32_t rate)
+			: m_source(std::move(source))
+			, m_rate(rate)
+			, m_up(rate / std::gcd(rate, m_source->Rate()))
+			, m_down(m_source->Rate() / std::gcd(rate, m_source->Rate())) {
+			if (m_up > MaxPhases)
+				throw std::invalid_argument(std::format("Resampling from {}Hz to {}Hz is not supported", m_source->Rate(), rate));
+
+			// Cutoff relative to the input Nyquist frequency.
+			const auto cutoff = PassBand * std::min(1., static_cast<double>(m_up) / static_cast<double>(m_down));
+			m_halfTaps = static_cast<size_t>(std::ceil(ZeroCrossings / cutoff));
+			m_taps = (2 * m_halfTaps + 3) / 4 * 4;
+			m_filter.resize(m_up * m_taps);
+			for (uint64_t phase = 0; phase < m_up; ++phase) {
+				const auto filter = std::span(m_filter).subspan(phase * m_taps, m_taps);
+				double total = 0;
+				std::vector<double> weights(2 * m_halfTaps);
+				for (size_t tap = 0; tap < weights.size(); ++tap) {
+					// Distance from the output sample, in input samples.
+					const auto d = static_cast<double>(tap) - static_cast<double>(m_halfTaps - 1) - static_cast<double>(phase) / static_cast<double>(m_up);
+					const auto x = cutoff * d;
+					const auto sinc = x == 0 ? 1. : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+					const auto r = d / static_cast<double>(m_halfTaps);
+					const auto window = BesselI0(KaiserBeta * std::sqrt(std::max(0., 1. - r * r))) / BesselI0(KaiserBeta);
+					weights[tap] = sinc * window;
+					total += weights[tap];
+				}
+				for (size_t tap = 0; tap < weights.size(); ++tap)
+					filter[tap] = static_cast<float>(weights[tap] / total);
+			}
+
+			m_history.resize(m_source->Channels());
+			m_historyStart = 1 - static_cast<int64_t>(m_halfTaps);
+			for (auto& h : m_history)
+				h.resize(m_halfTaps - 1, 0.f);
+		}
+
+		[[nodiscard]] uint32_t Rate() const override {
+			return m_rate;
+		}
+
+		[[nodiscard]] uint32_t Channels() const override {
+			return m_source->Channels();
+		}
+
+		[[nodiscard]] const std::map<std::string, std::string>& Tags() const override {
+			return m_source->Tags();
+		}
+
+		std::span<const float> Read(size_t maxBlocks) override {
+			const auto channels = m_history.size();
+
+			// Forget input that no longer affects any output.
+			if (const auto unused = static_cast<int64_t>(m_nextOutputBlock * m_down / m_up) - static_cast<int64_t>(m_halfTaps - 1) - m_historyStart; unused > 65536) {
+				for (auto& h : m_history)
+					h.erase(h.begin(), h.begin() + static_cast<ptrdiff_t>(unused));
+				m_historyStart += unused;
+			}
+
+			m_output.resize(std::max<size_t>(1, maxBlocks) * channels);
+			size_t produced = 0;
+			for (; produced < m_output.size(); produced += channels) {
+				const auto center = m_nextOutputBlock * m_down / m_up;
+				const auto phase = m_nextOutputBlock * m_down % m_up;
+				const auto first = static_cast<int64_t>(center) - static_cast<int64_t>(m_halfTaps - 1);
+				FillHistory(first + static_cast<int64_t>(m_taps));
+				if (m_sourceEnded && m_nextOutputBlock >= (m_inputBlocks * m_up + m_down - 1) / m_down)
+					break;
+
+				const auto filter = &m_filter[static_cast<size_t>(phase) * m_taps];
+				for (size_t c = 0; c < channels; ++c)
+					m_output[produced + c] = Dot(&m_history[c][static_cast<size_t>(first - m_historyStart)], filter, m_taps);
+				++m_nextOutputBlock;
+			}
+			return std::span(m_output).subspan(0, produced);
+		}
+	};
+}
+
+const std::map<std::string, std::string>& Sqex::Sound::PcmDecoder::Tags() const {
+	static const std::map<std::string, std::string> empty;
+	return empty;
+}
+
+std::unique_ptr<Sqex::Sound::PcmDecoder> Sqex::Sound::PcmDecoder::TryCreate(std::shared_ptr<const RandomAccessStream> stream) {
+	if (stream->GetDirectView().size() != stream->StreamSize())
+		stream = std::make_shared<MemoryRandomAccessStream>(*stream);
+
+	const auto data = stream->GetDirectView();
+	if (data.size() >= 12 && memcmp(&data[0], "RIFF", 4) == 0 && memcmp(&data[8], "WAVE", 4) == 0)
+		return std::make_unique<WavPcmDecoder>(std::move(stream));
+	if (const auto offset = SkipId3v2Tag(data); data.size() >= offset + 4 && memcmp(&data[offset], "fLaC", 4) == 0)
+		return std::make_unique<FlacDecoder>(std::move(stream));
+
+	// First page of an Ogg Vorbis stream holds the identification header and nothing else.
+	if (data.size() >= 27 && memcmp(&data[0], "OggS", 4) == 0) {
+		if (const auto body = 27 + static_cast<size_t>(data[26]); data.size() >= body + 7 && memcmp(&data[body], "\x01vorbis", 7) == 0)
+			return std::make_unique<OggVorbisDecoder>(std::move(stream));
+	}
+	return nullptr;
+}
+
+std::unique_ptr<Sqex::Sound::PcmDecoder> Sqex::Sound::PcmDecoder::Resample(std::unique_ptr<PcmDecoder> source, uint32_t rate) {
+	if (source->Rate() == rate)
+		return source;
+	return std::make_unique<ResamplingPcmDecoder>(std::move(source), rate);
+}
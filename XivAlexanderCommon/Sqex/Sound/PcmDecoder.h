@@ -0,0 +1,34 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <mmreg.h>
+
+#include "XivAlexanderCommon/Sqex.h"
+
+namespace Sqex::Sound {
+	// Decodes audio into interleaved float samples, with channels in the order ffmpeg would output them.
+	class PcmDecoder {
+	public:
+		virtual ~PcmDecoder() = default;
+
+		[[nodiscard]] virtual uint32_t Rate() const = 0;
+		[[nodiscard]] virtual uint32_t Channels() const = 0;
+
+		// Metadata such as LoopStart and LoopEnd, with keys as stored in the file.
+		[[nodiscard]] virtual const std::map<std::string, std::string>& Tags() const;
+
+		// Returns between 1 and maxBlocks sample blocks, or an empty span at the end of the stream.
+		// Returned span stays valid until the next call.
+		virtual std::span<const float> Read(size_t maxBlocks) = 0;
+
+		// Supports WAV (PCM, IEEE float, and MS-ADPCM), FLAC, and Ogg Vorbis; returns nullptr for anything else.
+		[[nodiscard]] static std::unique_ptr<PcmDecoder> TryCreate(std::shared_ptr<const RandomAccessStream> stream);
+
+		// Converts to given sampling rate with a windowed sinc filter.
+		[[nodiscard]] static std::unique_ptr<PcmDecoder> Resample(std::unique_ptr<PcmDecoder> source, uint32_t rate);
+	};
+}
@@ -2,11 +2,17 @@
 
 #include "XivAlexanderCommon/Sqex/Sound/Reader.h"
 
-std::vector<uint8_t> Sqex::Sound::ScdReader::ReadEntry(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) const {
+std::shared_ptr<Sqex::RandomAccessStream> Sqex::Sound::ScdReader::GetEntryStream(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) const {
 	if (!offsets[index])
-		return {};
+		return std::make_shared<MemoryRandomAccessStream>();
 	const auto next = index == offsets.size() - 1 || offsets[index + 1] == 0 ? endOffset : offsets[index + 1];
-	return m_stream->ReadStreamIntoVector<uint8_t>(offsets[index], next - offsets[index]);
+	if (next < offsets[index])
+		throw CorruptDataException(std::format("entry #{} ends before it starts", index));
+	return std::make_shared<RandomAccessStreamPartialView>(m_stream, offsets[index], next - offsets[index]);
+}
+
+std::vector<uint8_t> Sqex::Sound::ScdReader::ReadEntry(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) const {
+	return GetEntryStream(offsets, endOffset, index)->ReadStreamIntoVector<uint8_t>(0);
 }
 
 std::vector<std::vector<uint8_t>> Sqex::Sound::ScdReader::ReadEntries(const std::span<const uint32_t>& offsets, uint32_t endOffset) const {
@@ -139,12 +145,26 @@ std::vector<uint8_t> Sqex::Sound::ScdReader::SoundEntry::GetOggFile() const {
 	return res;
 }
 
-Sqex::Sound::ScdReader::SoundEntry Sqex::Sound::ScdReader::GetSoundEntry(size_t entryIndex) const {
-	if (entryIndex >= m_soundEntryOffsets.size())
-		throw std::out_of_range("entry index >= sound entry count");
+Sqex::Sound::ScdReader::SoundEntryView::SoundEntryView(std::shared_ptr<const RandomAccessStream> stream)
+	: m_stream(std::move(stream)) {
+	if (m_stream->StreamSize() < sizeof m_header)
+		throw CorruptDataException("sound entry too small to fit its header");
+	m_stream->ReadStream(0, &m_header, sizeof m_header);
+	if (sizeof m_header + static_cast<uint64_t>(m_header.StreamOffset) + m_header.StreamSize > m_stream->StreamSize())
+		throw CorruptDataException("sound entry stream data goes past the end of the entry");
+}
+
+std::vector<uint8_t> Sqex::Sound::ScdReader::SoundEntryView::ReadHeaderBytes() const {
+	return m_stream->ReadStreamIntoVector<uint8_t>(0, sizeof m_header + m_header.StreamOffset);
+}
 
+std::shared_ptr<const Sqex::RandomAccessStream> Sqex::Sound::ScdReader::SoundEntryView::DataStream() const {
+	return std::make_shared<RandomAccessStreamPartialView>(m_stream, sizeof m_header + m_header.StreamOffset, m_header.StreamSize);
+}
+
+Sqex::Sound::ScdReader::SoundEntry Sqex::Sound::ScdReader::SoundEntryView::Read() const {
 	SoundEntry res{
-		.Buffer = ReadEntry(m_soundEntryOffsets, m_endOfSoundEntries, static_cast<uint32_t>(entryIndex)),
+		.Buffer = m_stream->ReadStreamIntoVector<uint8_t>(0),
 		.Header = reinterpret_cast<SoundEntryHeader*>(&res.Buffer[0]),
 	};
 	auto pos = sizeof * res.Header;
@@ -156,3 +176,14 @@ Sqex::Sound::ScdReader::SoundEntry Sqex::Sound::ScdReader::GetSoundEntry(size_t
 	res.Data = std::span(res.Buffer).subspan(sizeof * res.Header + res.Header->StreamOffset, res.Header->StreamSize);
 	return res;
 }
+
+Sqex::Sound::ScdReader::SoundEntry Sqex::Sound::ScdReader::GetSoundEntry(size_t entryIndex) const {
+	return GetSoundEntryView(entryIndex).Read();
+}
+
+Sqex::Sound::ScdReader::SoundEntryView Sqex::Sound::ScdReader::GetSoundEntryView(size_t entryIndex) const {
+	if (entryIndex >= m_soundEntryOffsets.size())
+		throw std::out_of_range("entry index >= sound entry count");
+
+	return SoundEntryView(GetEntryStream(m_soundEntryOffsets, m_endOfSoundEntries, entryIndex));
+}
@@ -22,6 +22,7 @@ namespace Sqex::Sound {
 		const uint32_t m_endOfTable1;
 		const uint32_t m_endOfTable4;
 
+		[[nodiscard]] std::shared_ptr<RandomAccessStream> GetEntryStream(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) const;
 		[[nodiscard]] std::vector<uint8_t> ReadEntry(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) const;
 		[[nodiscard]] std::vector<std::vector<uint8_t>> ReadEntries(const std::span<const uint32_t>& offsets, uint32_t endOffset) const;
 
@@ -47,6 +48,27 @@ namespace Sqex::Sound {
 			[[nodiscard]] std::vector<uint8_t> GetOggFile() const;
 		};
 
+		// Sound entry that only reads its header until more is asked for.
+		class SoundEntryView {
+			std::shared_ptr<const RandomAccessStream> m_stream;
+			SoundEntryHeader m_header;
+
+		public:
+			SoundEntryView(std::shared_ptr<const RandomAccessStream> stream);
+
+			[[nodiscard]] const SoundEntryHeader& Header() const { return m_header; }
+
+			// Whole entry, including header, aux chunks, extra data, and stream data.
+			[[nodiscard]] const std::shared_ptr<const RandomAccessStream>& EntryStream() const { return m_stream; }
+
+			// Everything before stream data.
+			[[nodiscard]] std::vector<uint8_t> ReadHeaderBytes() const;
+
+			[[nodiscard]] std::shared_ptr<const RandomAccessStream> DataStream() const;
+
+			[[nodiscard]] SoundEntry Read() const;
+		};
+
 		[[nodiscard]] std::vector<std::vector<uint8_t>> ReadTable1Entries() const {
 			return ReadEntries(m_offsetsTable1, m_endOfTable1);
 		}
@@ -72,5 +94,6 @@ namespace Sqex::Sound {
 
 		[[nodiscard]] size_t GetSoundEntryCount() const { return m_soundEntryOffsets.size(); }
 		[[nodiscard]] SoundEntry GetSoundEntry(size_t entryIndex) const;
+		[[nodiscard]] SoundEntryView GetSoundEntryView(size_t entryIndex) const;
 	};
 }
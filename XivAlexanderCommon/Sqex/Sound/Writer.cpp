@@ -1,6 +1,64 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/Sound/Writer.h"
 
+namespace {
+	// Offset tables and tables other than sound entries, followed by sound entries read from where they are stored.
+	class ExportedScdStream : public Sqex::RandomAccessStream {
+		const std::vector<uint8_t> m_head;
+		const std::vector<std::shared_ptr<const Sqex::RandomAccessStream>> m_entries;
+		std::vector<uint64_t> m_entryOffsets;
+		const uint64_t m_size;
+
+	public:
+		ExportedScdStream(std::vector<uint8_t> head, std::vector<std::shared_ptr<const Sqex::RandomAccessStream>> entries, uint64_t size)
+			: m_head(std::move(head))
+			, m_entries(std::move(entries))
+			, m_size(size) {
+			m_entryOffsets.reserve(m_entries.size() + 1);
+			m_entryOffsets.push_back(m_head.size());
+			for (const auto& entry : m_entries)
+				m_entryOffsets.push_back(m_entryOffsets.back() + entry->StreamSize());
+		}
+
+		[[nodiscard]] uint64_t StreamSize() const override { return m_size; }
+
+		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+			if (offset >= m_size)
+				return 0;
+			length = std::min(length, m_size - offset);
+			auto out = std::span(static_cast<uint8_t*>(buf), static_cast<size_t>(length));
+
+			if (offset < m_head.size()) {
+				const auto available = std::min(out.size(), static_cast<size_t>(m_head.size() - offset));
+				std::copy_n(&m_head[static_cast<size_t>(offset)], available, out.begin());
+				out = out.subspan(available);
+				offset += available;
+			}
+
+			// Last entry starting at or before offset; empty entries before it get skipped.
+			auto i = static_cast<size_t>(std::ranges::upper_bound(m_entryOffsets, offset) - m_entryOffsets.begin()) - 1;
+			for (; !out.empty() && i < m_entries.size(); ++i) {
+				const auto available = static_cast<size_t>(std::min<uint64_t>(out.size(), m_entryOffsets[i + 1] - offset));
+				m_entries[i]->ReadStream(offset - m_entryOffsets[i], out.data(), available);
+				out = out.subspan(available);
+				offset += available;
+			}
+
+			// Alignment padding at the end.
+			std::ranges::fill(out, 0);
+			return length;
+		}
+
+		[[nodiscard]] uint64_t ReadAheadBoundary(uint64_t offset) const override {
+			if (offset < m_head.size())
+				return m_head.size();
+
+			const auto i = static_cast<size_t>(std::ranges::upper_bound(m_entryOffsets, offset) - m_entryOffsets.begin());
+			return i < m_entryOffsets.size() ? m_entryOffsets[i] : m_size;
+		}
+	};
+}
+
 Sqex::Sound::ScdWriter::SoundEntry Sqex::Sound::ScdWriter::SoundEntry::FromWave(const std::function<std::span<uint8_t>(size_t len, bool throwOnIncompleteRead)>& reader) {
 	struct ExpectedFormat {
 		LE<uint32_t> Riff;
@@ -262,13 +320,26 @@ void Sqex::Sound::ScdWriter::SetTable5(std::vector<std::vector<uint8_t>> t) {
 	m_table5 = std::move(t);
 }
 
-void Sqex::Sound::ScdWriter::SetSoundEntry(size_t index, SoundEntry entry) {
+void Sqex::Sound::ScdWriter::SetSoundEntry(size_t index, const SoundEntry& entry) {
+	std::vector<uint8_t> buf;
+	entry.ExportTo(buf);
+
+	if (m_soundEntries.size() <= index)
+		m_soundEntries.resize(index + 1);
+	m_soundEntries[index] = std::make_shared<MemoryRandomAccessStream>(std::move(buf));
+}
+
+void Sqex::Sound::ScdWriter::SetSoundEntry(size_t index, const ScdReader::SoundEntryView& entry) {
 	if (m_soundEntries.size() <= index)
 		m_soundEntries.resize(index + 1);
-	m_soundEntries[index] = std::move(entry);
+	m_soundEntries[index] = entry.EntryStream();
 }
 
 std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
+	return ExportStream()->ReadStreamIntoVector<uint8_t>(0);
+}
+
+std::shared_ptr<Sqex::RandomAccessStream> Sqex::Sound::ScdWriter::ExportStream() const {
 	if (m_table1.size() != m_table4.size())
 		throw std::invalid_argument("table1.size != table4.size");
 
@@ -279,19 +350,16 @@ std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
 	const auto table5OffsetsOffset = Sqex::Align<size_t>(table4OffsetsOffset + sizeof uint32_t * (1 + m_table4.size()), 0x10).Alloc;
 
 	std::vector<uint8_t> res;
-	size_t requiredSize = table5OffsetsOffset + sizeof uint32_t * 4;
+	size_t headSize = table5OffsetsOffset + sizeof uint32_t * 4;
 	for (const auto& item : m_table4)
-		requiredSize += item.size();
+		headSize += item.size();
 	for (const auto& item : m_table1)
-		requiredSize += item.size();
+		headSize += item.size();
 	for (const auto& item : m_table2)
-		requiredSize += item.size();
+		headSize += item.size();
 	for (const auto& item : m_table5)
-		requiredSize += item.size();
-	for (const auto& item : m_soundEntries)
-		requiredSize += item.CalculateEntrySize();
-	requiredSize = Sqex::Align<size_t>(requiredSize, 0x10).Alloc;
-	res.reserve(requiredSize);
+		headSize += item.size();
+	res.reserve(headSize);
 
 	res.resize(table5OffsetsOffset + sizeof uint32_t * 4);
 
@@ -313,10 +381,28 @@ std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
 		reinterpret_cast<uint32_t*>(&res[table5OffsetsOffset])[i] = static_cast<uint32_t>(res.size());
 		res.insert(res.end(), m_table5[i].begin(), m_table5[i].end());
 	}
+
+	std::vector<std::shared_ptr<const RandomAccessStream>> entries;
+	entries.reserve(m_soundEntries.size());
+	std::shared_ptr<const RandomAccessStream> defaultEntry;
+	auto entryOffset = static_cast<uint64_t>(res.size());
 	for (size_t i = 0; i < m_soundEntries.size(); ++i) {
-		reinterpret_cast<uint32_t*>(&res[soundEntryOffsetsOffset])[i] = static_cast<uint32_t>(res.size());
-		m_soundEntries[i].ExportTo(res);
+		auto entry = m_soundEntries[i];
+		if (!entry) {
+			if (!defaultEntry) {
+				std::vector<uint8_t> buf;
+				SoundEntry().ExportTo(buf);
+				defaultEntry = std::make_shared<MemoryRandomAccessStream>(std::move(buf));
+			}
+			entry = defaultEntry;
+		}
+		reinterpret_cast<uint32_t*>(&res[soundEntryOffsetsOffset])[i] = static_cast<uint32_t>(entryOffset);
+		entryOffset += entry->StreamSize();
+		entries.emplace_back(std::move(entry));
 	}
+	const auto requiredSize = Sqex::Align<uint64_t>(entryOffset, 0x10).Alloc;
+	if (requiredSize > UINT32_MAX)
+		throw std::invalid_argument("resulting scd file is too big");
 
 	*reinterpret_cast<ScdHeader*>(&res[0]) = {
 		.SedbVersion = ScdHeader::SedbVersion_FFXIV,
@@ -344,7 +430,5 @@ std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
 		.Unknown_0x01C = 0,  // ?
 	};
 
-	res.resize(requiredSize);
-
-	return res;
+	return std::make_shared<ExportedScdStream>(std::move(res), std::move(entries), requiredSize);
 }
@@ -4,6 +4,7 @@
 
 #include "XivAlexanderCommon/Sqex.h"
 #include "XivAlexanderCommon/Sqex/Sound.h"
+#include "XivAlexanderCommon/Sqex/Sound/Reader.h"
 
 namespace Sqex::Sound {
 	class ScdWriter {
@@ -42,7 +43,7 @@ namespace Sqex::Sound {
 	private:
 		std::vector<std::vector<uint8_t>> m_table1;
 		std::vector<std::vector<uint8_t>> m_table2;
-		std::vector<SoundEntry> m_soundEntries;
+		std::vector<std::shared_ptr<const RandomAccessStream>> m_soundEntries;
 		std::vector<std::vector<uint8_t>> m_table4;
 		std::vector<std::vector<uint8_t>> m_table5;
 
@@ -51,9 +52,15 @@ namespace Sqex::Sound {
 		void SetTable2(std::vector<std::vector<uint8_t>> t);
 		void SetTable4(std::vector<std::vector<uint8_t>> t);
 		void SetTable5(std::vector<std::vector<uint8_t>> t);
-		void SetSoundEntry(size_t index, SoundEntry entry);
+		void SetSoundEntry(size_t index, const SoundEntry& entry);
+
+		// Entry gets copied as-is from the stream it is backed by when the result is read.
+		void SetSoundEntry(size_t index, const ScdReader::SoundEntryView& entry);
 
 		[[nodiscard]] std::vector<uint8_t> Export() const;
+
+		// Sound entries are not copied, and are read from their sources as the returned stream is read.
+		[[nodiscard]] std::shared_ptr<RandomAccessStream> ExportStream() const;
 	};
 
 }
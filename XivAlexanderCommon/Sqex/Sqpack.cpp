@@ -274,29 +274,51 @@ uint64_t Sqex::Sqpack::SqData::FileEntryHeader::GetTotalEntrySize() const {
 	return HeaderSize + GetDataSize();
 }
 
+// Lowercases A-Z and turns '\\' into '/' for all four bytes of a little endian word at once.
+static uint32_t SqexHashNormalizeWord(uint32_t word) {
+	constexpr uint32_t Ones = 0x01010101U;
+	constexpr uint32_t HighBits = 0x80808080U;
+	const auto low7 = word & ~HighBits;
+
+	// high bit of each byte set if the byte is in range of A-Z
+	const auto upper = (low7 + (0x80 - 'A') * Ones) & ~(low7 + (0x80 - 'Z' - 1) * Ones) & ~word & HighBits;
+
+	// high bit of each byte set if the byte is a backslash
+	const auto diff = word ^ ('\\' * Ones);
+	const auto backslash = ~(((diff & ~HighBits) + ~HighBits) | diff | ~HighBits);
+
+	return word ^ (upper >> 2) ^ ((backslash >> 7) * ('\\' ^ '/'));
+}
+
 uint32_t Sqex::Sqpack::SqexHash(const char* data, size_t len) {
+	if (len == SIZE_MAX)
+		len = std::strlen(data);
+
 	if (len > UINT32_MAX)
 		return EntryPathSpec::EmptyHashValue;
 
-	if (len == SIZE_MAX) {
-		len = 0;
-		while (data[len])
-			len++;
+	// Equivalent to ~crc32(0, normalized, len): CRC32 without the final inversion.
+	const auto ptr = reinterpret_cast<const uint8_t*>(data);
+	uint32_t crc = 0xFFFFFFFFU;
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		uint32_t word;
+		std::memcpy(&word, ptr + i, sizeof word);
+		crc ^= SqexHashNormalizeWord(word);
+		crc = SqexHashTable[3][crc & 0xFF]
+			^ SqexHashTable[2][(crc >> 8) & 0xFF]
+			^ SqexHashTable[1][(crc >> 16) & 0xFF]
+			^ SqexHashTable[0][crc >> 24];
 	}
-
-	const auto buf = static_cast<char*>(_malloca(len));
-	if (!buf)
-		return EntryPathSpec::EmptyHashValue;
-
-	for (size_t i = 0; i < len; i++) {
-		auto& c = buf[i] = data[i];
+	for (; i < len; ++i) {
+		auto c = ptr[i];
 		if ('A' <= c && c <= 'Z')
-			c -= 'A' - 'a';
+			c += 'a' - 'A';
 		else if (c == '\\')
 			c = '/';
+		crc = SqexHashTable[0][(crc ^ c) & 0xFF] ^ (crc >> 8);
 	}
-
-	return ~crc32(0, reinterpret_cast<Bytef*>(buf), static_cast<uint32_t>(len));
+	return crc;
 }
 
 uint32_t Sqex::Sqpack::SqexHash(const std::string& text) {
@@ -25,14 +25,19 @@ uint64_t Sqex::Sqpack::BinaryStreamDecoder::ReadStreamPartial(uint64_t offset, v
 	if (!length)
 		return 0;
 
+	const auto lock = std::lock_guard(m_readMtx);
 	auto it = static_cast<size_t>(std::distance(m_offsets.begin(), std::ranges::lower_bound(m_offsets, static_cast<uint32_t>(offset))));
 	if (it && (it == m_offsets.size() || (it != m_offsets.size() && m_offsets[it] > offset)))
 		--it;
 
+	std::vector<uint32_t> touchedBlockOffsets;
+	for (auto i = it; i < m_offsets.size() && m_offsets[i] < offset + length; ++i)
+		touchedBlockOffsets.emplace_back(m_blockOffsets[i]);
+	PrefetchBlocks(std::move(touchedBlockOffsets));
+
 	ReadStreamState info{
-		.Underlying = *m_stream,
+		.Decoder = *this,
 		.TargetBuffer = std::span(static_cast<uint8_t*>(buf), static_cast<size_t>(length)),
-		.ReadBuffer = std::vector<uint8_t>(m_maxBlockSize),
 		.RelativeOffset = offset - m_offsets[it],
 		.RequestOffsetVerify = m_offsets[it],
 	};
@@ -43,6 +48,5 @@ uint64_t Sqex::Sqpack::BinaryStreamDecoder::ReadStreamPartial(uint64_t offset, v
 			break;
 	}
 
-	m_maxBlockSize = info.ReadBuffer.size();
 	return length - info.TargetBuffer.size_bytes();
 }
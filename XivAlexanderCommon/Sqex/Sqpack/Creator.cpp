@@ -11,10 +11,11 @@
 #include "XivAlexanderCommon/Sqex/Sqpack/Reader.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/TextureEntryProvider.h"
 #include "XivAlexanderCommon/Sqex/ThirdParty/TexTools.h"
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
 
 struct Sqex::Sqpack::Creator::Implementation {
-	void AddEntry(AddEntryResult& result, std::shared_ptr<EntryProvider> provider, bool overwriteExisting = true);
-	AddEntryResult AddEntry(std::shared_ptr<EntryProvider> provider, bool overwriteExisting = true);
+	void AddEntry(AddEntryResult& result, std::shared_ptr<EntryProvider> provider, bool overwriteExisting = true, EntrySource source = {});
+	AddEntryResult AddEntry(std::shared_ptr<EntryProvider> provider, bool overwriteExisting = true, EntrySource source = {});
 
 	Creator* const this_;
 
@@ -90,7 +91,7 @@ std::vector<Sqex::Sqpack::EntryProvider*> Sqex::Sqpack::Creator::AddEntryResult:
 	return res;
 }
 
-void Sqex::Sqpack::Creator::Implementation::AddEntry(AddEntryResult & result, std::shared_ptr<EntryProvider> provider, bool overwriteExisting) {
+void Sqex::Sqpack::Creator::Implementation::AddEntry(AddEntryResult & result, std::shared_ptr<EntryProvider> provider, bool overwriteExisting, EntrySource source) {
 	const auto pProvider = provider.get();
 
 	try {
@@ -114,11 +115,12 @@ void Sqex::Sqpack::Creator::Implementation::AddEntry(AddEntryResult & result, st
 				return;
 			}
 			pEntry->Provider = std::move(provider);
+			pEntry->Source = std::move(source);
 			result.Replaced.emplace_back(pProvider);
 			return;
 		}
 
-		auto entry = std::make_unique<Entry>(0, SqIndex::LEDataLocator{ 0, 0 }, std::move(provider));
+		auto entry = std::make_unique<Entry>(0, SqIndex::LEDataLocator{ 0, 0 }, std::move(provider), std::move(source));
 		if (pProvider->PathSpec().HasOriginal())
 			m_fullEntries.emplace(pProvider->PathSpec(), std::move(entry));
 		else
@@ -129,9 +131,9 @@ void Sqex::Sqpack::Creator::Implementation::AddEntry(AddEntryResult & result, st
 	}
 }
 
-Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::Implementation::AddEntry(std::shared_ptr<EntryProvider> provider, bool overwriteExisting) {
+Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::Implementation::AddEntry(std::shared_ptr<EntryProvider> provider, bool overwriteExisting, EntrySource source) {
 	AddEntryResult result;
-	AddEntry(result, std::move(provider), overwriteExisting);
+	AddEntry(result, std::move(provider), overwriteExisting, std::move(source));
 	return result;
 }
 
@@ -143,10 +145,19 @@ Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddEntriesFromSqPac
 		m_pImpl->m_sqpackIndex2Segment3 = { reader.Index2.Segment3.begin(), reader.Index2.Segment3.end() };
 	}
 
+	std::vector<std::filesystem::path> dataPaths;
+	for (size_t i = 0; i < reader.Data.size(); ++i)
+		dataPaths.emplace_back(std::filesystem::path(indexPath).replace_extension(std::format(".dat{}", i)));
+
 	AddEntryResult result;
 	for (const auto& [locator, entryInfo] : reader.EntryInfo) {
 		try {
-			m_pImpl->AddEntry(result, reader.GetEntryProvider(entryInfo.PathSpec, locator, entryInfo.Allocation), overwriteExisting);
+			m_pImpl->AddEntry(result, reader.GetEntryProvider(entryInfo.PathSpec, locator, entryInfo.Allocation), overwriteExisting, {
+				.Type = EntrySource::SourceType::StreamView,
+				.Path = dataPaths.at(locator.DatFileIndex),
+				.Offset = locator.DatFileOffset(),
+				.Size = entryInfo.Allocation,
+			});
 		} catch (const std::exception& e) {
 			result.Error.emplace_back(entryInfo.PathSpec, e.what());
 		}
@@ -156,18 +167,23 @@ Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddEntriesFromSqPac
 
 Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddEntryFromFile(EntryPathSpec pathSpec, const std::filesystem::path & path, bool overwriteExisting) {
 	std::shared_ptr<EntryProvider> provider;
+	EntrySource source{ .Path = path };
 	auto extensionLower = path.extension().wstring();
 	CharLowerW(&extensionLower[0]);
 	if (file_size(path) == 0) {
 		provider = std::make_shared<EmptyOrObfuscatedEntryProvider>(std::move(pathSpec));
+		source.Type = EntrySource::SourceType::Empty;
 	} else if (extensionLower == L".tex" || extensionLower == L".atex") {
 		provider = std::make_shared<OnTheFlyTextureEntryProvider>(std::move(pathSpec), path);
+		source.Type = EntrySource::SourceType::TextureFile;
 	} else if (extensionLower == L".mdl") {
 		provider = std::make_shared<OnTheFlyModelEntryProvider>(std::move(pathSpec), path);
+		source.Type = EntrySource::SourceType::ModelFile;
 	} else {
 		provider = std::make_shared<OnTheFlyBinaryEntryProvider>(std::move(pathSpec), path);
+		source.Type = EntrySource::SourceType::BinaryFile;
 	}
-	return m_pImpl->AddEntry(provider, overwriteExisting);
+	return m_pImpl->AddEntry(provider, overwriteExisting, std::move(source));
 }
 
 Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddAllEntriesFromSimpleTTMP(const std::filesystem::path & extractedDir, bool overwriteExisting) {
@@ -186,7 +202,12 @@ Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddAllEntriesFromSi
 			continue;
 
 		try {
-			m_pImpl->AddEntry(result, std::make_shared<RandomAccessStreamAsEntryProviderView>(entry.FullPath, dataStream, entry.ModOffset, entry.ModSize), overwriteExisting);
+			m_pImpl->AddEntry(result, std::make_shared<RandomAccessStreamAsEntryProviderView>(entry.FullPath, dataStream, entry.ModOffset, entry.ModSize), overwriteExisting, {
+				.Type = EntrySource::SourceType::StreamView,
+				.Path = ttmpdPath,
+				.Offset = entry.ModOffset,
+				.Size = entry.ModSize,
+			});
 		} catch (const std::exception& e) {
 			result.Error.emplace_back(EntryPathSpec{ entry.FullPath }, std::string(e.what()));
 			m_pImpl->Log("Error: {} (Name: {} > {})", entry.FullPath, ttmpl.Name, entry.Name);
@@ -247,6 +268,7 @@ Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddEntry(std::share
 void Sqex::Sqpack::Creator::ReserveSwappableSpace(EntryPathSpec pathSpec, uint32_t size) {
 	if (const auto it = m_pImpl->m_fullEntries.find(pathSpec); it != m_pImpl->m_fullEntries.end()) {
 		it->second->EntrySize = std::max(it->second->EntrySize, size);
+		it->second->Swappable = true;
 		return;
 	}
 
@@ -257,6 +279,7 @@ void Sqex::Sqpack::Creator::ReserveSwappableSpace(EntryPathSpec pathSpec, uint32
 		it = m_pImpl->m_hashOnlyEntries.find(EntryPathSpec(pathSpec.PathHash, pathSpec.NameHash));
 	if (it != m_pImpl->m_hashOnlyEntries.end()) {
 		it->second->EntrySize = std::max(it->second->EntrySize, size);
+		it->second->Swappable = true;
 		if (!it->second->Provider->PathSpec().HasOriginal() && pathSpec.HasOriginal()) {
 			it->second->Provider->UpdatePathSpec(pathSpec);
 			m_pImpl->m_fullEntries.emplace(pathSpec, std::move(it->second));
@@ -265,7 +288,7 @@ void Sqex::Sqpack::Creator::ReserveSwappableSpace(EntryPathSpec pathSpec, uint32
 		return;
 	}
 
-	auto entry = std::make_unique<Entry>(size, SqIndex::LEDataLocator{ 0, 0 }, std::make_shared<EmptyOrObfuscatedEntryProvider>(std::move(pathSpec)));
+	auto entry = std::make_unique<Entry>(size, SqIndex::LEDataLocator{ 0, 0 }, std::make_shared<EmptyOrObfuscatedEntryProvider>(std::move(pathSpec)), EntrySource{ .Type = EntrySource::SourceType::Empty }, true);
 	if (entry->Provider->PathSpec().HasOriginal())
 		m_pImpl->m_fullEntries.emplace(entry->Provider->PathSpec(), std::move(entry));
 	else
@@ -377,11 +400,13 @@ class Sqex::Sqpack::Creator::DataView : public RandomAccessStream {
 		return buffer;
 	}
 
+	// Diagnostics only; reads may come from multiple threads at once.
+	mutable std::mutex m_lastRequestMtx;
 	mutable uint64_t m_nLastRequestedOffset = 0;
 	mutable uint64_t m_nLastRequestedSize = 0;
 	mutable uint64_t m_nLastTimeTaken = 0;
 	mutable std::vector<std::tuple<EntryProvider*, uint64_t, uint64_t>> m_pLastEntryProviders;
-	mutable size_t m_lastAccessedEntryIndex = SIZE_MAX;
+	mutable std::atomic<size_t> m_lastAccessedEntryIndex = SIZE_MAX;
 	const std::shared_ptr<SqpackViewEntryCache> m_buffer;
 
 public:
@@ -392,14 +417,39 @@ public:
 		, m_buffer(std::move(buffer)) {
 	}
 
-	uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
-		const auto st = Utils::QpcUs();
-		m_pLastEntryProviders.clear();
+	std::span<Entry*>::iterator FindEntry(uint64_t absoluteOffset) const {
+		if (m_entries.empty())
+			return m_entries.end();
+
+		const auto lastIndex = m_lastAccessedEntryIndex.load(std::memory_order_relaxed);
+		auto it = lastIndex != SIZE_MAX ? m_entries.begin() + lastIndex : m_entries.begin();
+		if ((*it)->Locator.DatFileOffset() > absoluteOffset || absoluteOffset >= (*it)->Locator.DatFileOffset() + (*it)->EntrySize) {
+			it = std::ranges::lower_bound(m_entries, nullptr, [&](Entry* l, Entry* r) {
+				const auto lo = l ? l->Locator.DatFileOffset() : absoluteOffset;
+				const auto ro = r ? r->Locator.DatFileOffset() : absoluteOffset;
+				return lo < ro;
+				});
+			if (it != m_entries.begin() && (it == m_entries.end() || (*it)->Locator.DatFileOffset() > absoluteOffset))
+				--it;
+		}
+		return it;
+	}
+
+	void SetLastRequest(uint64_t offset, uint64_t length, uint64_t timeTaken, std::vector<std::tuple<EntryProvider*, uint64_t, uint64_t>> providers) const {
+		const auto lock = std::lock_guard(m_lastRequestMtx);
 		m_nLastRequestedOffset = offset;
 		m_nLastRequestedSize = length;
-		m_nLastTimeTaken = 0;
-		if (!length)
+		m_nLastTimeTaken = timeTaken;
+		m_pLastEntryProviders = std::move(providers);
+	}
+
+	uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+		const auto st = Utils::QpcUs();
+		std::vector<std::tuple<EntryProvider*, uint64_t, uint64_t>> providers;
+		if (!length) {
+			SetLastRequest(offset, length, 0, std::move(providers));
 			return 0;
+		}
 
 		auto relativeOffset = offset;
 		auto out = std::span(static_cast<char*>(buf), static_cast<size_t>(length));
@@ -414,36 +464,22 @@ public:
 			relativeOffset -= m_header.size();
 
 		if (out.empty()) {
-			m_nLastTimeTaken = Utils::QpcUs() - st;
+			SetLastRequest(offset, length, Utils::QpcUs() - st, std::move(providers));
 			return length;
 		}
 
-		auto it = m_lastAccessedEntryIndex != SIZE_MAX ? m_entries.begin() + m_lastAccessedEntryIndex : m_entries.begin();
-		if (const auto absoluteOffset = relativeOffset + m_header.size();
-			(*it)->Locator.DatFileOffset() > absoluteOffset || absoluteOffset >= (*it)->Locator.DatFileOffset() + (*it)->EntrySize) {
-			it = std::ranges::lower_bound(m_entries, nullptr, [&](Entry* l, Entry* r) {
-				const auto lo = l ? l->Locator.DatFileOffset() : absoluteOffset;
-				const auto ro = r ? r->Locator.DatFileOffset() : absoluteOffset;
-				return lo < ro;
-				});
-			if (it != m_entries.begin() && (it == m_entries.end() || (*it)->Locator.DatFileOffset() > absoluteOffset))
-				--it;
-		}
-
-		if (it != m_entries.end()) {
+		if (auto it = FindEntry(relativeOffset + m_header.size()); it != m_entries.end()) {
 			relativeOffset -= (*it)->Locator.DatFileOffset() - m_header.size();
 
 			for (; it < m_entries.end(); ++it) {
 				const auto& entry = **it;
-				m_lastAccessedEntryIndex = it - m_entries.begin();
-
-				const auto buf = m_buffer ? m_buffer->GetBuffer(this, &entry) : nullptr;
+				m_lastAccessedEntryIndex.store(it - m_entries.begin(), std::memory_order_relaxed);
 
 				if (relativeOffset < entry.EntrySize) {
 					const auto available = std::min(out.size_bytes(), static_cast<size_t>(entry.EntrySize - relativeOffset));
-					m_pLastEntryProviders.emplace_back(std::make_tuple(entry.Provider.get(), relativeOffset, available));
-					if (buf)
-						std::copy_n(&buf->Buffer()[static_cast<size_t>(relativeOffset)], available, &out[0]);
+					providers.emplace_back(std::make_tuple(entry.Provider.get(), relativeOffset, available));
+					if (const auto buf = m_buffer ? m_buffer->GetBuffer(this, &entry) : SqpackViewEntryCache::PinnedEntry())
+						std::copy_n(&buf.Buffer()[static_cast<size_t>(relativeOffset)], available, &out[0]);
 					else
 						entry.Provider->ReadStream(relativeOffset, out.data(), available);
 					out = out.subspan(available);
@@ -456,7 +492,7 @@ public:
 			}
 		}
 
-		m_nLastTimeTaken = Utils::QpcUs() - st;
+		SetLastRequest(offset, length, Utils::QpcUs() - st, std::move(providers));
 		return length - out.size_bytes();
 	}
 
@@ -464,7 +500,18 @@ public:
 		return m_header.size() + SubHeader().DataSize;
 	}
 
+	uint64_t ReadAheadBoundary(uint64_t offset) const override {
+		if (offset < m_header.size())
+			return m_header.size();
+
+		const auto it = FindEntry(offset);
+		if (it == m_entries.end())
+			return StreamSize();
+		return std::min(StreamSize(), (*it)->Locator.DatFileOffset() + (*it)->EntrySize);
+	}
+
 	std::string DescribeState() const override {
+		const auto lock = std::lock_guard(m_lastRequestMtx);
 		auto res = std::format("Sqpack::Creator::DataView({}->{}) {}us", m_nLastRequestedOffset, m_nLastRequestedSize, m_nLastTimeTaken);
 		for (const auto& [p, off, len] : m_pLastEntryProviders) {
 			res += std::format(" [{}: {}->{}: {}]", p->PathSpec(), off, len, p->DescribeState());
@@ -478,6 +525,78 @@ public:
 	}
 };
 
+// Points DuplicateOf of entries to an earlier entry whose payload is known to be identical.
+static void FindEntriesWithSamePayload(std::span<Sqex::Sqpack::Creator::Entry* const> entries) {
+	using Entry = Sqex::Sqpack::Creator::Entry;
+	using SourceType = Sqex::Sqpack::Creator::EntrySource::SourceType;
+
+	// Same range of the same file; covers paths sharing a region in game files, and mod entries sharing data.
+	std::map<std::tuple<std::filesystem::path, uint64_t, uint64_t>, Entry*> views;
+
+	// Group files by type and size first, so that only files that may have a match get read.
+	std::map<std::pair<SourceType, uint64_t>, std::vector<Entry*>> filesBySize;
+
+	for (const auto entry : entries) {
+		if (entry->Swappable)
+			continue;
+
+		switch (entry->Source.Type) {
+			case SourceType::StreamView:
+				if (const auto [it, inserted] = views.emplace(std::make_tuple(entry->Source.Path, entry->Source.Offset, entry->Source.Size), entry); !inserted) {
+					entry->DuplicateOf = it->second;
+					it->second->HasDuplicates = true;
+				}
+				break;
+
+			case SourceType::TextureFile:
+			case SourceType::ModelFile:
+			case SourceType::BinaryFile: {
+				std::error_code ec;
+				if (const auto size = file_size(entry->Source.Path, ec); !ec)
+					filesBySize[std::make_pair(entry->Source.Type, size)].emplace_back(entry);
+				break;
+			}
+		}
+	}
+
+	std::vector<Entry*> candidates;
+	for (const auto& group : filesBySize | std::views::values) {
+		if (group.size() > 1)
+			candidates.insert(candidates.end(), group.begin(), group.end());
+	}
+	if (candidates.empty())
+		return;
+
+	std::vector<std::string> hashes(candidates.size());
+	Utils::Win32::ParallelFor(candidates.size(), [&](size_t i) {
+		try {
+			const auto file = Utils::Win32::Handle::FromCreateFile(candidates[i]->Source.Path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN);
+			const auto size = file.GetFileSize();
+			std::vector<uint8_t> buf(65536);
+			CryptoPP::SHA1 sha1;
+			for (uint64_t offset = 0; offset < size; offset += buf.size()) {
+				const auto len = static_cast<size_t>(std::min<uint64_t>(buf.size(), size - offset));
+				file.Read(offset, buf.data(), len);
+				sha1.Update(buf.data(), len);
+			}
+			hashes[i].resize(CryptoPP::SHA1::DIGESTSIZE);
+			sha1.Final(reinterpret_cast<CryptoPP::byte*>(&hashes[i][0]));
+		} catch (...) {
+			// leave it out
+		}
+	});
+
+	std::map<std::pair<SourceType, std::string>, Entry*> files;
+	for (size_t i = 0; i < candidates.size(); ++i) {
+		if (hashes[i].empty())
+			continue;
+		if (const auto [it, inserted] = files.emplace(std::make_pair(candidates[i]->Source.Type, std::move(hashes[i])), candidates[i]); !inserted) {
+			candidates[i]->DuplicateOf = it->second;
+			it->second->HasDuplicates = true;
+		}
+	}
+}
+
 Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, const std::shared_ptr<SqpackViewEntryCache>&dataBuffer) {
 	SqpackHeader dataHeader{};
 	std::vector<SqData::Header> dataSubheaders;
@@ -494,6 +613,9 @@ Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, c
 	for (auto& entry : res.FullPathEntries | std::views::values)
 		res.Entries.emplace_back(entry.get());
 
+	FindEntriesWithSamePayload(res.Entries);
+	const auto placedEntryCount = static_cast<size_t>(std::ranges::stable_partition(res.Entries, [](const Entry* e) { return !e->DuplicateOf; }).begin() - res.Entries.begin());
+
 	std::map<std::pair<uint32_t, uint32_t>, std::vector<Entry*>> pairHashes;
 	std::map<uint32_t, std::vector<Entry*>> fullHashes;
 	for (const auto& entry : res.Entries) {
@@ -502,7 +624,7 @@ Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, c
 		fullHashes[pathSpec.FullPathHash].emplace_back(entry);
 	}
 
-	for (size_t i = 0; i < res.Entries.size(); ++i) {
+	for (size_t i = 0; i < placedEntryCount; ++i) {
 		auto& entry = res.Entries[i];
 		const auto& pathSpec = entry->Provider->PathSpec();
 		entry->EntrySize = Align(std::max(entry->EntrySize, static_cast<uint32_t>(entry->Provider->StreamSize()))).Alloc;
@@ -542,6 +664,13 @@ Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, c
 		dataEntryRanges.back().second++;
 	}
 
+	// Duplicates keep their own provider unwrapped, as swapping it would not change what the shared region holds.
+	for (size_t i = placedEntryCount; i < res.Entries.size(); ++i) {
+		auto& entry = *res.Entries[i];
+		entry.EntrySize = entry.DuplicateOf->EntrySize;
+		entry.Locator = entry.DuplicateOf->Locator;
+	}
+
 	if (strict && !dataSubheaders.empty()) {
 		CryptoPP::SHA1 sha1;
 		for (auto j = dataEntryRanges.back().first, j_ = j + dataEntryRanges.back().second; j < j_; ++j) {
@@ -631,6 +760,286 @@ Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, c
 	return res;
 }
 
+namespace {
+	struct CachedViewsHeader {
+		static constexpr char Signature_Value[8]{ 'X', 'A', 'S', 'Q', 'V', 'I', 'E', 'W' };
+		static constexpr uint32_t Version_Value = 3;
+
+		char Signature[8]{};
+		uint32_t Version{};
+		uint32_t HeaderSize{};
+		uint64_t PayloadSize{};
+		uint8_t PayloadSha1[20]{};
+	};
+
+	class CachedViewsPayloadWriter {
+		std::vector<uint8_t> m_buffer;
+
+	public:
+		template<typename T>
+		void Write(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			m_buffer.insert(m_buffer.end(), reinterpret_cast<const uint8_t*>(&value), reinterpret_cast<const uint8_t*>(&value + 1));
+		}
+
+		void WriteBytes(std::span<const uint8_t> data) {
+			Write<uint64_t>(data.size());
+			m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+		}
+
+		void WriteString(const std::string& s) {
+			WriteBytes(std::span(reinterpret_cast<const uint8_t*>(s.data()), s.size()));
+		}
+
+		[[nodiscard]] const std::vector<uint8_t>& Buffer() const {
+			return m_buffer;
+		}
+	};
+
+	class CachedViewsPayloadReader {
+		std::span<const uint8_t> m_remaining;
+
+		std::span<const uint8_t> Take(uint64_t size) {
+			if (m_remaining.size() < size)
+				throw Sqex::CorruptDataException("Cached views ended prematurely");
+			const auto res = m_remaining.subspan(0, static_cast<size_t>(size));
+			m_remaining = m_remaining.subspan(static_cast<size_t>(size));
+			return res;
+		}
+
+	public:
+		CachedViewsPayloadReader(std::span<const uint8_t> data)
+			: m_remaining(data) {
+		}
+
+		template<typename T>
+		T Read() {
+			static_assert(std::is_trivially_copyable_v<T>);
+			T value;
+			memcpy(&value, Take(sizeof value).data(), sizeof value);
+			return value;
+		}
+
+		std::span<const uint8_t> ReadBytes() {
+			return Take(Read<uint64_t>());
+		}
+
+		std::string ReadString() {
+			const auto bytes = ReadBytes();
+			return { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+		}
+
+		[[nodiscard]] bool Empty() const {
+			return m_remaining.empty();
+		}
+	};
+}
+
+bool Sqex::Sqpack::Creator::StoreViews(const SqpackViews& views, const std::filesystem::path& path, const std::string& key) {
+	std::map<std::filesystem::path, uint32_t> pathIndices;
+	std::vector<const std::filesystem::path*> paths;
+	std::vector<uint64_t> entryCountPerData(views.Data.size());
+	std::map<const Entry*, uint64_t> entryIndices;
+	for (const auto& entry : views.Entries) {
+		if (entry->Source.Type == EntrySource::SourceType::Unknown)
+			return false;
+		if (entry->Source.Type != EntrySource::SourceType::Empty) {
+			if (const auto [it, inserted] = pathIndices.emplace(entry->Source.Path, static_cast<uint32_t>(paths.size())); inserted)
+				paths.emplace_back(&it->first);
+		}
+		if (!entry->DuplicateOf)
+			entryCountPerData.at(entry->Locator.DatFileIndex) += 1;
+		entryIndices.emplace(entry, entryIndices.size());
+	}
+
+	CachedViewsPayloadWriter payload;
+	payload.WriteString(key);
+	payload.WriteBytes(views.Index1->ReadStreamIntoVector<uint8_t>(0));
+	payload.WriteBytes(views.Index2->ReadStreamIntoVector<uint8_t>(0));
+
+	payload.Write<uint32_t>(static_cast<uint32_t>(paths.size()));
+	for (const auto& p : paths)
+		payload.WriteString(Utils::ToUtf8(p->wstring()));
+
+	payload.Write<uint32_t>(static_cast<uint32_t>(views.Data.size()));
+	for (size_t i = 0; i < views.Data.size(); ++i) {
+		payload.WriteBytes(views.Data[i]->ReadStreamIntoVector<uint8_t>(0, sizeof SqpackHeader + sizeof SqData::Header));
+		payload.Write<uint64_t>(entryCountPerData[i]);
+	}
+
+	payload.Write<uint64_t>(views.Entries.size());
+	for (const auto& entry : views.Entries) {
+		const auto& pathSpec = entry->Provider->PathSpec();
+		payload.Write<uint32_t>(pathSpec.PathHash);
+		payload.Write<uint32_t>(pathSpec.NameHash);
+		payload.Write<uint32_t>(pathSpec.FullPathHash);
+		payload.WriteString(pathSpec.HasOriginal() ? Utils::ToUtf8(pathSpec.FullPath.wstring()) : std::string());
+		payload.Write<uint32_t>(entry->EntrySize);
+		payload.Write<uint32_t>(entry->Locator.Value);
+		payload.Write<uint8_t>(static_cast<uint8_t>(entry->Source.Type));
+		payload.Write<uint32_t>(entry->Source.Type == EntrySource::SourceType::Empty ? UINT32_MAX : pathIndices.at(entry->Source.Path));
+		payload.Write<uint64_t>(entry->Source.Offset);
+		payload.Write<uint64_t>(entry->Source.Size);
+		payload.Write<uint64_t>(entry->DuplicateOf ? entryIndices.at(entry->DuplicateOf) : UINT64_MAX);
+		payload.Write<uint8_t>(entry->Swappable ? 1 : 0);
+	}
+
+	CachedViewsHeader header{
+		.Version = CachedViewsHeader::Version_Value,
+		.HeaderSize = sizeof CachedViewsHeader,
+		.PayloadSize = payload.Buffer().size(),
+	};
+	memcpy(header.Signature, CachedViewsHeader::Signature_Value, sizeof header.Signature);
+	CryptoPP::SHA1 sha1;
+	sha1.Update(payload.Buffer().data(), payload.Buffer().size());
+	sha1.Final(header.PayloadSha1);
+
+	// write to a temporary file first, so that an interrupted write never leaves a file that looks complete
+	create_directories(path.parent_path());
+	const auto tempPath = std::filesystem::path(path).concat(L".tmp");
+	{
+		const auto file = Win32::Handle::FromCreateFile(tempPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, 0);
+		file.Write(0, &header, sizeof header);
+		file.Write(sizeof header, payload.Buffer().data(), payload.Buffer().size());
+	}
+	std::filesystem::rename(tempPath, path);
+	return true;
+}
+
+std::optional<Sqex::Sqpack::Creator::SqpackViews> Sqex::Sqpack::Creator::LoadViews(const std::filesystem::path& path, const std::string& key, const std::shared_ptr<SqpackViewEntryCache>& buffer) {
+	if (!exists(path))
+		return std::nullopt;
+
+	const auto file = Win32::Handle::FromCreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN);
+	const auto fileSize = file.GetFileSize();
+
+	CachedViewsHeader header;
+	if (fileSize < sizeof header)
+		return std::nullopt;
+	file.Read(0, &header, sizeof header);
+	if (memcmp(header.Signature, CachedViewsHeader::Signature_Value, sizeof header.Signature) != 0
+		|| header.Version != CachedViewsHeader::Version_Value
+		|| header.HeaderSize != sizeof header)
+		return std::nullopt;
+	if (header.PayloadSize != fileSize - sizeof header)
+		throw CorruptDataException("Cached views file size mismatch");
+
+	const auto data = file.Read<uint8_t>(sizeof header, static_cast<size_t>(header.PayloadSize));
+	{
+		uint8_t sha1Value[20];
+		CryptoPP::SHA1 sha1;
+		sha1.Update(data.data(), data.size());
+		sha1.Final(sha1Value);
+		if (memcmp(sha1Value, header.PayloadSha1, sizeof sha1Value) != 0)
+			throw CorruptDataException("Cached views checksum mismatch");
+	}
+
+	CachedViewsPayloadReader payload(data);
+	if (payload.ReadString() != key)
+		return std::nullopt;
+
+	SqpackViews res;
+	{
+		const auto index1 = payload.ReadBytes();
+		res.Index1 = std::make_shared<MemoryRandomAccessStream>(std::vector<uint8_t>(index1.begin(), index1.end()));
+		const auto index2 = payload.ReadBytes();
+		res.Index2 = std::make_shared<MemoryRandomAccessStream>(std::vector<uint8_t>(index2.begin(), index2.end()));
+	}
+
+	std::vector<std::filesystem::path> paths(payload.Read<uint32_t>());
+	for (auto& p : paths)
+		p = Utils::FromUtf8(payload.ReadString());
+	std::vector<std::shared_ptr<RandomAccessStream>> streams(paths.size());
+
+	std::vector<std::pair<SqpackHeader, SqData::Header>> dataHeaders(payload.Read<uint32_t>());
+	std::vector<std::pair<size_t, size_t>> dataEntryRanges;
+	for (auto& [dataHeader, dataSubheader] : dataHeaders) {
+		const auto bytes = payload.ReadBytes();
+		if (bytes.size() != sizeof dataHeader + sizeof dataSubheader)
+			throw CorruptDataException("Cached views has invalid data header");
+		memcpy(&dataHeader, &bytes[0], sizeof dataHeader);
+		memcpy(&dataSubheader, &bytes[sizeof dataHeader], sizeof dataSubheader);
+
+		const auto first = dataEntryRanges.empty() ? 0 : dataEntryRanges.back().first + dataEntryRanges.back().second;
+		dataEntryRanges.emplace_back(first, static_cast<size_t>(payload.Read<uint64_t>()));
+	}
+
+	const auto entryCount = payload.Read<uint64_t>();
+	const auto placedEntryCount = dataEntryRanges.empty() ? 0 : dataEntryRanges.back().first + dataEntryRanges.back().second;
+	if (entryCount < placedEntryCount)
+		throw CorruptDataException("Cached views has inconsistent entry count");
+	res.Entries.reserve(static_cast<size_t>(entryCount));
+	for (uint64_t i = 0; i < entryCount; ++i) {
+		const auto pathHash = payload.Read<uint32_t>();
+		const auto nameHash = payload.Read<uint32_t>();
+		const auto fullPathHash = payload.Read<uint32_t>();
+		const auto fullPath = payload.ReadString();
+		auto pathSpec = fullPath.empty() ? EntryPathSpec(pathHash, nameHash, fullPathHash) : EntryPathSpec(pathHash, nameHash, fullPathHash, fullPath);
+
+		auto entry = std::make_unique<Entry>();
+		entry->EntrySize = payload.Read<uint32_t>();
+		entry->Locator = SqIndex::LEDataLocator(payload.Read<uint32_t>());
+		entry->Source.Type = static_cast<EntrySource::SourceType>(payload.Read<uint8_t>());
+		const auto pathIndex = payload.Read<uint32_t>();
+		entry->Source.Offset = payload.Read<uint64_t>();
+		entry->Source.Size = payload.Read<uint64_t>();
+		if (entry->Source.Type != EntrySource::SourceType::Empty) {
+			if (pathIndex >= paths.size())
+				throw CorruptDataException("Cached views has invalid source path index");
+			entry->Source.Path = paths[pathIndex];
+		}
+		if (const auto duplicateOf = payload.Read<uint64_t>(); duplicateOf != UINT64_MAX) {
+			if (i < placedEntryCount || duplicateOf >= placedEntryCount)
+				throw CorruptDataException("Cached views has invalid duplicate entry index");
+			entry->DuplicateOf = res.Entries[static_cast<size_t>(duplicateOf)];
+			entry->DuplicateOf->HasDuplicates = true;
+		} else if (i >= placedEntryCount)
+			throw CorruptDataException("Cached views has an entry without region");
+		entry->Swappable = payload.Read<uint8_t>() != 0;
+
+		std::shared_ptr<EntryProvider> provider;
+		switch (entry->Source.Type) {
+			case EntrySource::SourceType::Empty:
+				provider = std::make_shared<EmptyOrObfuscatedEntryProvider>(pathSpec);
+				break;
+			case EntrySource::SourceType::StreamView:
+				if (!streams[pathIndex])
+					streams[pathIndex] = std::make_shared<FileRandomAccessStream>(paths[pathIndex]);
+				provider = std::make_shared<RandomAccessStreamAsEntryProviderView>(pathSpec, streams[pathIndex], entry->Source.Offset, entry->Source.Size);
+				break;
+			case EntrySource::SourceType::TextureFile:
+				provider = std::make_shared<OnTheFlyTextureEntryProvider>(pathSpec, entry->Source.Path);
+				break;
+			case EntrySource::SourceType::ModelFile:
+				provider = std::make_shared<OnTheFlyModelEntryProvider>(pathSpec, entry->Source.Path);
+				break;
+			case EntrySource::SourceType::BinaryFile:
+				provider = std::make_shared<OnTheFlyBinaryEntryProvider>(pathSpec, entry->Source.Path);
+				break;
+			default:
+				throw CorruptDataException("Cached views has invalid entry source type");
+		}
+		if (entry->DuplicateOf)
+			entry->Provider = std::move(provider);
+		else
+			entry->Provider = std::make_shared<HotSwappableEntryProvider>(pathSpec, entry->EntrySize, std::move(provider));
+
+		res.Entries.emplace_back(entry.get());
+		const auto inserted = pathSpec.HasOriginal()
+			? res.FullPathEntries.emplace(std::move(pathSpec), std::move(entry)).second
+			: res.HashOnlyEntries.emplace(std::move(pathSpec), std::move(entry)).second;
+		if (!inserted)
+			throw CorruptDataException("Cached views has duplicate entries");
+	}
+	if (!payload.Empty())
+		throw CorruptDataException("Cached views has trailing data");
+
+	for (size_t i = 0; i < dataHeaders.size(); ++i)
+		res.Data.emplace_back(std::make_shared<DataView>(dataHeaders[i].first, dataHeaders[i].second, std::span(res.Entries).subspan(dataEntryRanges[i].first, dataEntryRanges[i].second), buffer));
+
+	return res;
+}
+
 std::shared_ptr<Sqex::RandomAccessStream> Sqex::Sqpack::Creator::operator[](const EntryPathSpec& pathSpec) const {
 	if (const auto it = m_pImpl->m_hashOnlyEntries.find(pathSpec); it != m_pImpl->m_hashOnlyEntries.end())
 		return std::make_shared<BufferedRandomAccessStream>(std::make_shared<EntryRawStream>(it->second->Provider));
@@ -680,35 +1089,13 @@ void Sqex::Sqpack::Creator::WriteToFiles(const std::filesystem::path & dir, bool
 		fullHashes[pathSpec.FullPathHash].emplace_back(entry.get());
 	}
 
-	std::vector<SqIndex::LEDataLocator> locators;
-
-	Utils::Win32::Handle dataFile;
-	std::vector<uint8_t> buf(1024 * 1024);
-	for (size_t i = 0; i < entries.size(); ++i) {
-		auto& entry = *entries[i];
-		const auto provider{ std::move(entry.Provider) };
-		const auto entrySize = provider->StreamSize();
+	// Decide which dat file each entry goes into first, so that dat files can be written independently.
+	std::vector<std::vector<std::pair<Entry*, uint64_t>>> datEntries;
+	for (const auto& entry : entries) {
+		const auto entrySize = entry->Provider->StreamSize();
 
 		if (dataSubheaders.empty() ||
 			sizeof SqpackHeader + sizeof SqData::Header + dataSubheaders.back().DataSize + entrySize > dataSubheaders.back().MaxFileSize) {
-			if (strict && !dataSubheaders.empty()) {
-				CryptoPP::SHA1 sha1;
-				Align<uint64_t>(dataSubheaders.back().DataSize, buf.size()).IterateChunked([&](uint64_t index, uint64_t offset, uint64_t size) {
-					const auto bufSpan = std::span(buf).subspan(0, static_cast<size_t>(size));
-					dataFile.Read(offset, bufSpan);
-					sha1.Update(&bufSpan[0], static_cast<size_t>(size));
-					dataFile.Write(entry.Locator.DatFileOffset() + offset, bufSpan);
-					}, sizeof SqpackHeader + sizeof SqData::Header);
-
-				sha1.Final(reinterpret_cast<byte*>(dataSubheaders.back().DataSha1.Value));
-				dataSubheaders.back().Sha1.SetFromSpan(reinterpret_cast<char*>(&dataSubheaders.back()), offsetof(Sqpack::SqData::Header, Sha1));
-				dataFile.Write(0, &dataHeader, sizeof dataHeader);
-				dataFile.Write(sizeof dataHeader, &dataSubheaders.back(), sizeof dataSubheaders.back());
-				dataFile.Clear();
-			}
-
-			dataFile = Utils::Win32::Handle::FromCreateFile(dir / std::format("{}.win32.dat{}", DatName, dataSubheaders.size()),
-				GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS);
 			dataSubheaders.emplace_back(SqData::Header{
 				.HeaderSize = sizeof SqData::Header,
 				.Unknown1 = SqData::Header::Unknown1_Value,
@@ -716,37 +1103,72 @@ void Sqex::Sqpack::Creator::WriteToFiles(const std::filesystem::path & dir, bool
 				.SpanIndex = static_cast<uint32_t>(dataSubheaders.size()),
 				.MaxFileSize = m_maxFileSize,
 				});
+			datEntries.emplace_back();
 		}
 
-		entry.Locator = { static_cast<uint32_t>(dataSubheaders.size() - 1), sizeof SqpackHeader + sizeof SqData::Header + dataSubheaders.back().DataSize };
-		Align<uint64_t>(entrySize, buf.size()).IterateChunked([&](uint64_t index, uint64_t offset, uint64_t size) {
-			const auto bufSpan = std::span(buf).subspan(0, static_cast<size_t>(size));
-			provider->ReadStream(offset, bufSpan);
-			dataFile.Write(entry.Locator.DatFileOffset() + offset, bufSpan);
-			});
-
+		entry->Locator = { static_cast<uint32_t>(dataSubheaders.size() - 1), sizeof SqpackHeader + sizeof SqData::Header + dataSubheaders.back().DataSize };
+		datEntries.back().emplace_back(entry.get(), entrySize);
 		dataSubheaders.back().DataSize = dataSubheaders.back().DataSize + entrySize;
 	}
 
-	if (dataFile) {
+	// Each dat file gets its own worker. Within a worker, the next buffer gets filled from entry providers
+	// while the current one is being written and hashed, so that the data is never read back for SHA-1.
+	Utils::Win32::ParallelFor(datEntries.size(), [&](size_t datIndex) {
+		constexpr size_t WriteBufferSize = 8 * 1024 * 1024;
+
+		const auto& datEntryList = datEntries[datIndex];
+		auto& dataSubheader = dataSubheaders[datIndex];
+		const auto dataFile = Utils::Win32::Handle::FromCreateFile(dir / std::format("{}.win32.dat{}", DatName, datIndex),
+			GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS);
+
+		size_t entryIndex = 0;
+		uint64_t entryOffset = 0;
+		const auto fill = [&](std::vector<uint8_t>& buffer) {
+			size_t filled = 0;
+			while (filled < buffer.size() && entryIndex < datEntryList.size()) {
+				auto& [entry, entrySize] = datEntryList[entryIndex];
+				const auto available = static_cast<size_t>(std::min<uint64_t>(buffer.size() - filled, entrySize - entryOffset));
+				if (available)
+					entry->Provider->ReadStream(entryOffset, std::span(buffer).subspan(filled, available));
+				filled += available;
+				entryOffset += available;
+				if (entryOffset == entrySize) {
+					entry->Provider.reset();
+					entryIndex++;
+					entryOffset = 0;
+				}
+			}
+			return filled;
+		};
+
+		CryptoPP::SHA1 sha1;
+		std::vector<uint8_t> buffers[2]{ std::vector<uint8_t>(WriteBufferSize), std::vector<uint8_t>(WriteBufferSize) };
+		uint64_t writeOffset = sizeof SqpackHeader + sizeof SqData::Header;
+		size_t current = 0;
+		for (auto currentSize = fill(buffers[current]); currentSize;) {
+			size_t nextSize = 0;
+			Utils::Win32::ParallelFor(2, [&](size_t task) {
+				if (task == 0) {
+					nextSize = fill(buffers[1 - current]);
+				} else {
+					const auto span = std::span(buffers[current]).subspan(0, currentSize);
+					dataFile.Write(writeOffset, span);
+					if (strict)
+						sha1.Update(&span[0], span.size_bytes());
+				}
+			});
+			writeOffset += currentSize;
+			current = 1 - current;
+			currentSize = nextSize;
+		}
+
 		if (strict) {
-			CryptoPP::SHA1 sha1;
-			Align<uint64_t>(dataSubheaders.back().DataSize, buf.size()).IterateChunked([&](uint64_t index, uint64_t offset, uint64_t size) {
-				const auto bufSpan = std::span(buf).subspan(0, static_cast<size_t>(size));
-				dataFile.Read(offset, bufSpan);
-				sha1.Update(&bufSpan[0], static_cast<size_t>(size));
-				}, sizeof SqpackHeader + sizeof SqData::Header);
-
-			sha1.Final(reinterpret_cast<byte*>(dataSubheaders.back().DataSha1.Value));
-			dataSubheaders.back().Sha1.SetFromSpan(reinterpret_cast<char*>(&dataSubheaders.back()), offsetof(Sqpack::SqData::Header, Sha1));
-			dataFile.Write(0, &dataHeader, sizeof dataHeader);
-			dataFile.Write(sizeof dataHeader, &dataSubheaders.back(), sizeof dataSubheaders.back());
-			dataFile.Clear();
+			sha1.Final(reinterpret_cast<byte*>(dataSubheader.DataSha1.Value));
+			dataSubheader.Sha1.SetFromSpan(reinterpret_cast<char*>(&dataSubheader), offsetof(Sqpack::SqData::Header, Sha1));
 		}
 		dataFile.Write(0, &dataHeader, sizeof dataHeader);
-		dataFile.Write(sizeof dataHeader, &dataSubheaders.back(), sizeof dataSubheaders.back());
-		dataFile.Clear();
-	}
+		dataFile.Write(sizeof dataHeader, &dataSubheader, sizeof dataSubheader);
+	});
 
 	std::vector<SqIndex::PairHashLocator> fileEntries1;
 	std::vector<SqIndex::PairHashWithTextLocator> conflictEntries1;
@@ -810,17 +1232,125 @@ void Sqex::Sqpack::Creator::WriteToFiles(const std::filesystem::path & dir, bool
 			dataSubheaders.size(), std::move(fileEntries2), std::move(conflictEntries2), m_pImpl->m_sqpackIndex2Segment3, std::vector<SqIndex::PathHashLocator>(), strict)));
 }
 
+Sqex::Sqpack::Creator::SqpackViewEntryCache::PinnedEntry::PinnedEntry(PinnedEntry&& r) noexcept
+	: m_cache(r.m_cache)
+	, m_entry(std::move(r.m_entry)) {
+	r.m_cache = nullptr;
+}
+
+Sqex::Sqpack::Creator::SqpackViewEntryCache::PinnedEntry& Sqex::Sqpack::Creator::SqpackViewEntryCache::PinnedEntry::operator=(PinnedEntry&& r) noexcept {
+	if (this != &r) {
+		Release();
+		m_cache = r.m_cache;
+		m_entry = std::move(r.m_entry);
+		r.m_cache = nullptr;
+	}
+	return *this;
+}
+
+Sqex::Sqpack::Creator::SqpackViewEntryCache::PinnedEntry::~PinnedEntry() {
+	Release();
+}
+
+void Sqex::Sqpack::Creator::SqpackViewEntryCache::PinnedEntry::Release() {
+	if (!m_entry)
+		return;
+
+	{
+		const auto lock = std::lock_guard(m_cache->m_mtx);
+		m_entry->PinCount--;
+		m_cache->EvictUnpinnedUntilWithinBudget();
+	}
+	m_entry = nullptr;
+	m_cache = nullptr;
+}
+
+Sqex::Sqpack::Creator::SqpackViewEntryCache::SqpackViewEntryCache(uint64_t byteBudget)
+	: m_byteBudget(byteBudget) {
+}
+
+void Sqex::Sqpack::Creator::SqpackViewEntryCache::RemoveEntry(const std::shared_ptr<BufferedEntry>& entry) {
+	m_usedBytes -= entry->SourceEntry->EntrySize;
+	m_lru.erase(entry->LruIterator);
+	m_entries.erase(std::make_pair(entry->View, entry->SourceEntry));
+}
+
+void Sqex::Sqpack::Creator::SqpackViewEntryCache::EvictUnpinnedUntilWithinBudget() {
+	for (auto it = m_lru.end(); m_usedBytes > m_byteBudget && it != m_lru.begin();) {
+		--it;
+		if ((*it)->PinCount)
+			continue;
+
+		// RemoveEntry invalidates it, so step forward first; the loop steps back to the predecessor.
+		const auto victim = *it++;
+		RemoveEntry(victim);
+		m_evictions++;
+	}
+}
+
 void Sqex::Sqpack::Creator::SqpackViewEntryCache::Flush() {
-	m_lastActiveEntry.ClearEntry();
+	const auto lock = std::lock_guard(m_mtx);
+
+	// Pinned entries stay alive through PinnedEntry, and get freed once their readers are done.
+	m_entries.clear();
+	m_lru.clear();
+	m_usedBytes = 0;
 }
 
-Sqex::Sqpack::Creator::SqpackViewEntryCache::BufferedEntry* Sqex::Sqpack::Creator::SqpackViewEntryCache::GetBuffer(const DataView * view, const Entry * entry) {
-	if (m_lastActiveEntry.IsEntry(view, entry))
-		return &m_lastActiveEntry;
+Sqex::Sqpack::Creator::SqpackViewEntryCache::PinnedEntry Sqex::Sqpack::Creator::SqpackViewEntryCache::GetBuffer(const DataView* view, const Entry* entry) {
+	std::shared_ptr<BufferedEntry> buffered;
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		if (const auto it = m_entries.find(std::make_pair(view, entry)); it != m_entries.end()) {
+			buffered = it->second;
+			m_lru.splice(m_lru.begin(), m_lru, buffered->LruIterator);
+			m_hits++;
 
-	if (entry->EntrySize > LargeEntryBufferSizeMax)
-		return nullptr;
+		} else if (entry->EntrySize > m_byteBudget) {
+			m_bypasses++;
+			return {};
 
-	m_lastActiveEntry.SetEntry(view, entry);
-	return &m_lastActiveEntry;
+		} else {
+			buffered = std::make_shared<BufferedEntry>();
+			buffered->View = view;
+			buffered->SourceEntry = entry;
+			m_lru.emplace_front(buffered);
+			buffered->LruIterator = m_lru.begin();
+			m_entries.emplace(std::make_pair(view, entry), buffered);
+			m_usedBytes += entry->EntrySize;
+			m_misses++;
+		}
+		buffered->PinCount++;
+		EvictUnpinnedUntilWithinBudget();
+	}
+
+	auto pinned = PinnedEntry(this, buffered);
+
+	const auto lock = std::lock_guard(buffered->LoadMtx);
+	if (!buffered->Loaded) {
+		try {
+			buffered->Buffer.resize(entry->EntrySize);
+			entry->Provider->ReadStream(0, std::span(buffered->Buffer));
+			buffered->Loaded = true;
+		} catch (...) {
+			pinned.Release();
+			const auto cacheLock = std::lock_guard(m_mtx);
+			if (const auto it = m_entries.find(std::make_pair(view, entry)); it != m_entries.end() && it->second == buffered)
+				RemoveEntry(buffered);
+			throw;
+		}
+	}
+	return pinned;
+}
+
+Sqex::Sqpack::Creator::SqpackViewEntryCache::Statistics Sqex::Sqpack::Creator::SqpackViewEntryCache::GetStatistics() const {
+	const auto lock = std::lock_guard(m_mtx);
+	return {
+		.Hits = m_hits,
+		.Misses = m_misses,
+		.Evictions = m_evictions,
+		.Bypasses = m_bypasses,
+		.UsedBytes = m_usedBytes,
+		.EntryCount = m_entries.size(),
+	};
 }
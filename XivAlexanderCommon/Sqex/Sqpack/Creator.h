@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <list>
+
 #include "XivAlexanderCommon/Sqex/Sqpack.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/EntryProvider.h"
 #include "XivAlexanderCommon/Utils/ListenerManager.h"
@@ -49,85 +52,143 @@ namespace Sqex::Sqpack {
 		class DataView;
 
 	public:
+		// Where the provider of an entry came from, so that a finished layout can be reopened without rebuilding it.
+		struct EntrySource {
+			enum class SourceType : uint8_t {
+				Unknown,  // added via AddEntry; cannot be reopened
+				Empty,
+				StreamView,  // [Offset, Offset + Size) of Path, already in SqData entry format
+				TextureFile,
+				ModelFile,
+				BinaryFile,
+			};
+
+			SourceType Type = SourceType::Unknown;
+			std::filesystem::path Path;
+			uint64_t Offset{};
+			uint64_t Size{};
+		};
+
 		struct Entry {
 			uint32_t EntrySize{};
 			SqIndex::LEDataLocator Locator{};
 
 			std::shared_ptr<EntryProvider> Provider;
+			EntrySource Source;
+
+			// Space has been reserved with ReserveSwappableSpace, so the content may change after layout.
+			bool Swappable{};
+
+			// Set by AsViews if the payload is identical to that of another entry; such entries share its region in the data file.
+			Entry* DuplicateOf{};
+
+			// Set by AsViews if other entries share this entry's region; swapping its content would change theirs as well.
+			bool HasDuplicates{};
 		};
 
 		struct SqpackViews {
 			std::shared_ptr<Sqex::RandomAccessStream> Index1;
 			std::shared_ptr<Sqex::RandomAccessStream> Index2;
 			std::vector<std::shared_ptr<Sqex::RandomAccessStream>> Data;
-			std::vector<Entry*> Entries;
+			std::vector<Entry*> Entries;  // entries with DuplicateOf set come last, after every entry placed in data files
 			std::map<EntryPathSpec, std::unique_ptr<Entry>, EntryPathSpec::AllHashComparator> HashOnlyEntries;
 			std::map<EntryPathSpec, std::unique_ptr<Entry>, EntryPathSpec::FullPathComparator> FullPathEntries;
 		};
 
 		class SqpackViewEntryCache {
-			static constexpr auto SmallEntryBufferSize = (INTPTR_MAX == INT64_MAX ? 256 : 8) * 1048576;
-			static constexpr auto LargeEntryBufferSizeMax = (INTPTR_MAX == INT64_MAX ? 1024 : 64) * 1048576;
-
 		public:
-			class BufferedEntry {
-				const DataView* m_view = nullptr;
-				const Entry* m_entry = nullptr;
-				std::vector<uint8_t> m_bufferPreallocated;
-				std::vector<uint8_t> m_bufferTemporary;
-				std::span<uint8_t> m_bufferActive;
+			static constexpr uint64_t DefaultByteBudget = (INTPTR_MAX == INT64_MAX ? 512 : 64) * 1048576ULL;
+
+			struct Statistics {
+				uint64_t Hits;
+				uint64_t Misses;
+				uint64_t Evictions;
+				uint64_t Bypasses;
+				uint64_t UsedBytes;
+				size_t EntryCount;
+			};
 
-			public:
-				bool Empty() const {
-					return m_view == nullptr || m_entry == nullptr;
-				}
+		private:
+			struct BufferedEntry {
+				const DataView* View;
+				const Creator::Entry* SourceEntry;
+				std::vector<uint8_t> Buffer;
 
-				bool IsEntry(const DataView* view, const Entry* entry) const {
-					return m_view == view && m_entry == entry;
-				}
+				std::mutex LoadMtx;
+				bool Loaded = false;
 
-				void ClearEntry() {
-					m_view = nullptr;
-					m_entry = nullptr;
-					if (!m_bufferTemporary.empty())
-						std::vector<uint8_t>().swap(m_bufferTemporary);
-				}
+				// Following fields are guarded by SqpackViewEntryCache::m_mtx.
+				size_t PinCount = 0;
+				std::list<std::shared_ptr<BufferedEntry>>::iterator LruIterator;
+			};
+
+		public:
+			// Keeps an entry from being evicted while its buffer is being read from.
+			class PinnedEntry {
+				friend class SqpackViewEntryCache;
 
-				auto GetEntry() const {
-					return std::make_pair(m_view, m_entry);
+				SqpackViewEntryCache* m_cache = nullptr;
+				std::shared_ptr<BufferedEntry> m_entry;
+
+				PinnedEntry(SqpackViewEntryCache* cache, std::shared_ptr<BufferedEntry> entry)
+					: m_cache(cache)
+					, m_entry(std::move(entry)) {
 				}
 
-				void SetEntry(const DataView* view, const Entry* entry) {
-					m_view = view;
-					m_entry = entry;
-
-					if (entry->EntrySize <= SmallEntryBufferSize) {
-						if (!m_bufferTemporary.empty())
-							std::vector<uint8_t>().swap(m_bufferTemporary);
-						if (m_bufferPreallocated.size() != SmallEntryBufferSize)
-							m_bufferPreallocated.resize(SmallEntryBufferSize);
-						m_bufferActive = std::span(m_bufferPreallocated.begin(), entry->EntrySize);
-					} else {
-						m_bufferTemporary.resize(entry->EntrySize);
-						m_bufferActive = std::span(m_bufferTemporary);
-					}
-					entry->Provider->ReadStream(0, m_bufferActive);
+			public:
+				PinnedEntry() = default;
+				PinnedEntry(PinnedEntry&& r) noexcept;
+				PinnedEntry& operator=(PinnedEntry&& r) noexcept;
+				PinnedEntry(const PinnedEntry&) = delete;
+				PinnedEntry& operator=(const PinnedEntry&) = delete;
+				~PinnedEntry();
+
+				operator bool() const {
+					return !!m_entry;
 				}
 
-				const auto& Buffer() const {
-					return m_bufferActive;
+				[[nodiscard]] std::span<const uint8_t> Buffer() const {
+					return m_entry->Buffer;
 				}
+
+				void Release();
 			};
 
 		private:
-			BufferedEntry m_lastActiveEntry;
+			const uint64_t m_byteBudget;
+
+			mutable std::mutex m_mtx;
+			std::map<std::pair<const DataView*, const Entry*>, std::shared_ptr<BufferedEntry>> m_entries;
+			std::list<std::shared_ptr<BufferedEntry>> m_lru;  // most recently used at front
+			uint64_t m_usedBytes = 0;
+			uint64_t m_hits = 0;
+			uint64_t m_misses = 0;
+			uint64_t m_evictions = 0;
+			uint64_t m_bypasses = 0;
+
+			void EvictUnpinnedUntilWithinBudget();
+			void RemoveEntry(const std::shared_ptr<BufferedEntry>& entry);
 
 		public:
-			BufferedEntry* GetBuffer(const DataView* view, const Entry* entry);
+			SqpackViewEntryCache(uint64_t byteBudget = DefaultByteBudget);
+
+			// Returns an empty PinnedEntry if the entry does not fit in the cache at all.
+			PinnedEntry GetBuffer(const DataView* view, const Entry* entry);
 			void Flush();
+
+			[[nodiscard]] Statistics GetStatistics() const;
 		};
 
 		SqpackViews AsViews(bool strict, const std::shared_ptr<SqpackViewEntryCache>& buffer = nullptr);
+
+		// Stores index data, data file headers and entry table of views, along with key describing every input used to build them.
+		// Returns false without writing anything if any entry cannot be reopened.
+		static bool StoreViews(const SqpackViews& views, const std::filesystem::path& path, const std::string& key);
+
+		// Returns an empty value if there is no stored views, or if they were stored with a different format version or key.
+		// Throws CorruptDataException if the stored file fails checksum verification.
+		static std::optional<SqpackViews> LoadViews(const std::filesystem::path& path, const std::string& key, const std::shared_ptr<SqpackViewEntryCache>& buffer = nullptr);
+
 		void WriteToFiles(const std::filesystem::path& dir, bool strict = false);
 
 		std::shared_ptr<RandomAccessStream> operator[](const EntryPathSpec& pathSpec) const;
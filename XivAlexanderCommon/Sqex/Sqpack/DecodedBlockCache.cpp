@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Sqpack/DecodedBlockCache.h"
+
+Sqex::Sqpack::DecodedBlockCache::DecodedBlockCache(uint64_t byteBudget)
+	: m_byteBudget(byteBudget) {
+}
+
+Sqex::Sqpack::DecodedBlockCache& Sqex::Sqpack::DecodedBlockCache::Shared() {
+	static DecodedBlockCache s_instance;
+	return s_instance;
+}
+
+Sqex::Sqpack::DecodedBlockCache::Block Sqex::Sqpack::DecodedBlockCache::Find(const std::shared_ptr<const EntryProvider>& provider, uint64_t blockOffset) {
+	const auto lock = std::lock_guard(m_mtx);
+	const auto it = m_items.find(Key(provider.get(), blockOffset));
+	if (it == m_items.end()) {
+		++m_misses;
+		return nullptr;
+	}
+
+	// Address got reused by another provider after the original one has been destroyed.
+	if (it->second.Owner.expired()) {
+		EraseItem(it);
+		++m_misses;
+		return nullptr;
+	}
+
+	m_lru.splice(m_lru.begin(), m_lru, it->second.LruIterator);
+	++m_hits;
+	return it->second.Data;
+}
+
+bool Sqex::Sqpack::DecodedBlockCache::Contains(const std::shared_ptr<const EntryProvider>& provider, uint64_t blockOffset) const {
+	const auto lock = std::lock_guard(m_mtx);
+	const auto it = m_items.find(Key(provider.get(), blockOffset));
+	return it != m_items.end() && !it->second.Owner.expired();
+}
+
+void Sqex::Sqpack::DecodedBlockCache::Put(const std::shared_ptr<const EntryProvider>& provider, uint64_t blockOffset, Block data) {
+	if (!data)
+		return;
+
+	const auto lock = std::lock_guard(m_mtx);
+	if (data->size() > m_byteBudget)
+		return;
+
+	const auto key = Key(provider.get(), blockOffset);
+	if (const auto it = m_items.find(key); it != m_items.end())
+		EraseItem(it);
+
+	m_lru.push_front(key);
+	m_usedBytes += data->size();
+	m_items.emplace(key, Item{
+		.Owner = provider,
+		.Data = std::move(data),
+		.LruIterator = m_lru.begin(),
+	});
+	EvictUntilWithinBudget();
+}
+
+uint64_t Sqex::Sqpack::DecodedBlockCache::GetByteBudget() const {
+	const auto lock = std::lock_guard(m_mtx);
+	return m_byteBudget;
+}
+
+void Sqex::Sqpack::DecodedBlockCache::SetByteBudget(uint64_t byteBudget) {
+	const auto lock = std::lock_guard(m_mtx);
+	m_byteBudget = byteBudget;
+	EvictUntilWithinBudget();
+}
+
+void Sqex::Sqpack::DecodedBlockCache::Flush() {
+	const auto lock = std::lock_guard(m_mtx);
+	m_items.clear();
+	m_lru.clear();
+	m_usedBytes = 0;
+}
+
+Sqex::Sqpack::DecodedBlockCache::Statistics Sqex::Sqpack::DecodedBlockCache::GetStatistics() const {
+	const auto lock = std::lock_guard(m_mtx);
+	return {
+		.Hits = m_hits,
+		.Misses = m_misses,
+		.Evictions = m_evictions,
+		.UsedBytes = m_usedBytes,
+		.EntryCount = m_items.size(),
+	};
+}
+
+void Sqex::Sqpack::DecodedBlockCache::EraseItem(std::map<Key, Item>::iterator it) {
+	m_usedBytes -= it->second.Data->size();
+	m_lru.erase(it->second.LruIterator);
+	m_items.erase(it);
+}
+
+void Sqex::Sqpack::DecodedBlockCache::EvictUntilWithinBudget() {
+	while (m_usedBytes > m_byteBudget && !m_lru.empty()) {
+		EraseItem(m_items.find(m_lru.back()));
+		++m_evictions;
+	}
+}
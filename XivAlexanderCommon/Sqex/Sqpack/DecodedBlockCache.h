@@ -0,0 +1,62 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+
+#include "XivAlexanderCommon/Sqex/Sqpack/EntryProvider.h"
+
+namespace Sqex::Sqpack {
+	// Byte-bounded LRU of inflated SqData blocks, shared between all StreamDecoder instances.
+	// Blocks are keyed by provider identity and block offset; the provider must not change its content while alive.
+	class DecodedBlockCache {
+	public:
+		static constexpr uint64_t DefaultByteBudget = (INTPTR_MAX == INT64_MAX ? 128 : 16) * 1048576ULL;
+
+		using Block = std::shared_ptr<const std::vector<uint8_t>>;
+
+		struct Statistics {
+			uint64_t Hits;
+			uint64_t Misses;
+			uint64_t Evictions;
+			uint64_t UsedBytes;
+			size_t EntryCount;
+		};
+
+	private:
+		using Key = std::pair<const EntryProvider*, uint64_t>;
+
+		struct Item {
+			std::weak_ptr<const EntryProvider> Owner;
+			Block Data;
+			std::list<Key>::iterator LruIterator;
+		};
+
+		mutable std::mutex m_mtx;
+		uint64_t m_byteBudget;
+		uint64_t m_usedBytes = 0;
+		std::map<Key, Item> m_items;
+		std::list<Key> m_lru;  // front = most recently used
+
+		uint64_t m_hits = 0;
+		uint64_t m_misses = 0;
+		uint64_t m_evictions = 0;
+
+	public:
+		DecodedBlockCache(uint64_t byteBudget = DefaultByteBudget);
+
+		static DecodedBlockCache& Shared();
+
+		[[nodiscard]] Block Find(const std::shared_ptr<const EntryProvider>& provider, uint64_t blockOffset);
+		[[nodiscard]] bool Contains(const std::shared_ptr<const EntryProvider>& provider, uint64_t blockOffset) const;
+		void Put(const std::shared_ptr<const EntryProvider>& provider, uint64_t blockOffset, Block data);
+
+		[[nodiscard]] uint64_t GetByteBudget() const;
+		void SetByteBudget(uint64_t byteBudget);
+		void Flush();
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		void EraseItem(std::map<Key, Item>::iterator it);
+		void EvictUntilWithinBudget();
+	};
+}
@@ -94,10 +94,10 @@ uint64_t Sqex::Sqpack::ModelStreamDecoder::ReadStreamPartial(uint64_t offset, vo
 	if (!length)
 		return 0;
 
+	const auto lock = std::lock_guard(m_readMtx);
 	ReadStreamState info{
-		.Underlying = *m_stream,
+		.Decoder = *this,
 		.TargetBuffer = std::span(static_cast<uint8_t*>(buf), static_cast<size_t>(length)),
-		.ReadBuffer = std::vector<uint8_t>(m_maxBlockSize),
 		.RelativeOffset = offset,
 	};
 
@@ -122,12 +122,18 @@ uint64_t Sqex::Sqpack::ModelStreamDecoder::ReadStreamPartial(uint64_t offset, vo
 	info.RequestOffsetVerify = it->RequestOffset;
 	info.RelativeOffset -= info.RequestOffsetVerify;
 
+	std::vector<uint32_t> touchedBlockOffsets;
+	for (auto i = it; i != m_blocks.end() && i->RequestOffset < info.RequestOffsetVerify + info.RelativeOffset + info.TargetBuffer.size_bytes(); ++i) {
+		if (i->DecompressedSize)
+			touchedBlockOffsets.emplace_back(i->BlockOffset);
+	}
+	PrefetchBlocks(std::move(touchedBlockOffsets));
+
 	for (; it != m_blocks.end(); ++it) {
 		info.Progress(it->RequestOffset, it->BlockOffset);
 		if (info.TargetBuffer.empty())
 			break;
 	}
 
-	m_maxBlockSize = info.ReadBuffer.size();
 	return length - info.TargetBuffer.size_bytes();
 }
@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Sqpack/ReadScheduler.h"
+
+bool Sqex::Sqpack::ReadScheduler::Window::Contains(uint64_t offset, uint64_t length) const {
+	const auto available = Ready ? Data.size() : Length;
+	return Offset <= offset && offset + length <= Offset + available;
+}
+
+Sqex::Sqpack::ReadScheduler::ReadScheduler(size_t workerCount, uint64_t readAheadSize, size_t sequentialThreshold)
+	: m_readAheadSize(readAheadSize)
+	, m_sequentialThreshold(sequentialThreshold) {
+	m_workers.reserve(std::max<size_t>(1, workerCount));
+	for (size_t i = 0; i < std::max<size_t>(1, workerCount); ++i)
+		m_workers.emplace_back([this]() { WorkerBody(); });
+}
+
+Sqex::Sqpack::ReadScheduler::~ReadScheduler() {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		m_stopping = true;
+		m_readAheads.clear();
+	}
+	m_cv.notify_all();
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void Sqex::Sqpack::ReadScheduler::Submit(std::shared_ptr<const RandomAccessStream> stream, uint64_t offset, void* buf, uint64_t length, CompletionCallback onComplete) {
+	if (!length) {
+		onComplete(0, nullptr);
+		return;
+	}
+
+	uint64_t boundary;
+	try {
+		boundary = stream->ReadAheadBoundary(offset);
+	} catch (...) {
+		boundary = 0;
+	}
+
+	auto req = Request{stream, offset, buf, length, std::move(onComplete)};
+	std::shared_ptr<Window> readyWindow;
+	auto notify = false;
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		++m_reads;
+
+		auto& state = m_streams[stream.get()];
+		if (state.Owner.expired()) {
+			// Address got reused by another stream after the original one has been destroyed.
+			state = {};
+			state.Owner = stream;
+		}
+
+		if (offset == state.NextExpectedOffset)
+			++state.SequentialCount;
+		else
+			state.SequentialCount = 0;
+		state.NextExpectedOffset = offset + length;
+
+		while (!state.Windows.empty() && state.Windows.front()->Offset + state.Windows.front()->Length <= offset)
+			state.Windows.pop_front();
+
+		const auto windowIt = std::ranges::find_if(state.Windows, [&](const auto& w) { return w->Contains(offset, length); });
+		if (windowIt == state.Windows.end()) {
+			if (!state.SequentialCount)
+				state.Windows.clear();
+			m_requests.emplace_back(Job{std::move(req), {}});
+			notify = true;
+
+		} else if ((*windowIt)->Ready) {
+			readyWindow = *windowIt;
+			++m_readAheadHits;
+			++m_executing;
+
+		} else {
+			// Wait for the read-ahead to finish instead of reading the same range twice; promote it if it has not started yet.
+			if (!(*windowIt)->Started) {
+				m_requests.emplace_back(Job{{}, *windowIt});
+				notify = true;
+			}
+			(*windowIt)->Waiters.emplace_back(std::move(req));
+			++m_readAheadHits;
+		}
+
+		if (state.SequentialCount >= m_sequentialThreshold && state.Windows.size() < 2) {
+			auto start = offset + length;
+			auto eligible = true;
+			if (!state.Windows.empty()) {
+				const auto& last = *state.Windows.back();
+				start = last.Offset + last.Length;
+				eligible = offset + length >= last.Offset + last.Length / 2;
+			}
+
+			if (eligible && start < boundary) {
+				auto window = std::make_shared<Window>();
+				window->Stream = stream;
+				window->Offset = start;
+				window->Length = std::min(m_readAheadSize, boundary - start);
+				state.Windows.emplace_back(window);
+				m_readAheads.emplace_back(std::move(window));
+				++m_readAheadIssued;
+				notify = true;
+			}
+		}
+	}
+
+	if (notify)
+		m_cv.notify_one();
+
+	// Data of a ready window never changes, so it can be copied without holding the lock.
+	if (readyWindow) {
+		if (!TryServeFromWindow(*readyWindow, req))
+			ExecuteRead(req);
+
+		const auto lock = std::lock_guard(m_mtx);
+		if (!--m_executing && m_requests.empty())
+			m_idleCv.notify_all();
+	}
+}
+
+void Sqex::Sqpack::ReadScheduler::Forget(const RandomAccessStream* stream) {
+	const auto lock = std::lock_guard(m_mtx);
+	m_streams.erase(stream);
+}
+
+void Sqex::Sqpack::ReadScheduler::Invalidate() {
+	auto lock = std::unique_lock(m_mtx);
+
+	// Windows that have requests waiting on them are either running, or have been promoted into m_requests.
+	m_readAheads.clear();
+	m_streams.clear();
+	m_idleCv.wait(lock, [this]() { return !m_executing && m_requests.empty(); });
+}
+
+Sqex::Sqpack::ReadScheduler::Statistics Sqex::Sqpack::ReadScheduler::GetStatistics() const {
+	const auto lock = std::lock_guard(m_mtx);
+	return {
+		.Reads = m_reads,
+		.ReadAheadHits = m_readAheadHits,
+		.ReadAheadIssued = m_readAheadIssued,
+		.ReadAheadBytes = m_readAheadBytes,
+	};
+}
+
+void Sqex::Sqpack::ReadScheduler::WorkerBody() {
+	auto lock = std::unique_lock(m_mtx);
+	while (true) {
+		m_cv.wait(lock, [this]() { return m_stopping || !m_requests.empty() || !m_readAheads.empty(); });
+
+		Job job;
+		if (!m_requests.empty()) {
+			job = std::move(m_requests.front());
+			m_requests.pop_front();
+		} else if (m_stopping) {
+			return;
+		} else {
+			job.ReadAhead = std::move(m_readAheads.front());
+			m_readAheads.pop_front();
+		}
+
+		if (job.ReadAhead) {
+			// Promoted read-ahead jobs stay in the low priority queue as well.
+			if (job.ReadAhead->Started) {
+				if (m_requests.empty() && !m_executing)
+					m_idleCv.notify_all();
+				continue;
+			}
+			job.ReadAhead->Started = true;
+		}
+
+		++m_executing;
+		lock.unlock();
+
+		if (job.ReadAhead)
+			ExecuteReadAhead(job.ReadAhead);
+		else
+			ExecuteRead(job.Read);
+
+		lock.lock();
+		if (!--m_executing && m_requests.empty())
+			m_idleCv.notify_all();
+	}
+}
+
+void Sqex::Sqpack::ReadScheduler::ExecuteRead(Request& req) {
+	uint64_t read = 0;
+	std::exception_ptr error;
+	try {
+		read = req.Stream->ReadStreamPartial(req.Offset, req.Buffer, req.Length);
+	} catch (...) {
+		error = std::current_exception();
+	}
+	req.OnComplete(read, error);
+}
+
+void Sqex::Sqpack::ReadScheduler::ExecuteReadAhead(const std::shared_ptr<Window>& window) {
+	std::vector<uint8_t> data(static_cast<size_t>(window->Length));
+	try {
+		data.resize(static_cast<size_t>(window->Stream->ReadStreamPartial(window->Offset, data.data(), data.size())));
+	} catch (...) {
+		// Waiters will retry on their own and report the error if it persists.
+		data.clear();
+	}
+
+	std::vector<Request> waiters;
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		window->Data = std::move(data);
+		window->Ready = true;
+		window->Stream = nullptr;
+		waiters = std::move(window->Waiters);
+		m_readAheadBytes += window->Data.size();
+	}
+
+	for (auto& req : waiters) {
+		if (!TryServeFromWindow(*window, req))
+			ExecuteRead(req);
+	}
+}
+
+bool Sqex::Sqpack::ReadScheduler::TryServeFromWindow(const Window& window, Request& req) {
+	if (!window.Contains(req.Offset, req.Length))
+		return false;
+
+	std::copy_n(&window.Data[static_cast<size_t>(req.Offset - window.Offset)], static_cast<size_t>(req.Length), static_cast<uint8_t*>(req.Buffer));
+	req.OnComplete(req.Length, nullptr);
+	return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "XivAlexanderCommon/Sqex/RandomAccessStream.h"
+
+namespace Sqex::Sqpack {
+	// Services reads from RandomAccessStream on a dedicated set of worker threads.
+	// Requests are served in submission order, ahead of any read-ahead work.
+	// Once a stream has been read sequentially for a while, the following range up to RandomAccessStream::ReadAheadBoundary is
+	// read in advance, and requests falling into that range are served from memory.
+	class ReadScheduler {
+	public:
+		// read is the number of bytes stored into the buffer; if error is set, the content of the buffer is undefined.
+		// May be called from a worker thread, or from the thread calling Submit if the data was already available; must not throw.
+		using CompletionCallback = std::function<void(uint64_t read, std::exception_ptr error)>;
+
+		static constexpr size_t DefaultWorkerCount = 2;
+		static constexpr uint64_t DefaultReadAheadSize = 1048576;
+		static constexpr size_t DefaultSequentialThreshold = 2;
+
+		struct Statistics {
+			uint64_t Reads;
+			uint64_t ReadAheadHits;
+			uint64_t ReadAheadIssued;
+			uint64_t ReadAheadBytes;
+		};
+
+	private:
+		struct Request {
+			std::shared_ptr<const RandomAccessStream> Stream;
+			uint64_t Offset;
+			void* Buffer;
+			uint64_t Length;
+			CompletionCallback OnComplete;
+		};
+
+		struct Window {
+			std::shared_ptr<const RandomAccessStream> Stream;
+			uint64_t Offset;
+			uint64_t Length;
+			bool Started = false;
+			bool Ready = false;
+			std::vector<uint8_t> Data;  // valid only if Ready
+			std::vector<Request> Waiters;  // requests that fall inside this window, submitted before it became ready
+
+			[[nodiscard]] bool Contains(uint64_t offset, uint64_t length) const;
+		};
+
+		struct StreamState {
+			std::weak_ptr<const RandomAccessStream> Owner;
+			uint64_t NextExpectedOffset = UINT64_MAX;
+			size_t SequentialCount = 0;
+			std::deque<std::shared_ptr<Window>> Windows;  // at most two; current one and the next one
+		};
+
+		struct Job {
+			Request Read;
+			std::shared_ptr<Window> ReadAhead;  // if set, Read is unused
+		};
+
+		const uint64_t m_readAheadSize;
+		const size_t m_sequentialThreshold;
+
+		mutable std::mutex m_mtx;
+		std::condition_variable m_cv;
+		std::condition_variable m_idleCv;
+		bool m_stopping = false;
+		size_t m_executing = 0;  // jobs taken by workers, and reads being served from ready windows
+		std::deque<Job> m_requests;
+		std::deque<std::shared_ptr<Window>> m_readAheads;
+		std::map<const RandomAccessStream*, StreamState> m_streams;
+
+		uint64_t m_reads = 0;
+		uint64_t m_readAheadHits = 0;
+		uint64_t m_readAheadIssued = 0;
+		uint64_t m_readAheadBytes = 0;
+
+		std::vector<std::thread> m_workers;
+
+	public:
+		ReadScheduler(size_t workerCount = DefaultWorkerCount, uint64_t readAheadSize = DefaultReadAheadSize, size_t sequentialThreshold = DefaultSequentialThreshold);
+		ReadScheduler(ReadScheduler&&) = delete;
+		ReadScheduler(const ReadScheduler&) = delete;
+		ReadScheduler& operator=(ReadScheduler&&) = delete;
+		ReadScheduler& operator=(const ReadScheduler&) = delete;
+
+		// Completes every submitted request and drops pending read-ahead work.
+		~ReadScheduler();
+
+		// buf must stay valid until onComplete gets called.
+		void Submit(std::shared_ptr<const RandomAccessStream> stream, uint64_t offset, void* buf, uint64_t length, CompletionCallback onComplete);
+
+		// Drops read-ahead data for the stream; call when the stream is no longer going to be read from.
+		void Forget(const RandomAccessStream* stream);
+
+		// Waits for every submitted request and running read-ahead to finish, and drops all read-ahead data.
+		// Call before changing what a stream returns; requests submitted while this is waiting delay the return.
+		void Invalidate();
+
+		[[nodiscard]] Statistics GetStatistics() const;
+
+	private:
+		void WorkerBody();
+		void ExecuteRead(Request& req);
+		void ExecuteReadAhead(const std::shared_ptr<Window>& window);
+		bool TryServeFromWindow(const Window& window, Request& req);
+	};
+}
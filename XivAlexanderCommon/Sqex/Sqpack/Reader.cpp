@@ -4,14 +4,30 @@
 #include "XivAlexanderCommon/Sqex/Sqpack/EntryRawStream.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/RandomAccessStreamAsEntryProviderView.h"
 
+static std::shared_ptr<const Sqex::RandomAccessStream> EnsureDirectlyAddressable(std::shared_ptr<const Sqex::RandomAccessStream> stream) {
+	if (!stream || stream->GetDirectView().size() == stream->StreamSize())
+		return stream;
+	return std::make_shared<Sqex::MemoryRandomAccessStream>(*stream);
+}
+
+static uint64_t PairHashLocatorKey(const Sqex::Sqpack::SqIndex::PairHashLocator& locator) {
+	return (static_cast<uint64_t>(locator.PathHash.Value()) << 32) | locator.NameHash.Value();
+}
+
+static uint64_t FullHashLocatorKey(const Sqex::Sqpack::SqIndex::FullHashLocator& locator) {
+	return locator.FullPathHash.Value();
+}
+
 template<typename HashLocatorT, typename TextLocatorT>
-Sqex::Sqpack::Reader::SqIndexType<HashLocatorT, TextLocatorT>::SqIndexType(const RandomAccessStream* stream, bool strictVerify)
-	: Data(stream ? stream->ReadStreamIntoVector<uint8_t>(0) : std::vector<uint8_t>())
+Sqex::Sqpack::Reader::SqIndexType<HashLocatorT, TextLocatorT>::SqIndexType(std::shared_ptr<const RandomAccessStream> stream, bool strictVerify)
+	: Storage(EnsureDirectlyAddressable(std::move(stream)))
+	, Data(Storage ? Storage->GetDirectView() : std::span<const uint8_t>())
 	, Header(Data.empty() ? SqpackHeader{} : *reinterpret_cast<const SqpackHeader*>(&Data[0]))
 	, IndexHeader(Data.empty() ? SqIndex::Header{} : *reinterpret_cast<const SqIndex::Header*>(&Data[Header.HeaderSize]))
 	, HashLocators(Data.empty() ? std::span<const HashLocatorT>() : span_cast<HashLocatorT>(Data, IndexHeader.HashLocatorSegment.Offset, IndexHeader.HashLocatorSegment.Size, 1))
 	, TextLocators(Data.empty() ? std::span<const TextLocatorT>() : span_cast<TextLocatorT>(Data, IndexHeader.TextLocatorSegment.Offset, IndexHeader.TextLocatorSegment.Size, 1))
-	, Segment3(Data.empty() ? std::span<const SqIndex::Segment3Entry>() : span_cast<SqIndex::Segment3Entry>(Data, IndexHeader.UnknownSegment3.Offset, IndexHeader.UnknownSegment3.Size, 1)) {
+	, Segment3(Data.empty() ? std::span<const SqIndex::Segment3Entry>() : span_cast<SqIndex::Segment3Entry>(Data, IndexHeader.UnknownSegment3.Offset, IndexHeader.UnknownSegment3.Size, 1))
+	, m_verifyOnce(strictVerify ? std::make_shared<std::once_flag>() : nullptr) {
 
 	if (strictVerify) {
 		Header.VerifySqpackHeader(SqpackType::SqIndex);
@@ -22,23 +38,39 @@ Sqex::Sqpack::Reader::SqIndexType<HashLocatorT, TextLocatorT>::SqIndexType(const
 			throw CorruptDataException("TextLocators has an invalid size alignment");
 		if (IndexHeader.UnknownSegment3.Size % sizeof SqIndex::Segment3Entry)
 			throw CorruptDataException("Segment3 has an invalid size alignment");
-		IndexHeader.HashLocatorSegment.Sha1.Verify(HashLocators, "HashLocatorSegment has invalid data SHA-1");
-		IndexHeader.TextLocatorSegment.Sha1.Verify(TextLocators, "TextLocatorSegment has invalid data SHA-1");
-		IndexHeader.UnknownSegment3.Sha1.Verify(Segment3, "UnknownSegment3 has invalid data SHA-1");
 	}
 }
 
-Sqex::Sqpack::Reader::SqIndex1Type::SqIndex1Type(const RandomAccessStream* stream, bool strictVerify)
-	: SqIndexType<SqIndex::PairHashLocator, SqIndex::PairHashWithTextLocator>(stream, strictVerify)
+template<typename HashLocatorT, typename TextLocatorT>
+void Sqex::Sqpack::Reader::SqIndexType<HashLocatorT, TextLocatorT>::VerifyOnFirstUse() const {
+	if (m_verifyOnce)
+		std::call_once(*m_verifyOnce, [this]() { VerifySegmentHashes(); });
+}
+
+template<typename HashLocatorT, typename TextLocatorT>
+void Sqex::Sqpack::Reader::SqIndexType<HashLocatorT, TextLocatorT>::VerifySegmentHashes() const {
+	IndexHeader.HashLocatorSegment.Sha1.Verify(HashLocators, "HashLocatorSegment has invalid data SHA-1");
+	IndexHeader.TextLocatorSegment.Sha1.Verify(TextLocators, "TextLocatorSegment has invalid data SHA-1");
+	IndexHeader.UnknownSegment3.Sha1.Verify(Segment3, "UnknownSegment3 has invalid data SHA-1");
+}
+
+Sqex::Sqpack::Reader::SqIndex1Type::SqIndex1Type(std::shared_ptr<const RandomAccessStream> stream, bool strictVerify)
+	: SqIndexType<SqIndex::PairHashLocator, SqIndex::PairHashWithTextLocator>(std::move(stream), strictVerify)
 	, PathHashLocators(Data.empty() ? std::span<const SqIndex::PathHashLocator>() : span_cast<SqIndex::PathHashLocator>(Data, IndexHeader.PathHashLocatorSegment.Offset, IndexHeader.PathHashLocatorSegment.Size, 1)) {
 	if (strictVerify) {
 		if (IndexHeader.PathHashLocatorSegment.Size % sizeof SqIndex::PathHashLocator)
 			throw CorruptDataException("PathHashLocators has an invalid size alignment");
-		IndexHeader.PathHashLocatorSegment.Sha1.Verify(PathHashLocators, "PathHashLocatorSegment has invalid data SHA-1");
 	}
+	m_hashLocatorTable.Build(HashLocators, PairHashLocatorKey);
+}
+
+void Sqex::Sqpack::Reader::SqIndex1Type::VerifySegmentHashes() const {
+	SqIndexType::VerifySegmentHashes();
+	IndexHeader.PathHashLocatorSegment.Sha1.Verify(PathHashLocators, "PathHashLocatorSegment has invalid data SHA-1");
 }
 
 std::span<const Sqex::Sqpack::SqIndex::PairHashLocator> Sqex::Sqpack::Reader::SqIndex1Type::GetPairHashLocators(uint32_t pathHash) const {
+	VerifyOnFirstUse();
 	const auto it = std::lower_bound(PathHashLocators.begin(), PathHashLocators.end(), pathHash, PathSpecComparator());
 	if (it == PathHashLocators.end() || it->PathHash != pathHash)
 		throw std::out_of_range(std::format("PathHash {:08x} not found", pathHash));
@@ -47,22 +79,24 @@ std::span<const Sqex::Sqpack::SqIndex::PairHashLocator> Sqex::Sqpack::Reader::Sq
 }
 
 const Sqex::Sqpack::SqIndex::LEDataLocator& Sqex::Sqpack::Reader::SqIndex1Type::GetLocator(uint32_t pathHash, uint32_t nameHash) const {
-	const auto locators = GetPairHashLocators(pathHash);
-	const auto it = std::lower_bound(locators.begin(), locators.end(), nameHash, PathSpecComparator());
-	if (it == locators.end() || it->NameHash != nameHash)
+	VerifyOnFirstUse();
+	const auto item = m_hashLocatorTable.Find(HashLocators, PairHashLocatorKey, (static_cast<uint64_t>(pathHash) << 32) | nameHash);
+	if (!item)
 		throw std::out_of_range(std::format("NameHash {:08x} in PathHash {:08x} not found", nameHash, pathHash));
-	return it->Locator;
+	return item->Locator;
 }
 
-Sqex::Sqpack::Reader::SqIndex2Type::SqIndex2Type(const RandomAccessStream* stream, bool strictVerify)
-	: SqIndexType<SqIndex::FullHashLocator, SqIndex::FullHashWithTextLocator>(stream, strictVerify) {
+Sqex::Sqpack::Reader::SqIndex2Type::SqIndex2Type(std::shared_ptr<const RandomAccessStream> stream, bool strictVerify)
+	: SqIndexType<SqIndex::FullHashLocator, SqIndex::FullHashWithTextLocator>(std::move(stream), strictVerify) {
+	m_hashLocatorTable.Build(HashLocators, FullHashLocatorKey);
 }
 
 const Sqex::Sqpack::SqIndex::LEDataLocator& Sqex::Sqpack::Reader::SqIndex2Type::GetLocator(uint32_t fullPathHash) const {
-	const auto it = std::lower_bound(HashLocators.begin(), HashLocators.end(), fullPathHash, PathSpecComparator());
-	if (it == HashLocators.end() || it->FullPathHash != fullPathHash)
+	VerifyOnFirstUse();
+	const auto item = m_hashLocatorTable.Find(HashLocators, FullHashLocatorKey, fullPathHash);
+	if (!item)
 		throw std::out_of_range(std::format("FullPathHash {:08x} not found", fullPathHash));
-	return it->Locator;
+	return item->Locator;
 }
 
 Sqex::Sqpack::Reader::SqDataType::SqDataType(std::shared_ptr<RandomAccessStream> stream, const uint32_t datIndex, bool strictVerify)
@@ -102,22 +136,22 @@ Sqex::Sqpack::Reader Sqex::Sqpack::Reader::FromPath(const std::filesystem::path&
 
 	if (exists(index1Path) && exists(index2Path)) {
 		return Reader(
-			FileRandomAccessStream(index1Path),
-			FileRandomAccessStream(index2Path),
+			std::make_shared<MemoryMappedRandomAccessStream>(index1Path),
+			std::make_shared<MemoryMappedRandomAccessStream>(index2Path),
 			dataStreams);
 	}
 
 	if (exists(index2Path)) {
 		return Reader(
-			MemoryRandomAccessStream(span_cast<uint8_t, char>(EmptyIndexFileData)),
-			FileRandomAccessStream(index2Path),
+			std::make_shared<MemoryRandomAccessStream>(span_cast<uint8_t, char>(EmptyIndexFileData)),
+			std::make_shared<MemoryMappedRandomAccessStream>(index2Path),
 			dataStreams);
 	}
 
 	if (exists(index1Path)) {
 		return Reader(
-			FileRandomAccessStream(index1Path),
-			MemoryRandomAccessStream(span_cast<uint8_t, char>(EmptyIndexFileData)),
+			std::make_shared<MemoryMappedRandomAccessStream>(index1Path),
+			std::make_shared<MemoryRandomAccessStream>(span_cast<uint8_t, char>(EmptyIndexFileData)),
 			dataStreams);
 	}
 	
@@ -125,8 +159,16 @@ Sqex::Sqpack::Reader Sqex::Sqpack::Reader::FromPath(const std::filesystem::path&
 }
 
 Sqex::Sqpack::Reader::Reader(const RandomAccessStream& indexStream1, const RandomAccessStream& indexStream2, std::vector<std::shared_ptr<RandomAccessStream>> dataStreams, bool strictVerify)
-	: Index1(&indexStream1, strictVerify)
-	, Index2(&indexStream2, strictVerify) {
+	: Reader(
+		std::make_shared<MemoryRandomAccessStream>(indexStream1),
+		std::make_shared<MemoryRandomAccessStream>(indexStream2),
+		std::move(dataStreams),
+		strictVerify) {
+}
+
+Sqex::Sqpack::Reader::Reader(std::shared_ptr<const RandomAccessStream> indexStream1, std::shared_ptr<const RandomAccessStream> indexStream2, std::vector<std::shared_ptr<RandomAccessStream>> dataStreams, bool strictVerify)
+	: Index1(std::move(indexStream1), strictVerify)
+	, Index2(std::move(indexStream2), strictVerify) {
 
 	std::vector<std::pair<SqIndex::LEDataLocator, std::tuple<uint32_t, uint32_t, const char*>>> offsets1;
 	offsets1.reserve(
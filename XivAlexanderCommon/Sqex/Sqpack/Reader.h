@@ -6,9 +6,56 @@
 
 namespace Sqex::Sqpack {
 	struct Reader {
+		// Open-addressing table mapping a locator key to its index in a locator segment.
+		// Slots store (index + 1), so that 0 can denote an empty slot.
+		class LocatorHashTable {
+			std::vector<uint32_t> m_slots;
+			size_t m_mask = 0;
+
+			static size_t Mix(uint64_t key) {
+				return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32);
+			}
+
+		public:
+			template<typename T, typename KeyFn>
+			void Build(std::span<const T> items, KeyFn keyOf) {
+				size_t capacity = 16;
+				while (capacity < items.size() * 2)
+					capacity <<= 1;
+				m_slots.clear();
+				m_slots.resize(capacity);
+				m_mask = capacity - 1;
+				for (size_t i = 0; i < items.size(); ++i) {
+					const auto key = keyOf(items[i]);
+					for (auto slot = Mix(key) & m_mask; ; slot = (slot + 1) & m_mask) {
+						if (!m_slots[slot]) {
+							m_slots[slot] = static_cast<uint32_t>(i + 1);
+							break;
+						}
+						// keep the first occurrence, as std::lower_bound would have found it
+						if (keyOf(items[m_slots[slot] - 1]) == key)
+							break;
+					}
+				}
+			}
+
+			template<typename T, typename KeyFn>
+			const T* Find(std::span<const T> items, KeyFn keyOf, uint64_t key) const {
+				if (m_slots.empty())
+					return nullptr;
+				for (auto slot = Mix(key) & m_mask; m_slots[slot]; slot = (slot + 1) & m_mask) {
+					const auto& item = items[m_slots[slot] - 1];
+					if (keyOf(item) == key)
+						return &item;
+				}
+				return nullptr;
+			}
+		};
+
 		template<typename HashLocatorT, typename TextLocatorT> 
 		struct SqIndexType {
-			const std::vector<uint8_t> Data;
+			const std::shared_ptr<const RandomAccessStream> Storage;
+			const std::span<const uint8_t> Data;
 			const SqpackHeader& Header{};
 			const SqIndex::Header& IndexHeader{};
 			const std::span<const HashLocatorT> HashLocators;
@@ -16,6 +63,7 @@ namespace Sqex::Sqpack {
 			const std::span<const SqIndex::Segment3Entry> Segment3;
 
 			const SqIndex::LEDataLocator& GetLocatorFromTextLocators(const char* fullPath) const {
+				VerifyOnFirstUse();
 				const auto it = std::lower_bound(TextLocators.begin(), TextLocators.end(), fullPath, PathSpecComparator());
 				if (it == TextLocators.end() || _strcmpi(it->FullPath, fullPath) != 0)
 					throw std::out_of_range(std::format("Entry {} not found", fullPath));
@@ -24,7 +72,15 @@ namespace Sqex::Sqpack {
 
 		protected:
 			friend struct Reader;
-			SqIndexType(const RandomAccessStream* stream, bool strictVerify);
+			LocatorHashTable m_hashLocatorTable;
+
+			// SHA-1 of segments are only checked on first lookup, so that opening every index does not hash all of them.
+			const std::shared_ptr<std::once_flag> m_verifyOnce;
+
+			SqIndexType(std::shared_ptr<const RandomAccessStream> stream, bool strictVerify);
+
+			void VerifyOnFirstUse() const;
+			virtual void VerifySegmentHashes() const;
 		};
 
 		struct SqIndex1Type : SqIndexType<SqIndex::PairHashLocator, SqIndex::PairHashWithTextLocator> {
@@ -35,7 +91,9 @@ namespace Sqex::Sqpack {
 
 		protected:
 			friend struct Reader;
-			SqIndex1Type(const RandomAccessStream* stream, bool strictVerify);
+			SqIndex1Type(std::shared_ptr<const RandomAccessStream> stream, bool strictVerify);
+
+			void VerifySegmentHashes() const override;
 		};
 
 		struct SqIndex2Type : SqIndexType<SqIndex::FullHashLocator, SqIndex::FullHashWithTextLocator> {
@@ -43,7 +101,7 @@ namespace Sqex::Sqpack {
 
 		protected:
 			friend struct Reader;
-			SqIndex2Type(const RandomAccessStream* stream, bool strictVerify);
+			SqIndex2Type(std::shared_ptr<const RandomAccessStream> stream, bool strictVerify);
 		};
 
 		struct SqDataType {
@@ -67,6 +125,9 @@ namespace Sqex::Sqpack {
 		std::vector<std::pair<SqIndex::LEDataLocator, EntryInfoType>> EntryInfo;
 
 		Reader(const RandomAccessStream& indexStream1, const RandomAccessStream& indexStream2, std::vector<std::shared_ptr<RandomAccessStream>> dataStreams, bool strictVerify = false);
+
+		// Index streams that expose GetDirectView (memory mapped or in-memory) are used in place without copying.
+		Reader(std::shared_ptr<const RandomAccessStream> indexStream1, std::shared_ptr<const RandomAccessStream> indexStream2, std::vector<std::shared_ptr<RandomAccessStream>> dataStreams, bool strictVerify = false);
 		
 		static Reader FromPath(const std::filesystem::path& indexFile, bool strictVerify = false);
 
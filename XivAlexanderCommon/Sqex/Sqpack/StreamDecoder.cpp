@@ -2,9 +2,52 @@
 #include "XivAlexanderCommon/Sqex/Sqpack/StreamDecoder.h"
 
 #include "XivAlexanderCommon/Sqex/Sqpack/BinaryStreamDecoder.h"
+#include "XivAlexanderCommon/Sqex/Sqpack/DecodedBlockCache.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/EmptyOrObfuscatedStreamDecoder.h"
+#include "XivAlexanderCommon/Sqex/Sqpack/HotSwappableEntryProvider.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/ModelStreamDecoder.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/TextureStreamDecoder.h"
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
+static std::shared_ptr<Utils::ZlibReusableInflater> AcquireInflater() {
+	static std::mutex s_mtx;
+	static std::vector<std::unique_ptr<Utils::ZlibReusableInflater>> s_free;
+
+	std::unique_ptr<Utils::ZlibReusableInflater> inflater;
+	{
+		const auto lock = std::lock_guard(s_mtx);
+		if (!s_free.empty()) {
+			inflater = std::move(s_free.back());
+			s_free.pop_back();
+		}
+	}
+	if (!inflater)
+		inflater = std::make_unique<Utils::ZlibReusableInflater>(-MAX_WBITS);
+
+	return { inflater.release(), [](Utils::ZlibReusableInflater* p) {
+		const auto lock = std::lock_guard(s_mtx);
+		if (s_free.size() < Utils::Win32::GetCoreCount())
+			s_free.emplace_back(p);
+		else
+			delete p;
+	} };
+}
+
+static std::vector<uint8_t> InflateBlock(std::span<const uint8_t> read) {
+	if (read.size_bytes() < sizeof Sqex::Sqpack::SqData::BlockHeader)
+		throw Sqex::CorruptDataException("Failed to read block header");
+
+	const auto& blockHeader = *reinterpret_cast<const Sqex::Sqpack::SqData::BlockHeader*>(&read[0]);
+	if (sizeof blockHeader + blockHeader.CompressedSize > read.size_bytes())
+		throw Sqex::CorruptDataException("Failed to read block");
+
+	std::vector<uint8_t> decoded(blockHeader.DecompressedSize);
+	const auto inflated = (*AcquireInflater())(read.subspan(sizeof blockHeader, blockHeader.CompressedSize), std::span(decoded));
+	if (inflated.size_bytes() != decoded.size())
+		throw Sqex::CorruptDataException(std::format("Expected {} bytes, inflated to {} bytes",
+			decoded.size(), inflated.size_bytes()));
+	return decoded;
+}
 
 void Sqex::Sqpack::StreamDecoder::ReadStreamState::AttemptSatisfyRequestOffset(const uint32_t requestOffset) {
 	if (RequestOffsetVerify < requestOffset) {
@@ -24,51 +67,113 @@ void Sqex::Sqpack::StreamDecoder::ReadStreamState::AttemptSatisfyRequestOffset(c
 		throw CorruptDataException("Duplicate read on same region");
 }
 
-void Sqex::Sqpack::StreamDecoder::ReadStreamState::Progress(const uint32_t requestOffset, uint32_t blockOffset) {
-	const auto read = std::span(&ReadBuffer[0], static_cast<size_t>(Underlying.ReadStreamPartial(blockOffset, &ReadBuffer[0], ReadBuffer.size())));
-	const auto& blockHeader = *reinterpret_cast<const SqData::BlockHeader*>(&ReadBuffer[0]);
-
-	if (ReadBuffer.size() < sizeof blockHeader + blockHeader.CompressedSize) {
-		ReadBuffer.resize(static_cast<uint16_t>(sizeof blockHeader + blockHeader.CompressedSize));
-		Progress(requestOffset, blockOffset);
-		return;
+uint32_t Sqex::Sqpack::StreamDecoder::ReadStreamState::Progress(const uint32_t requestOffset, uint32_t blockOffset) {
+	DecodedBlockCache::Block cached;
+	if (Decoder.m_useBlockCache)
+		cached = DecodedBlockCache::Shared().Find(Decoder.m_stream, blockOffset);
+
+	std::span<const uint8_t> read;
+	uint32_t decompressedSize;
+	if (cached) {
+		decompressedSize = static_cast<uint32_t>(cached->size());
+	} else {
+		read = Decoder.ReadBlock(blockOffset, Decoder.m_readBuffer);
+		decompressedSize = read.size_bytes() < sizeof SqData::BlockHeader ? 0 : reinterpret_cast<const SqData::BlockHeader*>(&read[0])->DecompressedSize.Value();
 	}
 
 	AttemptSatisfyRequestOffset(requestOffset);
 	if (TargetBuffer.empty())
+		return decompressedSize;
+
+	RequestOffsetVerify += decompressedSize;
+
+	if (RelativeOffset >= decompressedSize) {
+		RelativeOffset -= decompressedSize;
+		return decompressedSize;
+	}
+
+	const auto target = TargetBuffer.subspan(0, std::min(TargetBuffer.size_bytes(), static_cast<size_t>(decompressedSize - RelativeOffset)));
+	if (cached) {
+		std::copy_n(&(*cached)[static_cast<size_t>(RelativeOffset)], target.size_bytes(), target.begin());
+
+	} else if (const auto& blockHeader = *reinterpret_cast<const SqData::BlockHeader*>(&read[0]);
+		blockHeader.CompressedSize == SqData::BlockHeader::CompressedSizeNotCompressed) {
+		if (sizeof blockHeader + blockHeader.DecompressedSize > read.size_bytes())
+			throw CorruptDataException("Failed to read block");
+		std::copy_n(&read[static_cast<size_t>(sizeof blockHeader + RelativeOffset)], target.size(), target.begin());
+
+	} else if (Decoder.m_useBlockCache) {
+		auto decoded = std::make_shared<const std::vector<uint8_t>>(InflateBlock(read));
+		std::copy_n(&(*decoded)[static_cast<size_t>(RelativeOffset)], target.size_bytes(), target.begin());
+		DecodedBlockCache::Shared().Put(Decoder.m_stream, blockOffset, std::move(decoded));
+
+	} else if (RelativeOffset) {
+		const auto decoded = InflateBlock(read);
+		std::copy_n(&decoded[static_cast<size_t>(RelativeOffset)], target.size_bytes(), target.begin());
+
+	} else {
+		if (sizeof blockHeader + blockHeader.CompressedSize > read.size_bytes())
+			throw CorruptDataException("Failed to read block");
+
+		const auto inflater = AcquireInflater();
+		const auto buf = (*inflater)(read.subspan(sizeof blockHeader, blockHeader.CompressedSize), target);
+		if (buf.size_bytes() != target.size_bytes())
+			throw CorruptDataException(std::format("Expected {} bytes, inflated to {} bytes",
+				target.size_bytes(), buf.size_bytes()));
+	}
+
+	TargetBuffer = TargetBuffer.subspan(target.size_bytes());
+	RelativeOffset = 0;
+	return decompressedSize;
+}
+
+Sqex::Sqpack::StreamDecoder::StreamDecoder(std::shared_ptr<const EntryProvider> stream)
+	: m_stream(std::move(stream))
+	, m_maxBlockSize(sizeof SqData::BlockHeader)
+	, m_useBlockCache(!dynamic_cast<const HotSwappableEntryProvider*>(m_stream.get())) {
+}
+
+void Sqex::Sqpack::StreamDecoder::PrefetchBlocks(std::vector<uint32_t> blockOffsets) {
+	if (!m_useBlockCache)
 		return;
 
-	RequestOffsetVerify += blockHeader.DecompressedSize;
-
-	if (RelativeOffset < blockHeader.DecompressedSize) {
-		auto target = TargetBuffer.subspan(0, std::min(TargetBuffer.size_bytes(), static_cast<size_t>(blockHeader.DecompressedSize - RelativeOffset)));
-		if (blockHeader.CompressedSize == SqData::BlockHeader::CompressedSizeNotCompressed) {
-			std::copy_n(&read[static_cast<size_t>(sizeof blockHeader + RelativeOffset)], target.size(), target.begin());
-
-		} else {
-			if (sizeof blockHeader + blockHeader.CompressedSize > read.size_bytes())
-				throw CorruptDataException("Failed to read block");
-
-			if (RelativeOffset) {
-				const auto buf = Inflater(read.subspan(sizeof blockHeader, blockHeader.CompressedSize), blockHeader.DecompressedSize);
-				if (buf.size_bytes() != blockHeader.DecompressedSize)
-					throw CorruptDataException(std::format("Expected {} bytes, inflated to {} bytes",
-						blockHeader.DecompressedSize.Value(), buf.size_bytes()));
-				std::copy_n(&buf[static_cast<size_t>(RelativeOffset)],
-					target.size_bytes(),
-					target.begin());
-			} else {
-				const auto buf = Inflater(read.subspan(sizeof blockHeader, blockHeader.CompressedSize), target);
-				if (buf.size_bytes() != target.size_bytes())
-					throw CorruptDataException(std::format("Expected {} bytes, inflated to {} bytes",
-						target.size_bytes(), buf.size_bytes()));
-			}
+	auto& cache = DecodedBlockCache::Shared();
+	std::ranges::sort(blockOffsets);
+	blockOffsets.erase(std::ranges::unique(blockOffsets).begin(), blockOffsets.end());
+	std::erase_if(blockOffsets, [&](uint32_t blockOffset) { return cache.Contains(m_stream, blockOffset); });
+
+	// Do not let a single read evict most of what it has just decoded.
+	if (const auto maxBlocks = static_cast<size_t>(cache.GetByteBudget() / 4 / EntryBlockDataSize); blockOffsets.size() > maxBlocks)
+		blockOffsets.resize(maxBlocks);
+	if (blockOffsets.size() < 2)
+		return;
+
+	Utils::Win32::ParallelFor(blockOffsets.size(), [&](size_t i) {
+		try {
+			std::vector<uint8_t> buffer;
+			const auto read = ReadBlock(blockOffsets[i], buffer);
+			if (reinterpret_cast<const SqData::BlockHeader*>(&buffer[0])->CompressedSize == SqData::BlockHeader::CompressedSizeNotCompressed)
+				return;
+			cache.Put(m_stream, blockOffsets[i], std::make_shared<const std::vector<uint8_t>>(InflateBlock(read)));
+		} catch (const std::exception&) {
+			// The sequential pass reports the error, if the block is actually needed.
 		}
-		TargetBuffer = TargetBuffer.subspan(target.size_bytes());
+	});
+}
+
+std::span<const uint8_t> Sqex::Sqpack::StreamDecoder::ReadBlock(uint32_t blockOffset, std::vector<uint8_t>& buffer) const {
+	if (buffer.size() < m_maxBlockSize)
+		buffer.resize(m_maxBlockSize);
+
+	const auto read = static_cast<size_t>(m_stream->ReadStreamPartial(blockOffset, &buffer[0], buffer.size()));
+	const auto& blockHeader = *reinterpret_cast<const SqData::BlockHeader*>(&buffer[0]);
+
+	if (buffer.size() < sizeof blockHeader + blockHeader.CompressedSize) {
+		buffer.resize(static_cast<uint16_t>(sizeof blockHeader + blockHeader.CompressedSize));
+		return ReadBlock(blockOffset, buffer);
+	}
 
-		RelativeOffset = 0;
-	} else
-		RelativeOffset -= blockHeader.DecompressedSize;
+	return std::span(buffer).subspan(0, read);
 }
 
 std::unique_ptr<Sqex::Sqpack::StreamDecoder> Sqex::Sqpack::StreamDecoder::CreateNew(const SqData::FileEntryHeader& header, std::shared_ptr<const EntryProvider> stream) {
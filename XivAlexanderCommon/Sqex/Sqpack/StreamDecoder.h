@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "XivAlexanderCommon/Sqex/Sqpack/EntryProvider.h"
 #include "XivAlexanderCommon/Utils/ZlibWrapper.h"
 
@@ -7,38 +9,42 @@ namespace Sqex::Sqpack {
 	class StreamDecoder {
 	protected:
 		struct ReadStreamState {
-			const RandomAccessStream& Underlying;
+			StreamDecoder& Decoder;
 			std::span<uint8_t> TargetBuffer;
-			std::vector<uint8_t> ReadBuffer;
 			uint64_t RelativeOffset = 0;
 			uint32_t RequestOffsetVerify = 0;
-			bool HadCompressedBlocks = false;
-
-			ZlibReusableInflater Inflater{ -MAX_WBITS };
-
-			[[nodiscard]] const auto& AsHeader() const {
-				return *reinterpret_cast<const SqData::BlockHeader*>(&ReadBuffer[0]);
-			}
 
 		private:
 			void AttemptSatisfyRequestOffset(const uint32_t requestOffset);
 
 		public:
-			void Progress(const uint32_t requestOffset, uint32_t blockOffset);
+			// Returns the decompressed size of the block at blockOffset.
+			uint32_t Progress(const uint32_t requestOffset, uint32_t blockOffset);
 		};
 
 		const std::shared_ptr<const EntryProvider> m_stream;
 		size_t m_maxBlockSize{};
 
+		// Guards m_readBuffer, and any state derived decoders mutate in ReadStreamPartial.
+		std::mutex m_readMtx;
+		std::vector<uint8_t> m_readBuffer;
+
+		// Providers that may swap their content behind the same address must not go through DecodedBlockCache.
+		const bool m_useBlockCache;
+
 	public:
-		StreamDecoder(std::shared_ptr<const EntryProvider> stream)
-			: m_stream(std::move(stream))
-			, m_maxBlockSize(sizeof SqData::BlockHeader) {
-		}
+		StreamDecoder(std::shared_ptr<const EntryProvider> stream);
 
 		virtual uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) = 0;
 		virtual ~StreamDecoder() = default;
 
 		static std::unique_ptr<StreamDecoder> CreateNew(const SqData::FileEntryHeader& header, std::shared_ptr<const EntryProvider> stream);
+
+	protected:
+		// Inflates blocks not yet in DecodedBlockCache in parallel, so that following Progress calls hit the cache.
+		void PrefetchBlocks(std::vector<uint32_t> blockOffsets);
+
+	private:
+		std::span<const uint8_t> ReadBlock(uint32_t blockOffset, std::vector<uint8_t>& buffer) const;
 	};
 }
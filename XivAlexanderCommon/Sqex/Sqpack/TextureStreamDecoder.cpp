@@ -35,6 +35,8 @@ Sqex::Sqpack::TextureStreamDecoder::TextureStreamDecoder(const SqData::FileEntry
 			.RemainingBlockSizes = m_stream->ReadStreamIntoVector<uint16_t>(readOffset, locator.SubBlockCount),
 			});
 		readOffset += std::span(m_blocks.back().RemainingBlockSizes).size_bytes();
+		for (const auto blockSize : m_blocks.back().RemainingBlockSizes)
+			m_maxBlockSize = std::max<size_t>(m_maxBlockSize, blockSize);
 		baseRequestOffset += mipmapPlaneSize;
 	}
 }
@@ -43,10 +45,10 @@ uint64_t Sqex::Sqpack::TextureStreamDecoder::ReadStreamPartial(uint64_t offset,
 	if (!length)
 		return 0;
 
+	const auto lock = std::lock_guard(m_readMtx);
 	ReadStreamState info{
-		.Underlying = *m_stream,
+		.Decoder = *this,
 		.TargetBuffer = std::span(static_cast<uint8_t*>(buf), static_cast<size_t>(length)),
-		.ReadBuffer = std::vector<uint8_t>(m_maxBlockSize),
 		.RelativeOffset = offset,
 	};
 
@@ -68,17 +70,37 @@ uint64_t Sqex::Sqpack::TextureStreamDecoder::ReadStreamPartial(uint64_t offset,
 	if (it == m_blocks.end() || (it != m_blocks.end() && it != m_blocks.begin() && it->RequestOffset > info.RelativeOffset))
 		--it;
 
+	// Sub-block request offsets are only known after inflating preceding ones; every sub-block but the last
+	// of a locator holds EntryBlockDataSize bytes, which is good enough for deciding what to prefetch.
+	{
+		const auto requestBegin = info.RelativeOffset;
+		const auto requestEnd = info.RelativeOffset + info.TargetBuffer.size_bytes();
+		std::vector<uint32_t> touchedBlockOffsets;
+		for (auto i = it; i != m_blocks.end() && i->RequestOffset < requestEnd; ++i) {
+			auto blockOffset = i->BlockOffset;
+			for (size_t j = 0, j_ = std::max<size_t>(1, i->RemainingBlockSizes.size()); j < j_; ++j) {
+				const auto blockRequestOffset = i->RequestOffset + static_cast<uint64_t>(j) * EntryBlockDataSize;
+				if (blockRequestOffset >= requestEnd)
+					break;
+				if (blockRequestOffset + EntryBlockDataSize > requestBegin)
+					touchedBlockOffsets.emplace_back(blockOffset);
+				if (j < i->RemainingBlockSizes.size())
+					blockOffset += i->RemainingBlockSizes[j];
+			}
+		}
+		PrefetchBlocks(std::move(touchedBlockOffsets));
+	}
+
 	while (it != m_blocks.end()) {
-		info.Progress(it->RequestOffset, it->BlockOffset);
+		const auto decompressedSize = info.Progress(it->RequestOffset, it->BlockOffset);
 
 		if (it->RemainingBlockSizes.empty()) {
 			++it;
 		} else {
-			const auto& blockHeader = info.AsHeader();
 			auto newBlockInfo = BlockInfo{
-				.RequestOffset = it->RequestOffset + blockHeader.DecompressedSize,
+				.RequestOffset = it->RequestOffset + decompressedSize,
 				.BlockOffset = it->BlockOffset + it->RemainingBlockSizes.front(),
-				.RemainingDecompressedSize = it->RemainingDecompressedSize - blockHeader.DecompressedSize,
+				.RemainingDecompressedSize = it->RemainingDecompressedSize - decompressedSize,
 				.RemainingBlockSizes = std::move(it->RemainingBlockSizes),
 			};
 
@@ -93,6 +115,5 @@ uint64_t Sqex::Sqpack::TextureStreamDecoder::ReadStreamPartial(uint64_t offset,
 			break;
 	}
 
-	m_maxBlockSize = info.ReadBuffer.size();
 	return length - info.TargetBuffer.size_bytes();
 }
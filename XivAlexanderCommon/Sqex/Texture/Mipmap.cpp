@@ -483,59 +483,23 @@ std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> Sqex::Texture::MemoryBackedMi
 		}
 
 		case Format::DXT1:
-		{
-			if (cbSource < pixelCount * 8)
-				throw std::runtime_error("Truncated data detected");
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len; i < count; i += 8, pos += 8) {
-					DecompressBlockDXT1(
-						pos / 2 % width,
-						pos / 2 / width * 4,
-						width, &buf8[i], reinterpret_cast<uint32_t*>(&rgba8888view[0]));
-				}
-			}
-			break;
-		}
-
 		case Format::DXT3:
-		{
-			if (cbSource < pixelCount * 16)
-				throw std::runtime_error("Truncated data detected");
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len; i < count; i += 16, pos += 16) {
-					DecompressBlockDXT1(
-						pos / 4 % width,
-						pos / 4 / width * 4,
-						width, &buf8[i], reinterpret_cast<uint32_t*>(&rgba8888view[0]));
-					for (size_t dy = 0; dy < 4; dy += 1) {
-						for (size_t dx = 0; dx < 4; dx += 2) {
-							rgba8888view[dy * width + dx].A = 17 * (buf8[i + dy * 2 + dx / 2] & 0xF);
-							rgba8888view[dy * width + dx + 1].A = 17 * (buf8[i + dy * 2 + dx / 2] >> 4);
-						}
-					}
-				}
-			}
-			break;
-		}
-
 		case Format::DXT5:
 		{
-			if (cbSource < pixelCount * 16)
+			const auto blockSize = stream->Type == Format::DXT1 ? 8 : 16;
+			const auto cbBlocks = (static_cast<size_t>(width) + 3) / 4 * ((static_cast<size_t>(height) + 3) / 4) * blockSize;
+			if (cbSource < cbBlocks)
 				throw std::runtime_error("Truncated data detected");
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len; i < count; i += 16, pos += 16) {
-					DecompressBlockDXT5(
-						pos / 4 % width,
-						pos / 4 / width * 4,
-						width, &buf8[i], reinterpret_cast<uint32_t*>(&rgba8888view[0]));
-				}
-			}
+
+			std::vector<uint8_t> blocks(cbBlocks);
+			stream->ReadStream(0, std::span(blocks));
+			const auto target = reinterpret_cast<uint32_t*>(&rgba8888view[0]);
+			if (stream->Type == Format::DXT1)
+				BlockDecompressImageDXT1(width, height, blocks.data(), target);
+			else if (stream->Type == Format::DXT3)
+				BlockDecompressImageDXT3(width, height, blocks.data(), target);
+			else
+				BlockDecompressImageDXT5(width, height, blocks.data(), target);
 			break;
 		}
 
@@ -547,6 +511,32 @@ std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> Sqex::Texture::MemoryBackedMi
 	return std::make_shared<MemoryBackedMipmap>(stream->Width, stream->Height, stream->Depth, type, std::move(result));
 }
 
+std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> Sqex::Texture::MemoryBackedMipmap::NewBlockCompressedFrom(const MipmapStream* stream, Format type, Utils::DxtQuality quality) {
+	if (type != Format::DXT1 && type != Format::DXT3 && type != Format::DXT5)
+		throw std::invalid_argument("invalid block compression type");
+
+	const auto width = stream->Width;
+	const auto height = stream->Height;
+	const auto argb = NewARGB8888From(stream);
+	const auto pixels = argb->View<uint32_t>();
+
+	// Alpha of X8R8G8B8 is unspecified; make sure that DXT1 does not turn it into transparency.
+	if (stream->Type == Format::X8R8G8B8) {
+		for (auto& pixel : pixels)
+			pixel |= 0xFF000000U;
+	}
+
+	std::vector<uint8_t> result(RawDataLength(type, width, height, 1));
+	if (type == Format::DXT1)
+		BlockCompressImageDXT1(width, height, pixels.data(), result.data(), quality);
+	else if (type == Format::DXT3)
+		BlockCompressImageDXT3(width, height, pixels.data(), result.data(), quality);
+	else
+		BlockCompressImageDXT5(width, height, pixels.data(), result.data(), quality);
+
+	return std::make_shared<MemoryBackedMipmap>(stream->Width, stream->Height, stream->Depth, type, std::move(result));
+}
+
 uint64_t Sqex::Texture::MemoryBackedMipmap::ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const {
 	const auto available = static_cast<size_t>(std::min(m_data.size() - offset, length));
 	std::copy_n(&m_data[static_cast<size_t>(offset)], available, static_cast<char*>(buf));
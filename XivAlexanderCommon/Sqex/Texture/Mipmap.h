@@ -1,6 +1,7 @@
 #pragma once
 
 #include "XivAlexanderCommon/Sqex/Texture.h"
+#include "XivAlexanderCommon/Utils/Dxt.h"
 
 namespace Sqex::Texture {
 	class MipmapStream : public RandomAccessStream {
@@ -54,6 +55,7 @@ namespace Sqex::Texture {
 		}
 
 		static std::shared_ptr<MemoryBackedMipmap> NewARGB8888From(const MipmapStream* stream, Format type = Format::A8R8G8B8);
+		static std::shared_ptr<MemoryBackedMipmap> NewBlockCompressedFrom(const MipmapStream* stream, Format type, Utils::DxtQuality quality = Utils::DxtQuality::Normal);
 
 		[[nodiscard]] uint64_t StreamSize() const override { return static_cast<uint32_t>(m_data.size());  }
 		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override;
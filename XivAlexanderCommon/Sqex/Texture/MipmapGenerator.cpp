@@ -0,0 +1,280 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Texture/MipmapGenerator.h"
+
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
+namespace {
+	using Sqex::Texture::Format;
+
+	// Each level is produced in bands of this many rows, each band on its own thread.
+	constexpr size_t BandRowCount = 32;
+
+	// Support of the Kaiser filter in target pixels on each side, and the shape parameter of its window.
+	constexpr int KaiserWidth = 3;
+	constexpr double KaiserAlpha = 4.;
+
+	constexpr size_t LinearToSrgbTableSize = 8192;
+
+	const auto SrgbToLinearTable = [] {
+		std::array<float, 256> table{};
+		for (size_t i = 0; i < table.size(); ++i) {
+			const auto v = static_cast<double>(i) / 255.;
+			table[i] = static_cast<float>(v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4));
+		}
+		return table;
+	}();
+
+	const auto LinearToSrgbTable = [] {
+		std::array<uint8_t, LinearToSrgbTableSize> table{};
+		for (size_t i = 0; i < table.size(); ++i) {
+			const auto v = static_cast<double>(i) / (table.size() - 1);
+			const auto s = v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1. / 2.4) - 0.055;
+			table[i] = static_cast<uint8_t>(std::lround(s * 255.));
+		}
+		return table;
+	}();
+
+	// Pixels of a level, with every channel in [0, 1] and color channels in linear space.
+	struct LinearImage {
+		size_t Width = 0;
+		size_t Height = 0;
+		std::vector<__m128> Pixels;
+	};
+
+	__m128 ToLinear(uint32_t pixel, bool srgb) {
+		if (srgb) {
+			return _mm_setr_ps(
+				SrgbToLinearTable[pixel & 0xFF],
+				SrgbToLinearTable[(pixel >> 8) & 0xFF],
+				SrgbToLinearTable[(pixel >> 16) & 0xFF],
+				static_cast<float>(pixel >> 24) / 255.f);
+		}
+		const auto zero = _mm_setzero_si128();
+		const auto channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pixel)), zero), zero);
+		return _mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(1.f / 255.f));
+	}
+
+	uint32_t ToRgba8888(__m128 pixel, bool srgb) {
+		pixel = _mm_min_ps(_mm_max_ps(pixel, _mm_setzero_ps()), _mm_set1_ps(1.f));
+		const auto bytes = _mm_cvtps_epi32(_mm_mul_ps(pixel, _mm_set1_ps(255.f)));
+		const auto packed = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(bytes, bytes), bytes)));
+		if (!srgb)
+			return packed;
+
+		alignas(16) int32_t indices[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(_mm_mul_ps(pixel, _mm_set1_ps(static_cast<float>(LinearToSrgbTableSize - 1)))));
+		return LinearToSrgbTable[indices[0]]
+			| (LinearToSrgbTable[indices[1]] << 8)
+			| (LinearToSrgbTable[indices[2]] << 16)
+			| (packed & 0xFF000000U);
+	}
+
+	// Target pixel x takes source pixels from Step * x + FirstTap, weighted by Weights in order.
+	struct Kernel {
+		size_t Step;
+		int FirstTap;
+		std::vector<float> Weights;
+	};
+
+	double BesselI0(double x) {
+		double sum = 1, term = 1;
+		for (int k = 1; term > sum * 1e-12; ++k) {
+			term *= x * x / (4. * k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	Kernel MakeKernel(Sqex::Texture::MipmapFilter filter, size_t sourceSize, size_t targetSize) {
+		if (sourceSize == targetSize)
+			return { 1, 0, { 1.f } };
+
+		if (filter == Sqex::Texture::MipmapFilter::Box)
+			return { 2, 0, { .5f, .5f } };
+
+		Kernel kernel{ 2, 1 - 2 * KaiserWidth, {} };
+		double total = 0;
+		std::vector<double> weights;
+		for (auto tap = kernel.FirstTap; tap <= 2 * KaiserWidth; ++tap) {
+			// Distance between the centers of the source pixel and the target pixel, in target pixels.
+			const auto d = (tap - 0.5) / 2.;
+			const auto sinc = std::sin(std::numbers::pi * d) / (std::numbers::pi * d);
+			const auto r = d / KaiserWidth;
+			const auto window = BesselI0(KaiserAlpha * std::sqrt(std::max(0., 1. - r * r))) / BesselI0(KaiserAlpha);
+			weights.push_back(sinc * window);
+			total += weights.back();
+		}
+		for (const auto w : weights)
+			kernel.Weights.push_back(static_cast<float>(w / total));
+		return kernel;
+	}
+
+	// Filters source into a level half the size of it, and also stores the result as RGBA8888 into rgba8888.
+	// Source rows are read using loadRow, which may use the given buffer to hold the row and returns where the row is.
+	LinearImage Downsample(size_t sourceWidth, size_t sourceHeight, const std::function<const __m128*(size_t y, __m128* buffer)>& loadRow,
+		Sqex::Texture::MipmapFilter filter, bool srgb, bool keepLinear, uint32_t* rgba8888) {
+		LinearImage target{
+			.Width = std::max<size_t>(1, sourceWidth / 2),
+			.Height = std::max<size_t>(1, sourceHeight / 2),
+		};
+		if (keepLinear)
+			target.Pixels.resize(target.Width * target.Height);
+
+		const auto horizontal = MakeKernel(filter, sourceWidth, target.Width);
+		const auto vertical = MakeKernel(filter, sourceHeight, target.Height);
+
+		// Source rows are padded on both sides by repeating the edge pixels, so that taps never need to be clamped.
+		const auto pad = horizontal.Weights.size() + 1;
+		const auto clampRow = [&](ptrdiff_t y) {
+			return static_cast<size_t>(std::clamp<ptrdiff_t>(y, 0, static_cast<ptrdiff_t>(sourceHeight) - 1));
+		};
+
+		Utils::Win32::ParallelFor((target.Height + BandRowCount - 1) / BandRowCount, [&](size_t bandIndex) {
+			const auto y0 = bandIndex * BandRowCount;
+			const auto y1 = std::min(target.Height, y0 + BandRowCount);
+			const auto sourceY0 = static_cast<ptrdiff_t>(vertical.Step * y0) + vertical.FirstTap;
+			const auto sourceY1 = static_cast<ptrdiff_t>(vertical.Step * (y1 - 1)) + vertical.FirstTap + static_cast<ptrdiff_t>(vertical.Weights.size());
+
+			std::vector<__m128> paddedRow(sourceWidth + 2 * pad);
+			std::vector<__m128> filteredRows(static_cast<size_t>(sourceY1 - sourceY0) * target.Width);
+			for (auto sourceY = sourceY0; sourceY < sourceY1; ++sourceY) {
+				const auto row = loadRow(clampRow(sourceY), &paddedRow[pad]);
+				if (row != &paddedRow[pad])
+					std::copy_n(row, sourceWidth, &paddedRow[pad]);
+				std::fill_n(paddedRow.begin(), pad, paddedRow[pad]);
+				std::fill_n(paddedRow.begin() + pad + sourceWidth, pad, paddedRow[pad + sourceWidth - 1]);
+
+				auto* const out = &filteredRows[static_cast<size_t>(sourceY - sourceY0) * target.Width];
+				for (size_t x = 0; x < target.Width; ++x) {
+					const auto* in = &paddedRow[pad + horizontal.Step * x + horizontal.FirstTap];
+					auto sum = _mm_setzero_ps();
+					for (const auto w : horizontal.Weights)
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w), *in++));
+					out[x] = sum;
+				}
+			}
+
+			for (auto y = y0; y < y1; ++y) {
+				const auto firstRow = static_cast<size_t>(static_cast<ptrdiff_t>(vertical.Step * y) + vertical.FirstTap - sourceY0);
+				auto* const linearOut = keepLinear ? &target.Pixels[y * target.Width] : nullptr;
+				auto* const rgbaOut = &rgba8888[y * target.Width];
+				for (size_t x = 0; x < target.Width; ++x) {
+					const auto* in = &filteredRows[firstRow * target.Width + x];
+					auto sum = _mm_setzero_ps();
+					for (const auto w : vertical.Weights) {
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w), *in));
+						in += target.Width;
+					}
+					if (linearOut)
+						linearOut[x] = sum;
+					rgbaOut[x] = ToRgba8888(sum, srgb);
+				}
+			}
+		});
+
+		return target;
+	}
+
+	// Converts RGBA8888 pixels into one of the formats that are not RGBA8888 themselves.
+	std::vector<uint8_t> Encode(size_t width, size_t height, std::span<const uint32_t> pixels, Format type, Utils::DxtQuality quality) {
+		std::vector<uint8_t> result(Sqex::Texture::RawDataLength(type, width, height, 1));
+		switch (type) {
+			case Format::A4R4G4B4:
+				Utils::Win32::ParallelFor((height + BandRowCount - 1) / BandRowCount, [&](size_t bandIndex) {
+					const auto target = span_cast<Sqex::Texture::RGBA4444>(result);
+					for (auto i = bandIndex * BandRowCount * width, i_ = std::min(height, (bandIndex + 1) * BandRowCount) * width; i < i_; ++i) {
+						const Sqex::Texture::RGBA8888 pixel(pixels[i]);
+						target[i].SetFrom((pixel.R * 15 + 127) / 255, (pixel.G * 15 + 127) / 255, (pixel.B * 15 + 127) / 255, (pixel.A * 15 + 127) / 255);
+					}
+				});
+				break;
+
+			case Format::A1R5G5B5:
+				Utils::Win32::ParallelFor((height + BandRowCount - 1) / BandRowCount, [&](size_t bandIndex) {
+					const auto target = span_cast<Sqex::Texture::RGBA5551>(result);
+					for (auto i = bandIndex * BandRowCount * width, i_ = std::min(height, (bandIndex + 1) * BandRowCount) * width; i < i_; ++i) {
+						const Sqex::Texture::RGBA8888 pixel(pixels[i]);
+						target[i].SetFrom((pixel.R * 31 + 127) / 255, (pixel.G * 31 + 127) / 255, (pixel.B * 31 + 127) / 255, pixel.A >= 128 ? 1 : 0);
+					}
+				});
+				break;
+
+			case Format::DXT1:
+				Utils::BlockCompressImageDXT1(static_cast<uint32_t>(width), static_cast<uint32_t>(height), pixels.data(), result.data(), quality);
+				break;
+
+			case Format::DXT3:
+				Utils::BlockCompressImageDXT3(static_cast<uint32_t>(width), static_cast<uint32_t>(height), pixels.data(), result.data(), quality);
+				break;
+
+			case Format::DXT5:
+				Utils::BlockCompressImageDXT5(static_cast<uint32_t>(width), static_cast<uint32_t>(height), pixels.data(), result.data(), quality);
+				break;
+
+			default:
+				throw std::invalid_argument("unsupported target type");
+		}
+		return result;
+	}
+}
+
+std::vector<std::shared_ptr<Sqex::Texture::MemoryBackedMipmap>> Sqex::Texture::GenerateMipmapChain(const MipmapStream* base, Format type, const MipmapChainOptions& options, size_t mipmapCount) {
+	const auto isRgba8888 = type == Format::A8R8G8B8 || type == Format::X8R8G8B8;
+	if (!isRgba8888 && type != Format::A4R4G4B4 && type != Format::A1R5G5B5 && type != Format::DXT1 && type != Format::DXT3 && type != Format::DXT5)
+		throw std::invalid_argument("unsupported target type");
+	if (!mipmapCount)
+		throw std::invalid_argument("mipmap count must be a positive integer");
+	if (base->Depth != 1)
+		throw std::invalid_argument("only 2D textures are supported");
+
+	size_t levelCount = 1;
+	for (auto size = std::max(base->Width, base->Height); size > 1 && levelCount < mipmapCount; size /= 2)
+		++levelCount;
+
+	std::vector<std::shared_ptr<MemoryBackedMipmap>> result;
+	result.reserve(levelCount);
+
+	// The first level is taken as is if it is already in the target format.
+	std::shared_ptr<MemoryBackedMipmap> base8888;
+	if (base->Type != type || levelCount > 1) {
+		base8888 = MemoryBackedMipmap::NewARGB8888From(base, isRgba8888 ? type : Format::A8R8G8B8);
+		if (base->Type == Format::X8R8G8B8) {
+			for (auto& pixel : base8888->View<uint32_t>())
+				pixel |= 0xFF000000U;
+		}
+	}
+	if (base->Type == type)
+		result.emplace_back(std::make_shared<MemoryBackedMipmap>(base->Width, base->Height, 1, type, base->ReadStreamIntoVector<uint8_t>(0, RawDataLength(type, base->Width, base->Height, 1))));
+	else if (isRgba8888)
+		result.emplace_back(base8888);
+	else
+		result.emplace_back(std::make_shared<MemoryBackedMipmap>(base->Width, base->Height, 1, type, Encode(base->Width, base->Height, base8888->View<uint32_t>(), type, options.Quality)));
+
+	// Every other level is filtered from the previous one in linear space, without going through RGBA8888.
+	LinearImage previous{ .Width = base->Width, .Height = base->Height };
+	for (size_t level = 1; level < levelCount; ++level) {
+		const auto loadBaseRow = [&, basePixels = std::as_const(*base8888).View<uint32_t>()](size_t y, __m128* buffer) {
+			for (size_t x = 0; x < previous.Width; ++x)
+				buffer[x] = ToLinear(basePixels[y * previous.Width + x], options.Srgb);
+			return static_cast<const __m128*>(buffer);
+		};
+		const auto loadPreviousRow = [&](size_t y, __m128*) {
+			return static_cast<const __m128*>(&previous.Pixels[y * previous.Width]);
+		};
+
+		const auto width = std::max<size_t>(1, previous.Width / 2);
+		const auto height = std::max<size_t>(1, previous.Height / 2);
+		std::vector<uint8_t> rgba8888(width * height * sizeof(uint32_t));
+		auto next = Downsample(previous.Width, previous.Height,
+			level == 1 ? std::function<const __m128*(size_t, __m128*)>(loadBaseRow) : std::function<const __m128*(size_t, __m128*)>(loadPreviousRow),
+			options.Filter, options.Srgb, level + 1 < levelCount, span_cast<uint32_t>(rgba8888).data());
+		previous = std::move(next);
+
+		if (isRgba8888)
+			result.emplace_back(std::make_shared<MemoryBackedMipmap>(width, height, 1, type, std::move(rgba8888)));
+		else
+			result.emplace_back(std::make_shared<MemoryBackedMipmap>(width, height, 1, type, Encode(width, height, span_cast<uint32_t>(rgba8888), type, options.Quality)));
+	}
+
+	return result;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "XivAlexanderCommon/Sqex/Texture.h"
+#include "XivAlexanderCommon/Sqex/Texture/Mipmap.h"
+
+namespace Sqex::Texture {
+	enum class MipmapFilter {
+		Box,  // average of 2x2 pixels
+		Kaiser,  // Kaiser windowed sinc; sharper, at the cost of some ringing
+	};
+
+	struct MipmapChainOptions {
+		MipmapFilter Filter = MipmapFilter::Box;
+
+		// Whether color channels are sRGB encoded, and thus should be filtered after being converted to linear space.
+		// Turn off for data textures such as normal maps. Alpha is always filtered as is.
+		bool Srgb = true;
+
+		// Used if the target format is block compressed.
+		Utils::DxtQuality Quality = Utils::DxtQuality::Normal;
+	};
+
+	// Builds mipmaps of base in the given format, down to 1x1 or until there are mipmapCount of them.
+	// Supported formats are A8R8G8B8, X8R8G8B8, A4R4G4B4, A1R5G5B5, DXT1, DXT3, and DXT5.
+	std::vector<std::shared_ptr<MemoryBackedMipmap>> GenerateMipmapChain(const MipmapStream* base, Format type, const MipmapChainOptions& options = {}, size_t mipmapCount = SIZE_MAX);
+}
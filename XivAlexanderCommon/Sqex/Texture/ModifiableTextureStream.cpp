@@ -74,7 +74,7 @@ void Sqex::Texture::ModifiableTextureStream::Resize(size_t mipmapCount, size_t r
 		mipmaps.resize(mipmapCount);
 
 	m_header.MipmapCount = static_cast<uint16_t>(mipmapCount);
-	m_header.HeaderSize = static_cast<uint32_t>(Align(sizeof m_header + std::span(m_mipmapOffsets).size_bytes()));
+	m_header.HeaderSize = static_cast<uint32_t>(Align(sizeof m_header + mipmapCount * sizeof m_mipmapOffsets[0]));
 
 	m_mipmapOffsets.clear();
 	m_repeatedUnitSize = 0;
@@ -84,6 +84,53 @@ void Sqex::Texture::ModifiableTextureStream::Resize(size_t mipmapCount, size_t r
 	}
 }
 
+void Sqex::Texture::ModifiableTextureStream::ConvertTo(Format type, Utils::DxtQuality quality) {
+	std::function<std::shared_ptr<MipmapStream>(const MipmapStream*)> convert;
+	switch (type) {
+		case Format::A8R8G8B8:
+		case Format::X8R8G8B8:
+			convert = [type](const MipmapStream* mipmap) { return MemoryBackedMipmap::NewARGB8888From(mipmap, type); };
+			break;
+
+		case Format::DXT1:
+		case Format::DXT3:
+		case Format::DXT5:
+			convert = [type, quality](const MipmapStream* mipmap) { return MemoryBackedMipmap::NewBlockCompressedFrom(mipmap, type, quality); };
+			break;
+
+		default:
+			throw std::invalid_argument("unsupported target type");
+	}
+
+	// Large mipmaps get encoded on multiple threads on their own; convert into a copy so that failures leave this unchanged.
+	auto repeats = m_repeats;
+	for (auto& mipmaps : repeats) {
+		for (auto& mipmap : mipmaps) {
+			if (mipmap && mipmap->Type != type)
+				mipmap = convert(mipmap.get());
+		}
+	}
+
+	m_repeats = std::move(repeats);
+	m_header.Type = type;
+	Resize(m_header.MipmapCount, m_repeats.size());
+}
+
+void Sqex::Texture::ModifiableTextureStream::GenerateMipmaps(Format type, const MipmapChainOptions& options, size_t mipmapCount) {
+	// Generate into a copy so that failures leave this unchanged.
+	decltype(m_repeats) repeats;
+	for (const auto& mipmaps : m_repeats) {
+		if (!mipmaps.at(0))
+			throw std::invalid_argument("first mipmap is not set");
+		auto chain = GenerateMipmapChain(mipmaps[0].get(), type, options, mipmapCount);
+		repeats.emplace_back(std::make_move_iterator(chain.begin()), std::make_move_iterator(chain.end()));
+	}
+
+	m_repeats = std::move(repeats);
+	m_header.Type = type;
+	Resize(m_repeats[0].size(), m_repeats.size());
+}
+
 uint64_t Sqex::Texture::ModifiableTextureStream::StreamSize() const {
 	return Align(sizeof m_header + std::span(m_mipmapOffsets).size_bytes()) + m_repeats.size() * m_repeatedUnitSize;
 }
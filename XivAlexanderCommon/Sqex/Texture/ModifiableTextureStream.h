@@ -2,6 +2,7 @@
 #include "XivAlexanderCommon/Sqex.h"
 #include "XivAlexanderCommon/Sqex/Texture.h"
 #include "XivAlexanderCommon/Sqex/Texture/Mipmap.h"
+#include "XivAlexanderCommon/Sqex/Texture/MipmapGenerator.h"
 
 namespace Sqex::Texture {
 	class ModifiableTextureStream : public RandomAccessStream {
@@ -19,6 +20,12 @@ namespace Sqex::Texture {
 		void SetMipmap(size_t mipmapIndex, size_t repeatIndex, std::shared_ptr<MipmapStream> mipmap);
 		void Resize(size_t mipmapCount, size_t repeatCount);
 
+		// Re-encodes every mipmap into ARGB8888 or a block compressed format. Throws std::invalid_argument for other formats.
+		void ConvertTo(Format type, Utils::DxtQuality quality = Utils::DxtQuality::Normal);
+
+		// Replaces every mipmap with the ones generated from the first mipmap of each repeat, in the given format.
+		void GenerateMipmaps(Format type, const MipmapChainOptions& options = {}, size_t mipmapCount = SIZE_MAX);
+
 		[[nodiscard]] uint64_t StreamSize() const override;
 		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override;
 
@@ -362,6 +362,16 @@ void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEqdpEdits(std::function<Sqex
 	}
 }
 
+void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEqdpEdits(Sqex::Eqdp::ExpandedFile& eqdp, uint32_t race) const {
+	for (const auto& v : Get<EqdpEntry>(MetaDataType::Eqdp)) {
+		if (v.RaceCode != race)
+			continue;
+		auto& target = eqdp.Set(PrimaryId);
+		target &= ~(0b11 << (SlotIndex * 2));
+		target |= v.Value << (SlotIndex * 2);
+	}
+}
+
 void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEqpEdits(Sqex::EqpGmp::ExpandedFile& eqp) const {
 	if (const auto eqpedit = Get<uint8_t>(Sqex::ThirdParty::TexTools::ItemMetadata::MetaDataType::Eqp); !eqpedit.empty()) {
 		if (eqpedit.size() != EqpEntrySize)
@@ -229,6 +229,7 @@ namespace Sqex::ThirdParty::TexTools {
 
 		void ApplyImcEdits(std::function<Sqex::Imc::File&()> reader) const;
 		void ApplyEqdpEdits(std::function<Sqex::Eqdp::ExpandedFile& (TargetItemType, uint32_t)> reader) const;
+		void ApplyEqdpEdits(Sqex::Eqdp::ExpandedFile& eqdp, uint32_t race) const;
 		void ApplyEqpEdits(Sqex::EqpGmp::ExpandedFile& eqp) const;
 		void ApplyGmpEdits(Sqex::EqpGmp::ExpandedFile& gmp) const;
 		void ApplyEstEdits(Sqex::Est::File& est) const;
@@ -1,227 +1,529 @@
-// From https://github.com/Benjamin-Dobell/s3tc-dxt-decompression/blob/master/s3tc.cpp
-
-// ReSharper disable All
-
 #include "pch.h"
 #include "XivAlexanderCommon/Utils/Dxt.h"
 
-#pragma warning(push, 0)
-namespace Utils {
-    // uint32_t PackRGBA(): Helper method that packs RGBA channels into a single 4 byte pixel.
-    //
-    // uint8_t r:     red channel.
-    // uint8_t g:     green channel.
-    // uint8_t b:     blue channel.
-    // uint8_t a:     alpha channel.
-
-    inline uint32_t PackRGBA(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
-        return ((r << 24) | (g << 16) | (b << 8) | a);
-    }
-
-    // void DecompressBlockDXT1(): Decompresses one block of a DXT1 texture and stores the resulting pixels at the appropriate offset in 'image'.
-    //
-    // uint32_t x:                     x-coordinate of the first pixel in the block.
-    // uint32_t y:                     y-coordinate of the first pixel in the block.
-    // uint32_t width:                 width of the texture being decompressed.
-    // uint32_t height:                height of the texture being decompressed.
-    // const uint8_t *blockStorage:   pointer to the block to decompress.
-    // uint32_t *image:                pointer to image where the decompressed pixel data should be stored.
-
-    void DecompressBlockDXT1(uint32_t x, uint32_t y, uint32_t width, const uint8_t* blockStorage, uint32_t* image) {
-        uint16_t color0 = *reinterpret_cast<const uint16_t*>(blockStorage);
-        uint16_t color1 = *reinterpret_cast<const uint16_t*>(blockStorage + 2);
-
-        uint32_t temp;
-
-        temp = (color0 >> 11) * 255 + 16;
-        uint8_t r0 = (uint8_t)((temp / 32 + temp) / 32);
-        temp = ((color0 & 0x07E0) >> 5) * 255 + 32;
-        uint8_t g0 = (uint8_t)((temp / 64 + temp) / 64);
-        temp = (color0 & 0x001F) * 255 + 16;
-        uint8_t b0 = (uint8_t)((temp / 32 + temp) / 32);
-
-        temp = (color1 >> 11) * 255 + 16;
-        uint8_t r1 = (uint8_t)((temp / 32 + temp) / 32);
-        temp = ((color1 & 0x07E0) >> 5) * 255 + 32;
-        uint8_t g1 = (uint8_t)((temp / 64 + temp) / 64);
-        temp = (color1 & 0x001F) * 255 + 16;
-        uint8_t b1 = (uint8_t)((temp / 32 + temp) / 32);
-
-        uint32_t code = *reinterpret_cast<const uint32_t*>(blockStorage + 4);
-
-        for (int j = 0; j < 4; j++) {
-            for (int i = 0; i < 4; i++) {
-                uint32_t finalColor = 0;
-                uint8_t positionCode = (code >> 2 * (4 * j + i)) & 0x03;
-
-                if (color0 > color1) {
-                    switch (positionCode) {
-                        case 0:
-                            finalColor = PackRGBA(r0, g0, b0, 255);
-                            break;
-                        case 1:
-                            finalColor = PackRGBA(r1, g1, b1, 255);
-                            break;
-                        case 2:
-                            finalColor = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
-                            break;
-                        case 3:
-                            finalColor = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
-                            break;
-                    }
-                } else {
-                    switch (positionCode) {
-                        case 0:
-                            finalColor = PackRGBA(r0, g0, b0, 255);
-                            break;
-                        case 1:
-                            finalColor = PackRGBA(r1, g1, b1, 255);
-                            break;
-                        case 2:
-                            finalColor = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
-                            break;
-                        case 3:
-                            finalColor = PackRGBA(0, 0, 0, 255);
-                            break;
-                    }
-                }
-
-                if (x + i < width)
-                    image[(y + j) * width + (x + i)] = finalColor;
-            }
-        }
-    }
-
-    // void BlockDecompressImageDXT1(): Decompresses all the blocks of a DXT1 compressed texture and stores the resulting pixels in 'image'.
-    //
-    // uint32_t width:                 Texture width.
-    // uint32_t height:                Texture height.
-    // const uint8_t *blockStorage:   pointer to compressed DXT1 blocks.
-    // uint32_t *image:                pointer to the image where the decompressed pixels will be stored.
-
-    void BlockDecompressImageDXT1(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
-        uint32_t blockCountX = (width + 3) / 4;
-        uint32_t blockCountY = (height + 3) / 4;
-        uint32_t blockWidth = (width < 4) ? width : 4;
-        uint32_t blockHeight = (height < 4) ? height : 4;
-
-        for (uint32_t j = 0; j < blockCountY; j++) {
-            for (uint32_t i = 0; i < blockCountX; i++) DecompressBlockDXT1(i * 4, j * 4, width, blockStorage + i * 8, image);
-            blockStorage += blockCountX * 8;
-        }
-    }
-
-    // void DecompressBlockDXT5(): Decompresses one block of a DXT5 texture and stores the resulting pixels at the appropriate offset in 'image'.
-    //
-    // uint32_t x:                     x-coordinate of the first pixel in the block.
-    // uint32_t y:                     y-coordinate of the first pixel in the block.
-    // uint32_t width:                 width of the texture being decompressed.
-    // uint32_t height:                height of the texture being decompressed.
-    // const uint8_t *blockStorage:   pointer to the block to decompress.
-    // uint32_t *image:                pointer to image where the decompressed pixel data should be stored.
-
-    void DecompressBlockDXT5(uint32_t x, uint32_t y, uint32_t width, const uint8_t* blockStorage, uint32_t* image) {
-        uint8_t alpha0 = *reinterpret_cast<const uint8_t*>(blockStorage);
-        uint8_t alpha1 = *reinterpret_cast<const uint8_t*>(blockStorage + 1);
-
-        const uint8_t* bits = blockStorage + 2;
-        uint32_t alphaCode1 = bits[2] | (bits[3] << 8) | (bits[4] << 16) | (bits[5] << 24);
-        uint16_t alphaCode2 = bits[0] | (bits[1] << 8);
-
-        uint16_t color0 = *reinterpret_cast<const uint16_t*>(blockStorage + 8);
-        uint16_t color1 = *reinterpret_cast<const uint16_t*>(blockStorage + 10);
-
-        uint32_t temp;
-
-        temp = (color0 >> 11) * 255 + 16;
-        uint8_t r0 = (uint8_t)((temp / 32 + temp) / 32);
-        temp = ((color0 & 0x07E0) >> 5) * 255 + 32;
-        uint8_t g0 = (uint8_t)((temp / 64 + temp) / 64);
-        temp = (color0 & 0x001F) * 255 + 16;
-        uint8_t b0 = (uint8_t)((temp / 32 + temp) / 32);
-
-        temp = (color1 >> 11) * 255 + 16;
-        uint8_t r1 = (uint8_t)((temp / 32 + temp) / 32);
-        temp = ((color1 & 0x07E0) >> 5) * 255 + 32;
-        uint8_t g1 = (uint8_t)((temp / 64 + temp) / 64);
-        temp = (color1 & 0x001F) * 255 + 16;
-        uint8_t b1 = (uint8_t)((temp / 32 + temp) / 32);
-
-        uint32_t code = *reinterpret_cast<const uint32_t*>(blockStorage + 12);
-
-        for (int j = 0; j < 4; j++) {
-            for (int i = 0; i < 4; i++) {
-                int alphaCodeIndex = 3 * (4 * j + i);
-                int alphaCode;
-
-                if (alphaCodeIndex <= 12) {
-                    alphaCode = (alphaCode2 >> alphaCodeIndex) & 0x07;
-                } else if (alphaCodeIndex == 15) {
-                    alphaCode = (alphaCode2 >> 15) | ((alphaCode1 << 1) & 0x06);
-                } else // alphaCodeIndex >= 18 && alphaCodeIndex <= 45
-                {
-                    alphaCode = (alphaCode1 >> (alphaCodeIndex - 16)) & 0x07;
-                }
-
-                uint8_t finalAlpha;
-                if (alphaCode == 0) {
-                    finalAlpha = alpha0;
-                } else if (alphaCode == 1) {
-                    finalAlpha = alpha1;
-                } else {
-                    if (alpha0 > alpha1) {
-                        finalAlpha = ((8 - alphaCode) * alpha0 + (alphaCode - 1) * alpha1) / 7;
-                    } else {
-                        if (alphaCode == 6)
-                            finalAlpha = 0;
-                        else if (alphaCode == 7)
-                            finalAlpha = 255;
-                        else
-                            finalAlpha = ((6 - alphaCode) * alpha0 + (alphaCode - 1) * alpha1) / 5;
-                    }
-                }
-
-                uint8_t colorCode = (code >> 2 * (4 * j + i)) & 0x03;
-
-                uint32_t finalColor;
-                switch (colorCode) {
-                    case 0:
-                        finalColor = PackRGBA(r0, g0, b0, finalAlpha);
-                        break;
-                    case 1:
-                        finalColor = PackRGBA(r1, g1, b1, finalAlpha);
-                        break;
-                    case 2:
-                        finalColor = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, finalAlpha);
-                        break;
-                    case 3:
-                        finalColor = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, finalAlpha);
-                        break;
-                }
-
-                if (x + i < width)
-                    image[(y + j) * width + (x + i)] = finalColor;
-            }
-        }
-    }
-
-    // void BlockDecompressImageDXT5(): Decompresses all the blocks of a DXT5 compressed texture and stores the resulting pixels in 'image'.
-    //
-    // uint32_t width:                 Texture width.
-    // uint32_t height:                Texture height.
-    // const uint8_t *blockStorage:   pointer to compressed DXT5 blocks.
-    // uint32_t *image:                pointer to the image where the decompressed pixels will be stored.
-
-    void BlockDecompressImageDXT5(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
-        uint32_t blockCountX = (width + 3) / 4;
-        uint32_t blockCountY = (height + 3) / 4;
-        uint32_t blockWidth = (width < 4) ? width : 4;
-        uint32_t blockHeight = (height < 4) ? height : 4;
-
-        for (uint32_t j = 0; j < blockCountY; j++) {
-            for (uint32_t i = 0; i < blockCountX; i++) DecompressBlockDXT5(i * 4, j * 4, width, blockStorage + i * 16, image);
-            blockStorage += blockCountX * 16;
-        }
-    }
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
+#ifndef PF_AVX2_INSTRUCTIONS_AVAILABLE
+#define PF_AVX2_INSTRUCTIONS_AVAILABLE 40
+#endif
+
+namespace {
+	using Utils::DxtQuality;
+
+	// Images with at least this many pixels get decoded on multiple threads.
+	constexpr size_t ParallelDecodePixelThreshold = 256 * 256;
+
+	// Images with at least this many pixels get encoded on multiple threads.
+	constexpr size_t ParallelEncodePixelThreshold = 64 * 64;
+
+	// Least squares passes DxtQuality::High may spend on a color block before giving up on further improvement.
+	constexpr size_t MaxRefinementPassCount = 8;
+
+	const bool HasAvx2 = !!IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE);
+
+	// round(v * 255 / 31), round(v * 255 / 63)
+	uint16_t Expand5(uint32_t v) {
+		const auto temp = v * 255 + 16;
+		return static_cast<uint16_t>((temp / 32 + temp) / 32);
+	}
+
+	uint16_t Expand6(uint32_t v) {
+		const auto temp = v * 255 + 32;
+		return static_cast<uint16_t>((temp / 64 + temp) / 64);
+	}
+
+	// Returns the four colors of a color block as 32-bit values in R, G, B, A byte order.
+	// BC2 and BC3 always use four colors; BC1 switches to three colors and transparent black if color0 <= color1.
+	__m128i DecodeColorPalette(const uint8_t* block, bool allowThreeColors) {
+		const auto c0 = static_cast<uint32_t>(block[0] | (block[1] << 8));
+		const auto c1 = static_cast<uint32_t>(block[2] | (block[3] << 8));
+
+		// [r0, g0, b0, 255, r1, g1, b1, 255] in 16-bit lanes
+		const auto endpoints = _mm_setr_epi16(
+			static_cast<short>(Expand5(c0 >> 11)), static_cast<short>(Expand6((c0 >> 5) & 0x3F)), static_cast<short>(Expand5(c0 & 0x1F)), 255,
+			static_cast<short>(Expand5(c1 >> 11)), static_cast<short>(Expand6((c1 >> 5) & 0x3F)), static_cast<short>(Expand5(c1 & 0x1F)), 255);
+		const auto swapped = _mm_shuffle_epi32(endpoints, _MM_SHUFFLE(1, 0, 3, 2));
+
+		__m128i interpolated;
+		if (!allowThreeColors || c0 > c1) {
+			// [(2 * e0 + e1) / 3, (e0 + 2 * e1) / 3]; x / 3 == (x * 0xAAAB) >> 17 for every x that can appear here.
+			const auto sum = _mm_add_epi16(_mm_add_epi16(endpoints, endpoints), swapped);
+			interpolated = _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16(static_cast<short>(0xAAAB))), 1);
+		} else {
+			// [(e0 + e1) / 2, transparent black]
+			interpolated = _mm_and_si128(_mm_srli_epi16(_mm_add_epi16(endpoints, swapped), 1), _mm_setr_epi32(-1, -1, 0, 0));
+		}
+		return _mm_packus_epi16(endpoints, interpolated);
+	}
+
+	// Picks palette entries for a 4x4 block, using the 2-bit indices in the order they are stored in blocks.
+	void SelectColors(__m128i palette, uint32_t indices, __m128i(&rows)[4]) {
+		if (HasAvx2) {
+			const auto broadcastPalette = _mm256_broadcastsi128_si256(palette);
+			const auto shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+			const auto mask = _mm256_set1_epi32(3);
+			const auto top = _mm256_permutevar8x32_epi32(broadcastPalette, _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(indices)), shifts), mask));
+			const auto bottom = _mm256_permutevar8x32_epi32(broadcastPalette, _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(indices >> 16)), shifts), mask));
+			rows[0] = _mm256_castsi256_si128(top);
+			rows[1] = _mm256_extracti128_si256(top, 1);
+			rows[2] = _mm256_castsi256_si128(bottom);
+			rows[3] = _mm256_extracti128_si256(bottom, 1);
+			return;
+		}
+
+		// Each 2-bit index is tested bit by bit, and the result picks between palette entries using masks.
+		const auto p0 = _mm_shuffle_epi32(palette, _MM_SHUFFLE(0, 0, 0, 0));
+		const auto p1 = _mm_shuffle_epi32(palette, _MM_SHUFFLE(1, 1, 1, 1));
+		const auto p2 = _mm_shuffle_epi32(palette, _MM_SHUFFLE(2, 2, 2, 2));
+		const auto p3 = _mm_shuffle_epi32(palette, _MM_SHUFFLE(3, 3, 3, 3));
+		const auto p01 = _mm_xor_si128(p0, p1);
+		const auto p23 = _mm_xor_si128(p2, p3);
+		const auto lowBits = _mm_setr_epi32(1, 4, 16, 64);
+		const auto highBits = _mm_setr_epi32(2, 8, 32, 128);
+		for (size_t j = 0; j < 4; ++j) {
+			const auto v = _mm_set1_epi32(static_cast<int>(indices >> (8 * j)));
+			const auto low = _mm_cmpeq_epi32(_mm_and_si128(v, lowBits), lowBits);
+			const auto high = _mm_cmpeq_epi32(_mm_and_si128(v, highBits), highBits);
+			const auto a = _mm_xor_si128(p0, _mm_and_si128(p01, low));
+			const auto b = _mm_xor_si128(p2, _mm_and_si128(p23, low));
+			rows[j] = _mm_xor_si128(a, _mm_and_si128(_mm_xor_si128(a, b), high));
+		}
+	}
+
+	// Replaces alpha of four pixels with four alpha values packed into a 32-bit integer, lowest byte first.
+	__m128i ApplyAlpha(__m128i pixels, uint32_t alphas) {
+		const auto zero = _mm_setzero_si128();
+		const auto spread = _mm_unpacklo_epi16(zero, _mm_unpacklo_epi8(zero, _mm_cvtsi32_si128(static_cast<int>(alphas))));
+		return _mm_or_si128(_mm_and_si128(pixels, _mm_set1_epi32(0x00FFFFFF)), spread);
+	}
+
+	void DecodeBlockBC1(const uint8_t* block, __m128i(&rows)[4]) {
+		SelectColors(DecodeColorPalette(block, true), *reinterpret_cast<const uint32_t*>(block + 4), rows);
+	}
+
+	void DecodeBlockBC2(const uint8_t* block, __m128i(&rows)[4]) {
+		SelectColors(DecodeColorPalette(block + 8, false), *reinterpret_cast<const uint32_t*>(block + 12), rows);
+		for (size_t j = 0; j < 4; ++j) {
+			const auto bits = static_cast<uint32_t>(block[2 * j] | (block[2 * j + 1] << 8));
+			const auto nibbles = (bits & 0xF) | ((bits & 0xF0) << 4) | ((bits & 0xF00) << 8) | ((bits & 0xF000) << 12);
+			rows[j] = ApplyAlpha(rows[j], nibbles * 17);
+		}
+	}
+
+	void DecodeBlockBC3(const uint8_t* block, __m128i(&rows)[4]) {
+		const uint32_t alpha0 = block[0];
+		const uint32_t alpha1 = block[1];
+		uint32_t alphas[8]{ alpha0, alpha1 };
+		if (alpha0 > alpha1) {
+			for (uint32_t i = 2; i < 8; ++i)
+				alphas[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+		} else {
+			for (uint32_t i = 2; i < 6; ++i)
+				alphas[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+			alphas[6] = 0;
+			alphas[7] = 255;
+		}
+
+		uint64_t indices = 0;
+		for (size_t i = 0; i < 6; ++i)
+			indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+
+		SelectColors(DecodeColorPalette(block + 8, false), *reinterpret_cast<const uint32_t*>(block + 12), rows);
+		for (size_t j = 0; j < 4; ++j, indices >>= 12) {
+			rows[j] = ApplyAlpha(rows[j], 0
+				| (alphas[indices & 7] << 0)
+				| (alphas[(indices >> 3) & 7] << 8)
+				| (alphas[(indices >> 6) & 7] << 16)
+				| (alphas[(indices >> 9) & 7] << 24));
+		}
+	}
+
+	template<size_t BlockSize>
+	void DecompressImage(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image, void(*decodeBlock)(const uint8_t*, __m128i(&)[4])) {
+		const auto blockCountX = (static_cast<size_t>(width) + 3) / 4;
+		const auto blockCountY = (static_cast<size_t>(height) + 3) / 4;
+
+		const auto decodeBlockRow = [&](size_t blockY) {
+			const auto y = blockY * 4;
+			const auto rowCount = std::min<size_t>(4, height - y);
+			const auto* block = blockStorage + blockY * blockCountX * BlockSize;
+			for (size_t blockX = 0; blockX < blockCountX; ++blockX, block += BlockSize) {
+				__m128i rows[4];
+				decodeBlock(block, rows);
+
+				const auto x = blockX * 4;
+				auto* const target = image + y * width + x;
+				if (x + 4 <= width) {
+					for (size_t j = 0; j < rowCount; ++j)
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(target + j * width), rows[j]);
+				} else {
+					alignas(16) uint32_t pixels[4];
+					for (size_t j = 0; j < rowCount; ++j) {
+						_mm_store_si128(reinterpret_cast<__m128i*>(pixels), rows[j]);
+						std::copy_n(pixels, width - x, target + j * width);
+					}
+				}
+			}
+		};
+
+		if (static_cast<size_t>(width) * height >= ParallelDecodePixelThreshold) {
+			Utils::Win32::ParallelFor(blockCountY, decodeBlockRow);
+		} else {
+			for (size_t blockY = 0; blockY < blockCountY; ++blockY)
+				decodeBlockRow(blockY);
+		}
+	}
+
+	uint32_t Channel(uint32_t pixel, size_t channel) {
+		return (pixel >> (8 * channel)) & 0xFF;
+	}
+
+	uint16_t Quantize565(const float(&color)[3]) {
+		const auto quantize = [](float v, long maxValue) {
+			return static_cast<uint16_t>(std::clamp(std::lround(v * maxValue / 255.f), 0L, maxValue));
+		};
+		return static_cast<uint16_t>((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+	}
+
+	struct ColorBlock {
+		uint16_t Color0 = 0;
+		uint16_t Color1 = 0;
+		uint32_t Indices = 0;
+		uint32_t Error = UINT32_MAX;
+	};
+
+	// Picks the closest palette entry for every pixel in mask; the others become transparent (index 3) in three color mode.
+	// Endpoints get swapped as needed, so that BC1 decoders pick the intended mode.
+	ColorBlock FitColorIndices(const uint32_t(&pixels)[16], uint32_t mask, uint16_t color0, uint16_t color1, bool threeColors) {
+		if (threeColors ? color0 > color1 : color0 < color1)
+			std::swap(color0, color1);
+
+		const uint8_t header[4]{
+			static_cast<uint8_t>(color0), static_cast<uint8_t>(color0 >> 8),
+			static_cast<uint8_t>(color1), static_cast<uint8_t>(color1 >> 8),
+		};
+		alignas(16) uint32_t palette[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(palette), DecodeColorPalette(header, threeColors));
+
+		ColorBlock result{ color0, color1, 0, 0 };
+		const auto paletteSize = threeColors ? 3U : 4U;
+		for (size_t i = 0; i < 16; ++i) {
+			if (!(mask & (1 << i))) {
+				result.Indices |= 3U << (2 * i);
+				continue;
+			}
+
+			uint32_t bestIndex = 0;
+			auto bestError = UINT32_MAX;
+			for (uint32_t j = 0; j < paletteSize; ++j) {
+				uint32_t error = 0;
+				for (size_t c = 0; c < 3; ++c) {
+					const auto d = static_cast<int>(Channel(pixels[i], c)) - static_cast<int>(Channel(palette[j], c));
+					error += d * d;
+				}
+				if (error < bestError) {
+					bestError = error;
+					bestIndex = j;
+				}
+			}
+			result.Indices |= bestIndex << (2 * i);
+			result.Error += bestError;
+		}
+		return result;
+	}
+
+	// Finds a pair of endpoints spanning the pixels in mask, which must not be empty.
+	void EstimateColorEndpoints(const uint32_t(&pixels)[16], uint32_t mask, DxtQuality quality, float(&endpoint0)[3], float(&endpoint1)[3]) {
+		float minColor[3]{ 255.f, 255.f, 255.f }, maxColor[3]{}, mean[3]{};
+		size_t count = 0;
+		for (size_t i = 0; i < 16; ++i) {
+			if (!(mask & (1 << i)))
+				continue;
+			++count;
+			for (size_t c = 0; c < 3; ++c) {
+				const auto v = static_cast<float>(Channel(pixels[i], c));
+				minColor[c] = std::min(minColor[c], v);
+				maxColor[c] = std::max(maxColor[c], v);
+				mean[c] += v;
+			}
+		}
+
+		if (quality == DxtQuality::Fast) {
+			// Shrink the box a bit, so that the interpolated colors land closer to where most pixels are.
+			for (size_t c = 0; c < 3; ++c) {
+				const auto inset = (maxColor[c] - minColor[c]) / 16.f;
+				endpoint0[c] = maxColor[c] - inset;
+				endpoint1[c] = minColor[c] + inset;
+			}
+			return;
+		}
+
+		for (auto& v : mean)
+			v /= static_cast<float>(count);
+
+		float covariance[3][3]{};
+		for (size_t i = 0; i < 16; ++i) {
+			if (!(mask & (1 << i)))
+				continue;
+			float d[3];
+			for (size_t c = 0; c < 3; ++c)
+				d[c] = static_cast<float>(Channel(pixels[i], c)) - mean[c];
+			for (size_t r = 0; r < 3; ++r)
+				for (size_t c = 0; c < 3; ++c)
+					covariance[r][c] += d[r] * d[c];
+		}
+
+		// Power iteration, starting from the row of the channel with the largest variance.
+		size_t widest = 0;
+		for (size_t c = 1; c < 3; ++c) {
+			if (covariance[c][c] > covariance[widest][widest])
+				widest = c;
+		}
+		float axis[3]{ covariance[widest][0], covariance[widest][1], covariance[widest][2] };
+		for (size_t iteration = 0; iteration < 4; ++iteration) {
+			float next[3]{};
+			for (size_t r = 0; r < 3; ++r)
+				for (size_t c = 0; c < 3; ++c)
+					next[r] += covariance[r][c] * axis[c];
+			const auto scale = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+			if (scale < 1e-6f)
+				break;
+			for (size_t c = 0; c < 3; ++c)
+				axis[c] = next[c] / scale;
+		}
+
+		if (std::max({ std::abs(axis[0]), std::abs(axis[1]), std::abs(axis[2]) }) < 1e-6f) {
+			std::copy_n(mean, 3, endpoint0);
+			std::copy_n(mean, 3, endpoint1);
+			return;
+		}
+
+		auto minProjection = std::numeric_limits<float>::max(), maxProjection = std::numeric_limits<float>::lowest();
+		size_t minIndex = 0, maxIndex = 0;
+		for (size_t i = 0; i < 16; ++i) {
+			if (!(mask & (1 << i)))
+				continue;
+			float projection = 0;
+			for (size_t c = 0; c < 3; ++c)
+				projection += (static_cast<float>(Channel(pixels[i], c)) - mean[c]) * axis[c];
+			if (projection < minProjection) {
+				minProjection = projection;
+				minIndex = i;
+			}
+			if (projection > maxProjection) {
+				maxProjection = projection;
+				maxIndex = i;
+			}
+		}
+		for (size_t c = 0; c < 3; ++c) {
+			endpoint0[c] = static_cast<float>(Channel(pixels[maxIndex], c));
+			endpoint1[c] = static_cast<float>(Channel(pixels[minIndex], c));
+		}
+	}
+
+	// Solves for the endpoints that minimize squared error while keeping the indices as they are.
+	bool RefineColorEndpoints(const uint32_t(&pixels)[16], uint32_t mask, uint32_t indices, bool threeColors, float(&endpoint0)[3], float(&endpoint1)[3]) {
+		static constexpr float FourColorWeights[4]{ 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+		static constexpr float ThreeColorWeights[4]{ 1.f, 0.f, 1.f / 2.f, 0.f };
+		const auto& weights = threeColors ? ThreeColorWeights : FourColorWeights;
+
+		float aa = 0, ab = 0, bb = 0, ax[3]{}, bx[3]{};
+		for (size_t i = 0; i < 16; ++i) {
+			const auto index = (indices >> (2 * i)) & 3;
+			if (!(mask & (1 << i)) || (threeColors && index == 3))
+				continue;
+			const auto a = weights[index];
+			const auto b = 1.f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (size_t c = 0; c < 3; ++c) {
+				ax[c] += a * static_cast<float>(Channel(pixels[i], c));
+				bx[c] += b * static_cast<float>(Channel(pixels[i], c));
+			}
+		}
+
+		const auto determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+
+		for (size_t c = 0; c < 3; ++c) {
+			endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+			endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+		}
+		return true;
+	}
+
+	ColorBlock EncodeColors(const uint32_t(&pixels)[16], uint32_t mask, bool threeColors, DxtQuality quality) {
+		if (!mask)
+			return { 0, 0, UINT32_MAX, 0 };
+
+		float endpoint0[3], endpoint1[3];
+		EstimateColorEndpoints(pixels, mask, quality, endpoint0, endpoint1);
+		auto best = FitColorIndices(pixels, mask, Quantize565(endpoint0), Quantize565(endpoint1), threeColors);
+
+		const auto passCount = quality == DxtQuality::Fast ? 0 : quality == DxtQuality::Normal ? 1 : MaxRefinementPassCount;
+		for (size_t pass = 0; pass < passCount && best.Error; ++pass) {
+			if (!RefineColorEndpoints(pixels, mask, best.Indices, threeColors, endpoint0, endpoint1))
+				break;
+			const auto candidate = FitColorIndices(pixels, mask, Quantize565(endpoint0), Quantize565(endpoint1), threeColors);
+			if (candidate.Error >= best.Error)
+				break;
+			best = candidate;
+		}
+		return best;
+	}
+
+	void WriteColorBlock(uint8_t* block, const ColorBlock& colors) {
+		block[0] = static_cast<uint8_t>(colors.Color0);
+		block[1] = static_cast<uint8_t>(colors.Color0 >> 8);
+		block[2] = static_cast<uint8_t>(colors.Color1);
+		block[3] = static_cast<uint8_t>(colors.Color1 >> 8);
+		for (size_t i = 0; i < 4; ++i)
+			block[4 + i] = static_cast<uint8_t>(colors.Indices >> (8 * i));
+	}
+
+	struct AlphaBlock {
+		uint8_t Alpha0 = 0;
+		uint8_t Alpha1 = 0;
+		uint64_t Indices = 0;
+		uint32_t Error = UINT32_MAX;
+	};
+
+	// Picks the closest of the 8 alpha values for every pixel; alpha0 <= alpha1 selects the mode with explicit 0 and 255.
+	AlphaBlock FitAlphaIndices(const uint32_t(&pixels)[16], uint8_t alpha0, uint8_t alpha1) {
+		uint32_t alphas[8]{ alpha0, alpha1 };
+		if (alpha0 > alpha1) {
+			for (uint32_t i = 2; i < 8; ++i)
+				alphas[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+		} else {
+			for (uint32_t i = 2; i < 6; ++i)
+				alphas[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+			alphas[6] = 0;
+			alphas[7] = 255;
+		}
+
+		AlphaBlock result{ alpha0, alpha1, 0, 0 };
+		for (size_t i = 0; i < 16; ++i) {
+			const auto alpha = static_cast<int>(pixels[i] >> 24);
+			uint64_t bestIndex = 0;
+			auto bestError = UINT32_MAX;
+			for (size_t j = 0; j < 8; ++j) {
+				const auto d = alpha - static_cast<int>(alphas[j]);
+				if (const auto error = static_cast<uint32_t>(d * d); error < bestError) {
+					bestError = error;
+					bestIndex = j;
+				}
+			}
+			result.Indices |= bestIndex << (3 * i);
+			result.Error += bestError;
+		}
+		return result;
+	}
+
+	void EncodeBlockBC1(const uint32_t(&pixels)[16], uint8_t* block, DxtQuality quality) {
+		uint32_t opaqueMask = 0;
+		for (size_t i = 0; i < 16; ++i) {
+			if (pixels[i] >> 24 >= 128)
+				opaqueMask |= 1 << i;
+		}
+
+		// Transparent pixels need three color mode; opaque blocks occasionally do better with it too.
+		auto colors = EncodeColors(pixels, opaqueMask, opaqueMask != 0xFFFF, quality);
+		if (opaqueMask == 0xFFFF && quality == DxtQuality::High && colors.Error) {
+			if (const auto threeColors = EncodeColors(pixels, opaqueMask, true, quality); threeColors.Error < colors.Error)
+				colors = threeColors;
+		}
+		WriteColorBlock(block, colors);
+	}
+
+	void EncodeBlockBC2(const uint32_t(&pixels)[16], uint8_t* block, DxtQuality quality) {
+		for (size_t i = 0; i < 16; i += 2) {
+			const auto alpha0 = ((pixels[i] >> 24) * 15 + 127) / 255;
+			const auto alpha1 = ((pixels[i + 1] >> 24) * 15 + 127) / 255;
+			block[i / 2] = static_cast<uint8_t>(alpha0 | (alpha1 << 4));
+		}
+		WriteColorBlock(block + 8, EncodeColors(pixels, 0xFFFF, false, quality));
+	}
+
+	void EncodeBlockBC3(const uint32_t(&pixels)[16], uint8_t* block, DxtQuality quality) {
+		uint8_t minAlpha = 255, maxAlpha = 0, minInnerAlpha = 255, maxInnerAlpha = 0;
+		for (const auto pixel : pixels) {
+			const auto alpha = static_cast<uint8_t>(pixel >> 24);
+			minAlpha = std::min(minAlpha, alpha);
+			maxAlpha = std::max(maxAlpha, alpha);
+			if (alpha != 0 && alpha != 255) {
+				minInnerAlpha = std::min(minInnerAlpha, alpha);
+				maxInnerAlpha = std::max(maxInnerAlpha, alpha);
+			}
+		}
+
+		auto alphas = FitAlphaIndices(pixels, maxAlpha, minAlpha);
+		if (quality != DxtQuality::Fast && alphas.Error) {
+			// Interpolate between the values other than 0 and 255, which are available as is.
+			if (minInnerAlpha > maxInnerAlpha)
+				minInnerAlpha = maxInnerAlpha = 0;
+			if (const auto withExtremes = FitAlphaIndices(pixels, minInnerAlpha, maxInnerAlpha); withExtremes.Error < alphas.Error)
+				alphas = withExtremes;
+		}
+
+		block[0] = alphas.Alpha0;
+		block[1] = alphas.Alpha1;
+		for (size_t i = 0; i < 6; ++i)
+			block[2 + i] = static_cast<uint8_t>(alphas.Indices >> (8 * i));
+		WriteColorBlock(block + 8, EncodeColors(pixels, 0xFFFF, false, quality));
+	}
+
+	template<size_t BlockSize>
+	void CompressImage(uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, DxtQuality quality, void(*encodeBlock)(const uint32_t(&)[16], uint8_t*, DxtQuality)) {
+		const auto blockCountX = (static_cast<size_t>(width) + 3) / 4;
+		const auto blockCountY = (static_cast<size_t>(height) + 3) / 4;
+
+		const auto encodeBlockRow = [&](size_t blockY) {
+			const auto y = blockY * 4;
+			auto* block = blockStorage + blockY * blockCountX * BlockSize;
+			for (size_t blockX = 0; blockX < blockCountX; ++blockX, block += BlockSize) {
+				// Blocks hanging over the edges repeat the last row and column.
+				const auto x = blockX * 4;
+				uint32_t pixels[16];
+				for (size_t j = 0; j < 4; ++j) {
+					const auto* const row = image + std::min<size_t>(y + j, height - 1) * width;
+					for (size_t i = 0; i < 4; ++i)
+						pixels[j * 4 + i] = row[std::min<size_t>(x + i, width - 1)];
+				}
+				encodeBlock(pixels, block, quality);
+			}
+		};
+
+		if (static_cast<size_t>(width) * height >= ParallelEncodePixelThreshold) {
+			Utils::Win32::ParallelFor(blockCountY, encodeBlockRow);
+		} else {
+			for (size_t blockY = 0; blockY < blockCountY; ++blockY)
+				encodeBlockRow(blockY);
+		}
+	}
+}
+
+void Utils::BlockDecompressImageDXT1(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
+	DecompressImage<8>(width, height, blockStorage, image, DecodeBlockBC1);
+}
+
+void Utils::BlockDecompressImageDXT3(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
+	DecompressImage<16>(width, height, blockStorage, image, DecodeBlockBC2);
+}
+
+void Utils::BlockDecompressImageDXT5(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image) {
+	DecompressImage<16>(width, height, blockStorage, image, DecodeBlockBC3);
+}
+
+void Utils::BlockCompressImageDXT1(uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, DxtQuality quality) {
+	CompressImage<8>(width, height, image, blockStorage, quality, EncodeBlockBC1);
+}
+
+void Utils::BlockCompressImageDXT3(uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, DxtQuality quality) {
+	CompressImage<16>(width, height, image, blockStorage, quality, EncodeBlockBC2);
+}
+
+void Utils::BlockCompressImageDXT5(uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, DxtQuality quality) {
+	CompressImage<16>(width, height, image, blockStorage, quality, EncodeBlockBC3);
 }
-#pragma warning(pop)
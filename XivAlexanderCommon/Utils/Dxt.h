@@ -1,10 +1,24 @@
-// From https://github.com/Benjamin-Dobell/s3tc-dxt-decompression/blob/master/s3tc.h
-
 #pragma once
 
 namespace Utils {
-	void DecompressBlockDXT1(uint32_t x, uint32_t y, uint32_t width, const uint8_t* blockStorage, uint32_t* image);
+	// Decode a BC1 (DXT1), BC2 (DXT3), or BC3 (DXT5) compressed image into 32-bit pixels stored in R, G, B, A byte order.
+	// blockStorage must hold ceil(width / 4) * ceil(height / 4) blocks; image must hold width * height pixels.
+	// Rows of blocks are decoded on multiple threads if the image is large enough.
 	void BlockDecompressImageDXT1(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image);
-	void DecompressBlockDXT5(uint32_t x, uint32_t y, uint32_t width, const uint8_t* blockStorage, uint32_t* image);
+	void BlockDecompressImageDXT3(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image);
 	void BlockDecompressImageDXT5(uint32_t width, uint32_t height, const uint8_t* blockStorage, uint32_t* image);
+
+	enum class DxtQuality {
+		Fast,  // endpoints from the bounding box of each block
+		Normal,  // endpoints from the principal axis of each block, refined once
+		High,  // refined until it stops improving; tries every block mode
+	};
+
+	// Encode 32-bit pixels stored in R, G, B, A byte order into a BC1 (DXT1), BC2 (DXT3), or BC3 (DXT5) compressed image.
+	// image must hold width * height pixels; blockStorage must hold ceil(width / 4) * ceil(height / 4) blocks.
+	// BC1 stores pixels with alpha below 128 as transparent black.
+	// Rows of blocks are encoded on multiple threads if the image is large enough.
+	void BlockCompressImageDXT1(uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, DxtQuality quality = DxtQuality::Normal);
+	void BlockCompressImageDXT3(uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, DxtQuality quality = DxtQuality::Normal);
+	void BlockCompressImageDXT5(uint32_t width, uint32_t height, const uint32_t* image, uint8_t* blockStorage, DxtQuality quality = DxtQuality::Normal);
 }
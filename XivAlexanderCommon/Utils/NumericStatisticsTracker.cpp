@@ -2,36 +2,251 @@
 #include "XivAlexanderCommon/Utils/NumericStatisticsTracker.h"
 #include "XivAlexanderCommon/Utils/Utils.h"
 
-Utils::NumericStatisticsTracker::Entry::Entry(int64_t value, int64_t maxAgeUs)
-	: Value(value)
-	, TimestampUs(Utils::QpcUs())
-	, ExpiryUs(maxAgeUs == INT64_MAX ? INT64_MAX : TimestampUs + maxAgeUs) {
-}
-
 Utils::NumericStatisticsTracker::NumericStatisticsTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs)
 	: m_trackCount(trackCount)
 	, m_emptyValue(emptyValue)
-	, m_maxAgeUs(maxAgeUs) {
+	, m_maxAgeUs(maxAgeUs)
+	, m_entries(std::make_unique<Entry[]>(trackCount))
+	, m_minQueue(std::make_unique<Relaxed<uint64_t>[]>(trackCount))
+	, m_maxQueue(std::make_unique<Relaxed<uint64_t>[]>(trackCount))
+	, m_nodes(std::make_unique<Node[]>(trackCount)) {
+	if (!trackCount)
+		throw std::invalid_argument("trackCount must be positive");
+	if (trackCount >= NoNode)
+		throw std::invalid_argument("trackCount too large");
 }
 
 Utils::NumericStatisticsTracker::~NumericStatisticsTracker() = default;
 
+void Utils::NumericStatisticsTracker::BeginWrite() {
+	// Acquire on success, so that this write sees everything the previous writer has done before its EndWrite.
+	auto sequence = m_sequence.load(std::memory_order_relaxed);
+	while (sequence & 1 || !m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+		sequence = m_sequence.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void Utils::NumericStatisticsTracker::EndWrite() {
+	m_sequence.fetch_add(1, std::memory_order_release);
+}
+
+bool Utils::NumericStatisticsTracker::NodeLess(uint32_t a, uint32_t b) const {
+	const int64_t va = m_entries[a].Value, vb = m_entries[b].Value;
+	return va < vb || (va == vb && m_nodes[a].Index < m_nodes[b].Index);
+}
+
+void Utils::NumericStatisticsTracker::UpdateSize(uint32_t node) {
+	m_nodes[node].Size = 1 + SizeOf(m_nodes[node].Left) + SizeOf(m_nodes[node].Right);
+}
+
+std::pair<uint32_t, uint32_t> Utils::NumericStatisticsTracker::Split(uint32_t tree, uint32_t key) {
+	// Nodes ordered before key go to the first tree, and the rest go to the second.
+	if (tree == NoNode)
+		return { NoNode, NoNode };
+
+	auto& n = m_nodes[tree];
+	if (NodeLess(tree, key)) {
+		const auto [left, right] = Split(n.Right, key);
+		n.Right = left;
+		UpdateSize(tree);
+		return { tree, right };
+	} else {
+		const auto [left, right] = Split(n.Left, key);
+		n.Left = right;
+		UpdateSize(tree);
+		return { left, tree };
+	}
+}
+
+uint32_t Utils::NumericStatisticsTracker::Merge(uint32_t left, uint32_t right) {
+	// Every node in left is ordered before every node in right.
+	if (left == NoNode)
+		return right;
+	if (right == NoNode)
+		return left;
+
+	if (m_nodes[left].Priority > m_nodes[right].Priority) {
+		m_nodes[left].Right = Merge(m_nodes[left].Right, right);
+		UpdateSize(left);
+		return left;
+	} else {
+		m_nodes[right].Left = Merge(left, m_nodes[right].Left);
+		UpdateSize(right);
+		return right;
+	}
+}
+
+uint32_t Utils::NumericStatisticsTracker::Insert(uint32_t tree, uint32_t node) {
+	if (tree == NoNode)
+		return node;
+
+	auto& n = m_nodes[tree];
+	if (m_nodes[node].Priority > n.Priority) {
+		const auto [left, right] = Split(tree, node);
+		m_nodes[node].Left = left;
+		m_nodes[node].Right = right;
+		UpdateSize(node);
+		return node;
+	}
+
+	if (NodeLess(node, tree))
+		n.Left = Insert(n.Left, node);
+	else
+		n.Right = Insert(n.Right, node);
+	UpdateSize(tree);
+	return tree;
+}
+
+uint32_t Utils::NumericStatisticsTracker::Erase(uint32_t tree, uint32_t node) {
+	if (tree == NoNode)
+		return NoNode;
+
+	auto& n = m_nodes[tree];
+	if (tree == node)
+		return Merge(n.Left, n.Right);
+
+	if (NodeLess(node, tree))
+		n.Left = Erase(n.Left, node);
+	else
+		n.Right = Erase(n.Right, node);
+	UpdateSize(tree);
+	return tree;
+}
+
+int64_t Utils::NumericStatisticsTracker::Select(size_t n) const {
+	// Node indices are checked and the walk is bounded, as a write may be changing the tree;
+	// whatever gets returned then is discarded by ReadConsistent.
+	uint32_t node = m_root;
+	for (size_t depth = 0; node < m_trackCount && depth < m_trackCount; ++depth) {
+		const auto& current = m_nodes[node];
+		const size_t leftSize = SizeOf(current.Left);
+		if (n < leftSize)
+			node = current.Left;
+		else if (n == leftSize)
+			return m_entries[node].Value;
+		else {
+			n -= leftSize + 1;
+			node = current.Right;
+		}
+	}
+	return m_emptyValue;
+}
+
 void Utils::NumericStatisticsTracker::AddValue(int64_t v) {
-	{
-		const auto lock = std::lock_guard(m_mtx);
-		m_values.emplace_back(v, m_maxAgeUs);
+	const auto nowUs = Utils::QpcUs();
+
+	BeginWrite();
+
+	// Make room for the new entry.
+	if (m_end - m_begin == m_trackCount) {
+		m_root = Erase(m_root, static_cast<uint32_t>(m_begin % m_trackCount));
+		m_begin++;
+	}
+	while (m_minQueueBegin < m_minQueueEnd && m_minQueue[m_minQueueBegin % m_trackCount] < m_begin)
+		m_minQueueBegin++;
+	while (m_maxQueueBegin < m_maxQueueEnd && m_maxQueue[m_maxQueueBegin % m_trackCount] < m_begin)
+		m_maxQueueBegin++;
+
+	const auto slot = static_cast<uint32_t>(m_end % m_trackCount);
+	auto& entry = m_entries[slot];
+	entry.Value = v;
+	entry.TimestampUs = nowUs;
+	entry.ExpiryUs = m_maxAgeUs == INT64_MAX ? INT64_MAX : nowUs + m_maxAgeUs;
+	entry.SumBefore = m_sum;
+	entry.SquaredSumBefore = m_squaredSum;
+	m_sum += static_cast<uint64_t>(v);
+	m_squaredSum += static_cast<uint64_t>(v) * static_cast<uint64_t>(v);
+
+	while (m_minQueueBegin < m_minQueueEnd && At(m_minQueue[(m_minQueueEnd - 1) % m_trackCount]).Value >= v)
+		m_minQueueEnd--;
+	m_minQueue[m_minQueueEnd++ % m_trackCount] = m_end;
+	while (m_maxQueueBegin < m_maxQueueEnd && At(m_maxQueue[(m_maxQueueEnd - 1) % m_trackCount]).Value <= v)
+		m_maxQueueEnd--;
+	m_maxQueue[m_maxQueueEnd++ % m_trackCount] = m_end;
+
+	// splitmix64
+	auto& node = m_nodes[slot];
+	node.Index = m_end;
+	node.Priority = node.Index + 0x9E3779B97F4A7C15ULL;
+	node.Priority = (node.Priority ^ (node.Priority >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	node.Priority = (node.Priority ^ (node.Priority >> 27)) * 0x94D049BB133111EBULL;
+	node.Priority ^= node.Priority >> 31;
+	node.Left = NoNode;
+	node.Right = NoNode;
+	node.Size = 1;
+	m_root = Insert(m_root, slot);
+
+	m_end++;
+
+	EndWrite();
+}
+
+void Utils::NumericStatisticsTracker::Clear() {
+	BeginWrite();
+	m_begin = m_end;
+	m_minQueueBegin = m_minQueueEnd;
+	m_maxQueueBegin = m_maxQueueEnd;
+	m_root = NoNode;
+	EndWrite();
+}
+
+Utils::NumericStatisticsTracker::Range Utils::NumericStatisticsTracker::GetRange(int64_t sinceUs, int64_t nowUs) const {
+	// Timestamps and expiry times only ever increase, so entries to skip are always at the front.
+	const uint64_t end = m_end;
+	const auto begin = end - std::min<uint64_t>(end - m_begin, m_trackCount);
+	Range range{ begin, begin, end };
+
+	for (auto count = range.End - range.LiveBegin; count;) {
+		const auto half = count / 2;
+		if (At(range.LiveBegin + half).ExpiryUs < nowUs) {
+			range.LiveBegin += half + 1;
+			count -= half + 1;
+		} else
+			count = half;
 	}
-	void(RemoveExpired(m_values.back().TimestampUs));
+
+	range.Begin = range.LiveBegin;
+	for (auto count = range.End - range.Begin; count;) {
+		const auto half = count / 2;
+		if (At(range.Begin + half).TimestampUs < sinceUs) {
+			range.Begin += half + 1;
+			count -= half + 1;
+		} else
+			count = half;
+	}
+
+	return range;
 }
 
-const std::deque<Utils::NumericStatisticsTracker::Entry>& Utils::NumericStatisticsTracker::RemoveExpired(int64_t nowUs) const {
-	const auto lock = std::lock_guard(m_mtx);
-	while (!m_values.empty() && (
-		m_values.size() > m_trackCount || 
-		m_values.front().ExpiryUs < nowUs
-	))
-		m_values.pop_front();
-	return m_values;
+int64_t Utils::NumericStatisticsTracker::Extremum(const Relaxed<uint64_t>* queue, uint64_t queueBegin, uint64_t queueEnd, uint64_t begin) const {
+	// First queued entry at or after begin holds the extremum of everything from begin.
+	queueBegin = std::max(queueBegin, queueEnd - std::min<uint64_t>(queueEnd - queueBegin, m_trackCount));
+	for (auto count = queueEnd - queueBegin; count;) {
+		const auto half = count / 2;
+		if (queue[(queueBegin + half) % m_trackCount] < begin) {
+			queueBegin += half + 1;
+			count -= half + 1;
+		} else
+			count = half;
+	}
+	if (queueBegin == queueEnd)
+		return m_emptyValue;
+	return At(queue[queueBegin % m_trackCount]).Value;
+}
+
+std::pair<int64_t, int64_t> Utils::NumericStatisticsTracker::NthValues(const Range& range, size_t n1, size_t n2) const {
+	// The treap covers every entry in the ring, which is what gets asked for most of the time.
+	if (range.Begin == m_begin && range.Count() == SizeOf(m_root))
+		return { Select(n1), Select(n2) };
+
+	std::vector<int64_t> values;
+	values.reserve(range.Count());
+	for (auto i = range.Begin; i < range.End; ++i)
+		values.emplace_back(At(i).Value);
+	std::ranges::nth_element(values, values.begin() + n1);
+	const auto v1 = values[n1];
+	std::ranges::nth_element(values, values.begin() + n2);
+	return { v1, values[n2] };
 }
 
 int64_t Utils::NumericStatisticsTracker::InvalidValue() const {
@@ -39,102 +254,92 @@ int64_t Utils::NumericStatisticsTracker::InvalidValue() const {
 }
 
 int64_t Utils::NumericStatisticsTracker::Latest() const {
-	const auto vals = RemoveExpired();
-	if (vals.empty())
-		return m_emptyValue;
-	return vals.back().Value;
+	return ReadConsistent([&]() -> int64_t {
+		const auto range = GetRange(0);
+		if (!range.Count())
+			return m_emptyValue;
+		return At(range.End - 1).Value;
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Min(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	auto found = false;
-	int64_t minValue{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		if (!found || minValue > v.Value)
-			minValue = v.Value;
-		found = true;
-	}
-	return found ? minValue : m_emptyValue;
+	return ReadConsistent([&] {
+		const auto range = GetRange(sinceUs);
+		if (!range.Count())
+			return m_emptyValue;
+		return Extremum(&m_minQueue[0], m_minQueueBegin, m_minQueueEnd, range.Begin);
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Max(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	auto found = false;
-	int64_t maxValue{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		if (!found || maxValue < v.Value)
-			maxValue = v.Value;
-		found = true;
-	}
-	return found ? maxValue : m_emptyValue;
+	return ReadConsistent([&] {
+		const auto range = GetRange(sinceUs);
+		if (!range.Count())
+			return m_emptyValue;
+		return Extremum(&m_maxQueue[0], m_maxQueueBegin, m_maxQueueEnd, range.Begin);
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Median(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-
-	std::vector<int64_t> sorted;
-	sorted.reserve(vals.size());
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		sorted.emplace_back(v.Value);
-	}
-	if (sorted.empty())
-		return m_emptyValue;
-	std::ranges::sort(sorted);
+	return ReadConsistent([&] {
+		const auto range = GetRange(sinceUs);
+		const auto count = range.Count();
+		if (!count)
+			return m_emptyValue;
 
-	if (sorted.size() % 2 == 0) {
-		// even
-		return (sorted[sorted.size() / 2] + sorted[sorted.size() / 2 - 1]) / 2;
-	} else {
-		// odd
-		return sorted[sorted.size() / 2];
-	}
+		if (count % 2 == 0) {
+			// even
+			const auto [v1, v2] = NthValues(range, count / 2, count / 2 - 1);
+			return (v1 + v2) / 2;
+		} else {
+			// odd
+			return NthValues(range, count / 2, count / 2).first;
+		}
+	});
+}
+
+int64_t Utils::NumericStatisticsTracker::Percentile(double fraction, int64_t sinceUs) const {
+	return ReadConsistent([&] {
+		const auto range = GetRange(sinceUs);
+		const auto count = range.Count();
+		if (!count)
+			return m_emptyValue;
+
+		// Nearest rank
+		const auto rank = static_cast<size_t>(std::ceil(std::clamp(fraction, 0., 1.) * static_cast<double>(count)));
+		const auto n = std::min(count - 1, rank ? rank - 1 : 0);
+		return NthValues(range, n, n).first;
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Mean(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	int64_t count = 0;
-	int64_t acc{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		acc += v.Value;
-		++count;
-	}
-	return count ? acc / count : m_emptyValue;
+	return ReadConsistent([&] {
+		const auto range = GetRange(sinceUs);
+		if (!range.Count())
+			return m_emptyValue;
+		return static_cast<int64_t>(m_sum - At(range.Begin).SumBefore) / static_cast<int64_t>(range.Count());
+	});
 }
 
 std::pair<int64_t, int64_t> Utils::NumericStatisticsTracker::MeanAndDeviation(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-
-	int64_t count = 0;
-	int64_t acc{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		acc += v.Value;
-		++count;
-	}
+	return ReadConsistent([&]() -> std::pair<int64_t, int64_t> {
+		const auto range = GetRange(sinceUs);
+		const auto count = static_cast<int64_t>(range.Count());
+		if (count == 0)
+			return { m_emptyValue, 0 };
 
-	if (count == 0)
-		return {m_emptyValue, 0};
-	if (count == 1)
-		return {acc, 0};
-	const auto mean = acc / count;
-
-	int64_t diffSquaredSum = 0;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		diffSquaredSum += (v.Value - mean) * (v.Value - mean);
-	}
+		const auto acc = m_sum - At(range.Begin).SumBefore;
+		if (count == 1)
+			return { static_cast<int64_t>(acc), 0 };
+		const auto mean = static_cast<int64_t>(acc) / count;
+
+		// sum((v - mean)^2) = sum(v^2) - 2 * mean * sum(v) + count * mean^2; exact even if intermediate values wrap around.
+		const auto squaredAcc = m_squaredSum - At(range.Begin).SquaredSumBefore;
+		const auto umean = static_cast<uint64_t>(mean);
+		const auto diffSquaredSum = static_cast<int64_t>(squaredAcc - 2 * umean * acc + static_cast<uint64_t>(count) * umean * umean);
 
-	return {mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count))};
+		return { mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count)) };
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Deviation(int64_t sinceUs) const {
@@ -142,45 +347,32 @@ int64_t Utils::NumericStatisticsTracker::Deviation(int64_t sinceUs) const {
 }
 
 size_t Utils::NumericStatisticsTracker::Count(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	if (!sinceUs)
-		return vals.size();
-
-	size_t count = 0;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		++count;
-	}
-	return count;
+	return ReadConsistent([&] {
+		return GetRange(sinceUs).Count();
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::NextBlankInUs() const {
-	const auto s = RemoveExpired();
-	if (s.size() < m_trackCount)
-		return 0;
-	return s.front().Value - Entry(0, 0).Value;
+	return ReadConsistent([&]() -> int64_t {
+		const auto range = GetRange(0);
+		if (range.Count() < m_trackCount)
+			return int64_t();
+		return At(range.Begin).Value;
+	});
 }
 
 double Utils::NumericStatisticsTracker::CountFractional(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	if (!sinceUs)
-		return static_cast<double>(vals.size());
-
-	size_t count = 0;
-	int64_t lastTimestamp = INT64_MIN;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs) {
-			if (lastTimestamp != INT64_MIN) {
-				const auto window = lastTimestamp - v.TimestampUs;
-				const auto elapsed = sinceUs - v.TimestampUs;
-				if (window > elapsed)
-					return static_cast<double>(count) + static_cast<double>(elapsed) / static_cast<double>(window);
-			}
-			break;
-		}
-		++count;
-		lastTimestamp = v.TimestampUs;
-	}
-	return static_cast<double>(count);
+	return ReadConsistent([&] {
+		const auto range = GetRange(sinceUs);
+		const auto count = range.Count();
+		if (!sinceUs || !count || range.Begin == range.LiveBegin)
+			return static_cast<double>(count);
+
+		const auto& previous = At(range.Begin - 1);
+		const auto window = At(range.Begin).TimestampUs - previous.TimestampUs;
+		const auto elapsed = sinceUs - previous.TimestampUs;
+		if (window > elapsed)
+			return static_cast<double>(count) + static_cast<double>(elapsed) / static_cast<double>(window);
+		return static_cast<double>(count);
+	});
 }
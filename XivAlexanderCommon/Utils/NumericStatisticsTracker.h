@@ -1,35 +1,129 @@
 #pragma once
 
-#include <deque>
+#include <atomic>
+#include <memory>
 #include "XivAlexanderCommon/Utils/Utils.h"
 
 namespace Utils {
+	// Keeps the last trackCount values in a ring buffer, along with what is needed to answer queries without scanning:
+	// prefix sums for mean and deviation, monotonic queues for min and max, and a treap ordered by value for median and percentiles.
+	//
+	// Writes are published through a sequence counter, so neither AddValue nor queries take a lock.
+	// AddValue and Clear are meant to be called from a single thread; other writers spin until it is done.
 	class NumericStatisticsTracker {
+		// Queries may read fields while AddValue is writing them, and throw away what they have read if so.
+		// Relaxed atomics keep that well-defined, and compile to plain loads and stores on x86 and x64.
+		// Only one writer at a time gets past BeginWrite, so modifying operators do not need to be atomic as a whole.
+		template<typename T>
+		class Relaxed {
+			std::atomic<T> m_value{};
+
+		public:
+			Relaxed() = default;
+			Relaxed(T value) : m_value(value) {}
+			Relaxed(const Relaxed& r) : m_value(static_cast<T>(r)) {}
+			Relaxed& operator=(const Relaxed& r) { return *this = static_cast<T>(r); }
+
+			operator T() const { return m_value.load(std::memory_order_relaxed); }
+			Relaxed& operator=(T value) { m_value.store(value, std::memory_order_relaxed); return *this; }
+			Relaxed& operator+=(T value) { return *this = *this + value; }
+			Relaxed& operator-=(T value) { return *this = *this - value; }
+			T operator++(int) { const T value = *this; *this = value + 1; return value; }
+			T operator--(int) { const T value = *this; *this = value - 1; return value; }
+		};
+
 		const size_t m_trackCount;
 		const int64_t m_emptyValue;
 		const int64_t m_maxAgeUs;
 
 		struct Entry {
-			const int64_t Value;
-			const int64_t TimestampUs;
-			const int64_t ExpiryUs;
+			Relaxed<int64_t> Value;
+			Relaxed<int64_t> TimestampUs;
+			Relaxed<int64_t> ExpiryUs;
 
-			Entry(int64_t value, int64_t maxAgeUs);
+			// Sums of values and squared values added before this entry; wraps around.
+			Relaxed<uint64_t> SumBefore;
+			Relaxed<uint64_t> SquaredSumBefore;
 		};
 
-		mutable std::mutex m_mtx;
-		mutable std::deque<Entry> m_values;
+		// Odd while being written.
+		mutable std::atomic<uint64_t> m_sequence = 0;
+
+		// Entries [m_begin, m_end) are in the ring, at index % m_trackCount.
+		const std::unique_ptr<Entry[]> m_entries;
+		Relaxed<uint64_t> m_begin = 0;
+		Relaxed<uint64_t> m_end = 0;
+		Relaxed<uint64_t> m_sum = 0;
+		Relaxed<uint64_t> m_squaredSum = 0;
+
+		// Indices of entries whose values are smaller (or larger) than every entry after them.
+		const std::unique_ptr<Relaxed<uint64_t>[]> m_minQueue;
+		const std::unique_ptr<Relaxed<uint64_t>[]> m_maxQueue;
+		Relaxed<uint64_t> m_minQueueBegin = 0, m_minQueueEnd = 0;
+		Relaxed<uint64_t> m_maxQueueBegin = 0, m_maxQueueEnd = 0;
+
+		// Treap of entries [m_begin, m_end), ordered by value and then by index, with one node per ring slot.
+		// Priorities come from hashing the index, so the tree stays balanced in expectation whatever the values are.
+		static constexpr uint32_t NoNode = UINT32_MAX;
+		struct Node {
+			Relaxed<uint32_t> Left;
+			Relaxed<uint32_t> Right;
+			Relaxed<uint32_t> Size;
+
+			// Only used by AddValue.
+			uint64_t Index;
+			uint64_t Priority;
+		};
+		const std::unique_ptr<Node[]> m_nodes;
+		Relaxed<uint32_t> m_root = NoNode;
+
+		struct Range {
+			uint64_t LiveBegin;  // first entry that has not expired
+			uint64_t Begin;  // first entry that has not expired and is at or after sinceUs
+			uint64_t End;
+
+			[[nodiscard]] size_t Count() const { return static_cast<size_t>(End - Begin); }
+		};
 
 	public:
 		NumericStatisticsTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs = INT64_MAX);
 		~NumericStatisticsTracker();
 
 		void AddValue(int64_t);
-		void Clear() { m_values.clear(); };
-		bool Empty() const { return m_values.empty(); }
+		void Clear();
+		bool Empty() const { return Count() == 0; }
 
 	private:
-		[[nodiscard]] const std::deque<Entry>& RemoveExpired(int64_t nowUs = Utils::QpcUs()) const;
+		void BeginWrite();
+		void EndWrite();
+
+		[[nodiscard]] uint32_t SizeOf(uint32_t node) const { return node < m_trackCount ? static_cast<uint32_t>(m_nodes[node].Size) : 0; }
+		[[nodiscard]] bool NodeLess(uint32_t a, uint32_t b) const;
+		void UpdateSize(uint32_t node);
+		[[nodiscard]] std::pair<uint32_t, uint32_t> Split(uint32_t tree, uint32_t key);
+		[[nodiscard]] uint32_t Merge(uint32_t left, uint32_t right);
+		[[nodiscard]] uint32_t Insert(uint32_t tree, uint32_t node);
+		[[nodiscard]] uint32_t Erase(uint32_t tree, uint32_t node);
+		[[nodiscard]] int64_t Select(size_t n) const;
+
+		// Calls fn until it has run without being interrupted by a write.
+		template<typename Fn>
+		auto ReadConsistent(Fn fn) const -> decltype(fn()) {
+			while (true) {
+				const auto sequence = m_sequence.load(std::memory_order_acquire);
+				if (sequence & 1)
+					continue;
+				auto result = fn();
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (m_sequence.load(std::memory_order_relaxed) == sequence)
+					return result;
+			}
+		}
+
+		[[nodiscard]] const Entry& At(uint64_t index) const { return m_entries[static_cast<size_t>(index % m_trackCount)]; }
+		[[nodiscard]] Range GetRange(int64_t sinceUs, int64_t nowUs = Utils::QpcUs()) const;
+		[[nodiscard]] int64_t Extremum(const Relaxed<uint64_t>* queue, uint64_t queueBegin, uint64_t queueEnd, uint64_t begin) const;
+		[[nodiscard]] std::pair<int64_t, int64_t> NthValues(const Range& range, size_t n1, size_t n2) const;
 
 	public:
 		[[nodiscard]] int64_t InvalidValue() const;
@@ -37,6 +131,7 @@ namespace Utils {
 		[[nodiscard]] int64_t Min(int64_t sinceUs = 0) const;
 		[[nodiscard]] int64_t Max(int64_t sinceUs = 0) const;
 		[[nodiscard]] int64_t Median(int64_t sinceUs = 0) const;
+		[[nodiscard]] int64_t Percentile(double fraction, int64_t sinceUs = 0) const;
 		[[nodiscard]] std::pair<int64_t, int64_t> MeanAndDeviation(int64_t sinceUs = 0) const;
 		[[nodiscard]] int64_t Mean(int64_t sinceUs = 0) const;
 		[[nodiscard]] int64_t Deviation(int64_t sinceUs = 0) const;
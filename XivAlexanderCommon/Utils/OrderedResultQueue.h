@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace Utils {
+	// Takes results of tasks that may finish in any order, and hands them to a consumer in the order the tasks were admitted,
+	// so that the output stays the same as if every task had been run one by one.
+	// Admission waits while the cost of admitted tasks whose results have not been consumed yet would exceed the budget.
+	// A task is always admitted if nothing else is in flight, so a task costing more than the budget still gets to run, alone.
+	template<typename T>
+	class OrderedResultQueue {
+		const uint64_t m_budget;
+		const std::function<void(T&)> m_consume;
+
+		std::mutex m_mtx;
+		std::condition_variable m_cv;
+		std::map<size_t, T> m_finished;
+		std::vector<uint64_t> m_costs;
+		size_t m_nextToConsume = 0;
+		uint64_t m_costInFlight = 0;
+
+	public:
+		// consume is called with the queue locked; it must neither throw nor call back into the queue.
+		OrderedResultQueue(uint64_t budget, std::function<void(T&)> consume)
+			: m_budget(budget)
+			, m_consume(std::move(consume)) {
+		}
+
+		// Returns the index to pass to Finish, or SIZE_MAX if cancelled returned true while waiting for budget.
+		size_t Admit(uint64_t cost, const std::function<bool()>& cancelled = nullptr) {
+			auto lock = std::unique_lock(m_mtx);
+			while (m_costInFlight && m_costInFlight + cost > m_budget) {
+				if (cancelled && cancelled())
+					return SIZE_MAX;
+				m_cv.wait_for(lock, std::chrono::milliseconds(100));
+			}
+			m_costInFlight += cost;
+			m_costs.emplace_back(cost);
+			return m_costs.size() - 1;
+		}
+
+		// Must be called exactly once for every admitted index, even if the task has failed.
+		void Finish(size_t index, T result) {
+			{
+				const auto lock = std::lock_guard(m_mtx);
+				m_finished.emplace(index, std::move(result));
+				for (auto it = m_finished.begin(); it != m_finished.end() && it->first == m_nextToConsume; it = m_finished.erase(it), ++m_nextToConsume) {
+					m_consume(it->second);
+					m_costInFlight -= m_costs[it->first];
+				}
+			}
+			m_cv.notify_all();
+		}
+
+		[[nodiscard]] uint64_t CostInFlight() {
+			const auto lock = std::lock_guard(m_mtx);
+			return m_costInFlight;
+		}
+	};
+}
@@ -93,3 +93,53 @@ void Utils::Win32::TpEnvironment::Cancel() {
 
 	m_cancelling = false;
 }
+
+
+void Utils::Win32::ParallelFor(size_t count, const std::function<void(size_t)>& body, size_t maxConcurrency) {
+	if (!count)
+		return;
+
+	struct State {
+		const std::function<void(size_t)>& Body;
+		const size_t Count;
+		std::atomic_size_t Next = 0;
+		std::atomic_size_t Active = 0;
+		std::mutex ErrorMtx;
+		std::exception_ptr FirstError;
+		const Event Done = Event::Create();
+
+		void Run() {
+			for (size_t i; (i = Next++) < Count;) {
+				try {
+					Body(i);
+				} catch (...) {
+					const auto lock = std::lock_guard(ErrorMtx);
+					if (!FirstError)
+						FirstError = std::current_exception();
+					Next = Count;
+				}
+			}
+		}
+	} state{ body, count };
+
+	const auto helperCount = std::min<size_t>({ count, maxConcurrency, GetNumberOfProcessors() }) - 1;
+	state.Active = helperCount;
+	for (size_t i = 0; i < helperCount; ++i) {
+		if (!TrySubmitThreadpoolCallback([](PTP_CALLBACK_INSTANCE, void* ctx) {
+			const auto pState = static_cast<State*>(ctx);
+			pState->Run();
+			if (!--pState->Active)
+				pState->Done.Set();
+		}, &state, nullptr)) {
+			if (!--state.Active)
+				state.Done.Set();
+		}
+	}
+
+	state.Run();
+	if (helperCount)
+		state.Done.Wait();
+
+	if (state.FirstError)
+		std::rethrow_exception(state.FirstError);
+}
@@ -27,4 +27,8 @@ namespace Utils::Win32 {
 		void WaitOutstanding();
 		void Cancel();
 	};
+
+	// Runs body(0..count-1) on the process default thread pool, with the calling thread participating.
+	// Returns after every invocation has finished; the first exception thrown by body is rethrown.
+	void ParallelFor(size_t count, const std::function<void(size_t)>& body, size_t maxConcurrency = SIZE_MAX);
 }
\ No newline at end of file
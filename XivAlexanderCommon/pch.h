@@ -15,12 +15,16 @@
 #define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <cmath>
 #include <codecvt>
 #include <cwctype>
 #include <format>
 #include <functional>
 #include <map>
+#include <numbers>
 #include <numeric>
 #include <ranges>
 #include <set>
@@ -28,6 +32,9 @@
 #include <string>
 #include <vector>
 
+// SIMD intrinsics
+#include <immintrin.h>
+
 // Windows API, part 1
 #define NOMINMAX
 #define _WINSOCKAPI_   // Prevent <winsock.h> from being included